@@ -38,7 +38,16 @@ const makerDeb = new MakerDeb({
     genericName: 'Pie Menu',
     icon: 'assets/icons/icon.svg',
     homepage: 'https://github.com/kando-menu/kando',
-    depends: ['libxtst6'],
+    depends: [
+      'libxtst6',
+      'libx11-xcb1',
+      'libxcb-composite0',
+      'libxcb-damage0',
+      'libxcb-shape0',
+      'libxcb-shm0',
+      'libxrandr2',
+      'libxi6',
+    ],
     categories: ['Utility'],
   },
 });
@@ -51,7 +60,7 @@ const makerRPM = new MakerRpm({
     genericName: 'Pie Menu',
     icon: 'assets/icons/icon.svg',
     homepage: 'https://github.com/kando-menu/kando',
-    requires: ['libXtst'],
+    requires: ['libXtst', 'libX11-xcb', 'libxcb', 'libXrandr', 'libXi'],
     categories: ['Utility'],
   },
 });
@@ -232,6 +232,18 @@ export class ActionTypeRegistry {
         prefersInhibitedShortcuts: true,
         createAction: () => ({ type: 'simulate-hotkey', hotkey: '' }),
       },
+      ['type-text']: {
+        name: i18next.t('menu-actions.type-text.name'),
+        icon: 'text-item.svg',
+        iconTheme: 'kando',
+        description: i18next.t('menu-actions.type-text.description'),
+        supportedByBackend: ['X11', 'KDE X11', 'Cinnamon', 'Hyprland', 'Niri'].includes(
+          backend.name
+        ),
+        prefersDelayedExecution: true,
+        prefersInhibitedShortcuts: true,
+        createAction: () => ({ type: 'type-text', text: '' }),
+      },
     };
   }
 
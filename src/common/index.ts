@@ -123,6 +123,9 @@ export type VersionInfo = {
  * the pie menu. It contains the name of the currently focused app / window, the current
  * pointer position, and the screen area where a maximized window can be placed. That is
  * the screen resolution minus the taskbar and other panels.
+ *
+ * Some backends also report the process which owns the focused window and the window
+ * which is under the pointer.
  */
 export type WMInfo = {
   readonly windowName: string;
@@ -130,6 +133,21 @@ export type WMInfo = {
   readonly pointerX: number;
   readonly pointerY: number;
   readonly workArea: Electron.Rectangle;
+
+  /** The ID of the process owning the focused window. */
+  readonly pid?: number;
+
+  /** The absolute path of the executable of this process. */
+  readonly executable?: string;
+
+  /** The arguments this process was started with, including argv[0]. */
+  readonly commandLine?: string[];
+
+  /** The application name of the top-most window under the pointer. */
+  readonly hoveredAppName?: string;
+
+  /** The title of the top-most window under the pointer. */
+  readonly hoveredWindowName?: string;
 };
 
 /**
@@ -205,6 +223,17 @@ export type KeyStroke = {
  */
 export type KeySequence = Array<KeyStroke>;
 
+/**
+ * This type is used to describe one representation of the clipboard content. The data
+ * is sent to other applications which ask for the given MIME type, for instance
+ * text/plain or text/html. Strings are sent as UTF-8, Buffers are sent as they are, for
+ * instance for images.
+ */
+export type ClipboardEntry = {
+  mimeType: string;
+  data: string | Buffer;
+};
+
 /** Enum for the different things a user can do in a menu. */
 export enum MenuInteractionType {
   eOpenMenu = 'openMenu',
@@ -285,6 +314,47 @@ export type ShowMenuOptions = {
    * opened. This is used to determine if the menu needs to be reloaded.
    */
   readonly systemIconsChanged: boolean;
+
+  /**
+   * If the menu theme requests a blurred backdrop, this contains the blurred screen
+   * content below the menu. It is captured before the window is shown.
+   */
+  readonly backdrop?: MenuBackdrop;
+};
+
+/**
+ * The blurred screen content below the menu. The image is usually smaller than the
+ * captured area and has to be scaled up to the given rectangle.
+ */
+export type MenuBackdrop = {
+  /** The left edge of the captured area relative to the window in CSS pixels. */
+  readonly x: number;
+
+  /** The top edge of the captured area relative to the window in CSS pixels. */
+  readonly y: number;
+
+  /** The width of the captured area in CSS pixels. */
+  readonly width: number;
+
+  /** The height of the captured area in CSS pixels. */
+  readonly height: number;
+
+  /** The blurred pixels. */
+  readonly image: WindowImage;
+};
+
+/**
+ * The area of the menu window which is currently covered by the menu. Backends can use
+ * this to restrict the visible and clickable area of the window. The renderer reports it
+ * in CSS pixels relative to the window; the host converts it to screen pixels before it
+ * is passed to the backend.
+ */
+export type MenuShape = {
+  /** The circles around the visible menu items and the connectors between them. */
+  readonly circles: Array<{ x: number; y: number; radius: number }>;
+
+  /** Additional rectangles, for instance for the settings button. */
+  readonly rectangles: Array<{ x: number; y: number; width: number; height: number }>;
 };
 
 /**
@@ -357,6 +427,14 @@ export type MenuThemeDescription = {
    */
   readonly drawWedgeSeparators: boolean;
 
+  /**
+   * If this is larger than zero, the screen content below the menu is captured before the
+   * menu is shown and blurred with this standard deviation in pixels. It will be drawn
+   * into a canvas with the class "backdrop" below all other elements of the menu. This is
+   * only supported by some backends. Default is 0.
+   */
+  readonly backdropBlur: number;
+
   /**
    * These colors will be available as var(--name) in the CSS file and can be adjusted by
    * the user in the settings. The map assigns a default CSS color to each name.
@@ -461,7 +539,8 @@ export type AppDescription = {
 
 /**
  * This type is used to describe an open window. It is used when listing the open windows,
- * for instance for the focus-window action.
+ * for instance for the focus-window action. The optional properties are only provided by
+ * some backends.
  */
 export type WindowDescription = {
   /** The title of the window. */
@@ -469,6 +548,33 @@ export type WindowDescription = {
 
   /** The application the window belongs to. */
   readonly appName: string;
+
+  /** A backend-specific ID which allows focusing the window without searching for it. */
+  readonly id?: number;
+
+  /** The index of the workspace the window is on. Sticky windows have none. */
+  readonly workspace?: number;
+
+  /** The index of the monitor which shows the window. */
+  readonly monitor?: number;
+
+  /** Whether the window is currently minimized. */
+  readonly minimized?: boolean;
+};
+
+/**
+ * This type is used to transfer the icon or a thumbnail of an open window. The pixels are
+ * stored row-by-row as non-premultiplied RGBA with eight bits per channel.
+ */
+export type WindowImage = {
+  /** The width of the image in pixels. */
+  readonly width: number;
+
+  /** The height of the image in pixels. */
+  readonly height: number;
+
+  /** The RGBA pixel data. It contains width * height * 4 bytes. */
+  readonly data: ArrayBuffer;
 };
 
 /**
@@ -30,6 +30,28 @@ export function mapKeys(keys: KeySequence, os: 'windows' | 'macos' | 'linux'): n
   });
 }
 
+/**
+ * This function maps a platform specific key code back to a key name. This is used to
+ * turn natively recorded key events into a KeySequence. If several key names share the
+ * same code, the first one is returned.
+ *
+ * @param code The platform specific key code.
+ * @param os The operating system the key code belongs to.
+ * @returns The key name in proper case or undefined if the key code is not known.
+ */
+export function getKeyName(
+  code: number,
+  os: 'windows' | 'macos' | 'linux'
+): string | undefined {
+  for (const [name, mapping] of KEY_CODES) {
+    if (mapping[os] === code) {
+      return fixKeyCodeCase(name);
+    }
+  }
+
+  return undefined;
+}
+
 /**
  * This function fixes a key code case. If the key code is not known, it is returned as
  * is.
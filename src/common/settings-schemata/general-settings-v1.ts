@@ -263,6 +263,37 @@ export const GENERAL_SETTINGS_SCHEMA_V1 = z.object({
     ])
     .default('center'),
 
+  /**
+   * If enabled, the WLRoots backend keeps the surface which is used to get the pointer
+   * position between menu openings. It is unmapped in the meantime. This saves setting
+   * up the surface and the input devices each time a menu is opened.
+   */
+  wlrootsKeepPointerSurface: z.boolean().default(false),
+
+  /**
+   * If enabled, the X11 backends follow the pointer with XInput2 raw motion events in a
+   * background thread. This way, the pointer position is known without a round trip to
+   * the X server when a menu is opened.
+   */
+  x11PointerTracking: z.boolean().default(false),
+
+  /**
+   * If enabled, the X11 backends restrict the visible and clickable area of the menu
+   * window to the menu itself. This reduces the work of the compositor during animations
+   * and lets clicks outside of the menu reach the windows below. The menu is closed when
+   * the clicked window takes the focus. As pointer motion outside of the menu is only
+   * reported while a button is held, selecting items by direction, turbo mode, and hover
+   * mode only work close to the menu items.
+   */
+  x11ShapeMenuWindow: z.boolean().default(false),
+
+  /**
+   * On X11, items which focus a window and still use the default icon of this action can
+   * show the icon or a thumbnail of the matching window instead. The images are fetched
+   * after the menu has been shown.
+   */
+  x11FocusWindowItemImages: z.enum(['none', 'icon', 'thumbnail']).default('none'),
+
   /**
    * If enabled, pressing 'cmd + ,' on macOS or 'ctrl + ,' on Linux or Windows will open
    * the settings window. If disabled, the default hotkey will be ignored.
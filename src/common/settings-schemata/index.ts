@@ -24,6 +24,7 @@ export type {
   OpenURIActionV2 as OpenURIAction,
   SetClipboardActionV2 as SetClipboardAction,
   SimulateHotkeyActionV2 as SimulateHotkeyAction,
+  TypeTextActionV2 as TypeTextAction,
   DelayActionV2 as DelayAction,
   MenuConditionsV2 as MenuConditions,
   MacroEventV2 as MacroEvent,
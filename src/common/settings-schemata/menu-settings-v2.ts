@@ -135,6 +135,14 @@ export const SIMULATE_HOTKEY_ACTION_SCHEMA_V2 = z.object({
   hotkey: z.string(),
 });
 
+/** This action will type some text when triggered. */
+export const TYPE_TEXT_ACTION_SCHEMA_V2 = z.object({
+  type: z.literal('type-text'),
+
+  /** The text to type. */
+  text: z.string(),
+});
+
 /** This type describes the possible actions that can be performed in a workflow. */
 export const WORKFLOW_ACTION_SCHEMA_V2 = z.discriminatedUnion('type', [
   CLOSE_MENU_ACTION_SCHEMA_V2,
@@ -150,6 +158,7 @@ export const WORKFLOW_ACTION_SCHEMA_V2 = z.discriminatedUnion('type', [
   OPEN_URI_ACTION_SCHEMA_V2,
   SET_CLIPBOARD_ACTION_SCHEMA_V2,
   SIMULATE_HOTKEY_ACTION_SCHEMA_V2,
+  TYPE_TEXT_ACTION_SCHEMA_V2,
 ]);
 
 /** This type describes a workflow for a menu item is triggered when it is selected. */
@@ -272,6 +281,23 @@ export const MENU_CONDITIONS_SCHEMA_V2 = z.object({
   /** Regex to match for an application name. */
   appName: z.string().optional(),
 
+  /**
+   * Regex to match for the command line of the process owning the window. It starts with
+   * the path of the executable, followed by the arguments separated by spaces. This
+   * allows distinguishing apps which share the same application name, like Electron apps.
+   * It is only available on some backends.
+   */
+  commandLine: z.string().optional(),
+
+  /**
+   * Regex to match for the application name of the window under the pointer. This may
+   * differ from the focused window. It is only available on some backends.
+   */
+  hoveredAppName: z.string().optional(),
+
+  /** Regex to match for the title of the window under the pointer. */
+  hoveredWindowName: z.string().optional(),
+
   /**
    * Cursor position to match. In pixels relative to the top-left corner of the primary
    * display.
@@ -424,6 +450,7 @@ export type OpenSettingsActionV2 = z.infer<typeof OPEN_SETTINGS_ACTION_SCHEMA_V2
 export type OpenURIActionV2 = z.infer<typeof OPEN_URI_ACTION_SCHEMA_V2>;
 export type SetClipboardActionV2 = z.infer<typeof SET_CLIPBOARD_ACTION_SCHEMA_V2>;
 export type SimulateHotkeyActionV2 = z.infer<typeof SIMULATE_HOTKEY_ACTION_SCHEMA_V2>;
+export type TypeTextActionV2 = z.infer<typeof TYPE_TEXT_ACTION_SCHEMA_V2>;
 export type DelayActionV2 = z.infer<typeof DELAY_ACTION_SCHEMA_V2>;
 
 export type RootMenuItemV2 = z.infer<typeof ROOT_MENU_ITEM_SCHEMA_V2>;
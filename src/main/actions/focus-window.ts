@@ -8,7 +8,7 @@
 // SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
 // SPDX-License-Identifier: MIT
 
-import { FocusWindowAction } from '../../common';
+import { FocusWindowAction, WindowDescription } from '../../common';
 import { KandoApp } from '../app';
 import { DeepReadonly } from '../settings';
 
@@ -38,6 +38,27 @@ function testStringCondition(condition: string, value: string) {
   return value.toLowerCase().includes(condition.toLowerCase());
 }
 
+/**
+ * Returns the first of the given windows which matches the app name and the window name
+ * of the given action. Backends which know the order in which the windows were used
+ * return the most recently used windows first. So the first match is the window the user
+ * most likely wants to focus.
+ *
+ * @param action The action which describes the window.
+ * @param windows The open windows as reported by the backend.
+ * @returns The matching window or undefined if there is none.
+ */
+export function findMatchingWindow(
+  action: DeepReadonly<FocusWindowAction>,
+  windows: WindowDescription[]
+) {
+  return windows.find(
+    (window) =>
+      testStringCondition(action.appName, window.appName) &&
+      testStringCondition(action.windowName, window.windowName)
+  );
+}
+
 /**
  * This action will focus a matching application window.
  *
@@ -53,15 +74,11 @@ export async function execute(action: DeepReadonly<FocusWindowAction>, app: Kand
   }
 
   const openWindows = await app.getBackend().getOpenWindows();
+  const window = findMatchingWindow(action, openWindows);
 
-  for (const window of openWindows) {
-    if (
-      testStringCondition(action.appName, window.appName) &&
-      testStringCondition(action.windowName, window.windowName)
-    ) {
-      await app.getBackend().focusWindow(window);
-      return;
-    }
+  if (window) {
+    await app.getBackend().focusWindow(window);
+    return;
   }
 
   console.warn(`No window found for action ${JSON.stringify(action)}`);
@@ -11,18 +11,26 @@
 import clipboard from 'clipboardy';
 
 import { SetClipboardAction } from '../../common';
+import { KandoApp } from '../app';
 import { DeepReadonly } from '../settings';
 
 /**
- * Stores the given text in the clipboard.
+ * Stores the given text in the clipboard. If the backend can own the clipboard itself,
+ * the text is served by the backend. Else the clipboard module is used.
  *
  * @param action The action for which the clipboard text should be set.
+ * @param app The app which executed the action.
  */
-export async function execute(action: DeepReadonly<SetClipboardAction>) {
+export async function execute(action: DeepReadonly<SetClipboardAction>, app: KandoApp) {
   if (!action.text) {
     return;
   }
 
+  const entries = [{ mimeType: 'text/plain', data: action.text }];
+  if (await app.getBackend().setClipboard(entries)) {
+    return;
+  }
+
   // Since Electron 33, the clipboard API seems to be broken on Wayland. Hence, we use
   // the clipboardy package instead.
   clipboard.writeSync(action.text);
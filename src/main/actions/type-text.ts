@@ -0,0 +1,31 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/menu/kando           //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+import { TypeTextAction } from '../../common';
+import { KandoApp } from '../app';
+import { DeepReadonly } from '../settings';
+
+/**
+ * Types the given text into the focused window. The backend looks up the keys in the
+ * current keyboard layout, so the text does not depend on the layout.
+ *
+ * @param action The action for which the text should be typed.
+ * @param app The app which executed the action.
+ * @returns A promise which resolves when the text has been typed.
+ */
+export async function execute(action: DeepReadonly<TypeTextAction>, app: KandoApp) {
+  if (!action.text) {
+    return;
+  }
+
+  if (!(await app.getBackend().simulateText(action.text))) {
+    throw new Error('Typing text is not supported by the current backend.');
+  }
+}
@@ -101,6 +101,9 @@ export class KandoApp {
   /** This will cache the icon themes. */
   private iconThemesCache?: IconThemesInfo;
 
+  /** This will cache the description of the current menu theme. */
+  private menuThemeCache?: { theme: string; description: Promise<MenuThemeDescription> };
+
   /** Flag to indicate if the app is quitting. */
   private isQuitting = false;
 
@@ -484,9 +487,41 @@ export class KandoApp {
    * respective button in the settings is pressed.
    */
   public reloadMenuTheme() {
+    delete this.menuThemeCache;
     this.menuWindow?.webContents.send('menu-window.reload-menu-theme');
   }
 
+  /**
+   * Returns the description of the current menu theme. The description is cached until
+   * the menu theme is reloaded or another theme is selected. If loading fails, the cache
+   * entry is dropped again.
+   *
+   * @returns The description of the menu theme.
+   */
+  public getMenuThemeDescription() {
+    const useDarkVariant =
+      this.generalSettings.get('enableDarkModeForMenuThemes') &&
+      nativeTheme.shouldUseDarkColors;
+    const theme = this.generalSettings.get(
+      useDarkVariant ? 'darkMenuTheme' : 'menuTheme'
+    );
+
+    if (this.menuThemeCache?.theme !== theme) {
+      const cache = { theme, description: this.loadMenuThemeDescription(theme) };
+
+      // A theme which failed to load is tried again the next time.
+      cache.description.catch(() => {
+        if (this.menuThemeCache === cache) {
+          delete this.menuThemeCache;
+        }
+      });
+
+      this.menuThemeCache = cache;
+    }
+
+    return this.menuThemeCache.description;
+  }
+
   /**
    * This is called when the --reload-sound-theme command line option is passed or when
    * the respective button in the settings is pressed.
@@ -756,6 +791,15 @@ export class KandoApp {
       return this.backend.getInstalledApps();
     });
 
+    // Allow the renderer to record macros with the exact timing of the key strokes.
+    ipcMain.handle('settings-window.start-macro-recording', () => {
+      return this.backend.startMacroRecording();
+    });
+
+    ipcMain.handle('settings-window.stop-macro-recording', () => {
+      return this.backend.stopMacroRecording();
+    });
+
     // Allow the renderer to retrieve the current level progress.
     ipcMain.handle('settings-window.get-level-progress', () => {
       return this.achievementTracker.getProgress();
@@ -1184,12 +1228,7 @@ export class KandoApp {
     // Allow the renderer to retrieve the description of the current menu theme. We also
     // return the path to the CSS file of the theme, so that the renderer can load it.
     ipcMain.handle('common.get-menu-theme', async () => {
-      const useDarkVariant =
-        this.generalSettings.get('enableDarkModeForMenuThemes') &&
-        nativeTheme.shouldUseDarkColors;
-      return this.loadMenuThemeDescription(
-        this.generalSettings.get(useDarkVariant ? 'darkMenuTheme' : 'menuTheme')
-      );
+      return this.getMenuThemeDescription();
     });
 
     // Allow the renderer to retrieve the current menu theme override colors. We return
@@ -1687,6 +1726,7 @@ export class KandoApp {
       drawCenterText: parsed.drawCenterText ?? true,
       drawSelectionWedges: parsed.drawSelectionWedges ?? false,
       drawWedgeSeparators: parsed.drawWedgeSeparators ?? false,
+      backdropBlur: parsed.backdropBlur ?? 0,
     };
 
     return description;
@@ -15,12 +15,15 @@ import mime from 'mime-types';
 
 import {
   BackendInfo,
+  ClipboardEntry,
   KeySequence,
   WMInfo,
   MenuItem,
   AppDescription,
   WindowDescription,
+  WindowImage,
   GeneralSettings,
+  MenuShape,
 } from '../../common';
 import { Settings } from '../settings';
 
@@ -32,7 +35,13 @@ import { Settings } from '../settings';
  * to get information about the currently focused window.
  *
  * If a global shortcut is activated, it will emit the 'shortcutPressed' event with the
- * activated shortcut as the first argument.
+ * activated shortcut as the first argument. Backends which can observe the release of a
+ * shortcut regardless of the input focus may also emit the 'shortcutReleased' event once
+ * the key and all modifiers of a shortcut have been released.
+ *
+ * Backends which can observe the window manager may also emit the 'activeWindowChanged'
+ * event with the newly focused WindowDescription (or null) and the 'windowsChanged' event
+ * with a list of all open windows.
  *
  * See index.ts for information about how the backend is selected.
  */
@@ -99,6 +108,106 @@ export abstract class Backend extends EventEmitter {
    */
   public abstract focusWindow(window: WindowDescription): Promise<void>;
 
+  /**
+   * Backends can provide the icon of an open window. The icon is scaled down to be at
+   * most `size` pixels wide and high, but it is never scaled up. The default
+   * implementation returns null.
+   *
+   * @param window The window to get the icon of.
+   * @param size The desired size of the icon in pixels.
+   * @returns A promise which resolves to the icon or to null if there is none.
+   */
+  // eslint-disable-next-line @typescript-eslint/no-unused-vars
+  public async getWindowIcon(
+    window: WindowDescription,
+    size: number
+  ): Promise<WindowImage | null> {
+    return null;
+  }
+
+  /**
+   * Backends can provide thumbnails of open windows. All thumbnails are requested in one
+   * batch so that backends can capture them together. They are scaled down to be at most
+   * `size` pixels wide and high. The default implementation returns null for each
+   * window.
+   *
+   * @param windows The windows to get the thumbnails of.
+   * @param size The desired size of the thumbnails in pixels.
+   * @returns A promise which resolves to one thumbnail per window. A thumbnail is null if
+   *   the window could not be captured.
+   */
+  // eslint-disable-next-line @typescript-eslint/no-unused-vars
+  public async getWindowThumbnails(
+    windows: WindowDescription[],
+    size: number
+  ): Promise<Array<WindowImage | null>> {
+    return windows.map(() => null);
+  }
+
+  /**
+   * Backends can capture the screen content in the given rectangle and blur it. This is
+   * used for the backdrop of the menu, so it is called before the menu window is shown.
+   * The result is usually smaller than the rectangle and has to be scaled up. The default
+   * implementation returns null.
+   *
+   * @param region The rectangle to capture in screen coordinates.
+   * @param sigma The standard deviation of the blur in pixels.
+   * @returns A promise which resolves to the blurred image or to null if the screen could
+   *   not be captured.
+   */
+  // eslint-disable-next-line @typescript-eslint/no-unused-vars
+  public async captureBackdrop(
+    region: Electron.Rectangle,
+    sigma: number
+  ): Promise<WindowImage | null> {
+    return null;
+  }
+
+  /**
+   * Backends can restrict the visible and clickable area of the menu window to the area
+   * which is actually covered by the menu. This way, the compositor does not have to
+   * redraw the entire window during animations and clicks outside of the menu reach the
+   * windows below. This is called whenever a submenu is opened or closed. As the menu
+   * does not see these clicks, the menu window closes the menu when it loses the focus
+   * while it is shaped. The default implementation does nothing.
+   *
+   * @param windowHandle The native window handle of the menu window as returned by
+   *   getNativeWindowHandle().
+   * @param shape The area covered by the menu in logical screen pixels relative to the
+   *   window, or null to make the whole window visible and clickable again.
+   * @returns A promise which resolves to true if the shape has been applied.
+   */
+  // eslint-disable-next-line @typescript-eslint/no-unused-vars
+  public async setMenuWindowShape(
+    windowHandle: Buffer,
+    shape: MenuShape | null
+  ): Promise<boolean> {
+    return false;
+  }
+
+  /**
+   * Backends can record key events system-wide. This is used by the settings window to
+   * record macros for the execute-macro action with the exact timing of the key strokes.
+   * Recording must not block the main thread. The default implementation does not
+   * support recording.
+   *
+   * @returns A promise which resolves to true if the recording has been started.
+   */
+  public async startMacroRecording(): Promise<boolean> {
+    return false;
+  }
+
+  /**
+   * Stops a recording started with startMacroRecording(). The delay of each key stroke
+   * is the time since the previous one. The default implementation returns null.
+   *
+   * @returns A promise which resolves to the recorded key strokes or to null if nothing
+   *   has been recorded.
+   */
+  public async stopMacroRecording(): Promise<KeySequence | null> {
+    return null;
+  }
+
   /**
    * Each backend must provide a way to get a list of all installed applications. This is
    * used by the settings window to populate the list of available applications.
@@ -209,6 +318,40 @@ export abstract class Backend extends EventEmitter {
     await this.simulateKeysImpl(keys);
   }
 
+  /**
+   * Backends can type arbitrary text into the focused window. This is used by the
+   * type-text action. The keys should be looked up in the active keyboard layout so that
+   * the text is typed correctly regardless of the layout. The default implementation
+   * does not support typing text.
+   *
+   * @param text The text to type.
+   * @returns A promise which resolves to true if the text has been typed.
+   */
+  // eslint-disable-next-line @typescript-eslint/no-unused-vars
+  public async simulateText(text: string): Promise<boolean> {
+    return false;
+  }
+
+  /**
+   * Backends can take ownership of the clipboard natively. This is used by the
+   * set-clipboard action. The content should be served by the backend itself, so that it
+   * stays available while Kando's windows are hidden and large payloads do not block the
+   * main process. The default implementation does not support this, the caller then
+   * falls back to the clipboard module.
+   *
+   * @param entries The representations of the content, for example text/plain and
+   *   text/html.
+   * @param primary If true, the primary selection is set instead of the clipboard.
+   * @returns A promise which resolves to true if the clipboard has been set.
+   */
+  // eslint-disable-next-line @typescript-eslint/no-unused-vars
+  public async setClipboard(
+    entries: ClipboardEntry[],
+    primary = false
+  ): Promise<boolean> {
+    return false;
+  }
+
   /**
    * This binds the given shortcuts globally. What the shortcut strings look like depends
    * on the backend:
@@ -323,6 +466,17 @@ export abstract class Backend extends EventEmitter {
     this.emit('shortcutPressed', shortcut);
   }
 
+  /**
+   * Derived backends can call this method when a global shortcut has been released. This
+   * is also called for inhibited shortcuts.
+   *
+   * @param shortcut The shortcut that was released. This should be the same string as
+   *   used in the bindShortcuts method.
+   */
+  protected onShortcutReleased(shortcut: string): void {
+    this.emit('shortcutReleased', shortcut);
+  }
+
   /**
    * This method is called by the bind-shortcuts and inhibit-shortcuts methods above to
    * actually bind the shortcuts. The implementation in this class uses Electron's
@@ -12,10 +12,10 @@ import * as os from 'os';
 import * as path from 'path';
 import * as fs from 'fs';
 import { readIniFile, readIniFileSync } from 'read-ini-file';
-import { execSync } from 'child_process';
 import { isexe } from 'isexe';
 
 import { Backend } from '../backend';
+import { getCurrentIconTheme } from './icon-theme';
 import { MenuItem, AppDescription, ActionTypeRegistry } from '../../../common';
 
 /**
@@ -125,7 +125,7 @@ export abstract class LinuxBackend extends Backend {
    * @returns A map of icon names to their CSS image sources.
    */
   public override async getSystemIcons(): Promise<Map<string, string>> {
-    this.currentTheme = await this.getCurrentIconTheme();
+    this.currentTheme = await getCurrentIconTheme(this.getNativeIconTheme());
     const allThemeDirectories = await this.getThemeDirectoriesRecursively(
       this.currentTheme
     );
@@ -145,7 +145,7 @@ export abstract class LinuxBackend extends Backend {
    *   reloaded.
    */
   public override async systemIconsChanged(): Promise<boolean> {
-    const newTheme = await this.getCurrentIconTheme();
+    const newTheme = await getCurrentIconTheme(this.getNativeIconTheme());
     return newTheme !== this.currentTheme;
   }
 
@@ -263,101 +263,13 @@ export abstract class LinuxBackend extends Backend {
   }
 
   /**
-   * This method retrieves the current icon theme from the system. It checks various
-   * desktop environments (GNOME, KDE, XFCE) and their respective configuration files to
-   * find the currently set icon theme. If no specific theme is found, it defaults to
-   * 'hicolor', which is a standard fallback theme according to the Freedesktop Icon Theme
-   * Specification.
-   *
-   * @returns A promise that resolves to the name of the current icon theme as a string.
+   * Derived backends can override this to provide the current icon theme without
+   * spawning any process. This is called whenever a menu is shown, so it should be
+   * cheap. If this returns null, the icon theme is read from the settings of the desktop
+   * environment.
    */
-  private async getCurrentIconTheme(): Promise<string> {
-    // Check the environment variable first.
-    if (process.env.ICON_THEME) {
-      return process.env.ICON_THEME;
-    }
-
-    const home = os.homedir();
-
-    // If we are inside a flatpak container, we cannot execute commands directly on the
-    // host. Instead we need to use flatpak-spawn.
-    let commandPrefix = '';
-    if (process.env.container && process.env.container === 'flatpak') {
-      commandPrefix = 'flatpak-spawn --host ';
-    }
-
-    const tryGNOME = () => {
-      try {
-        const output = execSync(
-          commandPrefix + 'gsettings get org.gnome.desktop.interface icon-theme',
-          {
-            encoding: 'utf8',
-          }
-        ).trim();
-        return output.replace(/^'|'$/g, ''); // remove surrounding quotes
-      } catch {
-        return null;
-      }
-    };
-
-    const tryKDE = async () => {
-      const kdeFile = path.join(home, '.config', 'kdeglobals');
-      if (!fs.existsSync(kdeFile)) {
-        return null;
-      }
-      try {
-        const data = (await readIniFile(kdeFile)) as {
-          ['Icons']?: { ['Theme']?: string };
-        };
-        return data?.Icons?.Theme || null;
-      } catch {
-        return null;
-      }
-    };
-
-    const tryXFCE = () => {
-      try {
-        const output = execSync(
-          commandPrefix + 'xfconf-query -c xsettings -p /Net/IconThemeName',
-          {
-            encoding: 'utf8',
-          }
-        ).trim();
-        return output || null;
-      } catch {
-        return null;
-      }
-    };
-
-    const tryGTKSettings = async () => {
-      const gtkFile = path.join(home, '.config', 'gtk-3.0', 'settings.ini');
-      if (!fs.existsSync(gtkFile)) {
-        return null;
-      }
-      try {
-        const data = (await readIniFile(gtkFile)) as {
-          ['Settings']?: { ['gtk-icon-theme-name']?: string };
-        };
-        return data?.Settings?.['gtk-icon-theme-name'] || null;
-      } catch {
-        return null;
-      }
-    };
-
-    const desktop = process.env.XDG_CURRENT_DESKTOP || '';
-
-    switch (desktop.toLowerCase()) {
-      case 'gnome':
-        return tryGNOME() || (await tryGTKSettings()) || 'hicolor';
-      case 'kde':
-        return (await tryKDE()) || (await tryGTKSettings()) || 'hicolor';
-      case 'xfce':
-        return tryXFCE() || (await tryGTKSettings()) || 'hicolor';
-    }
-
-    return (
-      tryGNOME() || (await tryKDE()) || tryXFCE() || (await tryGTKSettings()) || 'hicolor'
-    );
+  protected getNativeIconTheme(): string | null {
+    return null;
   }
 
   /**
@@ -61,10 +61,15 @@ for more information.
         this.onShortcutPressed(shortcutID);
       }
     });
+
+    // Keep track of the focused window.
+    this.watchWindows();
   }
 
-  /** Nothing to be done here. */
-  public async deinit() {}
+  /** We only need to stop tracking the windows. */
+  public async deinit() {
+    this.unwatchWindows();
+  }
 
   /**
    * This uses the hyprctl commandline tool to get the current pointer position and the
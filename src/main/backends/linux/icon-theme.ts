@@ -0,0 +1,124 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+import * as os from 'os';
+import * as path from 'path';
+import * as fs from 'fs';
+import { readIniFile } from 'read-ini-file';
+import { execSync } from 'child_process';
+
+/**
+ * This retrieves the current icon theme from the system. If the backend could read the
+ * icon theme without spawning a process, for instance from the XSETTINGS manager on
+ * X11, it should be passed as nativeIconTheme. Else this checks various desktop
+ * environments (GNOME, KDE, XFCE) and their respective configuration files to find the
+ * currently set icon theme. Note that this spawns `gsettings` or `xfconf-query` on GNOME
+ * and XFCE which blocks the calling thread. If no specific theme is found, it defaults
+ * to 'hicolor', which is a standard fallback theme according to the Freedesktop Icon
+ * Theme Specification.
+ *
+ * @param nativeIconTheme The icon theme as reported by the backend or null.
+ * @returns A promise that resolves to the name of the current icon theme as a string.
+ */
+export async function getCurrentIconTheme(
+  nativeIconTheme: string | null
+): Promise<string> {
+  // Check the environment variable first.
+  if (process.env.ICON_THEME) {
+    return process.env.ICON_THEME;
+  }
+
+  // If the backend knows the icon theme, there is no need to look any further.
+  if (nativeIconTheme) {
+    return nativeIconTheme;
+  }
+
+  const home = os.homedir();
+
+  // If we are inside a flatpak container, we cannot execute commands directly on the
+  // host. Instead we need to use flatpak-spawn.
+  let commandPrefix = '';
+  if (process.env.container && process.env.container === 'flatpak') {
+    commandPrefix = 'flatpak-spawn --host ';
+  }
+
+  const tryGNOME = () => {
+    try {
+      const output = execSync(
+        commandPrefix + 'gsettings get org.gnome.desktop.interface icon-theme',
+        {
+          encoding: 'utf8',
+        }
+      ).trim();
+      return output.replace(/^'|'$/g, ''); // remove surrounding quotes
+    } catch {
+      return null;
+    }
+  };
+
+  const tryKDE = async () => {
+    const kdeFile = path.join(home, '.config', 'kdeglobals');
+    if (!fs.existsSync(kdeFile)) {
+      return null;
+    }
+    try {
+      const data = (await readIniFile(kdeFile)) as {
+        ['Icons']?: { ['Theme']?: string };
+      };
+      return data?.Icons?.Theme || null;
+    } catch {
+      return null;
+    }
+  };
+
+  const tryXFCE = () => {
+    try {
+      const output = execSync(
+        commandPrefix + 'xfconf-query -c xsettings -p /Net/IconThemeName',
+        {
+          encoding: 'utf8',
+        }
+      ).trim();
+      return output || null;
+    } catch {
+      return null;
+    }
+  };
+
+  const tryGTKSettings = async () => {
+    const gtkFile = path.join(home, '.config', 'gtk-3.0', 'settings.ini');
+    if (!fs.existsSync(gtkFile)) {
+      return null;
+    }
+    try {
+      const data = (await readIniFile(gtkFile)) as {
+        ['Settings']?: { ['gtk-icon-theme-name']?: string };
+      };
+      return data?.Settings?.['gtk-icon-theme-name'] || null;
+    } catch {
+      return null;
+    }
+  };
+
+  const desktop = process.env.XDG_CURRENT_DESKTOP || '';
+
+  switch (desktop.toLowerCase()) {
+    case 'gnome':
+      return tryGNOME() || (await tryGTKSettings()) || 'hicolor';
+    case 'kde':
+      return (await tryKDE()) || (await tryGTKSettings()) || 'hicolor';
+    case 'xfce':
+      return tryXFCE() || (await tryGTKSettings()) || 'hicolor';
+  }
+
+  return (
+    tryGNOME() || (await tryKDE()) || tryXFCE() || (await tryGTKSettings()) || 'hicolor'
+  );
+}
@@ -0,0 +1,178 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "Blur.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The image is scaled down until the standard deviation is about this many pixels. Less
+// looks blocky once the result is scaled up again, more makes the box blurs slower.
+constexpr double   TARGET_SIGMA  = 2.0;
+constexpr uint32_t MAX_DOWNSCALE = 16;
+
+// Three box blurs of the same width approximate a Gaussian.
+constexpr int BOX_PASSES = 3;
+
+// Scales the image down by averaging boxes of source pixels and converts it to RGBA.
+void downscale(uint8_t const* pixels, uint32_t width, uint32_t height, size_t stride,
+    bool swapRedBlue, BlurredImage& image) {
+
+  int const red  = swapRedBlue ? 0 : 2;
+  int const blue = swapRedBlue ? 2 : 0;
+
+  for (uint32_t y = 0; y < image.height; ++y) {
+    uint32_t y0 = uint64_t(y) * height / image.height;
+    uint32_t y1 = uint64_t(y + 1) * height / image.height;
+
+    for (uint32_t x = 0; x < image.width; ++x) {
+      uint32_t x0 = uint64_t(x) * width / image.width;
+      uint32_t x1 = uint64_t(x + 1) * width / image.width;
+
+      uint32_t sums[3] = {0, 0, 0};
+
+      for (uint32_t sy = y0; sy < y1; ++sy) {
+        uint8_t const* row = pixels + sy * stride;
+        for (uint32_t sx = x0; sx < x1; ++sx) {
+          sums[0] += row[sx * 4 + red];
+          sums[1] += row[sx * 4 + 1];
+          sums[2] += row[sx * 4 + blue];
+        }
+      }
+
+      uint32_t count = (x1 - x0) * (y1 - y0);
+      uint8_t* out   = image.rgba.data() + (size_t(y) * image.width + x) * 4;
+      out[0]         = uint8_t((sums[0] + count / 2) / count);
+      out[1]         = uint8_t((sums[1] + count / 2) / count);
+      out[2]         = uint8_t((sums[2] + count / 2) / count);
+      out[3]         = 255;
+    }
+  }
+}
+
+// Blurs a line of RGBA pixels with a box of the given radius. The pixels are step bytes
+// apart, so this can be used for rows and columns. Pixels beyond the ends of the line
+// are clamped to the first and last pixel.
+void boxBlurLine(
+    uint8_t const* in, uint8_t* out, uint32_t count, size_t step, uint32_t radius) {
+
+  auto at = [&](int64_t i) {
+    return in + size_t(std::clamp<int64_t>(i, 0, count - 1)) * step;
+  };
+
+#if defined(__SSE2__)
+  __m128i const zero  = _mm_setzero_si128();
+  __m128 const  scale = _mm_set1_ps(1.f / float(2 * radius + 1));
+
+  // Loads one pixel into four 32-bit lanes.
+  auto load = [&](uint8_t const* pixel) {
+    int32_t value;
+    std::memcpy(&value, pixel, 4);
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+  };
+
+  __m128i sum = zero;
+  for (int64_t i = -int64_t(radius); i <= int64_t(radius); ++i) {
+    sum = _mm_add_epi32(sum, load(at(i)));
+  }
+
+  for (uint32_t x = 0; x < count; ++x) {
+    __m128i average = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(sum), scale));
+    average         = _mm_packus_epi16(_mm_packs_epi32(average, zero), zero);
+
+    int32_t value = _mm_cvtsi128_si32(average);
+    std::memcpy(out + x * step, &value, 4);
+
+    sum = _mm_add_epi32(sum, load(at(int64_t(x) + radius + 1)));
+    sum = _mm_sub_epi32(sum, load(at(int64_t(x) - radius)));
+  }
+#else
+  uint32_t const size    = 2 * radius + 1;
+  uint32_t       sums[4] = {0, 0, 0, 0};
+
+  for (int64_t i = -int64_t(radius); i <= int64_t(radius); ++i) {
+    for (int c = 0; c < 4; ++c) {
+      sums[c] += at(i)[c];
+    }
+  }
+
+  for (uint32_t x = 0; x < count; ++x) {
+    uint8_t const* next = at(int64_t(x) + radius + 1);
+    uint8_t const* last = at(int64_t(x) - radius);
+
+    for (int c = 0; c < 4; ++c) {
+      out[x * step + c] = uint8_t((sums[c] + size / 2) / size);
+      sums[c] += next[c];
+      sums[c] -= last[c];
+    }
+  }
+#endif
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+BlurredImage blurImage(uint8_t const* pixels, uint32_t width, uint32_t height,
+    size_t stride, double sigma, bool swapRedBlue) {
+
+  BlurredImage image;
+
+  if (width == 0 || height == 0) {
+    return image;
+  }
+
+  // First, we scale the image down. The blur is done at the reduced resolution.
+  uint32_t factor = std::clamp(uint32_t(sigma / TARGET_SIGMA), 1u, MAX_DOWNSCALE);
+  sigma /= factor;
+
+  image.width  = std::max(1u, width / factor);
+  image.height = std::max(1u, height / factor);
+  image.rgba.resize(size_t(image.width) * image.height * 4);
+
+  downscale(pixels, width, height, stride, swapRedBlue, image);
+
+  // The variance of a box blur of width w is (w * w - 1) / 12. The variances of the
+  // passes add up, so this is the width for which they sum up to sigma * sigma.
+  double   boxWidth = std::sqrt(12.0 * sigma * sigma / BOX_PASSES + 1.0);
+  uint32_t radius   = uint32_t(std::lround((boxWidth - 1.0) / 2.0));
+
+  if (radius == 0) {
+    return image;
+  }
+
+  size_t const         rowStep = size_t(image.width) * 4;
+  std::vector<uint8_t> buffer(image.rgba.size());
+
+  for (int pass = 0; pass < BOX_PASSES; ++pass) {
+    for (uint32_t y = 0; y < image.height; ++y) {
+      boxBlurLine(image.rgba.data() + y * rowStep, buffer.data() + y * rowStep,
+          image.width, 4, radius);
+    }
+
+    for (uint32_t x = 0; x < image.width; ++x) {
+      boxBlurLine(buffer.data() + x * 4, image.rgba.data() + x * 4, image.height,
+          rowStep, radius);
+    }
+  }
+
+  return image;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
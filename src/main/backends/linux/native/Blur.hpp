@@ -0,0 +1,42 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef BLUR_HPP
+#define BLUR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** An opaque image with 8-bit RGBA pixels. */
+struct BlurredImage {
+  uint32_t             width  = 0;
+  uint32_t             height = 0;
+  std::vector<uint8_t> rgba;
+};
+
+/**
+ * Blurs a screen capture for use as the backdrop of the menu. The pixels are 32-bit
+ * little-endian XRGB values as delivered by X11 and by wl_shm, so blue is the first byte
+ * in memory. If swapRedBlue is set, red is the first byte instead. The upper byte is
+ * ignored.
+ *
+ * The blur approximates a Gaussian with the given standard deviation in pixels by three
+ * successive box blurs in each direction. As the result is blurry anyway, the image is
+ * first scaled down so that the standard deviation is only a few pixels at the reduced
+ * resolution. This makes the cost mostly independent of the blur radius. The returned
+ * image is therefore smaller than the input and has to be scaled up for display.
+ *
+ * The box blurs use SSE2 if available.
+ */
+BlurredImage blurImage(uint8_t const* pixels, uint32_t width, uint32_t height,
+    size_t stride, double sigma, bool swapRedBlue = false);
+
+#endif // BLUR_HPP
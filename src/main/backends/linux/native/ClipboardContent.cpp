@@ -0,0 +1,93 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "ClipboardContent.hpp"
+#include "Utf8.hpp"
+
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Other clients may ask for UTF-8 text with any of these names. STRING is not included
+// as it denotes Latin-1 text on X11, it is offered separately.
+const char* const TEXT_TARGETS[] = {
+    "text/plain;charset=utf-8", "text/plain", "UTF8_STRING", "TEXT"};
+
+const char* const LATIN1_TARGET = "STRING";
+
+bool isText(std::string const& mimeType) {
+  return std::find(std::begin(TEXT_TARGETS), std::end(TEXT_TARGETS), mimeType) !=
+         std::end(TEXT_TARGETS);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<ClipboardOffer> getClipboardOffers(
+    std::vector<ClipboardEntry> const& entries) {
+  std::vector<ClipboardOffer> offers;
+
+  auto add = [&offers](std::string const& target, size_t entry, bool latin1 = false) {
+    auto it = std::find_if(offers.begin(), offers.end(),
+        [&target](ClipboardOffer const& offer) { return offer.target == target; });
+
+    if (it == offers.end()) {
+      offers.push_back({target, entry, latin1});
+    }
+  };
+
+  // The explicit MIME types come first so that they take precedence over the aliases.
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (!entries[i].mimeType.empty()) {
+      add(entries[i].mimeType, i);
+    }
+  }
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (isText(entries[i].mimeType)) {
+      for (const char* target : TEXT_TARGETS) {
+        add(target, i);
+      }
+
+      add(LATIN1_TARGET, i, true);
+    }
+  }
+
+  return offers;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void convertLatin1Offers(
+    std::vector<ClipboardEntry>& entries, std::vector<ClipboardOffer>& offers) {
+  for (auto& offer : offers) {
+    if (offer.latin1) {
+      entries.push_back({offer.target, toLatin1(entries[offer.entry].data)});
+      offer.entry  = entries.size() - 1;
+      offer.latin1 = false;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::string toLatin1(std::string const& text) {
+  std::string result;
+  result.reserve(text.size());
+
+  for (char32_t codepoint : decodeUtf8(text)) {
+    result.push_back(codepoint <= 0xFF ? static_cast<char>(codepoint) : '?');
+  }
+
+  return result;
+}
@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CLIPBOARD_CONTENT_HPP
+#define CLIPBOARD_CONTENT_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/** A single representation of the clipboard content, like plain text or HTML. */
+struct ClipboardEntry {
+  std::string mimeType;
+  std::string data;
+};
+
+/** A target under which the clipboard content is offered to other clients. */
+struct ClipboardOffer {
+  std::string target;
+
+  // The index of the entry which is sent if this target is requested.
+  size_t entry = 0;
+
+  // If true, the entry has to be converted to Latin-1 before it is sent.
+  bool latin1 = false;
+};
+
+/**
+ * Returns all targets under which the given entries should be offered. Each entry is
+ * offered under its own MIME type. Plain text is additionally offered under the names
+ * which older X11 and Wayland clients ask for, like UTF8_STRING or
+ * text/plain;charset=utf-8, unless another entry has been given for them explicitly.
+ * This includes STRING, for which the text has to be converted to Latin-1 first, see
+ * convertLatin1Offers(). Entries with an empty MIME type are skipped. If two entries
+ * have the same MIME type, the first one wins.
+ */
+std::vector<ClipboardOffer> getClipboardOffers(
+    std::vector<ClipboardEntry> const& entries);
+
+/**
+ * Appends a Latin-1 copy of the entry for each offer which requires one and redirects the
+ * offer to this copy. This has to be called once before the offers are served.
+ */
+void convertLatin1Offers(
+    std::vector<ClipboardEntry>& entries, std::vector<ClipboardOffer>& offers);
+
+/**
+ * Converts UTF-8 text to Latin-1. Characters which cannot be represented in Latin-1 are
+ * replaced with a question mark.
+ */
+std::string toLatin1(std::string const& text);
+
+#endif // CLIPBOARD_CONTENT_HPP
@@ -0,0 +1,243 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "ProcessCache.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <iterator>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The cache holds one pidfd per entry. Usually, only a handful of processes own
+// windows. If there are more entries, the ones of exited processes are removed.
+constexpr size_t MAX_ENTRIES = 256;
+
+// The command line of some processes is huge. We only read this many bytes.
+constexpr size_t MAX_COMMAND_LINE = 32 * 1024;
+
+// The start time is the 22nd field of /proc/<pid>/stat. The fields after the command
+// name in parentheses start with the third one.
+constexpr int START_TIME_FIELD = 22;
+
+std::string procPath(uint32_t pid, const char* file) {
+  return "/proc/" + std::to_string(pid) + "/" + file;
+}
+
+// Reads at most maxSize bytes of the given file. Returns nothing if it cannot be opened.
+std::optional<std::string> readFile(std::string const& path, size_t maxSize) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return std::nullopt;
+  }
+
+  std::string content;
+  char        buffer[4096];
+
+  while (content.size() < maxSize) {
+    ssize_t count = read(fd, buffer, sizeof(buffer));
+    if (count <= 0) {
+      break;
+    }
+
+    content.append(buffer, std::min(size_t(count), maxSize - content.size()));
+  }
+
+  close(fd);
+  return content;
+}
+
+int openPidfd(uint32_t pid) {
+#if defined(SYS_pidfd_open)
+  return int(syscall(SYS_pidfd_open, pid_t(pid), 0));
+#else
+  return -1;
+#endif
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<uint64_t> readProcessStartTime(uint32_t pid) {
+  std::optional<std::string> stat = readFile(procPath(pid, "stat"), 1024);
+  if (!stat) {
+    return std::nullopt;
+  }
+
+  // The command name may contain spaces and parentheses, so we search for the last
+  // closing parenthesis.
+  size_t position = stat->rfind(')');
+  if (position == std::string::npos) {
+    return std::nullopt;
+  }
+
+  for (int field = 2; field < START_TIME_FIELD && position != std::string::npos;
+      ++field) {
+    position = stat->find(' ', position + 1);
+  }
+
+  if (position == std::string::npos) {
+    return std::nullopt;
+  }
+
+  return std::strtoull(stat->c_str() + position + 1, nullptr, 10);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<ProcessInfo> readProcessInfo(uint32_t pid) {
+  std::optional<uint64_t> startTime = readProcessStartTime(pid);
+  if (!startTime) {
+    return std::nullopt;
+  }
+
+  ProcessInfo info;
+  info.pid       = pid;
+  info.startTime = *startTime;
+
+  // The link cannot be read for processes of other users. We still report the command
+  // line in this case.
+  char    path[PATH_MAX];
+  ssize_t length = readlink(procPath(pid, "exe").c_str(), path, sizeof(path));
+  if (length > 0) {
+    info.executable.assign(path, length);
+  }
+
+  // The arguments are separated by null characters.
+  std::string commandLine = readFile(procPath(pid, "cmdline"), MAX_COMMAND_LINE)
+                                .value_or("");
+  size_t start = 0;
+  while (start < commandLine.size()) {
+    size_t end = commandLine.find('\0', start);
+    if (end == std::string::npos) {
+      end = commandLine.size();
+    }
+
+    info.commandLine.push_back(commandLine.substr(start, end - start));
+    start = end + 1;
+  }
+
+  return info;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+ProcessCache::~ProcessCache() {
+  clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const ProcessInfo> ProcessCache::get(uint32_t pid) {
+  if (pid == 0) {
+    return nullptr;
+  }
+
+  auto it = mEntries.find(pid);
+  if (it != mEntries.end()) {
+    if (isAlive(it->second)) {
+      return it->second.info;
+    }
+
+    // The PID may have been reused by another process.
+    remove(it);
+  }
+
+  ++mLookups;
+
+  // The pidfd is opened before reading the process information. If the process is
+  // replaced in between, its start time changes, so we compare it afterwards.
+  int                        pidfd = openPidfd(pid);
+  std::optional<ProcessInfo> info  = readProcessInfo(pid);
+
+  if (!info || readProcessStartTime(pid) != info->startTime) {
+    if (pidfd >= 0) {
+      close(pidfd);
+    }
+
+    return nullptr;
+  }
+
+  if (mEntries.size() >= MAX_ENTRIES) {
+    prune();
+
+    if (mEntries.size() >= MAX_ENTRIES) {
+      clear();
+    }
+  }
+
+  Entry entry;
+  entry.info  = std::make_shared<const ProcessInfo>(std::move(*info));
+  entry.pidfd = pidfd;
+
+  return mEntries.emplace(pid, entry).first->second.info;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ProcessCache::clear() {
+  while (!mEntries.empty()) {
+    remove(mEntries.begin());
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t ProcessCache::getLookups() const {
+  return mLookups;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ProcessCache::isAlive(Entry const& entry) const {
+
+  // A pidfd becomes readable once the process has exited.
+  if (entry.pidfd >= 0) {
+    pollfd pfd = {.fd = entry.pidfd, .events = POLLIN};
+    return poll(&pfd, 1, 0) == 0;
+  }
+
+  return readProcessStartTime(entry.info->pid) == entry.info->startTime;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ProcessCache::remove(std::unordered_map<uint32_t, Entry>::iterator it) {
+  if (it->second.pidfd >= 0) {
+    close(it->second.pidfd);
+  }
+
+  mEntries.erase(it);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ProcessCache::prune() {
+  for (auto it = mEntries.begin(); it != mEntries.end();) {
+    if (isAlive(it->second)) {
+      ++it;
+    } else {
+      auto next = std::next(it);
+      remove(it);
+      it = next;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
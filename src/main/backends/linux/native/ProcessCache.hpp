@@ -0,0 +1,103 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef PROCESS_CACHE_HPP
+#define PROCESS_CACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** Information about a running process as read from /proc. */
+struct ProcessInfo {
+  uint32_t pid = 0;
+
+  /** The absolute path of the executable. Empty if it cannot be read. */
+  std::string executable;
+
+  /** The arguments the process was started with, including argv[0]. */
+  std::vector<std::string> commandLine;
+
+  /** The start time of the process in clock ticks since boot. */
+  uint64_t startTime = 0;
+};
+
+/**
+ * Returns the start time of the given process in clock ticks since boot as reported in
+ * /proc/<pid>/stat. Together with the PID, this identifies a process uniquely. Returns
+ * nothing if the process does not exist.
+ */
+std::optional<uint64_t> readProcessStartTime(uint32_t pid);
+
+/**
+ * Reads the executable and the command line of the given process from /proc. Returns
+ * nothing if the process does not exist.
+ */
+std::optional<ProcessInfo> readProcessInfo(uint32_t pid);
+
+/**
+ * This class caches the information about processes which own windows. Usually, the
+ * information of the same few processes is requested over and over again, and they
+ * hardly ever change.
+ *
+ * A cached entry is only valid as long as its process is alive, as the PID may be reused
+ * afterwards. For each entry, a pidfd is kept open. Checking whether the process is still
+ * alive is a single non-blocking poll() on this fd and does not require reading from
+ * /proc. On kernels without pidfd support, the start time of the process is read again
+ * from /proc/<pid>/stat and compared to the cached one instead.
+ *
+ * This class is not thread-safe.
+ */
+class ProcessCache {
+ public:
+  ProcessCache() = default;
+  ~ProcessCache();
+
+  ProcessCache(ProcessCache const& other)            = delete;
+  ProcessCache& operator=(ProcessCache const& other) = delete;
+
+  /**
+   * Returns the information about the given process. It is read from /proc if it is not
+   * cached yet or if the cached process has exited. Returns nullptr if there is no such
+   * process or if the PID is zero.
+   */
+  std::shared_ptr<const ProcessInfo> get(uint32_t pid);
+
+  /** Removes all entries and closes their pidfds. */
+  void clear();
+
+  /** Returns the number of /proc lookups so far. This is mostly useful for testing. */
+  uint32_t getLookups() const;
+
+ private:
+  struct Entry {
+    std::shared_ptr<const ProcessInfo> info;
+
+    // A pidfd of the process or -1 if pidfds are not supported.
+    int pidfd = -1;
+  };
+
+  // Returns true if the process of the given entry is still running.
+  bool isAlive(Entry const& entry) const;
+
+  // Removes the given entry and closes its pidfd.
+  void remove(std::unordered_map<uint32_t, Entry>::iterator it);
+
+  // Removes all entries whose process has exited.
+  void prune();
+
+  std::unordered_map<uint32_t, Entry> mEntries;
+  uint32_t                            mLookups = 0;
+};
+
+#endif // PROCESS_CACHE_HPP
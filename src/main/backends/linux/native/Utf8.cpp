@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "Utf8.hpp"
+
+#include <cstdint>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::u32string decodeUtf8(std::string const& text) {
+  const char32_t REPLACEMENT = 0xFFFD;
+
+  std::u32string result;
+  result.reserve(text.size());
+
+  size_t i = 0;
+  while (i < text.size()) {
+    uint8_t lead = static_cast<uint8_t>(text[i]);
+
+    // ASCII is by far the most common case.
+    if (lead < 0x80) {
+      result.push_back(lead);
+      ++i;
+      continue;
+    }
+
+    // The number of continuation bytes and the smallest code point which may be encoded
+    // with this many bytes.
+    size_t   length;
+    char32_t codepoint;
+    char32_t minimum;
+
+    if ((lead & 0xE0) == 0xC0) {
+      length    = 1;
+      codepoint = lead & 0x1F;
+      minimum   = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+      length    = 2;
+      codepoint = lead & 0x0F;
+      minimum   = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+      length    = 3;
+      codepoint = lead & 0x07;
+      minimum   = 0x10000;
+    } else {
+      result.push_back(REPLACEMENT);
+      ++i;
+      continue;
+    }
+
+    // A truncated sequence is replaced as a whole. The following byte is decoded again
+    // as it may be the start of a new sequence.
+    size_t j = 1;
+    for (; j <= length && i + j < text.size(); ++j) {
+      uint8_t next = static_cast<uint8_t>(text[i + j]);
+      if ((next & 0xC0) != 0x80) {
+        break;
+      }
+      codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+
+    if (j <= length || codepoint < minimum || codepoint > 0x10FFFF ||
+        (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+      result.push_back(REPLACEMENT);
+    } else {
+      result.push_back(codepoint);
+    }
+
+    i += j;
+  }
+
+  return result;
+}
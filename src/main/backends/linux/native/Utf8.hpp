@@ -0,0 +1,24 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef UTF8_HPP
+#define UTF8_HPP
+
+#include <string>
+
+/**
+ * Decodes a UTF-8 string into Unicode code points. This is used to type text which is
+ * passed from JavaScript. Invalid bytes, truncated sequences, overlong encodings, and
+ * surrogates are replaced with U+FFFD, so the result has at most one code point per
+ * byte of the input.
+ */
+std::u32string decodeUtf8(std::string const& text);
+
+#endif // UTF8_HPP
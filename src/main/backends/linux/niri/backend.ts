@@ -66,10 +66,15 @@ for more information.
 
     // Set timeout options
     this.generalSettings = generalSettings;
+
+    // Keep track of the focused window.
+    this.watchWindows();
   }
 
-  /** Nothing to be done here. */
-  public async deinit() {}
+  /** We only need to stop tracking the windows. */
+  public async deinit() {
+    this.unwatchWindows();
+  }
 
   /**
    * The pointer position as well as the work-area size are retrieved via a native addon
@@ -83,7 +88,7 @@ for more information.
     try {
       const focusedWindow = await this.getFocusedWindow();
       const { pointerX, pointerY, workAreaWidth, workAreaHeight } =
-        this.getPointerPositionAndWorkAreaSize();
+        await this.getPointerPositionAndWorkAreaSize();
       const workArea = screen.getDisplayNearestPoint({
         x: pointerX,
         y: pointerY,
@@ -10,7 +10,12 @@
 
 import { native } from './native';
 import { LinuxBackend } from '../backend';
-import { GeneralSettings, KeySequence, WindowDescription } from '../../../../common';
+import {
+  ClipboardEntry,
+  GeneralSettings,
+  KeySequence,
+  WindowDescription,
+} from '../../../../common';
 import { mapKeys } from '../../../../common/key-codes';
 import { Settings } from '../../../../main/settings';
 
@@ -37,21 +42,88 @@ export abstract class WLRBackend extends LinuxBackend {
   public generalSettings: Settings<GeneralSettings>;
   public defaultBehavior: PointerTimeoutBehavior = 'center';
 
-  /** Uses the foreign-toplevel protocol to list currently open windows. */
+  /**
+   * The focused window as last reported by the native module. This is undefined as long
+   * as watchWindows() has not been called or if the compositor does not support the
+   * foreign-toplevel protocol.
+   */
+  private focusedWindow: WindowDescription | null | undefined = undefined;
+
+  /**
+   * Uses the foreign-toplevel protocol to list currently open windows. The most recently
+   * activated windows come first.
+   */
   public async getOpenWindows(): Promise<WindowDescription[]> {
     return native.getOpenWindows();
   }
 
-  /** Uses the foreign-toplevel protocol to focus the given window. */
+  /**
+   * Uses the foreign-toplevel protocol to focus the given window. If the window comes
+   * from getOpenWindows(), the native module activates it by its ID.
+   */
   public async focusWindow(window: WindowDescription): Promise<void> {
-    native.focusWindow(window.windowName, window.appName);
+    native.focusWindow(window.windowName, window.appName, window.id);
   }
 
-  /** Uses the foreign-toplevel protocol to get the currently focused window. */
+  /**
+   * Uses the foreign-toplevel protocol to get the currently focused window. If
+   * watchWindows() has been called, this returns the last window reported by the native
+   * module without talking to the compositor.
+   */
   protected async getFocusedWindow(): Promise<WindowDescription | null> {
+    if (this.focusedWindow !== undefined) {
+      return this.focusedWindow;
+    }
+
     return native.getFocusedWindow();
   }
 
+  /**
+   * Derived backends should call this in their init() method. It subscribes to the
+   * toplevel changes reported by the native module. They are used to answer
+   * getFocusedWindow() and forwarded as 'activeWindowChanged' and 'windowsChanged'
+   * events.
+   */
+  protected watchWindows() {
+    const available = native.onActiveWindowChanged((window) => {
+      this.focusedWindow = window;
+      this.emit('activeWindowChanged', window);
+    });
+
+    if (!available) {
+      console.warn('The foreign-toplevel protocol is not available.');
+      return;
+    }
+
+    native.onWindowsChanged((windows) => {
+      this.emit('windowsChanged', windows);
+    });
+
+    // The first callback is called asynchronously, so we query the initial state once.
+    this.focusedWindow = native.getFocusedWindow();
+  }
+
+  /** Unsubscribes from the toplevel changes again. */
+  protected unwatchWindows() {
+    native.onActiveWindowChanged();
+    native.onWindowsChanged();
+    this.focusedWindow = undefined;
+  }
+
+  /**
+   * Uses the wlr-screencopy protocol to capture the given rectangle. The native module
+   * keeps the connection and the shared memory buffer between calls.
+   */
+  public async captureBackdrop(region: Electron.Rectangle, sigma: number) {
+    return native.captureBackdrop(
+      Math.round(region.x),
+      Math.round(region.y),
+      Math.round(region.width),
+      Math.round(region.height),
+      sigma
+    );
+  }
+
   /**
    * Moves the pointer by the given amount using the native module which uses the
    * wlr-virtual-pointer-unstable-v1 Wayland protocol.
@@ -79,19 +151,53 @@ export abstract class WLRBackend extends LinuxBackend {
     // not found, this throws an error.
     const keyCodes = mapKeys(keys, 'linux');
 
-    // Now simulate the key presses. We wait a couple of milliseconds if the key has a
-    // delay specified.
+    // Now simulate the key presses. The keys between two delays are sent in one batch so
+    // that the compositor is only waited for once per batch.
+    let batch: Array<{ keycode: number; down: boolean }> = [];
+
     for (let i = 0; i < keyCodes.length; i++) {
       if (keys[i].delay > 0) {
+        if (batch.length > 0) {
+          native.simulateKeys(batch);
+          batch = [];
+        }
+
         await new Promise((resolve) => {
           setTimeout(resolve, keys[i].delay);
         });
       }
 
-      native.simulateKey(keyCodes[i], keys[i].down);
+      batch.push({ keycode: keyCodes[i], down: keys[i].down });
+    }
+
+    if (batch.length > 0) {
+      native.simulateKeys(batch);
     }
   }
 
+  /**
+   * This types the given text into the currently focused window using the
+   * virtual-keyboard-unstable-v1 Wayland protocol. The keys are looked up in the keymap
+   * of the real keyboard by the native module.
+   *
+   * @param text The text to type.
+   */
+  public override async simulateText(text: string) {
+    return native.simulateText(text);
+  }
+
+  /**
+   * This sets the clipboard using the wlr-data-control Wayland protocol. The native
+   * module sends the content to other clients from a background thread, so it does not
+   * require a focused surface.
+   *
+   * @param entries The representations of the content.
+   * @param primary If true, the primary selection is set instead of the clipboard.
+   */
+  public override async setClipboard(entries: ClipboardEntry[], primary = false) {
+    return native.setClipboard(entries, primary);
+  }
+
   /**
    * This gets the pointer's position and work area size. Derived backends may use this in
    * their getWMInfo() implementations.
@@ -99,14 +205,24 @@ export abstract class WLRBackend extends LinuxBackend {
    * This is only supported on Wayland compositors implementing the wlr-layer-shell
    * protocol. Also, it requires that the compositor automatically sends a pointer-enter
    * event when the surface is created. It seems that for instance Niri does this, but
-   * Hyprland does not. Hence, on Hyprland, the method would block until the user moves
-   * the pointer.
+   * Hyprland does not. Hence, on Hyprland, the method only resolves once the user moves
+   * the pointer or the timeout expires.
+   *
+   * If the wlrootsKeepPointerSurface setting is enabled, the surface is only unmapped
+   * after each call instead of being destroyed.
+   *
+   * The native module waits for the pointer event in the event loop of the main process,
+   * so other work continues while the compositor is slow to respond.
    */
-  protected getPointerPositionAndWorkAreaSize() {
-    const data = native.getPointerPositionAndWorkAreaSize(
+  protected async getPointerPositionAndWorkAreaSize() {
+    const data = await native.getPointerPositionAndWorkAreaSizeAsync(
       this.generalSettings.get('wlrootsPointerGetTimeoutMouse'),
-      this.generalSettings.get('wlrootsPointerGetTimeoutTouch')
+      this.generalSettings.get('wlrootsPointerGetTimeoutTouch'),
+      this.generalSettings.get('wlrootsKeepPointerSurface')
     );
+    if (!data) {
+      throw new Error('Failed to get the pointer position.');
+    }
     if (data.pointerGetTimedOut) {
       console.error('Pointer get timed out');
       switch (this.defaultBehavior) {
@@ -0,0 +1,390 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "ClipboardOwner.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Transfers are dropped if the receiver does not read anything within this time.
+constexpr auto TRANSFER_TIMEOUT = std::chrono::seconds(5);
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+ClipboardOwner::~ClipboardOwner() {
+  stop();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ClipboardOwner::start() {
+  if (mThread.joinable()) {
+    return true;
+  }
+
+  mDisplay = wl_display_connect(nullptr);
+  if (!mDisplay) {
+    return false;
+  }
+
+  static const wl_registry_listener registryListener = {
+      .global =
+          [](void* data, wl_registry* registry, uint32_t name, const char* interface,
+              uint32_t version) {
+            static_cast<ClipboardOwner*>(data)->addGlobal(
+                registry, name, interface, version);
+          },
+      .global_remove = [](void*, wl_registry*, uint32_t) {},
+  };
+
+  mRegistry = wl_display_get_registry(mDisplay);
+  wl_registry_add_listener(mRegistry, &registryListener, this);
+  wl_display_roundtrip(mDisplay);
+
+  if (!mManager || !mSeat) {
+    disconnect();
+    return false;
+  }
+
+  // The device tells us about the current selections. We are not interested in them,
+  // but we have to destroy the offers.
+  static const zwlr_data_control_device_v1_listener deviceListener = {
+      .data_offer = [](void*, zwlr_data_control_device_v1*,
+                        zwlr_data_control_offer_v1*) {},
+      .selection =
+          [](void*, zwlr_data_control_device_v1*, zwlr_data_control_offer_v1* offer) {
+            if (offer) {
+              zwlr_data_control_offer_v1_destroy(offer);
+            }
+          },
+      .finished =
+          [](void* data, zwlr_data_control_device_v1*) {
+            static_cast<ClipboardOwner*>(data)->mFinished = true;
+          },
+      .primary_selection =
+          [](void*, zwlr_data_control_device_v1*, zwlr_data_control_offer_v1* offer) {
+            if (offer) {
+              zwlr_data_control_offer_v1_destroy(offer);
+            }
+          },
+  };
+
+  mDevice = zwlr_data_control_manager_v1_get_data_device(mManager, mSeat);
+  zwlr_data_control_device_v1_add_listener(mDevice, &deviceListener, this);
+  wl_display_roundtrip(mDisplay);
+
+  mFinished = false;
+  mWakeupFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  mRunning  = true;
+  mAlive    = true;
+  mThread   = std::thread(&ClipboardOwner::run, this);
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::stop() {
+  if (!mThread.joinable()) {
+    return;
+  }
+
+  mRunning = false;
+
+  uint64_t value = 1;
+  write(mWakeupFd, &value, sizeof(value));
+
+  mThread.join();
+
+  close(mWakeupFd);
+  mWakeupFd = -1;
+
+  disconnect();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ClipboardOwner::isRunning() const {
+  return mAlive;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ClipboardOwner::set(std::vector<ClipboardEntry> entries, bool primary) {
+  static const zwlr_data_control_source_v1_listener sourceListener = {
+      .send =
+          [](void* data, zwlr_data_control_source_v1*, const char* mimeType, int32_t fd) {
+            auto* source = static_cast<Source*>(data);
+            source->owner->send(source, mimeType, fd);
+          },
+      .cancelled =
+          [](void* data, zwlr_data_control_source_v1*) {
+            auto* source = static_cast<Source*>(data);
+            source->owner->removeSource(source);
+          },
+  };
+
+  // The primary selection has been added in version 2 of the protocol.
+  if (!mAlive || (primary && mManagerVersion < 2)) {
+    return false;
+  }
+
+  auto content     = std::make_shared<Content>();
+  content->offers  = getClipboardOffers(entries);
+  convertLatin1Offers(entries, content->offers);
+  content->entries = std::move(entries);
+
+  if (content->offers.empty()) {
+    return false;
+  }
+
+  // Requests can be sent from any thread. The event thread only accesses the source once
+  // the compositor sends an event for it, which requires the selection to be set first.
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  auto source     = std::make_unique<Source>();
+  source->owner   = this;
+  source->content = std::move(content);
+  source->source  = zwlr_data_control_manager_v1_create_data_source(mManager);
+  zwlr_data_control_source_v1_add_listener(source->source, &sourceListener, source.get());
+
+  for (auto const& offer : source->content->offers) {
+    zwlr_data_control_source_v1_offer(source->source, offer.target.c_str());
+  }
+
+  if (primary) {
+    zwlr_data_control_device_v1_set_primary_selection(mDevice, source->source);
+  } else {
+    zwlr_data_control_device_v1_set_selection(mDevice, source->source);
+  }
+
+  mSources.push_back(std::move(source));
+  wl_display_flush(mDisplay);
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::run() {
+  int displayFd = wl_display_get_fd(mDisplay);
+
+  while (mRunning && !mFinished) {
+
+    // First, we dispatch everything which has been read already. This starts new
+    // transfers and destroys the cancelled sources.
+    while (wl_display_prepare_read(mDisplay) != 0) {
+      wl_display_dispatch_pending(mDisplay);
+    }
+
+    wl_display_flush(mDisplay);
+
+    int timeout = expireTransfers();
+
+    // We sleep until the compositor sends something, until a receiver can take more
+    // data, or until the thread should stop.
+    std::vector<pollfd> fds = {
+        {.fd = displayFd, .events = POLLIN},
+        {.fd = mWakeupFd, .events = POLLIN},
+    };
+
+    for (auto const& transfer : mTransfers) {
+      fds.push_back({.fd = transfer.fd, .events = POLLOUT});
+    }
+
+    if (poll(fds.data(), fds.size(), timeout) > 0 && (fds[0].revents & POLLIN)) {
+      wl_display_read_events(mDisplay);
+    } else {
+      wl_display_cancel_read(mDisplay);
+    }
+
+    if (wl_display_get_error(mDisplay) || (fds[0].revents & (POLLHUP | POLLERR))) {
+      std::cerr << "Lost connection to the Wayland compositor!" << std::endl;
+      break;
+    }
+
+    // Reading the events does not dispatch them, so the transfers are still the ones we
+    // polled for.
+    std::vector<Transfer> transfers;
+    for (size_t i = 0; i < mTransfers.size(); ++i) {
+      if (fds[i + 2].revents == 0 || continueTransfer(mTransfers[i])) {
+        transfers.push_back(std::move(mTransfers[i]));
+      } else {
+        close(mTransfers[i].fd);
+      }
+    }
+
+    mTransfers = std::move(transfers);
+  }
+
+  for (auto const& transfer : mTransfers) {
+    close(transfer.fd);
+  }
+
+  mTransfers.clear();
+  mAlive = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::addGlobal(
+    wl_registry* registry, uint32_t name, const char* interface, uint32_t version) {
+
+  if (!mManager &&
+      std::strcmp(interface, zwlr_data_control_manager_v1_interface.name) == 0) {
+    mManagerVersion = std::min(version, 2u);
+    mManager        = static_cast<zwlr_data_control_manager_v1*>(wl_registry_bind(
+        registry, name, &zwlr_data_control_manager_v1_interface, mManagerVersion));
+  } else if (!mSeat && std::strcmp(interface, wl_seat_interface.name) == 0) {
+    mSeat =
+        static_cast<wl_seat*>(wl_registry_bind(registry, name, &wl_seat_interface, 1));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::send(Source* source, const char* mimeType, int fd) {
+  auto const& offers = source->content->offers;
+
+  auto it = std::find_if(offers.begin(), offers.end(),
+      [mimeType](ClipboardOffer const& offer) { return offer.target == mimeType; });
+
+  if (it == offers.end()) {
+    close(fd);
+    return;
+  }
+
+  // Node.js ignores SIGPIPE, so writing to a receiver which went away only fails with
+  // EPIPE.
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  Transfer transfer;
+  transfer.fd      = fd;
+  transfer.content = source->content;
+  transfer.entry   = it->entry;
+
+  if (continueTransfer(transfer)) {
+    mTransfers.push_back(std::move(transfer));
+  } else {
+    close(fd);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::removeSource(Source* source) {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  auto it = std::find_if(mSources.begin(), mSources.end(),
+      [source](std::unique_ptr<Source> const& s) { return s.get() == source; });
+
+  if (it != mSources.end()) {
+    zwlr_data_control_source_v1_destroy(source->source);
+    mSources.erase(it);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ClipboardOwner::continueTransfer(Transfer& transfer) {
+  auto const& data = transfer.content->entries[transfer.entry].data;
+
+  while (transfer.offset < data.size()) {
+    ssize_t written =
+        write(transfer.fd, data.data() + transfer.offset, data.size() - transfer.offset);
+
+    if (written > 0) {
+      transfer.offset += written;
+    } else if (written < 0 && errno == EINTR) {
+      continue;
+    } else if (written < 0 && errno == EAGAIN) {
+      break;
+    } else {
+      return false;
+    }
+  }
+
+  transfer.deadline = std::chrono::steady_clock::now() + TRANSFER_TIMEOUT;
+
+  return transfer.offset < data.size();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int ClipboardOwner::expireTransfers() {
+  auto now     = std::chrono::steady_clock::now();
+  int  timeout = -1;
+
+  for (auto it = mTransfers.begin(); it != mTransfers.end();) {
+    if (it->deadline <= now) {
+      close(it->fd);
+      it = mTransfers.erase(it);
+      continue;
+    }
+
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(it->deadline - now);
+    if (timeout < 0 || remaining.count() < timeout) {
+      timeout = static_cast<int>(remaining.count());
+    }
+
+    ++it;
+  }
+
+  return timeout;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::disconnect() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& source : mSources) {
+      zwlr_data_control_source_v1_destroy(source->source);
+    }
+    mSources.clear();
+  }
+
+  if (mDevice) {
+    zwlr_data_control_device_v1_destroy(mDevice);
+    mDevice = nullptr;
+  }
+
+  if (mSeat) {
+    wl_seat_destroy(mSeat);
+    mSeat = nullptr;
+  }
+
+  if (mManager) {
+    zwlr_data_control_manager_v1_destroy(mManager);
+    mManager = nullptr;
+  }
+
+  if (mRegistry) {
+    wl_registry_destroy(mRegistry);
+    mRegistry = nullptr;
+  }
+
+  if (mDisplay) {
+    wl_display_disconnect(mDisplay);
+    mDisplay = nullptr;
+  }
+}
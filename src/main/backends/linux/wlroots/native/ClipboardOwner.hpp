@@ -0,0 +1,138 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CLIPBOARD_OWNER_HPP
+#define CLIPBOARD_OWNER_HPP
+
+#include "ClipboardContent.hpp"
+#include "wlr-data-control-unstable-v1.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * This class sets the clipboard and the primary selection using the wlr-data-control
+ * protocol. Unlike the regular data device protocol, this does not require a focused
+ * surface, so it works while all of Kando's windows are hidden.
+ *
+ * It runs a background thread with its own connection to the compositor which answers
+ * the send events of the data sources. The file descriptors of the receivers are written
+ * without blocking, so a slow receiver does not hold up other transfers. Each transfer
+ * keeps a reference to the content it was started with, so setting new content does not
+ * disturb transfers which are still running.
+ */
+class ClipboardOwner {
+ public:
+  ClipboardOwner() = default;
+  ~ClipboardOwner();
+
+  ClipboardOwner(ClipboardOwner const& other)            = delete;
+  ClipboardOwner& operator=(ClipboardOwner const& other) = delete;
+
+  /**
+   * Connects to the compositor and starts the event thread. Returns false if the
+   * compositor does not support the wlr-data-control protocol or if there is no seat.
+   * Does nothing if the thread is already running.
+   */
+  bool start();
+
+  /** Stops the event thread and disconnects from the compositor. */
+  void stop();
+
+  /**
+   * Returns true as long as the event thread is running. It stops by itself if the
+   * connection to the compositor is lost.
+   */
+  bool isRunning() const;
+
+  /**
+   * Offers the given entries as the new clipboard content or, if primary is true, as the
+   * new primary selection. This can be called from any thread. Returns false if the
+   * owner is not running, if there is nothing to offer, or if the compositor does not
+   * support the primary selection.
+   */
+  bool set(std::vector<ClipboardEntry> entries, bool primary = false);
+
+ private:
+  struct Content {
+    std::vector<ClipboardEntry> entries;
+    std::vector<ClipboardOffer> offers;
+  };
+
+  struct Source {
+    ClipboardOwner*                owner  = nullptr;
+    zwlr_data_control_source_v1*   source = nullptr;
+    std::shared_ptr<Content const> content;
+  };
+
+  // A payload which is written to the file descriptor of a receiver.
+  struct Transfer {
+    int                            fd = -1;
+    std::shared_ptr<Content const> content;
+    size_t                         entry  = 0;
+    size_t                         offset = 0;
+
+    // The transfer is dropped if the receiver does not read anything for a while.
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  void run();
+
+  // Binds the given global if it is one of the interfaces we need.
+  void addGlobal(
+      wl_registry* registry, uint32_t name, const char* interface, uint32_t version);
+
+  // Starts a transfer of the given source to the given file descriptor.
+  void send(Source* source, const char* mimeType, int fd);
+
+  // Destroys a source which has been replaced by another one.
+  void removeSource(Source* source);
+
+  // Writes as much of the given transfer as possible. Returns false once it is complete
+  // or if the receiver went away.
+  bool continueTransfer(Transfer& transfer);
+
+  // Drops all transfers which have not made any progress for a while and returns the
+  // time in milliseconds until the next one expires or -1 if there are none.
+  int expireTransfers();
+
+  // Destroys all Wayland objects and disconnects from the compositor.
+  void disconnect();
+
+  wl_display*                   mDisplay        = nullptr;
+  wl_registry*                  mRegistry       = nullptr;
+  zwlr_data_control_manager_v1* mManager        = nullptr;
+  uint32_t                      mManagerVersion = 0;
+  zwlr_data_control_device_v1*  mDevice         = nullptr;
+  wl_seat*                      mSeat           = nullptr;
+
+  std::thread mThread;
+
+  // This eventfd is used to wake up the event thread when it should stop. mAlive is
+  // cleared by the thread itself when it exits.
+  int               mWakeupFd = -1;
+  std::atomic<bool> mRunning  = false;
+  std::atomic<bool> mAlive    = false;
+
+  // These are only accessed from the event thread once it is running.
+  bool                  mFinished = false;
+  std::vector<Transfer> mTransfers;
+
+  // Sources are created on the calling thread of set() and destroyed on the event
+  // thread.
+  std::mutex                           mMutex;
+  std::vector<std::unique_ptr<Source>> mSources;
+};
+
+#endif // CLIPBOARD_OWNER_HPP
@@ -10,14 +10,18 @@
 
 #include "Native.hpp"
 
+#include "Utf8.hpp"
+
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
-#include <memory>
 #include <poll.h>
 #include <string>
 #include <sys/mman.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 #include <vector>
 
@@ -25,7 +29,7 @@
 
 namespace {
 
-// Create an anonymous shared memory file descriptor for the debug color buffer.
+// Create an anonymous shared memory file descriptor for the keymap.
 int createSharedMemoryFile() {
   const char* name = "/kando-shm-buffer";
   int         fd   = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
@@ -39,222 +43,65 @@ int createSharedMemoryFile() {
   return fd;
 }
 
-// Create wl_shm pool and buffer with given size, filled with solid color.
-wl_buffer* createPixelBuffer(wl_shm* shm, int width, int height, uint32_t color) {
-  const int stride = width * 4;
-  const int size   = stride * height;
-
-  int fd = createSharedMemoryFile();
-  if (fd < 0) {
-    std::cerr << "Failed to create shm fd\n";
-    return nullptr;
-  }
-
-  if (ftruncate(fd, size) < 0) {
-    std::cerr << "Failed to set shm size\n";
-    close(fd);
-    return nullptr;
-  }
-
-  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-  if (data == MAP_FAILED) {
-    std::cerr << "Failed to mmap shm\n";
-    close(fd);
-    return nullptr;
-  }
+Napi::Object toObject(Napi::Env env, ToplevelInfo const& toplevel) {
+  Napi::Object window = Napi::Object::New(env);
+  window.Set("windowName", toplevel.title);
+  window.Set("appName", toplevel.appId);
+  window.Set("id", Napi::Number::New(env, double(toplevel.id)));
+  window.Set("minimized", toplevel.minimized);
 
-  // Fill buffer with the given color (ARGB in 32-bit little endian)
-  uint32_t* pixels = (uint32_t*)data;
-  for (int i = 0; i < width * height; ++i) {
-    pixels[i] = color;
+  if (toplevel.output >= 0) {
+    window.Set("monitor", toplevel.output);
   }
 
-  wl_shm_pool* pool = wl_shm_create_pool(shm, fd, size);
-  wl_buffer*   buffer =
-      wl_shm_pool_create_buffer(pool, 0, width, height, stride, WL_SHM_FORMAT_ARGB8888);
-  wl_shm_pool_destroy(pool);
-  munmap(data, size);
-  close(fd);
-
-  return buffer;
+  return window;
 }
 
-struct ForeignToplevelWindow {
-  zwlr_foreign_toplevel_handle_v1* handle = nullptr;
-  std::string title;
-  std::string appId;
-  bool activated = false;
-  bool closed = false;
-};
-
-struct ForeignToplevelQueryData {
-  wl_display* display = nullptr;
-  wl_registry* registry = nullptr;
-  wl_seat* seat = nullptr;
-  zwlr_foreign_toplevel_manager_v1* manager = nullptr;
-  std::vector<std::unique_ptr<ForeignToplevelWindow>> windows;
-  wl_registry_listener registryListener{};
-};
-
-static const zwlr_foreign_toplevel_handle_v1_listener foreignToplevelHandleListener = {
-    .title = [](void* data, zwlr_foreign_toplevel_handle_v1*, const char* title) {
-      auto* window = static_cast<ForeignToplevelWindow*>(data);
-      window->title = title ? title : "";
-    },
-    .app_id = [](void* data, zwlr_foreign_toplevel_handle_v1*, const char* appId) {
-      auto* window = static_cast<ForeignToplevelWindow*>(data);
-      window->appId = appId ? appId : "";
-    },
-    .output_enter = [](void*, zwlr_foreign_toplevel_handle_v1*, wl_output*) {},
-    .output_leave = [](void*, zwlr_foreign_toplevel_handle_v1*, wl_output*) {},
-    .state = [](void* data, zwlr_foreign_toplevel_handle_v1*, wl_array* state) {
-      auto* window = static_cast<ForeignToplevelWindow*>(data);
-      window->activated = false;
-
-      auto* bytes = static_cast<uint8_t*>(state->data);
-      for (size_t offset = 0; offset + sizeof(uint32_t) <= state->size;
-           offset += sizeof(uint32_t)) {
-        const uint32_t value = *reinterpret_cast<uint32_t*>(bytes + offset);
-        if (value == ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_ACTIVATED) {
-          window->activated = true;
-          break;
-        }
-      }
-    },
-    .done = [](void*, zwlr_foreign_toplevel_handle_v1*) {},
-    .closed = [](void* data, zwlr_foreign_toplevel_handle_v1*) {
-      auto* window = static_cast<ForeignToplevelWindow*>(data);
-      window->closed = true;
-    },
-};
+// Creates a thread-safe function for the given JavaScript callback. It does not keep the
+// event loop alive.
+Napi::ThreadSafeFunction createCallback(
+    Napi::Env env, Napi::Function const& callback, const char* name) {
+  auto tsfn = Napi::ThreadSafeFunction::New(env, callback, name, 0, 1);
+  tsfn.Unref(env);
+  return tsfn;
+}
 
-static const zwlr_foreign_toplevel_manager_v1_listener foreignToplevelManagerListener = {
-    .toplevel = [](void* userData, zwlr_foreign_toplevel_manager_v1*,
-                    zwlr_foreign_toplevel_handle_v1* toplevel) {
-      auto* query = static_cast<ForeignToplevelQueryData*>(userData);
-      auto  window = std::make_unique<ForeignToplevelWindow>();
-      window->handle = toplevel;
-      auto* windowPtr = window.get();
-      query->windows.push_back(std::move(window));
-      zwlr_foreign_toplevel_handle_v1_add_listener(
-          toplevel, &foreignToplevelHandleListener, windowPtr);
-    },
-    .finished = [](void*, zwlr_foreign_toplevel_manager_v1*) {},
-};
+// The temporary keymaps of simulateText() use the keycodes starting at 9. X11 clients
+// running in Xwayland only support keycodes up to 255.
+const size_t MAX_TEMPORARY_KEYS = 247;
 
-void bindForeignToplevelManager(ForeignToplevelQueryData* data, wl_registry* registry,
-    uint32_t name, uint32_t version) {
-  if (data->manager) {
-    return;
+// Returns the given keymap in the XKB text format. This is used to compare keymaps.
+std::string serializeKeymap(xkb_keymap* keymap) {
+  char* text = xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
+  if (!text) {
+    return "";
   }
 
-  data->manager = static_cast<zwlr_foreign_toplevel_manager_v1*>(wl_registry_bind(
-      registry, name, &zwlr_foreign_toplevel_manager_v1_interface, std::min(version, 3u)));
-  zwlr_foreign_toplevel_manager_v1_add_listener(
-      data->manager, &foreignToplevelManagerListener, data);
+  std::string result(text);
+  free(text);
+  return result;
 }
 
-void handleForeignToplevelGlobal(void* userData, wl_registry* registry, uint32_t name,
-    const char* interface, uint32_t version) {
-  auto* data = static_cast<ForeignToplevelQueryData*>(userData);
-
-  if (std::strcmp(interface, wl_seat_interface.name) == 0) {
-    if (!data->seat) {
-      data->seat = static_cast<wl_seat*>(
-          wl_registry_bind(registry, name, &wl_seat_interface, std::min(version, 4u)));
-    }
-  } else if (std::strcmp(interface, zwlr_foreign_toplevel_manager_v1_interface.name) ==
-             0) {
-    bindForeignToplevelManager(data, registry, name, version);
+// Sends the given keymap in the XKB text format to the virtual keyboard.
+bool sendKeymap(zwp_virtual_keyboard_v1* keyboard, std::string const& keymap) {
+  int fd = createSharedMemoryFile();
+  if (fd < 0) {
+    std::cerr << "Failed to create shm fd\n";
+    return false;
   }
-}
 
-bool initializeForeignToplevelQuery(ForeignToplevelQueryData& data, Napi::Env env) {
-  data.display = wl_display_connect(nullptr);
-  if (!data.display) {
-    Napi::Error::New(env, "Failed to get Wayland display!").ThrowAsJavaScriptException();
+  // The size includes the terminating null byte.
+  ssize_t size = keymap.size() + 1;
+  if (write(fd, keymap.c_str(), size) != size) {
+    std::cerr << "Failed to write keymap\n";
+    close(fd);
     return false;
   }
 
-  data.registryListener = {
-      .global = handleForeignToplevelGlobal,
-      .global_remove = [](void*, wl_registry*, uint32_t) {},
-  };
-
-  data.registry = wl_display_get_registry(data.display);
-  wl_registry_add_listener(data.registry, &data.registryListener, &data);
-  wl_display_roundtrip(data.display);
-  wl_display_dispatch_pending(data.display);
+  zwp_virtual_keyboard_v1_keymap(keyboard, WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1, fd, size);
+  close(fd);
   return true;
 }
-
-void cleanupForeignToplevelQuery(ForeignToplevelQueryData& data) {
-  for (auto& window : data.windows) {
-    if (window && window->handle) {
-      zwlr_foreign_toplevel_handle_v1_destroy(window->handle);
-      window->handle = nullptr;
-    }
-  }
-
-  if (data.manager) {
-    zwlr_foreign_toplevel_manager_v1_destroy(data.manager);
-    data.manager = nullptr;
-  }
-
-  if (data.seat) {
-    wl_seat_release(data.seat);
-    data.seat = nullptr;
-  }
-
-  if (data.registry) {
-    wl_registry_destroy(data.registry);
-    data.registry = nullptr;
-  }
-
-  if (data.display) {
-    wl_display_disconnect(data.display);
-    data.display = nullptr;
-  }
-}
-
-ForeignToplevelWindow* findMatchingWindow(ForeignToplevelQueryData& data,
-    const std::string& windowName, const std::string& appName) {
-  for (auto& window : data.windows) {
-    if (!window || window->closed) {
-      continue;
-    }
-
-    if (window->title == windowName && window->appId == appName) {
-      return window.get();
-    }
-  }
-
-  for (auto& window : data.windows) {
-    if (!window || window->closed) {
-      continue;
-    }
-
-    if (window->title == windowName) {
-      return window.get();
-    }
-  }
-
-  return nullptr;
-}
-
-ForeignToplevelWindow* findFocusedWindow(ForeignToplevelQueryData& data) {
-  for (auto& window : data.windows) {
-    if (!window || window->closed) {
-      continue;
-    }
-
-    if (window->activated) {
-      return window.get();
-    }
-  }
-
-  return nullptr;
-}
 } // namespace
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -263,17 +110,38 @@ Native::Native(Napi::Env env, Napi::Object exports) {
   DefineAddon(exports, {
                            InstanceMethod("movePointer", &Native::movePointer),
                            InstanceMethod("simulateKey", &Native::simulateKey),
+                           InstanceMethod("simulateKeys", &Native::simulateKeys),
+                           InstanceMethod("simulateText", &Native::simulateText),
+                           InstanceMethod("setClipboard", &Native::setClipboard),
                            InstanceMethod("getOpenWindows", &Native::getOpenWindows),
                  InstanceMethod("getFocusedWindow", &Native::getFocusedWindow),
                            InstanceMethod("focusWindow", &Native::focusWindow),
                            InstanceMethod("getPointerPositionAndWorkAreaSize",
                                &Native::getPointerPositionAndWorkAreaSize),
+                           InstanceMethod("getPointerPositionAndWorkAreaSizeAsync",
+                               &Native::getPointerPositionAndWorkAreaSizeAsync),
+                           InstanceMethod(
+                               "onActiveWindowChanged", &Native::onActiveWindowChanged),
+                           InstanceMethod("onWindowsChanged", &Native::onWindowsChanged),
+                           InstanceMethod("captureBackdrop", &Native::captureBackdrop),
                        });
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
 Native::~Native() {
+  closePointerQuery();
+  mClipboardOwner.stop();
+  mToplevelRegistry.stop();
+
+  if (mActiveWindowCallback) {
+    mActiveWindowCallback.Release();
+  }
+
+  if (mWindowsCallback) {
+    mWindowsCallback.Release();
+  }
+
   if (mData.mVirtualPointer) {
     zwlr_virtual_pointer_v1_destroy(mData.mVirtualPointer);
   }
@@ -282,6 +150,10 @@ Native::~Native() {
     zwp_virtual_keyboard_v1_destroy(mData.mVirtualKeyboard);
   }
 
+  if (mData.mKeyboard) {
+    wl_keyboard_destroy(mData.mKeyboard);
+  }
+
   if (mData.mSeat) {
     wl_seat_release(mData.mSeat);
   }
@@ -306,21 +178,31 @@ Native::~Native() {
     xkb_state_unref(mData.mXkbState);
   }
 
-  if (mData.mPixelBuffer) {
-    wl_buffer_destroy(mData.mPixelBuffer);
-  }
+  releasePixelBuffer(mData);
 
   if (mData.mPointer) {
     wl_pointer_destroy(mData.mPointer);
   }
 
+  if (mData.mTouch) {
+    wl_touch_destroy(mData.mTouch);
+  }
+
   if (mData.mLayerSurface) {
     zwlr_layer_surface_v1_destroy(mData.mLayerSurface);
   }
 
+  if (mData.mViewport) {
+    wp_viewport_destroy(mData.mViewport);
+  }
+
   if (mData.mSurface) {
     wl_surface_destroy(mData.mSurface);
   }
+
+  if (mData.mViewporter) {
+    wp_viewporter_destroy(mData.mViewporter);
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -371,6 +253,9 @@ void Native::init(Napi::Env const& env) {
     } else if (strcmp(interface, zxdg_output_manager_v1_interface.name) == 0) {
       data->mXdgOutputManager = static_cast<zxdg_output_manager_v1*>(
         wl_registry_bind(registry, name, &zxdg_output_manager_v1_interface, 3));
+    } else if (strcmp(interface, wp_viewporter_interface.name) == 0) {
+      data->mViewporter = static_cast<wp_viewporter*>(
+          wl_registry_bind(registry, name, &wp_viewporter_interface, 1));
     } else if (strcmp(interface, wl_output_interface.name) == 0) {
       data->mOutput = static_cast<wl_output*>(
           wl_registry_bind(registry, name, &wl_output_interface, 4));
@@ -408,8 +293,9 @@ void Native::init(Napi::Env const& env) {
       // the real keyboard.
       // The code below retrieves the keymap from the real keyboard and creates a
       // corresponding xkb_state object and also forwards the keymap to the virtual
-      // keyboard.
-      wl_keyboard_listener keyboardListener = {
+      // keyboard. The real keyboard is kept so that the keymap is updated whenever the
+      // compositor sends a new one.
+      static const wl_keyboard_listener keyboardListener = {
           .keymap =
               [](void* userData, wl_keyboard* keyboard, uint32_t format, int32_t fd,
                   uint32_t size) {
@@ -430,16 +316,46 @@ void Native::init(Napi::Env const& env) {
                   return;
                 }
 
-                // Create the xkb_state object for this keymap.
-                WaylandData* data = static_cast<WaylandData*>(userData);
-                data->mXkbKeymap  = xkb_keymap_new_from_string(data->mXkbContext,
-                     mappedKeymap, XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
-                data->mXkbState   = xkb_state_new(data->mXkbKeymap);
+                WaylandData* data   = static_cast<WaylandData*>(userData);
+                xkb_keymap*  keymap = xkb_keymap_new_from_string(data->mXkbContext,
+                    mappedKeymap, XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
 
                 munmap(mappedKeymap, size);
 
+                if (!keymap) {
+                  close(fd);
+                  std::cerr << "Failed to compile keymap!" << std::endl;
+                  return;
+                }
+
+                // The compositor may send us the keymap of our own virtual keyboard, for
+                // instance the temporary keymap of simulateText(). This and the keymap we
+                // already have are ignored.
+                std::string serialized = serializeKeymap(keymap);
+                if (serialized == data->mKeymapString ||
+                    serialized == data->mTemporaryKeymap) {
+                  xkb_keymap_unref(keymap);
+                  close(fd);
+                  return;
+                }
+
+                // Create the xkb_state object for this keymap.
+                if (data->mXkbState) {
+                  xkb_state_unref(data->mXkbState);
+                }
+
+                if (data->mXkbKeymap) {
+                  xkb_keymap_unref(data->mXkbKeymap);
+                }
+
+                data->mXkbKeymap     = keymap;
+                data->mXkbState      = xkb_state_new(keymap);
+                data->mKeymapString  = std::move(serialized);
+                data->mKeymapChanged = true;
+
                 // Forward the keymap to the virtual keyboard.
                 zwp_virtual_keyboard_v1_keymap(data->mVirtualKeyboard, format, fd, size);
+                close(fd);
               },
           // The other callbacks are not needed.
           .enter     = [](void*, wl_keyboard*, uint32_t, wl_surface*, wl_array*) {},
@@ -451,11 +367,11 @@ void Native::init(Napi::Env const& env) {
       };
 
       // Get the real keyboard and add the keyboard listener to it. The roundtrip below
-      // will call the keymap callback above. Finally, we destroy the real keyboard again.
-      auto realKeyboard = wl_seat_get_keyboard(data->mSeat);
-      wl_keyboard_add_listener(realKeyboard, &keyboardListener, data);
+      // will call the keymap callback above. Later keymaps are received whenever events
+      // are dispatched on this connection.
+      data->mKeyboard = wl_seat_get_keyboard(data->mSeat);
+      wl_keyboard_add_listener(data->mKeyboard, &keyboardListener, data);
       wl_display_roundtrip(data->mDisplay);
-      wl_keyboard_destroy(realKeyboard);
     }
   };
 
@@ -534,6 +450,7 @@ void Native::movePointer(const Napi::CallbackInfo& info) {
       mData.mVirtualPointer, 0, wl_fixed_from_int(dx), wl_fixed_from_int(dy));
   zwlr_virtual_pointer_v1_frame(mData.mVirtualPointer);
   wl_display_roundtrip(mData.mDisplay);
+  finishPointerQueryIfReceived();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -545,78 +462,287 @@ void Native::simulateKey(const Napi::CallbackInfo& info) {
   // throw a JavaScript exception.
   if (info.Length() != 2 || !info[0].IsNumber() || !info[1].IsBoolean()) {
     Napi::TypeError::New(env, "Number and Boolean expected").ThrowAsJavaScriptException();
+    return;
   }
 
-  int32_t keycode = info[0].As<Napi::Number>().Int32Value();
-  bool    press   = info[1].As<Napi::Boolean>().Value();
+  KeyEvent event;
+  event.keycode = info[0].As<Napi::Number>().Uint32Value();
+  event.down    = info[1].As<Napi::Boolean>().Value();
 
   // Make sure that we are connected to the Wayland display.
   init(env);
+  if (!mData.mVirtualKeyboard || !mData.mXkbState) {
+    return;
+  }
+
+  sendKeyEvents(mData.mVirtualKeyboard, mData.mXkbState, {event});
+
+  // Make sure that the event is sent.
+  wl_display_roundtrip(mData.mDisplay);
+  finishPointerQueryIfReceived();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
 
-  // Update the modifier state.
-  xkb_state_component changedMods =
-      xkb_state_update_key(mData.mXkbState, keycode, press ? XKB_KEY_DOWN : XKB_KEY_UP);
+void Native::simulateKeys(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
 
-  // If the modifier state changed, we send a modifier event.
-  if (changedMods) {
-    zwp_virtual_keyboard_v1_modifiers(mData.mVirtualKeyboard,
-        xkb_state_serialize_mods(mData.mXkbState, XKB_STATE_MODS_DEPRESSED),
-        xkb_state_serialize_mods(mData.mXkbState, XKB_STATE_MODS_LATCHED),
-        xkb_state_serialize_mods(mData.mXkbState, XKB_STATE_MODS_LOCKED),
-        xkb_state_serialize_layout(mData.mXkbState, XKB_STATE_LAYOUT_EFFECTIVE));
+  if (info.Length() != 1 || !info[0].IsArray()) {
+    Napi::TypeError::New(env, "Array expected").ThrowAsJavaScriptException();
+    return;
   }
 
-  // Finally send the key event itself.
-  zwp_virtual_keyboard_v1_key(mData.mVirtualKeyboard, 0, keycode - 8,
-      press ? WL_KEYBOARD_KEY_STATE_PRESSED : WL_KEYBOARD_KEY_STATE_RELEASED);
+  // All events are validated before the first one is sent, so that no key is left
+  // pressed if the array is malformed.
+  Napi::Array           array = info[0].As<Napi::Array>();
+  std::vector<KeyEvent> events;
+  events.reserve(array.Length());
 
-  // Make sure that the event is sent.
+  for (uint32_t i = 0; i < array.Length(); ++i) {
+    Napi::Value value = array.Get(i);
+    if (!value.IsObject()) {
+      Napi::TypeError::New(env, "Key event object expected").ThrowAsJavaScriptException();
+      return;
+    }
+
+    Napi::Object object  = value.As<Napi::Object>();
+    Napi::Value  keycode = object.Get("keycode");
+    Napi::Value  down    = object.Get("down");
+    if (!keycode.IsNumber() || !down.IsBoolean()) {
+      Napi::TypeError::New(env, "Key events need a keycode and a down state")
+          .ThrowAsJavaScriptException();
+      return;
+    }
+
+    events.push_back(
+        {keycode.As<Napi::Number>().Uint32Value(), down.As<Napi::Boolean>().Value()});
+  }
+
+  // Make sure that we are connected to the Wayland display.
+  init(env);
+  if (!mData.mVirtualKeyboard || !mData.mXkbState) {
+    return;
+  }
+
+  // The events are queued and sent in one go. The roundtrip makes sure that the
+  // compositor has processed them before the caller continues or waits for a delay.
+  sendKeyEvents(mData.mVirtualKeyboard, mData.mXkbState, events);
   wl_display_roundtrip(mData.mDisplay);
+  finishPointerQueryIfReceived();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
-Napi::Value Native::getOpenWindows(const Napi::CallbackInfo& info) {
+Napi::Value Native::simulateText(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
-  if (info.Length() != 0) {
-    Napi::TypeError::New(env, "No arguments expected").ThrowAsJavaScriptException();
+  if (info.Length() != 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "String expected").ThrowAsJavaScriptException();
     return env.Null();
   }
 
-  ForeignToplevelQueryData query{};
-  if (!initializeForeignToplevelQuery(query, env)) {
-    return env.Null();
+  std::u32string text = decodeUtf8(info[0].As<Napi::String>().Utf8Value());
+
+  // Make sure that we are connected to the Wayland display.
+  init(env);
+
+  if (!mData.mXkbKeymap) {
+    return Napi::Boolean::New(env, false);
   }
 
-  if (!query.manager) {
-    cleanupForeignToplevelQuery(query);
-    return Napi::Array::New(env);
+  // New keymaps are received during the roundtrips of previous calls. The table is only
+  // rebuilt if one has been received or if the layout has been changed.
+  xkb_layout_index_t layout =
+      xkb_state_serialize_layout(mData.mXkbState, XKB_STATE_LAYOUT_EFFECTIVE);
+
+  if (mData.mKeymapChanged || layout != mTextKeymapLayout) {
+    mTextKeymap.build(mData.mXkbKeymap, layout);
+    mTextKeymapLayout    = layout;
+    mData.mKeymapChanged = false;
   }
 
-  wl_display_roundtrip(query.display);
-  wl_display_dispatch_pending(query.display);
+  std::vector<KeyPosition> strokes;
+  bool                     complete = true;
 
-  Napi::Array windows = Napi::Array::New(env);
-  uint32_t    index   = 0;
-  for (const auto& window : query.windows) {
-    if (!window || window->closed) {
+  for (char32_t codepoint : text) {
+    if (keysymFromCodepoint(codepoint) == XKB_KEY_NoSymbol) {
       continue;
     }
 
-    Napi::Object entry = Napi::Object::New(env);
-    entry.Set("windowName", window->title);
-    entry.Set("appName", window->appId);
-    windows.Set(index++, entry);
+    auto position = mTextKeymap.find(codepoint);
+    if (!position) {
+      complete = false;
+      break;
+    }
+
+    strokes.push_back(*position);
   }
 
-  cleanupForeignToplevelQuery(query);
-  return windows;
+  bool success = true;
+
+  if (complete) {
+    sendKeyStrokes(strokes, layout);
+  } else {
+
+    // Some characters are missing in the keymap. Hence, we type the text with temporary
+    // keymaps in which each character has its own key. Usually, one keymap is enough,
+    // but if the text contains too many different characters, it is split.
+    size_t start = 0;
+    while (success && start < text.size()) {
+      std::vector<xkb_keysym_t> keysyms;
+      strokes.clear();
+
+      size_t end = start;
+      for (; end < text.size(); ++end) {
+        xkb_keysym_t keysym = keysymFromCodepoint(text[end]);
+        if (keysym == XKB_KEY_NoSymbol) {
+          continue;
+        }
+
+        auto it = std::find(keysyms.begin(), keysyms.end(), keysym);
+        if (it == keysyms.end()) {
+          if (keysyms.size() == MAX_TEMPORARY_KEYS) {
+            break;
+          }
+          it = keysyms.insert(it, keysym);
+        }
+
+        strokes.push_back({xkb_keycode_t(9 + (it - keysyms.begin())), 0});
+      }
+
+      success = sendTemporaryKeymap(keysyms);
+      if (success) {
+        sendKeyStrokes(strokes, 0);
+      }
+
+      start = end;
+    }
+
+    sendKeymap(mData.mVirtualKeyboard, mData.mKeymapString);
+  }
+
+  // Restore the modifiers which are tracked for simulateKey().
+  zwp_virtual_keyboard_v1_modifiers(mData.mVirtualKeyboard,
+      xkb_state_serialize_mods(mData.mXkbState, XKB_STATE_MODS_DEPRESSED),
+      xkb_state_serialize_mods(mData.mXkbState, XKB_STATE_MODS_LATCHED),
+      xkb_state_serialize_mods(mData.mXkbState, XKB_STATE_MODS_LOCKED),
+      xkb_state_serialize_layout(mData.mXkbState, XKB_STATE_LAYOUT_EFFECTIVE));
+
+  // All events are sent at once. This also dispatches new keymaps.
+  wl_display_roundtrip(mData.mDisplay);
+  finishPointerQueryIfReceived();
+
+  return Napi::Boolean::New(env, success);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
-Napi::Value Native::getFocusedWindow(const Napi::CallbackInfo& info) {
+void Native::sendKeyStrokes(
+    std::vector<KeyPosition> const& strokes, xkb_layout_index_t layout) {
+  bool           first     = true;
+  xkb_mod_mask_t modifiers = 0;
+
+  for (auto const& stroke : strokes) {
+
+    // The locked modifiers are cleared so that Caps Lock does not change the case.
+    if (first || stroke.modifiers != modifiers) {
+      zwp_virtual_keyboard_v1_modifiers(
+          mData.mVirtualKeyboard, stroke.modifiers, 0, 0, layout);
+      modifiers = stroke.modifiers;
+      first     = false;
+    }
+
+    zwp_virtual_keyboard_v1_key(
+        mData.mVirtualKeyboard, 0, stroke.keycode - 8, WL_KEYBOARD_KEY_STATE_PRESSED);
+    zwp_virtual_keyboard_v1_key(
+        mData.mVirtualKeyboard, 0, stroke.keycode - 8, WL_KEYBOARD_KEY_STATE_RELEASED);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool Native::sendTemporaryKeymap(std::vector<xkb_keysym_t> const& keysyms) {
+  std::string keymapText = createKeymap(keysyms);
+
+  // We compile the keymap ourselves to make sure that it is valid and to recognize it
+  // if the compositor sends it back to us.
+  xkb_keymap* keymap = xkb_keymap_new_from_string(mData.mXkbContext, keymapText.c_str(),
+      XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+  if (!keymap) {
+    std::cerr << "Failed to compile temporary keymap!" << std::endl;
+    return false;
+  }
+
+  mData.mTemporaryKeymap = serializeKeymap(keymap);
+  xkb_keymap_unref(keymap);
+
+  return sendKeymap(mData.mVirtualKeyboard, mData.mTemporaryKeymap);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::setClipboard(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsArray() ||
+      (info.Length() > 1 && !info[1].IsBoolean())) {
+    Napi::TypeError::New(env, "Array and optional boolean expected")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  auto array = info[0].As<Napi::Array>();
+
+  std::vector<ClipboardEntry> entries;
+  for (uint32_t i = 0; i < array.Length(); ++i) {
+    Napi::Value value = array.Get(i);
+    if (!value.IsObject()) {
+      Napi::TypeError::New(env, "Clipboard entries must be objects")
+          .ThrowAsJavaScriptException();
+      return env.Null();
+    }
+
+    auto object   = value.As<Napi::Object>();
+    auto mimeType = object.Get("mimeType");
+    auto data     = object.Get("data");
+
+    if (!mimeType.IsString() || !(data.IsString() || data.IsBuffer())) {
+      Napi::TypeError::New(env, "Clipboard entries need a MIME type and data")
+          .ThrowAsJavaScriptException();
+      return env.Null();
+    }
+
+    ClipboardEntry entry;
+    entry.mimeType = mimeType.As<Napi::String>().Utf8Value();
+
+    if (data.IsBuffer()) {
+      auto buffer = data.As<Napi::Buffer<char>>();
+      entry.data.assign(buffer.Data(), buffer.Length());
+    } else {
+      entry.data = data.As<Napi::String>().Utf8Value();
+    }
+
+    entries.push_back(std::move(entry));
+  }
+
+  bool primary = info.Length() > 1 && info[1].As<Napi::Boolean>().Value();
+
+  // The owner thread stops by itself if the connection to the compositor is lost. In
+  // this case, we start it again.
+  if (!mClipboardOwner.isRunning()) {
+    mClipboardOwner.stop();
+  }
+
+  if (!mClipboardOwner.start()) {
+    return Napi::Boolean::New(env, false);
+  }
+
+  return Napi::Boolean::New(env, mClipboardOwner.set(std::move(entries), primary));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::getOpenWindows(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
   if (info.Length() != 0) {
@@ -624,31 +750,43 @@ Napi::Value Native::getFocusedWindow(const Napi::CallbackInfo& info) {
     return env.Null();
   }
 
-  ForeignToplevelQueryData query{};
-  if (!initializeForeignToplevelQuery(query, env)) {
-    return env.Null();
+  Napi::Array windows = Napi::Array::New(env);
+
+  // The registry keeps track of the toplevels in the background and knows the order in
+  // which they have been activated. It is started on the first call, so all subsequent
+  // calls only copy its state.
+  if (!mToplevelRegistry.start()) {
+    return windows;
   }
 
-  if (!query.manager) {
-    cleanupForeignToplevelQuery(query);
-    return env.Null();
+  uint32_t index = 0;
+  for (auto const& toplevel : mToplevelRegistry.getToplevels()) {
+    windows.Set(index++, toObject(env, toplevel));
   }
 
-  wl_display_roundtrip(query.display);
-  wl_display_dispatch_pending(query.display);
+  return windows;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::getFocusedWindow(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
 
-  auto* focused = findFocusedWindow(query);
-  if (!focused) {
-    cleanupForeignToplevelQuery(query);
+  if (info.Length() != 0) {
+    Napi::TypeError::New(env, "No arguments expected").ThrowAsJavaScriptException();
     return env.Null();
   }
 
-  Napi::Object window = Napi::Object::New(env);
-  window.Set("windowName", focused->title);
-  window.Set("appName", focused->appId);
+  if (!mToplevelRegistry.start()) {
+    return env.Null();
+  }
 
-  cleanupForeignToplevelQuery(query);
-  return window;
+  std::optional<ToplevelInfo> toplevel = mToplevelRegistry.getActiveToplevel();
+  if (!toplevel) {
+    return env.Null();
+  }
+
+  return toObject(env, *toplevel);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -656,87 +794,146 @@ Napi::Value Native::getFocusedWindow(const Napi::CallbackInfo& info) {
 void Native::focusWindow(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
-  if (info.Length() != 2 || !info[0].IsString() || !info[1].IsString()) {
-    Napi::TypeError::New(env, "Two strings expected").ThrowAsJavaScriptException();
+  if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString() ||
+      (info.Length() > 2 && !info[2].IsNumber())) {
+    Napi::TypeError::New(env, "Two strings and an optional number expected")
+        .ThrowAsJavaScriptException();
     return;
   }
 
   const std::string windowName = info[0].As<Napi::String>().Utf8Value();
   const std::string appName    = info[1].As<Napi::String>().Utf8Value();
 
-  ForeignToplevelQueryData query{};
-  if (!initializeForeignToplevelQuery(query, env)) {
+  if (!mToplevelRegistry.start()) {
+    std::cerr << "foreign-toplevel protocol is not available on this compositor\n";
     return;
   }
 
-  if (!query.seat || !query.manager) {
-    std::cerr << "foreign-toplevel protocol is not available on this compositor\n";
-    cleanupForeignToplevelQuery(query);
+  // If the ID of a window from getOpenWindows() is given, we activate it directly. If it
+  // is not known anymore, we search the registry for a window with the given title.
+  if (info.Length() > 2 &&
+      mToplevelRegistry.activate(uint64_t(info[2].As<Napi::Number>().DoubleValue()))) {
     return;
   }
 
-  wl_display_roundtrip(query.display);
-  wl_display_dispatch_pending(query.display);
-
-  auto* window = findMatchingWindow(query, windowName, appName);
-  if (!window || !window->handle) {
+  std::optional<uint64_t> id = mToplevelRegistry.findToplevel(windowName, appName);
+  if (!id || !mToplevelRegistry.activate(*id)) {
     std::cerr << "Could not find window to focus via foreign-toplevel protocol\n";
-    cleanupForeignToplevelQuery(query);
-    return;
   }
-
-  zwlr_foreign_toplevel_handle_v1_activate(window->handle, query.seat);
-  wl_display_roundtrip(query.display);
-  cleanupForeignToplevelQuery(query);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
-Napi::Value Native::getPointerPositionAndWorkAreaSize(const Napi::CallbackInfo& info) {
+Napi::Value Native::onActiveWindowChanged(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
-  // We need to check the number of arguments and their types. If something is wrong, we
-  // throw a JavaScript exception.
-  if (info.Length() != 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
-    Napi::TypeError::New(env, "2 Numbers expected").ThrowAsJavaScriptException();
+  // Remove the previous callback first. Once this returns, the event thread will not
+  // use the old thread-safe function anymore.
+  mToplevelRegistry.setActiveToplevelCallback(nullptr);
+
+  if (mActiveWindowCallback) {
+    mActiveWindowCallback.Release();
+    mActiveWindowCallback = Napi::ThreadSafeFunction();
   }
 
-  // Ensure Wayland is initialized
-  if (!mData.mDisplay) {
-    init(env);
-    if (!mData.mDisplay)
-      return env.Null();
+  if (info.Length() == 0 || !info[0].IsFunction()) {
+    return Napi::Boolean::New(env, false);
   }
 
-  // Create surface and pointer listener
-  createSurfaceAndPointer();
-  if (!mData.mSurface || !(mData.mPointer || mData.mTouch)) {
-    destroySurfaceAndPointer();
+  mActiveWindowCallback =
+      createCallback(env, info[0].As<Napi::Function>(), "onActiveWindowChanged");
+
+  // The callback is set before the registry is started so that it receives the initial
+  // state.
+  mToplevelRegistry.setActiveToplevelCallback(
+      [tsfn = mActiveWindowCallback](std::optional<ToplevelInfo> const& toplevel) {
+        tsfn.NonBlockingCall(new std::optional<ToplevelInfo>(toplevel),
+            [](Napi::Env env, Napi::Function callback,
+                std::optional<ToplevelInfo>* toplevel) {
+              if (*toplevel) {
+                callback.Call({toObject(env, **toplevel)});
+              } else {
+                callback.Call({env.Null()});
+              }
+              delete toplevel;
+            });
+      });
+
+  return Napi::Boolean::New(env, mToplevelRegistry.start());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::onWindowsChanged(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  mToplevelRegistry.setToplevelsCallback(nullptr);
+
+  if (mWindowsCallback) {
+    mWindowsCallback.Release();
+    mWindowsCallback = Napi::ThreadSafeFunction();
+  }
+
+  if (info.Length() == 0 || !info[0].IsFunction()) {
+    return Napi::Boolean::New(env, false);
+  }
+
+  mWindowsCallback =
+      createCallback(env, info[0].As<Napi::Function>(), "onWindowsChanged");
+
+  mToplevelRegistry.setToplevelsCallback(
+      [tsfn = mWindowsCallback](std::vector<ToplevelInfo> const& toplevels) {
+        tsfn.NonBlockingCall(new std::vector<ToplevelInfo>(toplevels),
+            [](Napi::Env env, Napi::Function callback,
+                std::vector<ToplevelInfo>* toplevels) {
+              Napi::Array windows = Napi::Array::New(env);
+              uint32_t    index   = 0;
+
+              for (auto const& toplevel : *toplevels) {
+                windows.Set(index++, toObject(env, toplevel));
+              }
+
+              callback.Call({windows});
+              delete toplevels;
+            });
+      });
+
+  return Napi::Boolean::New(env, mToplevelRegistry.start());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::getPointerPositionAndWorkAreaSize(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  // We need to check the number of arguments and their types. If something is wrong, we
+  // throw a JavaScript exception.
+  if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
+    Napi::TypeError::New(env, "2 Numbers expected").ThrowAsJavaScriptException();
     return env.Null();
   }
 
-  if (mData.mXdgOutputManager && mData.mOutput) {
-    auto* xdgOutput = zxdg_output_manager_v1_get_xdg_output(
-        mData.mXdgOutputManager, mData.mOutput);
+  // The probe surface is used by the asynchronous query.
+  if (mPointerQuery) {
+    Napi::Error::New(env, "An asynchronous pointer query is running.")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
 
-    static const zxdg_output_v1_listener xdgOutputListener = {
-        .logical_position = [](void* data, zxdg_output_v1*, int32_t x, int32_t y) {
-            auto* d = static_cast<WaylandData*>(data);
-            d->mOutputX = x;
-            d->mOutputY = y;
-        },
-        .logical_size = [](void*, zxdg_output_v1*, int32_t, int32_t) {},
-        .done        = [](void*, zxdg_output_v1*) {},
-        .name        = [](void*, zxdg_output_v1*, const char*) {},
-        .description = [](void*, zxdg_output_v1*, const char*) {},
-    };
-    zxdg_output_v1_add_listener(xdgOutput, &xdgOutputListener, &mData);
-    wl_display_roundtrip(mData.mDisplay);
-    zxdg_output_v1_destroy(xdgOutput);
+  // Ensure Wayland is initialized
+  if (!mData.mDisplay) {
+    init(env);
+    if (!mData.mDisplay)
+      return env.Null();
   }
 
-  int fd                      = wl_display_get_fd(mData.mDisplay);
-  mData.mPointerEventReceived = false;
+  bool keepSurface =
+      info.Length() > 2 && info[2].IsBoolean() && info[2].As<Napi::Boolean>().Value();
+  if (!beginPointerQuery(keepSurface)) {
+    return env.Null();
+  }
+
+  int fd = wl_display_get_fd(mData.mDisplay);
 
   int timeoutMs = info[0].As<Napi::Number>().Int32Value();;
   if (mData.mSeatCapabilities & WL_SEAT_CAPABILITY_TOUCH) {
@@ -789,16 +986,292 @@ Napi::Value Native::getPointerPositionAndWorkAreaSize(const Napi::CallbackInfo&
     }
   }
 
+  Napi::Object result = createPointerQueryResult(env, mPointerGetTimedOut);
+  endPointerQuery(keepSurface);
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::getPointerPositionAndWorkAreaSizeAsync(
+    const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
+    Napi::TypeError::New(env, "2 Numbers expected").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  auto deferred = Napi::Promise::Deferred::New(env);
+
+  // If a query is running, the caller gets the same position.
+  if (mPointerQuery) {
+    mPointerQuery->mDeferreds.push_back(deferred);
+    return deferred.Promise();
+  }
+
+  if (!mData.mDisplay) {
+    init(env);
+    if (!mData.mDisplay) {
+      return env.Null();
+    }
+  }
+
+  bool keepSurface =
+      info.Length() > 2 && info[2].IsBoolean() && info[2].As<Napi::Boolean>().Value();
+  if (!beginPointerQuery(keepSurface)) {
+    deferred.Resolve(env.Null());
+    return deferred.Promise();
+  }
+
+  // The compositor may have sent the enter event already.
+  wl_display_dispatch_pending(mData.mDisplay);
+  wl_display_flush(mData.mDisplay);
+  if (mData.mPointerEventReceived) {
+    deferred.Resolve(createPointerQueryResult(env, false));
+    endPointerQuery(keepSurface);
+    return deferred.Promise();
+  }
+
+  int timeoutMs = info[0].As<Napi::Number>().Int32Value();
+  if (mData.mSeatCapabilities & WL_SEAT_CAPABILITY_TOUCH) {
+    timeoutMs = info[1].As<Napi::Number>().Int32Value();
+  }
+
+  // A zero it_value would disarm the timer, so we wait at least one nanosecond.
+  itimerspec timeout{};
+  timeout.it_value.tv_sec  = std::max(timeoutMs, 0) / 1000;
+  timeout.it_value.tv_nsec = std::max(timeoutMs % 1000 * 1000000L, 1L);
+
+  int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (timerFd < 0 || timerfd_settime(timerFd, 0, &timeout, nullptr) < 0) {
+    std::cerr << "Failed to create the timer of the pointer query\n";
+    if (timerFd >= 0) {
+      close(timerFd);
+    }
+    endPointerQuery(keepSurface);
+    deferred.Resolve(env.Null());
+    return deferred.Promise();
+  }
+
+  uv_loop_t* loop = nullptr;
+  napi_get_uv_event_loop(env, &loop);
+
+  mPointerQuery               = new PointerQuery(env);
+  mPointerQuery->mNative      = this;
+  mPointerQuery->mTimerFd     = timerFd;
+  mPointerQuery->mKeepSurface = keepSurface;
+  mPointerQuery->mDeferreds.push_back(deferred);
+
+  uv_poll_init(loop, &mPointerQuery->mDisplayPoll, wl_display_get_fd(mData.mDisplay));
+  uv_poll_init(loop, &mPointerQuery->mTimerPoll, timerFd);
+  mPointerQuery->mDisplayPoll.data = mPointerQuery;
+  mPointerQuery->mTimerPoll.data   = mPointerQuery;
+  mPointerQuery->mOpenHandles      = 2;
+
+  uv_poll_start(&mPointerQuery->mDisplayPoll, UV_READABLE, &onPointerQueryDisplay);
+  uv_poll_start(&mPointerQuery->mTimerPoll, UV_READABLE, &onPointerQueryTimer);
+
+  return deferred.Promise();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool Native::beginPointerQuery(bool keepSurface) {
+  // If the probe surface is kept between calls, it is usually only mapped again. If the
+  // compositor has closed it in the meantime, we create a new one.
+  if (mData.mSurfaceClosed) {
+    destroySurfaceAndPointer();
+  }
+
+  // Create surface and pointer listener
+  createSurfaceAndPointer();
+  if (!mData.mSurface || !(mData.mPointer || mData.mTouch)) {
+    destroySurfaceAndPointer();
+    return false;
+  }
+
+  if (mData.mXdgOutputManager && mData.mOutput) {
+    auto* xdgOutput = zxdg_output_manager_v1_get_xdg_output(
+        mData.mXdgOutputManager, mData.mOutput);
+
+    static const zxdg_output_v1_listener xdgOutputListener = {
+        .logical_position = [](void* data, zxdg_output_v1*, int32_t x, int32_t y) {
+            auto* d = static_cast<WaylandData*>(data);
+            d->mOutputX = x;
+            d->mOutputY = y;
+        },
+        .logical_size = [](void*, zxdg_output_v1*, int32_t, int32_t) {},
+        .done        = [](void*, zxdg_output_v1*) {},
+        .name        = [](void*, zxdg_output_v1*, const char*) {},
+        .description = [](void*, zxdg_output_v1*, const char*) {},
+    };
+    zxdg_output_v1_add_listener(xdgOutput, &xdgOutputListener, &mData);
+    wl_display_roundtrip(mData.mDisplay);
+    zxdg_output_v1_destroy(xdgOutput);
+  }
+
+  mData.mPointerEventReceived = false;
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Object Native::createPointerQueryResult(Napi::Env env, bool timedOut) const {
   // Return the pointer coordinates and work area geometry
   Napi::Object result = Napi::Object::New(env);
   result.Set("pointerX", Napi::Number::New(env, mData.mPointerX + mData.mOutputX));
   result.Set("pointerY", Napi::Number::New(env, mData.mPointerY + mData.mOutputY));
-  result.Set("pointerGetTimedOut", Napi::Boolean::New(env,mPointerGetTimedOut));
+  result.Set("pointerGetTimedOut", Napi::Boolean::New(env, timedOut));
   result.Set("workAreaWidth", Napi::Number::New(env, mData.mWorkAreaWidth));
   result.Set("workAreaHeight", Napi::Number::New(env, mData.mWorkAreaHeight));
 
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::endPointerQuery(bool keepSurface) {
   // Clean up Wayland resources
-  destroySurfaceAndPointer();
+  if (keepSurface) {
+    parkSurface();
+  } else {
+    destroySurfaceAndPointer();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::onPointerQueryDisplay(uv_poll_t* handle, int status, int events) {
+  auto*        query   = static_cast<PointerQuery*>(handle->data);
+  wl_display*  display = query->mNative->mData.mDisplay;
+  WaylandData& data    = query->mNative->mData;
+
+  // The events are read like in the blocking loop. If the connection breaks, we handle
+  // it like a timeout so that the default position is used.
+  bool failed = status < 0;
+  if (!failed) {
+    if (wl_display_prepare_read(display) == 0) {
+      failed = wl_display_read_events(display) < 0;
+    }
+    failed = failed || wl_display_dispatch_pending(display) < 0;
+    wl_display_flush(display);
+  }
+
+  if (failed) {
+    std::cerr << "Failed to read from the Wayland display in the pointer query\n";
+    query->mNative->finishPointerQuery(true);
+  } else if (data.mPointerEventReceived) {
+    query->mNative->finishPointerQuery(false);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::onPointerQueryTimer(uv_poll_t* handle, int status, int events) {
+  auto* query = static_cast<PointerQuery*>(handle->data);
+
+  uint64_t expirations = 0;
+  if (read(query->mTimerFd, &expirations, sizeof(expirations)) < 0 && status == 0) {
+    return;
+  }
+
+  query->mNative->finishPointerQuery(true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::onPointerQueryClosed(uv_handle_t* handle) {
+  auto* query = static_cast<PointerQuery*>(handle->data);
+
+  if (--query->mOpenHandles == 0) {
+    close(query->mTimerFd);
+    delete query;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::finishPointerQuery(bool timedOut) {
+  PointerQuery* query = mPointerQuery;
+  Napi::Env     env   = query->mDeferreds.front().Env();
+
+  // We are usually called from libuv, so we need a scope for the JavaScript values. The
+  // callback scope runs the microtasks of the resolved promises once it is closed.
+  Napi::HandleScope   handleScope(env);
+  Napi::CallbackScope callbackScope(env, query->mContext);
+
+  for (auto const& deferred : query->mDeferreds) {
+    deferred.Resolve(createPointerQueryResult(env, timedOut));
+  }
+
+  query->mDeferreds.clear();
+  closePointerQuery();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::finishPointerQueryIfReceived() {
+  if (mPointerQuery && mData.mPointerEventReceived) {
+    finishPointerQuery(false);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::closePointerQuery() {
+  if (!mPointerQuery) {
+    return;
+  }
+
+  PointerQuery* query = mPointerQuery;
+  mPointerQuery       = nullptr;
+
+  uv_poll_stop(&query->mDisplayPoll);
+  uv_poll_stop(&query->mTimerPoll);
+  uv_close(reinterpret_cast<uv_handle_t*>(&query->mDisplayPoll), &onPointerQueryClosed);
+  uv_close(reinterpret_cast<uv_handle_t*>(&query->mTimerPoll), &onPointerQueryClosed);
+
+  endPointerQuery(query->mKeepSurface);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::captureBackdrop(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() != 5 || !info[0].IsNumber() || !info[1].IsNumber() ||
+      !info[2].IsNumber() || !info[3].IsNumber() || !info[4].IsNumber()) {
+    Napi::TypeError::New(env, "Five numbers expected").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  // The sigma comes from the menu theme, so it may be anything. Nothing is captured
+  // unless it is a positive number.
+  double sigma = info[4].As<Napi::Number>().DoubleValue();
+  if (!std::isfinite(sigma) || sigma <= 0) {
+    return env.Null();
+  }
+
+  auto image = mScreenCapture.capture(info[0].As<Napi::Number>().Int32Value(),
+      info[1].As<Napi::Number>().Int32Value(), info[2].As<Napi::Number>().Int32Value(),
+      info[3].As<Napi::Number>().Int32Value(), sigma);
+
+  if (!image) {
+    return env.Null();
+  }
+
+  // Electron does not allow external buffers, so the pixels are copied.
+  Napi::ArrayBuffer data = Napi::ArrayBuffer::New(env, image->rgba.size());
+  std::copy(image->rgba.begin(), image->rgba.end(), static_cast<uint8_t*>(data.Data()));
+
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("width", image->width);
+  result.Set("height", image->height);
+  result.Set("data", data);
+
   return result;
 }
 
@@ -806,6 +1279,9 @@ Napi::Value Native::getPointerPositionAndWorkAreaSize(const Napi::CallbackInfo&
 
 void Native::createSurfaceAndPointer() {
   if (mData.mSurface) {
+    if (mData.mSurfaceParked) {
+      unparkSurface();
+    }
     return; // already created
   }
 
@@ -826,6 +1302,10 @@ void Native::createSurfaceAndPointer() {
   };
   wl_surface_add_listener(mData.mSurface, &wlSurfaceListener, &mData);
 
+  if (mData.mViewporter) {
+    mData.mViewport = wp_viewporter_get_viewport(mData.mViewporter, mData.mSurface);
+  }
+
   static const zwlr_layer_surface_v1_listener surfaceListener = {
       .configure =
           [](void* data, zwlr_layer_surface_v1* surface, uint32_t serial, uint32_t width,
@@ -835,24 +1315,23 @@ void Native::createSurfaceAndPointer() {
             // Ack configure so compositor knows we handled it
             zwlr_layer_surface_v1_ack_configure(surface, serial);
 
-            // Only recreate the buffer if the work area therefore the needed size changes
-            if (d->mWorkAreaWidth != width || d->mWorkAreaHeight != height) {
-              d->mWorkAreaWidth  = width;
-              d->mWorkAreaHeight = height;
-
-              // Create or update the buffer with requested size
-              if (d->mPixelBuffer) {
-                wl_buffer_destroy(d->mPixelBuffer);
-                d->mPixelBuffer = nullptr;
+            d->mWorkAreaWidth  = width;
+            d->mWorkAreaHeight = height;
+
+            // With a viewport, a single transparent pixel is scaled to the size of the
+            // surface. Else the buffer needs the full size. Either way, the buffer is
+            // only recreated if its size changes.
+            bool ok = false;
+            if (d->mViewport) {
+              ok = Native::reservePixelBuffer(*d, 1, 1);
+              if (ok && width > 0 && height > 0) {
+                wp_viewport_set_destination(d->mViewport, width, height);
               }
-
-              // ARGB Color Buffer (useful for debugging, I'll set to transparent but it
-              // doesn't hurt to keep it here just in case for now)
-              constexpr uint32_t fillColor = 0x00000000;
-
-              d->mPixelBuffer = createPixelBuffer(d->mShm, width, height, fillColor);
+            } else {
+              ok = Native::reservePixelBuffer(*d, width, height);
             }
-            if (d->mPixelBuffer) {
+
+            if (ok) {
               wl_surface_attach(d->mSurface, d->mPixelBuffer, 0, 0);
               wl_surface_damage(d->mSurface, 0, 0, width, height);
               wl_surface_commit(d->mSurface);
@@ -862,6 +1341,8 @@ void Native::createSurfaceAndPointer() {
           },
       .closed =
           [](void* data, zwlr_layer_surface_v1* surface) {
+            auto* d           = static_cast<Native::WaylandData*>(data);
+            d->mSurfaceClosed = true;
             std::cerr << "Layer surface closed by compositor\n";
           },
   };
@@ -886,7 +1367,14 @@ void Native::createSurfaceAndPointer() {
             d->mPointerY             = wl_fixed_to_double(y);
             d->mPointerEventReceived = true;
           },
-      .leave = [](void*, wl_pointer*, uint32_t, wl_surface*) {},
+      // When a kept probe surface is mapped again, motion events of the previous call
+      // may still be queued. The leave event of the unmapped surface follows them, so
+      // they are discarded here.
+      .leave =
+          [](void* data, wl_pointer*, uint32_t, wl_surface*) {
+            auto* d                  = static_cast<Native::WaylandData*>(data);
+            d->mPointerEventReceived = false;
+          },
       .motion =
           [](void* data, wl_pointer*, uint32_t, wl_fixed_t x, wl_fixed_t y) {
             auto* d                  = static_cast<Native::WaylandData*>(data);
@@ -952,6 +1440,11 @@ void Native::destroySurfaceAndPointer() {
     mData.mLayerSurface = nullptr;
   }
 
+  if (mData.mViewport) {
+    wp_viewport_destroy(mData.mViewport);
+    mData.mViewport = nullptr;
+  }
+
   if (mData.mSurface) {
     wl_surface_commit(mData.mSurface);
     wl_display_flush(mData.mDisplay);
@@ -960,6 +1453,8 @@ void Native::destroySurfaceAndPointer() {
   }
 
   mData.mPointerEventReceived = false;
+  mData.mSurfaceParked        = false;
+  mData.mSurfaceClosed        = false;
 
   mData.mOutput = nullptr;
   mData.mOutputX = 0;
@@ -968,6 +1463,118 @@ void Native::destroySurfaceAndPointer() {
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
+void Native::parkSurface() {
+  // Without a buffer, the layer surface is unmapped. The compositor does not draw it
+  // anymore and sends a leave event to the pointer. The empty input region makes sure
+  // that it cannot receive input in any case.
+  wl_region* region = wl_compositor_create_region(mData.mCompositor);
+  wl_surface_set_input_region(mData.mSurface, region);
+  wl_region_destroy(region);
+
+  wl_surface_attach(mData.mSurface, nullptr, 0, 0);
+  wl_surface_commit(mData.mSurface);
+  wl_display_flush(mData.mDisplay);
+
+  mData.mSurfaceParked        = true;
+  mData.mPointerEventReceived = false;
+
+  mData.mOutputX = 0;
+  mData.mOutputY = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::unparkSurface() {
+  // An unmapped layer surface is mapped again like a new one: We commit it without a
+  // buffer and the configure handler attaches the buffer once the compositor has sent
+  // the size. The buffer is reused if the size did not change. The input region is reset
+  // to cover the entire surface, so the compositor sends a new enter event.
+  zwlr_layer_surface_v1_set_size(mData.mLayerSurface, 0, 0);
+  zwlr_layer_surface_v1_set_anchor(mData.mLayerSurface,
+      ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP | ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM |
+          ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT | ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT);
+  wl_surface_set_input_region(mData.mSurface, nullptr);
+  wl_surface_commit(mData.mSurface);
+  wl_display_roundtrip(mData.mDisplay);
+
+  mData.mSurfaceParked = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool Native::reservePixelBuffer(WaylandData& data, int32_t width, int32_t height) {
+  if (data.mPixelBuffer && data.mBufferWidth == width && data.mBufferHeight == height) {
+    return true;
+  }
+
+  if (data.mPixelBuffer) {
+    wl_buffer_destroy(data.mPixelBuffer);
+    data.mPixelBuffer = nullptr;
+  }
+
+  int32_t stride = width * 4;
+  size_t  size   = size_t(stride) * size_t(height);
+
+  if (size == 0) {
+    return false;
+  }
+
+  // The memory file is only grown. Its new pages are zero-filled by the kernel, which is
+  // a transparent ARGB8888 pixel, so we never have to touch them.
+  if (size > data.mPoolSize) {
+    if (data.mPoolFd < 0) {
+      data.mPoolFd = memfd_create("kando-pixel-buffer", MFD_CLOEXEC);
+      if (data.mPoolFd < 0) {
+        return false;
+      }
+    }
+
+    if (ftruncate(data.mPoolFd, off_t(size)) < 0) {
+      return false;
+    }
+
+    if (data.mPool) {
+      wl_shm_pool_resize(data.mPool, int32_t(size));
+    } else {
+      data.mPool = wl_shm_create_pool(data.mShm, data.mPoolFd, int32_t(size));
+    }
+
+    data.mPoolSize = size;
+  }
+
+  data.mPixelBuffer = wl_shm_pool_create_buffer(
+      data.mPool, 0, width, height, stride, WL_SHM_FORMAT_ARGB8888);
+  data.mBufferWidth  = width;
+  data.mBufferHeight = height;
+
+  return data.mPixelBuffer != nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::releasePixelBuffer(WaylandData& data) {
+  if (data.mPixelBuffer) {
+    wl_buffer_destroy(data.mPixelBuffer);
+    data.mPixelBuffer = nullptr;
+  }
+
+  if (data.mPool) {
+    wl_shm_pool_destroy(data.mPool);
+    data.mPool = nullptr;
+  }
+
+  if (data.mPoolFd >= 0) {
+    close(data.mPoolFd);
+    data.mPoolFd = -1;
+  }
+
+  data.mPoolSize     = 0;
+  data.mBufferWidth  = 0;
+  data.mBufferHeight = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
 // This generates the addon and makes it available to JavaScript.
 NODE_API_ADDON(Native)
 
@@ -11,6 +11,12 @@
 #ifndef NATIVE_HPP
 #define NATIVE_HPP
 
+#include "ClipboardOwner.hpp"
+#include "ScreenCapture.hpp"
+#include "TextKeymap.hpp"
+#include "ToplevelRegistry.hpp"
+#include "VirtualKeyboard.hpp"
+#include "viewporter.h"
 #include "virtual-keyboard-unstable-v1.h"
 #include "wlr-foreign-toplevel-management-unstable-v1.h"
 #include "wlr-layer-shell-unstable-v1.h"
@@ -19,8 +25,12 @@
 #include "xdg-output-unstable-v1.h"
 
 #include <napi.h>
+#include <uv.h>
 #include <xkbcommon/xkbcommon.h>
 
+#include <string>
+#include <vector>
+
 /**
  * This class allows moving the mouse pointer and simulating key presses using the
  * virtual-pointer and virtual-keyboard Wayland protocols. It also provides a method for
@@ -76,32 +86,132 @@ class Native : public Napi::Addon<Native> {
   void simulateKey(const Napi::CallbackInfo& info);
 
   /**
-   * This function gets a list of all currently open windows using the foreign-toplevel
-   * protocol.
+   * This function is called when the simulateKeys function is called from JavaScript.
+   * It sends all given key events back-to-back and waits only once for the compositor
+   * to process them. Delays between the keys have to be handled by the caller by
+   * splitting the sequence.
+   *
+   * @param info The arguments passed to the simulateKeys function. It should contain an
+   *             array of objects with a 'keycode' number and a 'down' boolean.
+   */
+  void simulateKeys(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the simulateText function is called from JavaScript.
+   * It types the given text with the virtual keyboard. The keys are looked up in the
+   * keymap of the real keyboard. If the text contains characters which are not part of
+   * this keymap, the whole text is typed with a temporary keymap which contains exactly
+   * the required characters. Afterwards, the original keymap is restored. It returns
+   * false if the keymap of the real keyboard is not known.
+   *
+   * @param info The arguments passed to the simulateText function. It should contain a
+   *             string.
+   */
+  Napi::Value simulateText(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the setClipboard function is called from JavaScript.
+   * It offers the given entries as the new clipboard content using the wlr-data-control
+   * protocol. The content is sent to other clients by the clipboard owner thread which
+   * is started on the first call. It returns false if the compositor does not support
+   * the protocol.
+   *
+   * @param info The arguments passed to the setClipboard function. It should contain an
+   *             array of objects with a 'mimeType' string and a 'data' string or buffer
+   *             and optionally a boolean which selects the primary selection.
+   */
+  Napi::Value setClipboard(const Napi::CallbackInfo& info);
+
+  /**
+   * Sends a press and a release for each of the given keys. The modifiers are set as
+   * required for each key. They are not reset afterwards.
+   */
+  void sendKeyStrokes(std::vector<KeyPosition> const& strokes, xkb_layout_index_t layout);
+
+  /**
+   * Sends the temporary keymap for the given keysyms to the compositor. Returns false if
+   * the keymap cannot be compiled.
+   */
+  bool sendTemporaryKeymap(std::vector<xkb_keysym_t> const& keysyms);
+
+  /**
+   * This function gets a list of all currently open windows from the toplevel registry.
+   * The registry is started on the first call and then kept up to date by its event
+   * thread, so no round trip to the compositor is required.
    */
   Napi::Value getOpenWindows(const Napi::CallbackInfo& info);
 
   /**
-   * This function gets the currently focused window using the foreign-toplevel protocol.
+   * This function gets the currently focused window from the toplevel registry.
    */
   Napi::Value getFocusedWindow(const Napi::CallbackInfo& info);
 
   /**
-   * This function focuses the given window using the foreign-toplevel protocol.
+   * This function focuses the given window using the foreign-toplevel protocol. The
+   * window is looked up in the toplevel registry and activated with a single request.
    */
   void focusWindow(const Napi::CallbackInfo& info);
 
+  /**
+   * This function registers a callback which is called with the focused window (or null)
+   * whenever the activated toplevel changes. The toplevels are tracked on a background
+   * thread which is started when the first callback is registered. If no function is
+   * passed, the previous callback is removed.
+   *
+   * @return True if the foreign-toplevel protocol is available and the callback will be
+   *         called.
+   */
+  Napi::Value onActiveWindowChanged(const Napi::CallbackInfo& info);
+
+  /**
+   * This function registers a callback which is called with the list of all open windows
+   * whenever a toplevel is opened, closed or changed. If no function is passed, the
+   * previous callback is removed.
+   *
+   * @return True if the foreign-toplevel protocol is available and the callback will be
+   *         called.
+   */
+  Napi::Value onWindowsChanged(const Napi::CallbackInfo& info);
+
   /**
    * This function gets the pointer's location and work area size by spawning a wlr layer
-   * shell surface, waiting for the event, then cleaning up.
+   * shell surface, waiting for the event, then cleaning up. If the third argument is
+   * true, the surface and the input devices are not destroyed but only unmapped. The
+   * next call then only has to map the surface again.
    *
    * @param info The arguments passed to the getPointerPositionAndWorkAreaSize function.
-   *             It does not expect any arguments.
+   *             It expects the timeouts for mouse and touch input in milliseconds and
+   *             optionally a boolean which keeps the surface.
    * @return A JavaScript object containing the pointer's x and y coordinates and the
    *         work area width and height.
    */
   Napi::Value getPointerPositionAndWorkAreaSize(const Napi::CallbackInfo& info);
 
+  /**
+   * This is the same as getPointerPositionAndWorkAreaSize() but it does not block. The
+   * Wayland display and a timerfd for the timeout are watched by the libuv event loop of
+   * the main thread. If this is called while a query is running, the returned promise is
+   * resolved together with the running one.
+   *
+   * @param info The same arguments as for getPointerPositionAndWorkAreaSize.
+   * @return A promise which is resolved with the same object as returned by
+   *         getPointerPositionAndWorkAreaSize or with null if the query failed.
+   */
+  Napi::Value getPointerPositionAndWorkAreaSizeAsync(const Napi::CallbackInfo& info);
+
+  /**
+   * This function captures the given rectangle of the screen using the wlr-screencopy
+   * protocol and blurs it. The result contains the width, the height, and an ArrayBuffer
+   * with RGBA pixels. It is usually smaller than the rectangle. It returns null if the
+   * compositor does not support screencopy or if the rectangle is not fully inside one
+   * output.
+   *
+   * @param info The arguments passed to the captureBackdrop function. It should contain
+   *             the x, y, width, and height of the rectangle in logical pixels as well as
+   *             the standard deviation of the blur in logical pixels.
+   */
+  Napi::Value captureBackdrop(const Napi::CallbackInfo& info);
+
   /**
    * Creates the Wayland surface and initializes pointer tracking.
    *
@@ -118,6 +228,81 @@ class Native : public Napi::Addon<Native> {
    */
   void destroySurfaceAndPointer();
 
+  /**
+   * Unmaps the surface and clears its input region but keeps it and the input devices.
+   * The compositor does not draw or deliver input to it until it is unparked again.
+   */
+  void parkSurface();
+
+  /**
+   * Maps a parked surface again. This waits for the configure event of the compositor,
+   * so that the pointer enter event follows.
+   */
+  void unparkSurface();
+
+  /**
+   * Creates or maps the probe surface and requests the position of its output. Returns
+   * false if the surface cannot receive pointer or touch input.
+   */
+  bool beginPointerQuery(bool keepSurface);
+
+  /**
+   * Returns the result of the current pointer query. This has to be called before
+   * endPointerQuery() as the output position is reset there.
+   */
+  Napi::Object createPointerQueryResult(Napi::Env env, bool timedOut) const;
+
+  /** Unmaps or destroys the probe surface, depending on the argument. */
+  void endPointerQuery(bool keepSurface);
+
+  /**
+   * The state of the query started by getPointerPositionAndWorkAreaSizeAsync(). It is
+   * deleted once libuv has closed both handles.
+   */
+  struct PointerQuery {
+    PointerQuery(Napi::Env env)
+        : mContext(env, "kando-pointer-query") {
+    }
+
+    Native*            mNative      = nullptr;
+    Napi::AsyncContext mContext;
+    uv_poll_t          mDisplayPoll = {};
+    uv_poll_t          mTimerPoll   = {};
+    int                mTimerFd     = -1;
+    int                mOpenHandles = 0;
+    bool               mKeepSurface = false;
+
+    std::vector<Napi::Promise::Deferred> mDeferreds;
+  };
+
+  // The libuv callbacks of the running PointerQuery.
+  static void onPointerQueryDisplay(uv_poll_t* handle, int status, int events);
+  static void onPointerQueryTimer(uv_poll_t* handle, int status, int events);
+  static void onPointerQueryClosed(uv_handle_t* handle);
+
+  // Resolves all promises of the running PointerQuery and closes it.
+  void finishPointerQuery(bool timedOut);
+
+  // Other calls on the main connection dispatch events during their roundtrips. If one of
+  // them has dispatched the pointer event of a running PointerQuery, the display fd will
+  // not become readable for it anymore. So these calls finish the query themselves.
+  void finishPointerQueryIfReceived();
+
+  // Stops watching the file descriptors and unmaps or destroys the probe surface. The
+  // handles are closed asynchronously by libuv.
+  void closePointerQuery();
+
+  struct WaylandData;
+
+  /**
+   * Makes sure that the pixel buffer of the probe surface has the given size. The memory
+   * file and the pool are reused if they are large enough. The memory is never written,
+   * so it stays zero-filled and the buffer fully transparent. Returns false if the
+   * memory file cannot be created or resized.
+   */
+  static bool reservePixelBuffer(WaylandData& data, int32_t width, int32_t height);
+  static void releasePixelBuffer(WaylandData& data);
+
   struct WaylandData {
     wl_display*    mDisplay    = nullptr;
     wl_registry*   mRegistry   = nullptr;
@@ -140,13 +325,34 @@ class Native : public Napi::Addon<Native> {
     xkb_keymap*  mXkbKeymap  = nullptr;
     xkb_state*   mXkbState   = nullptr;
 
+    // The real keyboard is kept so that we are notified when its keymap changes. The
+    // keymaps are stored in serialized form so that we can detect whether the compositor
+    // sent us the same keymap again or the temporary keymap of simulateText().
+    wl_keyboard* mKeyboard        = nullptr;
+    std::string  mKeymapString    = "";
+    std::string  mTemporaryKeymap = "";
+    bool         mKeymapChanged   = false;
+
     wl_pointer*            mPointer      = nullptr;
     wl_touch*              mTouch        = nullptr;
     zwlr_layer_shell_v1*   mLayerShell   = nullptr;
     zwlr_layer_surface_v1* mLayerSurface = nullptr;
     wl_surface*            mSurface      = nullptr;
     wl_shm*                mShm          = nullptr;
-    wl_buffer*             mPixelBuffer  = nullptr;
+
+    // If the compositor supports wp_viewporter, the probe surface uses a single
+    // transparent pixel which is scaled to the size of the work area. Else the pixel
+    // buffer has the size of the work area.
+    wp_viewporter* mViewporter = nullptr;
+    wp_viewport*   mViewport   = nullptr;
+
+    // The reused pixel buffer.
+    int          mPoolFd       = -1;
+    size_t       mPoolSize     = 0;
+    wl_shm_pool* mPool         = nullptr;
+    wl_buffer*   mPixelBuffer  = nullptr;
+    int32_t      mBufferWidth  = 0;
+    int32_t      mBufferHeight = 0;
 
     double mPointerX       = 0;
     double mPointerY       = 0;
@@ -157,9 +363,34 @@ class Native : public Napi::Addon<Native> {
 
     // Track whether a pointer event has been received (used for blocking wait).
     bool mPointerEventReceived = false;
+
+    // Whether the surface has been kept unmapped since the last call and whether the
+    // compositor has closed its layer surface.
+    bool mSurfaceParked = false;
+    bool mSurfaceClosed = false;
   };
 
   WaylandData mData{};
+
+  // This is only set while an asynchronous pointer query is running.
+  PointerQuery* mPointerQuery = nullptr;
+
+  // This tracks the toplevels for the callbacks above. The thread-safe functions are
+  // used to call the JavaScript callbacks from its event thread.
+  ToplevelRegistry         mToplevelRegistry;
+  Napi::ThreadSafeFunction mActiveWindowCallback;
+  Napi::ThreadSafeFunction mWindowsCallback;
+
+  // This uses its own connection to the compositor which is kept open between captures.
+  ScreenCapture mScreenCapture;
+
+  // This is started when the clipboard is set for the first time. It keeps running so
+  // that the content stays available.
+  ClipboardOwner mClipboardOwner;
+
+  // The table of simulateText(). It is only rebuilt if the keymap or the layout changes.
+  TextKeymap         mTextKeymap;
+  xkb_layout_index_t mTextKeymapLayout = XKB_LAYOUT_INVALID;
 };
 
 #endif // NATIVE_HPP
@@ -0,0 +1,455 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "ScreenCapture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// A capture waits at most this many milliseconds for the compositor.
+constexpr int CAPTURE_TIMEOUT = 500;
+
+// Returns true if the given wl_shm format can be passed to blurImage(). If swapRedBlue is
+// set, red is the first byte in memory.
+bool isSupportedFormat(uint32_t format, bool& swapRedBlue) {
+  switch (format) {
+  case WL_SHM_FORMAT_XRGB8888:
+  case WL_SHM_FORMAT_ARGB8888:
+    swapRedBlue = false;
+    return true;
+  case WL_SHM_FORMAT_XBGR8888:
+  case WL_SHM_FORMAT_ABGR8888:
+    swapRedBlue = true;
+    return true;
+  default:
+    return false;
+  }
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+ScreenCapture::~ScreenCapture() {
+  disconnect();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<BlurredImage> ScreenCapture::capture(
+    int32_t x, int32_t y, int32_t width, int32_t height, double sigma) {
+
+  if (width <= 0 || height <= 0 || !connect()) {
+    return std::nullopt;
+  }
+
+  // The compositor would clip the region to the output. We rather capture nothing than
+  // a part of the requested rectangle.
+  auto output = std::find_if(mOutputs.begin(), mOutputs.end(), [&](auto const& o) {
+    return x >= o->x && y >= o->y && x + width <= o->x + o->width &&
+           y + height <= o->y + o->height;
+  });
+
+  if (output == mOutputs.end()) {
+    return std::nullopt;
+  }
+
+  static const zwlr_screencopy_frame_v1_listener frameListener = {
+      .buffer =
+          [](void* data, zwlr_screencopy_frame_v1*, uint32_t format, uint32_t width,
+              uint32_t height, uint32_t stride) {
+            auto* frame   = static_cast<Frame*>(data);
+            frame->format = format;
+            frame->width  = width;
+            frame->height = height;
+            frame->stride = stride;
+            frame->hasShm = true;
+          },
+      .flags =
+          [](void* data, zwlr_screencopy_frame_v1*, uint32_t flags) {
+            static_cast<Frame*>(data)->yInvert =
+                flags & ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT;
+          },
+      .ready =
+          [](void* data, zwlr_screencopy_frame_v1*, uint32_t, uint32_t, uint32_t) {
+            static_cast<Frame*>(data)->ready = true;
+          },
+      .failed =
+          [](void* data, zwlr_screencopy_frame_v1*) {
+            static_cast<Frame*>(data)->failed = true;
+          },
+      .damage =
+          [](void*, zwlr_screencopy_frame_v1*, uint32_t, uint32_t, uint32_t, uint32_t) {},
+      .linux_dmabuf =
+          [](void*, zwlr_screencopy_frame_v1*, uint32_t, uint32_t, uint32_t) {},
+      .buffer_done =
+          [](void* data, zwlr_screencopy_frame_v1*) {
+            static_cast<Frame*>(data)->bufferDone = true;
+          },
+  };
+
+  Frame frame;
+  auto* handle = zwlr_screencopy_manager_v1_capture_output_region(mManager, 0,
+      (*output)->output, x - (*output)->x, y - (*output)->y, width, height);
+  zwlr_screencopy_frame_v1_add_listener(handle, &frameListener, &frame);
+
+  // Before version 3, the buffer event is the only one sent before the copy request.
+  bool success = dispatchUntil([&]() {
+    return frame.failed || (mManagerVersion >= 3 ? frame.bufferDone : frame.hasShm);
+  });
+
+  bool swapRedBlue = false;
+  success = success && !frame.failed && frame.hasShm &&
+            isSupportedFormat(frame.format, swapRedBlue) && reserveBuffer(frame);
+
+  if (success) {
+    zwlr_screencopy_frame_v1_copy(handle, mBuffer);
+    success = dispatchUntil([&]() { return frame.ready || frame.failed; }) && frame.ready;
+  }
+
+  zwlr_screencopy_frame_v1_destroy(handle);
+
+  if (!success) {
+    // If the compositor went away, we will reconnect on the next capture.
+    if (wl_display_get_error(mDisplay)) {
+      disconnect();
+    } else {
+      wl_display_flush(mDisplay);
+    }
+
+    return std::nullopt;
+  }
+
+  // The buffer may have a higher resolution than the logical rectangle if the output is
+  // scaled. The blur is specified in logical pixels.
+  double scale = double(frame.width) / width;
+
+  BlurredImage image = blurImage(
+      mPoolData, frame.width, frame.height, frame.stride, sigma * scale, swapRedBlue);
+
+  if (frame.yInvert) {
+    size_t const         rowSize = size_t(image.width) * 4;
+    std::vector<uint8_t> row(rowSize);
+
+    for (uint32_t top = 0, bottom = image.height - 1; top < bottom; ++top, --bottom) {
+      uint8_t* a = image.rgba.data() + top * rowSize;
+      uint8_t* b = image.rgba.data() + bottom * rowSize;
+      std::memcpy(row.data(), a, rowSize);
+      std::memcpy(a, b, rowSize);
+      std::memcpy(b, row.data(), rowSize);
+    }
+  }
+
+  return image;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScreenCapture::connect() {
+  if (mDisplay) {
+    return true;
+  }
+
+  if (mUnsupported) {
+    return false;
+  }
+
+  mDisplay = wl_display_connect(nullptr);
+  if (!mDisplay) {
+    return false;
+  }
+
+  static const wl_registry_listener registryListener = {
+      .global =
+          [](void* data, wl_registry* registry, uint32_t name, const char* interface,
+              uint32_t version) {
+            static_cast<ScreenCapture*>(data)->addGlobal(
+                registry, name, interface, version);
+          },
+      .global_remove =
+          [](void* data, wl_registry*, uint32_t name) {
+            static_cast<ScreenCapture*>(data)->removeOutput(name);
+          },
+  };
+
+  mRegistry = wl_display_get_registry(mDisplay);
+  wl_registry_add_listener(mRegistry, &registryListener, this);
+
+  // The first roundtrip binds the globals, the second one receives the logical geometry
+  // of the outputs.
+  wl_display_roundtrip(mDisplay);
+
+  if (!mShm || !mManager || !mXdgOutputManager) {
+    mUnsupported = true;
+    disconnect();
+    return false;
+  }
+
+  // The outputs may have been announced before the xdg-output manager.
+  for (auto& output : mOutputs) {
+    watchOutput(*output);
+  }
+
+  wl_display_roundtrip(mDisplay);
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ScreenCapture::disconnect() {
+  releaseBuffer();
+
+  for (auto& output : mOutputs) {
+    if (output->xdgOutput) {
+      zxdg_output_v1_destroy(output->xdgOutput);
+    }
+
+    wl_output_destroy(output->output);
+  }
+
+  mOutputs.clear();
+
+  if (mXdgOutputManager) {
+    zxdg_output_manager_v1_destroy(mXdgOutputManager);
+    mXdgOutputManager = nullptr;
+  }
+
+  if (mManager) {
+    zwlr_screencopy_manager_v1_destroy(mManager);
+    mManager = nullptr;
+  }
+
+  if (mShm) {
+    wl_shm_destroy(mShm);
+    mShm = nullptr;
+  }
+
+  if (mRegistry) {
+    wl_registry_destroy(mRegistry);
+    mRegistry = nullptr;
+  }
+
+  if (mDisplay) {
+    wl_display_disconnect(mDisplay);
+    mDisplay = nullptr;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ScreenCapture::addGlobal(
+    wl_registry* registry, uint32_t name, const char* interface, uint32_t version) {
+
+  if (std::strcmp(interface, wl_output_interface.name) == 0) {
+    auto* output = wl_registry_bind(registry, name, &wl_output_interface, 1);
+    addOutput(name, static_cast<wl_output*>(output));
+  } else if (!mShm && std::strcmp(interface, wl_shm_interface.name) == 0) {
+    mShm = static_cast<wl_shm*>(wl_registry_bind(registry, name, &wl_shm_interface, 1));
+  } else if (!mManager &&
+             std::strcmp(interface, zwlr_screencopy_manager_v1_interface.name) == 0) {
+    mManagerVersion = std::min(version, 3u);
+    mManager        = static_cast<zwlr_screencopy_manager_v1*>(wl_registry_bind(
+        registry, name, &zwlr_screencopy_manager_v1_interface, mManagerVersion));
+  } else if (!mXdgOutputManager &&
+             std::strcmp(interface, zxdg_output_manager_v1_interface.name) == 0) {
+    mXdgOutputManager = static_cast<zxdg_output_manager_v1*>(wl_registry_bind(
+        registry, name, &zxdg_output_manager_v1_interface, std::min(version, 3u)));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ScreenCapture::addOutput(uint32_t name, wl_output* output) {
+  auto entry    = std::make_unique<Output>();
+  entry->name   = name;
+  entry->output = output;
+
+  watchOutput(*entry);
+  mOutputs.push_back(std::move(entry));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ScreenCapture::removeOutput(uint32_t name) {
+  auto output = std::find_if(mOutputs.begin(), mOutputs.end(),
+      [&](auto const& o) { return o->name == name; });
+
+  if (output == mOutputs.end()) {
+    return;
+  }
+
+  if ((*output)->xdgOutput) {
+    zxdg_output_v1_destroy((*output)->xdgOutput);
+  }
+
+  wl_output_destroy((*output)->output);
+  mOutputs.erase(output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ScreenCapture::watchOutput(Output& output) {
+  if (output.xdgOutput || !mXdgOutputManager) {
+    return;
+  }
+
+  static const zxdg_output_v1_listener xdgOutputListener = {
+      .logical_position =
+          [](void* data, zxdg_output_v1*, int32_t x, int32_t y) {
+            auto* output = static_cast<Output*>(data);
+            output->x    = x;
+            output->y    = y;
+          },
+      .logical_size =
+          [](void* data, zxdg_output_v1*, int32_t width, int32_t height) {
+            auto* output   = static_cast<Output*>(data);
+            output->width  = width;
+            output->height = height;
+          },
+      .done        = [](void*, zxdg_output_v1*) {},
+      .name        = [](void*, zxdg_output_v1*, const char*) {},
+      .description = [](void*, zxdg_output_v1*, const char*) {},
+  };
+
+  output.xdgOutput =
+      zxdg_output_manager_v1_get_xdg_output(mXdgOutputManager, output.output);
+  zxdg_output_v1_add_listener(output.xdgOutput, &xdgOutputListener, &output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScreenCapture::dispatchUntil(std::function<bool()> const& condition) {
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(CAPTURE_TIMEOUT);
+
+  while (!condition()) {
+    if (wl_display_prepare_read(mDisplay) != 0) {
+      if (wl_display_dispatch_pending(mDisplay) < 0) {
+        return false;
+      }
+
+      continue;
+    }
+
+    wl_display_flush(mDisplay);
+
+    int remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now())
+                        .count();
+
+    pollfd pfd = {.fd = wl_display_get_fd(mDisplay), .events = POLLIN, .revents = 0};
+    if (remaining <= 0 || poll(&pfd, 1, remaining) <= 0) {
+      wl_display_cancel_read(mDisplay);
+      return false;
+    }
+
+    if (wl_display_read_events(mDisplay) < 0 ||
+        wl_display_dispatch_pending(mDisplay) < 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScreenCapture::reserveBuffer(Frame const& frame) {
+  if (mBuffer && mBufferFormat == frame.format && mBufferWidth == frame.width &&
+      mBufferHeight == frame.height && mBufferStride == frame.stride) {
+    return true;
+  }
+
+  if (mBuffer) {
+    wl_buffer_destroy(mBuffer);
+    mBuffer = nullptr;
+  }
+
+  size_t size = size_t(frame.stride) * frame.height;
+
+  // The pool can only grow. If it is large enough, the new buffer simply uses the
+  // beginning of it.
+  if (size > mPoolSize) {
+    if (mPoolFd < 0) {
+      mPoolFd = memfd_create("kando-screencopy", MFD_CLOEXEC);
+    }
+
+    if (mPoolFd < 0 || ftruncate(mPoolFd, size) < 0) {
+      releaseBuffer();
+      return false;
+    }
+
+    if (mPoolData) {
+      munmap(mPoolData, mPoolSize);
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mPoolFd, 0);
+    mPoolData  = data == MAP_FAILED ? nullptr : static_cast<uint8_t*>(data);
+    mPoolSize  = mPoolData ? size : 0;
+
+    if (!mPoolData) {
+      releaseBuffer();
+      return false;
+    }
+
+    if (mPool) {
+      wl_shm_pool_resize(mPool, size);
+    } else {
+      mPool = wl_shm_create_pool(mShm, mPoolFd, size);
+    }
+  }
+
+  mBuffer = wl_shm_pool_create_buffer(
+      mPool, 0, frame.width, frame.height, frame.stride, frame.format);
+
+  mBufferFormat = frame.format;
+  mBufferWidth  = frame.width;
+  mBufferHeight = frame.height;
+  mBufferStride = frame.stride;
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ScreenCapture::releaseBuffer() {
+  if (mBuffer) {
+    wl_buffer_destroy(mBuffer);
+    mBuffer = nullptr;
+  }
+
+  if (mPool) {
+    wl_shm_pool_destroy(mPool);
+    mPool = nullptr;
+  }
+
+  if (mPoolData) {
+    munmap(mPoolData, mPoolSize);
+    mPoolData = nullptr;
+  }
+
+  if (mPoolFd >= 0) {
+    close(mPoolFd);
+    mPoolFd = -1;
+  }
+
+  mPoolSize = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,131 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef SCREEN_CAPTURE_HPP
+#define SCREEN_CAPTURE_HPP
+
+#include "Blur.hpp"
+#include "wlr-screencopy-unstable-v1.h"
+#include "xdg-output-unstable-v1.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+/**
+ * This class captures rectangles of the screen using the wlr-screencopy protocol and
+ * blurs them. It is used for the backdrop of the menu. Only the requested rectangle is
+ * copied by the compositor, so the cost depends on the size of the menu rather than on
+ * the size of the output.
+ *
+ * The connection to the compositor is opened on the first capture and kept open. The
+ * pixels are copied into a wl_shm buffer which is reused for subsequent captures. Its
+ * memory file is only grown if a larger rectangle is requested.
+ *
+ * All methods have to be called from the same thread. The events of the connection are
+ * only dispatched during a capture.
+ */
+class ScreenCapture {
+ public:
+  ScreenCapture() = default;
+  ~ScreenCapture();
+
+  ScreenCapture(ScreenCapture const& other)            = delete;
+  ScreenCapture& operator=(ScreenCapture const& other) = delete;
+
+  /**
+   * Captures the given rectangle and blurs it with the given standard deviation. All
+   * values are in the global logical coordinate space of the compositor. Returns nothing
+   * if the compositor does not support the wlr-screencopy and xdg-output protocols, if
+   * the rectangle is not fully inside one output, or if the capture fails.
+   */
+  std::optional<BlurredImage> capture(
+      int32_t x, int32_t y, int32_t width, int32_t height, double sigma);
+
+ private:
+  struct Output {
+    uint32_t        name      = 0;
+    wl_output*      output    = nullptr;
+    zxdg_output_v1* xdgOutput = nullptr;
+
+    // The logical geometry as reported by xdg-output.
+    int32_t x      = 0;
+    int32_t y      = 0;
+    int32_t width  = 0;
+    int32_t height = 0;
+  };
+
+  // The state of a single screencopy frame.
+  struct Frame {
+    uint32_t format  = 0;
+    uint32_t width   = 0;
+    uint32_t height  = 0;
+    uint32_t stride  = 0;
+    bool     hasShm  = false;
+    bool     yInvert = false;
+
+    bool bufferDone = false;
+    bool ready      = false;
+    bool failed     = false;
+  };
+
+  // Connects to the compositor and binds all required globals if this has not been done
+  // yet. Returns false if this fails.
+  bool connect();
+
+  // Destroys all Wayland objects and disconnects from the compositor.
+  void disconnect();
+
+  // Binds the given global if it is one of the interfaces we need.
+  void addGlobal(
+      wl_registry* registry, uint32_t name, const char* interface, uint32_t version);
+
+  void addOutput(uint32_t name, wl_output* output);
+  void removeOutput(uint32_t name);
+
+  // Requests the logical geometry of the given output.
+  void watchOutput(Output& output);
+
+  // Dispatches events until the given condition is true. Returns false if this takes too
+  // long or if the connection is lost.
+  bool dispatchUntil(std::function<bool()> const& condition);
+
+  // Makes sure that mBuffer has the format and the size of the given frame. The memory
+  // file and the pool are reused if they are large enough.
+  bool reserveBuffer(Frame const& frame);
+  void releaseBuffer();
+
+  wl_display*                 mDisplay          = nullptr;
+  wl_registry*                mRegistry         = nullptr;
+  wl_shm*                     mShm              = nullptr;
+  zwlr_screencopy_manager_v1* mManager          = nullptr;
+  uint32_t                    mManagerVersion   = 0;
+  zxdg_output_manager_v1*     mXdgOutputManager = nullptr;
+
+  // If the compositor lacks one of the protocols, we do not try again.
+  bool mUnsupported = false;
+
+  std::vector<std::unique_ptr<Output>> mOutputs;
+
+  // The reused buffer.
+  int          mPoolFd       = -1;
+  uint8_t*     mPoolData     = nullptr;
+  size_t       mPoolSize     = 0;
+  wl_shm_pool* mPool         = nullptr;
+  wl_buffer*   mBuffer       = nullptr;
+  uint32_t     mBufferFormat = 0;
+  uint32_t     mBufferWidth  = 0;
+  uint32_t     mBufferHeight = 0;
+  uint32_t     mBufferStride = 0;
+};
+
+#endif // SCREEN_CAPTURE_HPP
@@ -0,0 +1,138 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "TextKeymap.hpp"
+
+#include <bitset>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+xkb_keysym_t keysymFromCodepoint(char32_t codepoint) {
+  switch (codepoint) {
+  case '\n':
+    return XKB_KEY_Return;
+  case '\t':
+    return XKB_KEY_Tab;
+  case '\b':
+    return XKB_KEY_BackSpace;
+  default:
+    break;
+  }
+
+  // This also skips the carriage return of Windows line endings.
+  if (codepoint < 0x20 || (codepoint >= 0x7F && codepoint < 0xA0)) {
+    return XKB_KEY_NoSymbol;
+  }
+
+  return xkb_utf32_to_keysym(codepoint);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::string createKeymap(std::vector<xkb_keysym_t> const& keysyms) {
+  std::string keycodes;
+  std::string symbols;
+
+  for (size_t i = 0; i < keysyms.size(); ++i) {
+    std::string name = "<K" + std::to_string(i) + ">";
+
+    char keysymName[64];
+    if (xkb_keysym_get_name(keysyms[i], keysymName, sizeof(keysymName)) < 0) {
+      keysymName[0] = '\0';
+    }
+
+    keycodes += "    " + name + " = " + std::to_string(9 + i) + ";\n";
+    symbols += "    key " + name + " { [ " + keysymName + " ] };\n";
+  }
+
+  return "xkb_keymap {\n"
+         "  xkb_keycodes \"kando\" {\n"
+         "    minimum = 8;\n"
+         "    maximum = " +
+         std::to_string(9 + keysyms.size()) + ";\n" + keycodes +
+         "  };\n"
+         "  xkb_types \"kando\" { include \"complete\" };\n"
+         "  xkb_compatibility \"kando\" { include \"complete\" };\n"
+         "  xkb_symbols \"kando\" {\n" +
+         symbols +
+         "  };\n"
+         "};\n";
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void TextKeymap::build(xkb_keymap* keymap, xkb_layout_index_t layout) {
+  mPositions.clear();
+
+  xkb_keycode_t minKeycode = xkb_keymap_min_keycode(keymap);
+  xkb_keycode_t maxKeycode = xkb_keymap_max_keycode(keymap);
+
+  for (xkb_keycode_t keycode = minKeycode; keycode <= maxKeycode; ++keycode) {
+    xkb_layout_index_t numLayouts = xkb_keymap_num_layouts_for_key(keymap, keycode);
+    if (numLayouts == 0) {
+      continue;
+    }
+
+    // Keys with fewer layouts use the first one.
+    xkb_layout_index_t keyLayout = layout < numLayouts ? layout : 0;
+    xkb_level_index_t  numLevels =
+        xkb_keymap_num_levels_for_key(keymap, keycode, keyLayout);
+
+    for (xkb_level_index_t level = 0; level < numLevels; ++level) {
+      // Levels producing several keysyms at once cannot be used for typing text.
+      xkb_keysym_t const* keysyms    = nullptr;
+      int                 numKeysyms = xkb_keymap_key_get_syms_by_level(
+          keymap, keycode, keyLayout, level, &keysyms);
+      if (numKeysyms != 1) {
+        continue;
+      }
+
+      char32_t codepoint = xkb_keysym_to_utf32(keysyms[0]);
+      if (codepoint == 0) {
+        continue;
+      }
+
+      xkb_mod_mask_t masks[16];
+      size_t         numMasks = xkb_keymap_key_get_mods_for_level(
+          keymap, keycode, keyLayout, level, masks, sizeof(masks) / sizeof(masks[0]));
+
+      for (size_t i = 0; i < numMasks; ++i) {
+        add(codepoint, {keycode, masks[i]});
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<KeyPosition> TextKeymap::find(char32_t codepoint) const {
+  // This maps newlines to the carriage return of the Return key.
+  auto it = mPositions.find(xkb_keysym_to_utf32(keysymFromCodepoint(codepoint)));
+  if (it == mPositions.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+size_t TextKeymap::size() const {
+  return mPositions.size();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void TextKeymap::add(char32_t codepoint, KeyPosition position) {
+  auto [it, inserted] = mPositions.emplace(codepoint, position);
+  if (!inserted && std::bitset<32>(position.modifiers).count() <
+                       std::bitset<32>(it->second.modifiers).count()) {
+    it->second = position;
+  }
+}
@@ -0,0 +1,66 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef TEXT_KEYMAP_HPP
+#define TEXT_KEYMAP_HPP
+
+#include <xkbcommon/xkbcommon.h>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Returns the keysym which produces the given character. Newlines, tabs, and backspaces
+ * are mapped to their keys. Returns XKB_KEY_NoSymbol for all other control characters.
+ */
+xkb_keysym_t keysymFromCodepoint(char32_t codepoint);
+
+/**
+ * Creates a keymap in the XKB text format in which the i-th of the given keysyms is
+ * produced by the keycode 9 + i without any modifiers. The types and the compatibility
+ * section are included from the default XKB data.
+ */
+std::string createKeymap(std::vector<xkb_keysym_t> const& keysyms);
+
+/** The key and the modifiers which have to be held down to type a character. */
+struct KeyPosition {
+  xkb_keycode_t  keycode   = 0;
+  xkb_mod_mask_t modifiers = 0;
+};
+
+/**
+ * This maps characters to the keys of an XKB keymap which produce them. It is used by
+ * Native::simulateText() and only rebuilt if the compositor sends a new keymap or if the
+ * active layout changes.
+ *
+ * If a character can be typed in several ways, the one requiring the fewest modifiers is
+ * kept. Among those, the key with the lowest keycode wins. This way, the main keys are
+ * preferred over the keypad.
+ */
+class TextKeymap {
+ public:
+  /** Replaces the table with the symbols of the given layout of the given keymap. */
+  void build(xkb_keymap* keymap, xkb_layout_index_t layout);
+
+  /** Returns the key which produces the given character in the current table. */
+  std::optional<KeyPosition> find(char32_t codepoint) const;
+
+  size_t size() const;
+
+ private:
+  void add(char32_t codepoint, KeyPosition position);
+
+  std::unordered_map<char32_t, KeyPosition> mPositions;
+};
+
+#endif // TEXT_KEYMAP_HPP
@@ -0,0 +1,481 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "ToplevelRegistry.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+bool isSameToplevel(
+    std::optional<ToplevelInfo> const& a, std::optional<ToplevelInfo> const& b) {
+  if (!a || !b) {
+    return !a && !b;
+  }
+
+  return a->id == b->id && a->title == b->title && a->appId == b->appId &&
+         a->activated == b->activated && a->minimized == b->minimized &&
+         a->output == b->output;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+ToplevelRegistry::~ToplevelRegistry() {
+  stop();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ToplevelRegistry::start() {
+  if (mThread.joinable()) {
+    if (mAlive) {
+      return true;
+    }
+
+    // The event thread has exited as the connection was lost. We join it and reconnect.
+    stop();
+  }
+
+  mDisplay = wl_display_connect(nullptr);
+  if (!mDisplay) {
+    return false;
+  }
+
+  static const wl_registry_listener registryListener = {
+      .global =
+          [](void* data, wl_registry* registry, uint32_t name, const char* interface,
+              uint32_t version) {
+            static_cast<ToplevelRegistry*>(data)->addGlobal(
+                registry, name, interface, version);
+          },
+      .global_remove =
+          [](void* data, wl_registry*, uint32_t name) {
+            static_cast<ToplevelRegistry*>(data)->removeOutput(name);
+          },
+  };
+
+  mRegistry = wl_display_get_registry(mDisplay);
+  wl_registry_add_listener(mRegistry, &registryListener, this);
+
+  // The first roundtrip binds the manager and the outputs, the second one receives all
+  // toplevels and their initial state. The event thread is not running yet, so we can
+  // dispatch the events on this thread.
+  wl_display_roundtrip(mDisplay);
+
+  if (!mManager) {
+    disconnect();
+    return false;
+  }
+
+  wl_display_roundtrip(mDisplay);
+
+  mLastActivation = 0;
+  mChanged        = true;
+  mActiveNotified = false;
+  mWakeupFd       = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  mRunning        = true;
+  mAlive          = true;
+  mThread         = std::thread(&ToplevelRegistry::run, this);
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ToplevelRegistry::stop() {
+  if (!mThread.joinable()) {
+    return;
+  }
+
+  mRunning = false;
+
+  uint64_t value = 1;
+  write(mWakeupFd, &value, sizeof(value));
+
+  mThread.join();
+
+  close(mWakeupFd);
+  mWakeupFd = -1;
+
+  disconnect();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ToplevelRegistry::isRunning() const {
+  return mAlive;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<ToplevelInfo> ToplevelRegistry::getToplevels() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  std::vector<ToplevelInfo> toplevels;
+  toplevels.reserve(mToplevels.size());
+
+  for (auto const& toplevel : mToplevels) {
+    if (toplevel->committed) {
+      toplevels.push_back(toplevel->current);
+    }
+  }
+
+  std::stable_sort(toplevels.begin(), toplevels.end(),
+      [](ToplevelInfo const& a, ToplevelInfo const& b) {
+        return a.activationSerial > b.activationSerial;
+      });
+
+  return toplevels;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<ToplevelInfo> ToplevelRegistry::getActiveToplevel() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (auto const& toplevel : mToplevels) {
+    if (toplevel->committed && toplevel->current.activated) {
+      return toplevel->current;
+    }
+  }
+
+  return std::nullopt;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<uint64_t> ToplevelRegistry::findToplevel(
+    std::string const& title, std::string const& appId) const {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  Toplevel const* match = nullptr;
+
+  for (auto const& toplevel : mToplevels) {
+    if (!toplevel->committed || toplevel->current.title != title) {
+      continue;
+    }
+
+    if (toplevel->current.appId == appId) {
+      return toplevel->current.id;
+    }
+
+    if (!match) {
+      match = toplevel.get();
+    }
+  }
+
+  if (!match) {
+    return std::nullopt;
+  }
+
+  return match->current.id;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ToplevelRegistry::activate(uint64_t id) {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  auto it = mToplevelsById.find(id);
+  if (!mAlive || !mSeat || it == mToplevelsById.end()) {
+    return false;
+  }
+
+  // Requests can be sent from any thread. The handle cannot be destroyed concurrently as
+  // the event thread holds the mutex while doing so.
+  zwlr_foreign_toplevel_handle_v1_activate(it->second->handle, mSeat);
+  wl_display_flush(mDisplay);
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ToplevelRegistry::setActiveToplevelCallback(ActiveToplevelCallback callback) {
+  std::lock_guard<std::mutex> lock(mCallbackMutex);
+  mActiveToplevelCallback = std::move(callback);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ToplevelRegistry::setToplevelsCallback(ToplevelsCallback callback) {
+  std::lock_guard<std::mutex> lock(mCallbackMutex);
+  mToplevelsCallback = std::move(callback);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ToplevelRegistry::run() {
+  int displayFd = wl_display_get_fd(mDisplay);
+
+  while (mRunning) {
+
+    // First, we dispatch everything which has been read already. The event handlers only
+    // update the pending state of the toplevels.
+    while (wl_display_prepare_read(mDisplay) != 0) {
+      wl_display_dispatch_pending(mDisplay);
+    }
+
+    wl_display_flush(mDisplay);
+
+    // Then we tell the world about the changes...
+    notify();
+
+    // ... and sleep until the compositor sends something or the thread should stop.
+    pollfd fds[2] = {
+        {.fd = displayFd, .events = POLLIN},
+        {.fd = mWakeupFd, .events = POLLIN},
+    };
+
+    if (poll(fds, 2, -1) > 0 && (fds[0].revents & POLLIN)) {
+      wl_display_read_events(mDisplay);
+    } else {
+      wl_display_cancel_read(mDisplay);
+    }
+
+    if (wl_display_get_error(mDisplay) || (fds[0].revents & (POLLHUP | POLLERR))) {
+      std::cerr << "Lost connection to the Wayland compositor!" << std::endl;
+      break;
+    }
+  }
+
+  mAlive = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ToplevelRegistry::addGlobal(
+    wl_registry* registry, uint32_t name, const char* interface, uint32_t version) {
+
+  static const zwlr_foreign_toplevel_manager_v1_listener managerListener = {
+      .toplevel =
+          [](void* data, zwlr_foreign_toplevel_manager_v1*,
+              zwlr_foreign_toplevel_handle_v1* handle) {
+            static_cast<ToplevelRegistry*>(data)->addToplevel(handle);
+          },
+      .finished = [](void*, zwlr_foreign_toplevel_manager_v1*) {},
+  };
+
+  if (!mManager &&
+      std::strcmp(interface, zwlr_foreign_toplevel_manager_v1_interface.name) == 0) {
+    mManager = static_cast<zwlr_foreign_toplevel_manager_v1*>(wl_registry_bind(registry,
+        name, &zwlr_foreign_toplevel_manager_v1_interface, std::min(version, 3u)));
+    zwlr_foreign_toplevel_manager_v1_add_listener(mManager, &managerListener, this);
+  } else if (!mSeat && std::strcmp(interface, wl_seat_interface.name) == 0) {
+    mSeat =
+        static_cast<wl_seat*>(wl_registry_bind(registry, name, &wl_seat_interface, 1));
+  } else if (std::strcmp(interface, wl_output_interface.name) == 0) {
+    // We only need the output objects to identify them in the output_enter events.
+    auto* output = static_cast<wl_output*>(
+        wl_registry_bind(registry, name, &wl_output_interface, 1));
+    mOutputs.push_back({name, output});
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ToplevelRegistry::removeOutput(uint32_t name) {
+  auto it = std::find_if(mOutputs.begin(), mOutputs.end(),
+      [name](Output const& o) { return o.name == name; });
+
+  if (it == mOutputs.end()) {
+    return;
+  }
+
+  for (auto& toplevel : mToplevels) {
+    auto& outputs = toplevel->outputs;
+    outputs.erase(std::remove(outputs.begin(), outputs.end(), it->output), outputs.end());
+  }
+
+  wl_output_destroy(it->output);
+  mOutputs.erase(it);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ToplevelRegistry::addToplevel(zwlr_foreign_toplevel_handle_v1* handle) {
+  static const zwlr_foreign_toplevel_handle_v1_listener handleListener = {
+      .title =
+          [](void* data, zwlr_foreign_toplevel_handle_v1*, const char* title) {
+            static_cast<Toplevel*>(data)->pending.title = title ? title : "";
+          },
+      .app_id =
+          [](void* data, zwlr_foreign_toplevel_handle_v1*, const char* appId) {
+            static_cast<Toplevel*>(data)->pending.appId = appId ? appId : "";
+          },
+      .output_enter =
+          [](void* data, zwlr_foreign_toplevel_handle_v1*, wl_output* output) {
+            static_cast<Toplevel*>(data)->outputs.push_back(output);
+          },
+      .output_leave =
+          [](void* data, zwlr_foreign_toplevel_handle_v1*, wl_output* output) {
+            auto& outputs = static_cast<Toplevel*>(data)->outputs;
+            outputs.erase(
+                std::remove(outputs.begin(), outputs.end(), output), outputs.end());
+          },
+      .state =
+          [](void* data, zwlr_foreign_toplevel_handle_v1*, wl_array* state) {
+            auto* toplevel              = static_cast<Toplevel*>(data);
+            toplevel->pending.activated = false;
+            toplevel->pending.minimized = false;
+
+            auto*  values = static_cast<uint32_t*>(state->data);
+            size_t count  = state->size / sizeof(uint32_t);
+            for (size_t i = 0; i < count; ++i) {
+              if (values[i] == ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_ACTIVATED) {
+                toplevel->pending.activated = true;
+              } else if (values[i] == ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_MINIMIZED) {
+                toplevel->pending.minimized = true;
+              }
+            }
+          },
+      .done =
+          [](void* data, zwlr_foreign_toplevel_handle_v1*) {
+            auto* toplevel = static_cast<Toplevel*>(data);
+            toplevel->registry->commitToplevel(toplevel);
+          },
+      .closed =
+          [](void* data, zwlr_foreign_toplevel_handle_v1*) {
+            auto* toplevel = static_cast<Toplevel*>(data);
+            toplevel->registry->removeToplevel(toplevel);
+          },
+      .parent = [](void*, zwlr_foreign_toplevel_handle_v1*,
+                    zwlr_foreign_toplevel_handle_v1*) {},
+  };
+
+  auto toplevel        = std::make_unique<Toplevel>();
+  toplevel->registry   = this;
+  toplevel->handle     = handle;
+  toplevel->pending.id = ++mLastId;
+  zwlr_foreign_toplevel_handle_v1_add_listener(handle, &handleListener, toplevel.get());
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mToplevelsById[toplevel->pending.id] = toplevel.get();
+  mToplevels.push_back(std::move(toplevel));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ToplevelRegistry::commitToplevel(Toplevel* toplevel) {
+  ToplevelInfo& pending = toplevel->pending;
+
+  if (pending.activated && (!toplevel->committed || !toplevel->current.activated)) {
+    pending.activationSerial = ++mLastActivation;
+  }
+
+  pending.output = -1;
+  if (!toplevel->outputs.empty()) {
+    auto it = std::find_if(mOutputs.begin(), mOutputs.end(),
+        [&](Output const& o) { return o.output == toplevel->outputs.front(); });
+    if (it != mOutputs.end()) {
+      pending.output = int32_t(it - mOutputs.begin());
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  toplevel->current   = pending;
+  toplevel->committed = true;
+  mChanged            = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ToplevelRegistry::removeToplevel(Toplevel* toplevel) {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  // This is done while holding the mutex so that activate() cannot use the handle.
+  zwlr_foreign_toplevel_handle_v1_destroy(toplevel->handle);
+
+  mToplevelsById.erase(toplevel->pending.id);
+  mToplevels.erase(std::remove_if(mToplevels.begin(), mToplevels.end(),
+                       [toplevel](auto const& t) { return t.get() == toplevel; }),
+      mToplevels.end());
+  mChanged = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ToplevelRegistry::notify() {
+  std::optional<ToplevelInfo> activeToplevel = getActiveToplevel();
+  bool                        activeToplevelChanged =
+      !mActiveNotified || !isSameToplevel(activeToplevel, mNotifiedActiveToplevel);
+
+  if (!mChanged && !activeToplevelChanged) {
+    return;
+  }
+
+  std::vector<ToplevelInfo> toplevels;
+  if (mChanged) {
+    toplevels = getToplevels();
+  }
+
+  std::lock_guard<std::mutex> lock(mCallbackMutex);
+
+  if (mChanged && mToplevelsCallback) {
+    mToplevelsCallback(toplevels);
+  }
+
+  if (activeToplevelChanged && mActiveToplevelCallback) {
+    mActiveToplevelCallback(activeToplevel);
+  }
+
+  mChanged                = false;
+  mActiveNotified         = true;
+  mNotifiedActiveToplevel = std::move(activeToplevel);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ToplevelRegistry::disconnect() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& toplevel : mToplevels) {
+      zwlr_foreign_toplevel_handle_v1_destroy(toplevel->handle);
+    }
+    mToplevels.clear();
+    mToplevelsById.clear();
+  }
+
+  for (auto const& output : mOutputs) {
+    wl_output_destroy(output.output);
+  }
+  mOutputs.clear();
+
+  if (mSeat) {
+    wl_seat_destroy(mSeat);
+    mSeat = nullptr;
+  }
+
+  if (mManager) {
+    zwlr_foreign_toplevel_manager_v1_destroy(mManager);
+    mManager = nullptr;
+  }
+
+  if (mRegistry) {
+    wl_registry_destroy(mRegistry);
+    mRegistry = nullptr;
+  }
+
+  if (mDisplay) {
+    wl_display_disconnect(mDisplay);
+    mDisplay = nullptr;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,206 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef TOPLEVEL_REGISTRY_HPP
+#define TOPLEVEL_REGISTRY_HPP
+
+#include "wlr-foreign-toplevel-management-unstable-v1.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/** The state of a toplevel window as reported by the foreign-toplevel protocol. */
+struct ToplevelInfo {
+  // An ID assigned by the registry. It is unique for the lifetime of the registry.
+  uint64_t id = 0;
+
+  std::string title;
+  std::string appId;
+  bool        activated = false;
+  bool        minimized = false;
+
+  // The index of the first output the toplevel is shown on in the order in which the
+  // outputs have been announced by the compositor. This is -1 if it is on no output.
+  int32_t output = -1;
+
+  // The value of a counter which is incremented each time a toplevel becomes activated.
+  // The most recently activated toplevel has the highest value, never activated
+  // toplevels have zero.
+  uint64_t activationSerial = 0;
+};
+
+/**
+ * This class keeps track of all toplevel windows using the
+ * wlr-foreign-toplevel-management protocol. It runs a background thread with its own
+ * connection to the compositor which applies the title, app_id, and state events of each
+ * toplevel handle whenever the compositor sends the corresponding done event.
+ *
+ * The compositor does not tell us when a toplevel has been used. Therefore, the registry
+ * numbers the activations it observes and reports the toplevels in the order of their
+ * last activation.
+ *
+ * Interested parties can register callbacks which are called whenever the activated
+ * toplevel or the list of toplevels changes. Both are called from the event thread, once
+ * after the thread has been started and then after each batch of changes.
+ */
+class ToplevelRegistry {
+ public:
+  ToplevelRegistry() = default;
+  ~ToplevelRegistry();
+
+  ToplevelRegistry(ToplevelRegistry const& other)            = delete;
+  ToplevelRegistry& operator=(ToplevelRegistry const& other) = delete;
+
+  /**
+   * Connects to the compositor, reads the initial list of toplevels, and starts the event
+   * thread. Returns false if the compositor does not support the foreign-toplevel
+   * protocol. Does nothing if the thread is already running. If it has stopped because
+   * the connection was lost, it is started again.
+   */
+  bool start();
+
+  /** Stops the event thread and disconnects from the compositor. */
+  void stop();
+
+  /**
+   * Returns true as long as the event thread is running. It stops by itself if the
+   * connection to the compositor is lost.
+   */
+  bool isRunning() const;
+
+  /**
+   * Returns a copy of all toplevels. The most recently activated toplevels come first,
+   * toplevels which have never been activated while the registry was running come last
+   * in the order in which they have been announced.
+   */
+  std::vector<ToplevelInfo> getToplevels() const;
+
+  /** Returns a copy of the activated toplevel, if there is one. */
+  std::optional<ToplevelInfo> getActiveToplevel() const;
+
+  /**
+   * Returns the ID of the toplevel with the given title and app ID. If there is none,
+   * the first toplevel with the given title is returned.
+   */
+  std::optional<uint64_t> findToplevel(
+      std::string const& title, std::string const& appId) const;
+
+  /**
+   * Asks the compositor to activate the toplevel with the given ID. This can be called
+   * from any thread. Returns false if the registry is not running, if the compositor did
+   * not announce a seat, or if there is no such toplevel.
+   */
+  bool activate(uint64_t id);
+
+  using ActiveToplevelCallback = std::function<void(std::optional<ToplevelInfo> const&)>;
+  using ToplevelsCallback      = std::function<void(std::vector<ToplevelInfo> const&)>;
+
+  /**
+   * Sets the callback which is called from the event thread whenever the activated
+   * toplevel changes. Pass an empty function to remove the callback. Once this returns,
+   * the previous callback will not be called anymore.
+   */
+  void setActiveToplevelCallback(ActiveToplevelCallback callback);
+
+  /**
+   * Sets the callback which is called from the event thread whenever a toplevel is
+   * added, removed, or changed. Pass an empty function to remove the callback. Once this
+   * returns, the previous callback will not be called anymore.
+   */
+  void setToplevelsCallback(ToplevelsCallback callback);
+
+ private:
+  struct Toplevel {
+    ToplevelRegistry*                registry = nullptr;
+    zwlr_foreign_toplevel_handle_v1* handle   = nullptr;
+
+    // The events of a handle are double-buffered. They are collected in pending and
+    // copied to current once the done event is received.
+    ToplevelInfo pending;
+    ToplevelInfo current;
+
+    // The outputs the toplevel has entered. They are not double-buffered, the index of
+    // the first one is computed on the done event.
+    std::vector<wl_output*> outputs;
+
+    // Toplevels are only reported after their first done event.
+    bool committed = false;
+  };
+
+  struct Output {
+    uint32_t   name   = 0;
+    wl_output* output = nullptr;
+  };
+
+  void run();
+
+  // Binds the given global if it is one of the interfaces we need.
+  void addGlobal(
+      wl_registry* registry, uint32_t name, const char* interface, uint32_t version);
+
+  // Destroys the output with the given global name if it has been bound.
+  void removeOutput(uint32_t name);
+
+  // Adds a toplevel which has been announced by the manager.
+  void addToplevel(zwlr_foreign_toplevel_handle_v1* handle);
+
+  // Copies the pending state of the given toplevel to its current state. If it has been
+  // activated since the last done event, it gets a new activation serial.
+  void commitToplevel(Toplevel* toplevel);
+
+  // Removes the given toplevel and destroys its handle.
+  void removeToplevel(Toplevel* toplevel);
+
+  // Calls the callbacks if something changed since the last call.
+  void notify();
+
+  // Destroys all Wayland objects and disconnects from the compositor.
+  void disconnect();
+
+  wl_display*                       mDisplay  = nullptr;
+  wl_registry*                      mRegistry = nullptr;
+  zwlr_foreign_toplevel_manager_v1* mManager  = nullptr;
+  wl_seat*                          mSeat     = nullptr;
+
+  std::thread mThread;
+
+  // This eventfd is used to wake up the event thread when it should stop. mAlive is
+  // cleared by the thread itself when it exits.
+  int               mWakeupFd = -1;
+  std::atomic<bool> mRunning  = false;
+  std::atomic<bool> mAlive    = false;
+
+  // These are only accessed from the event thread once it is running.
+  std::vector<Output>         mOutputs;
+  uint64_t                    mLastId         = 0;
+  uint64_t                    mLastActivation = 0;
+  bool                        mChanged        = false;
+  bool                        mActiveNotified = false;
+  std::optional<ToplevelInfo> mNotifiedActiveToplevel;
+
+  // The current state of the toplevels is protected by mMutex as it is read from the
+  // main thread.
+  mutable std::mutex                      mMutex;
+  std::vector<std::unique_ptr<Toplevel>>  mToplevels;
+  std::unordered_map<uint64_t, Toplevel*> mToplevelsById;
+
+  std::mutex             mCallbackMutex;
+  ActiveToplevelCallback mActiveToplevelCallback;
+  ToplevelsCallback      mToplevelsCallback;
+};
+
+#endif // TOPLEVEL_REGISTRY_HPP
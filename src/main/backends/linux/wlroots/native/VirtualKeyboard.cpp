@@ -0,0 +1,37 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "VirtualKeyboard.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void sendKeyEvents(zwp_virtual_keyboard_v1* keyboard, xkb_state* state,
+    std::vector<KeyEvent> const& events) {
+
+  for (auto const& event : events) {
+
+    // Update the modifier state.
+    xkb_state_component changedMods = xkb_state_update_key(
+        state, event.keycode, event.down ? XKB_KEY_DOWN : XKB_KEY_UP);
+
+    // If the modifier state changed, we send a modifier event.
+    if (changedMods) {
+      zwp_virtual_keyboard_v1_modifiers(keyboard,
+          xkb_state_serialize_mods(state, XKB_STATE_MODS_DEPRESSED),
+          xkb_state_serialize_mods(state, XKB_STATE_MODS_LATCHED),
+          xkb_state_serialize_mods(state, XKB_STATE_MODS_LOCKED),
+          xkb_state_serialize_layout(state, XKB_STATE_LAYOUT_EFFECTIVE));
+    }
+
+    // Finally send the key event itself.
+    zwp_virtual_keyboard_v1_key(keyboard, 0, event.keycode - 8,
+        event.down ? WL_KEYBOARD_KEY_STATE_PRESSED : WL_KEYBOARD_KEY_STATE_RELEASED);
+  }
+}
@@ -0,0 +1,36 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef VIRTUAL_KEYBOARD_HPP
+#define VIRTUAL_KEYBOARD_HPP
+
+#include "virtual-keyboard-unstable-v1.h"
+
+#include <xkbcommon/xkbcommon.h>
+
+#include <vector>
+
+/** A key press or release. The keycode is an XKB keycode, i.e. the scan code plus 8. */
+struct KeyEvent {
+  xkb_keycode_t keycode = 0;
+  bool          down    = false;
+};
+
+/**
+ * Sends the given key events to the virtual keyboard. The given XKB state is updated
+ * with each event. If this changes the modifiers, they are sent before the key itself.
+ *
+ * The requests are only queued. The caller has to flush the display or do a roundtrip
+ * once all events of a sequence have been sent.
+ */
+void sendKeyEvents(zwp_virtual_keyboard_v1* keyboard, xkb_state* state,
+    std::vector<KeyEvent> const& events);
+
+#endif // VIRTUAL_KEYBOARD_HPP
@@ -8,6 +8,31 @@
 // SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
 // SPDX-License-Identifier: MIT
 
+/**
+ * A toplevel as reported by the native module. The ID, the output, and the minimized
+ * state are only known if the toplevels are tracked by the background thread. The
+ * protocol does not report workspaces.
+ */
+export type NativeWindow = {
+  windowName: string;
+  appName: string;
+  id?: number;
+  monitor?: number;
+  minimized?: boolean;
+};
+
+/**
+ * The pointer position in global logical coordinates and the size of the work area of
+ * the output under the pointer as reported by the native module.
+ */
+export type PointerInfo = {
+  pointerX: number;
+  pointerY: number;
+  pointerGetTimedOut: boolean;
+  workAreaWidth: number;
+  workAreaHeight: number;
+};
+
 export type Native = {
   /**
    * This simulates a mouse movement.
@@ -25,29 +50,120 @@ export type Native = {
    */
   simulateKey(keycode: number, down: boolean): void;
 
+  /**
+   * This simulates a sequence of key presses and releases. All events are sent at once
+   * and the compositor is only waited for once at the end. Delays have to be handled by
+   * the caller by splitting the sequence.
+   *
+   * @param events The X11 scan codes and whether the keys are pressed or released.
+   */
+  simulateKeys(events: Array<{ keycode: number; down: boolean }>): void;
+
+  /**
+   * This types the given text with the virtual keyboard. The keys are looked up in the
+   * keymap of the real keyboard. If some characters are not part of it, the text is
+   * typed with a temporary keymap instead. All key events are sent at once.
+   *
+   * @param text The text to type.
+   * @returns False if the keymap of the real keyboard is not known.
+   */
+  simulateText(text: string): boolean;
+
+  /**
+   * This offers the given entries as the new clipboard content using the
+   * wlr-data-control protocol. Plain text is additionally offered under the legacy names
+   * like UTF8_STRING. The content is sent to other clients by a background thread, so
+   * large payloads do not block the main thread.
+   *
+   * @param entries The representations of the content, like text/plain and text/html.
+   * @param primary If true, the primary selection is set instead of the clipboard.
+   * @returns False if the compositor does not support the wlr-data-control protocol.
+   */
+  setClipboard(
+    entries: Array<{ mimeType: string; data: string | Buffer }>,
+    primary?: boolean
+  ): boolean;
+
   /**
    * This gets the pointer's position and work area size by spawning a temporary
-   * wlr_layer_shell overlay surface.
+   * wlr_layer_shell overlay surface. If keepSurface is true, the surface and the input
+   * devices are only unmapped afterwards, so that subsequent calls can reuse them.
    */
   getPointerPositionAndWorkAreaSize(
     mouseTimeout: number,
-    touchTimeout: number
-  ): {
-    pointerX: number;
-    pointerY: number;
-    pointerGetTimedOut: boolean;
-    workAreaWidth: number;
-    workAreaHeight: number;
-  };
-
-  /** Lists all currently open windows using the foreign-toplevel protocol. */
-  getOpenWindows(): Array<{ windowName: string; appName: string }>;
-
-  /** Gets the currently focused window using the foreign-toplevel protocol. */
-  getFocusedWindow(): { windowName: string; appName: string } | null;
-
-  /** Focuses the given window using the foreign-toplevel protocol. */
-  focusWindow(windowName: string, appName: string): void;
+    touchTimeout: number,
+    keepSurface?: boolean
+  ): PointerInfo;
+
+  /**
+   * This is the same as getPointerPositionAndWorkAreaSize but it does not block the main
+   * thread while waiting for the compositor. The Wayland connection and the timeout are
+   * watched by the event loop instead. Concurrent calls share the running query.
+   */
+  getPointerPositionAndWorkAreaSizeAsync(
+    mouseTimeout: number,
+    touchTimeout: number,
+    keepSurface?: boolean
+  ): Promise<PointerInfo | null>;
+
+  /**
+   * Lists all currently open windows using the foreign-toplevel protocol. The toplevels
+   * are tracked by a background thread which is started on the first call. The most
+   * recently activated windows come first.
+   */
+  getOpenWindows(): Array<NativeWindow>;
+
+  /**
+   * Gets the currently focused window from the same background registry as
+   * getOpenWindows().
+   */
+  getFocusedWindow(): NativeWindow | null;
+
+  /**
+   * Focuses the given window using the foreign-toplevel protocol. If the ID as returned
+   * by getOpenWindows() is given, the window is activated without searching for it.
+   * Else it is searched by its title in the background registry.
+   */
+  focusWindow(windowName: string, appName: string, id?: number): void;
+
+  /**
+   * Registers a callback which is called whenever the focused window changes. The
+   * toplevels are tracked by a background thread of the native module, so the callback is
+   * called asynchronously. It is also called once with the initial state. Call this
+   * without a callback to unsubscribe.
+   *
+   * @returns False if the foreign-toplevel protocol is not available.
+   */
+  onActiveWindowChanged(callback?: (window: NativeWindow | null) => void): boolean;
+
+  /**
+   * Registers a callback which is called with all open windows whenever a window is
+   * opened, closed, renamed, activated, minimized, or moved to another output. Call this
+   * without a callback to unsubscribe.
+   *
+   * @returns False if the foreign-toplevel protocol is not available.
+   */
+  onWindowsChanged(callback?: (windows: Array<NativeWindow>) => void): boolean;
+
+  /**
+   * Captures the given rectangle of the screen using the wlr-screencopy protocol and
+   * blurs it. The result is usually smaller than the rectangle and has to be scaled up.
+   * Returns null if the compositor does not support screencopy or if the rectangle is not
+   * fully inside one output.
+   *
+   * @param x The left edge of the rectangle in global logical pixels.
+   * @param y The top edge of the rectangle in global logical pixels.
+   * @param width The width of the rectangle in logical pixels.
+   * @param height The height of the rectangle in logical pixels.
+   * @param sigma The standard deviation of the blur in logical pixels.
+   */
+  captureBackdrop(
+    x: number,
+    y: number,
+    width: number,
+    height: number,
+    sigma: number
+  ): { width: number; height: number; data: ArrayBuffer } | null;
 };
 
 const native: Native = require('./../../../../../../build/Release/NativeWLR.node');
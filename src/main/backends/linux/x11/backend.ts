@@ -8,21 +8,35 @@
 // SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
 // SPDX-License-Identifier: MIT
 
-import { native } from './native';
+import { native, NativeWindow } from './native';
 import { LinuxBackend } from '../backend';
-import { KeySequence, WindowDescription } from '../../../../common';
-import { mapKeys } from '../../../../common/key-codes';
+import { Settings } from '../../../../main/settings';
+import {
+  ClipboardEntry,
+  GeneralSettings,
+  KeySequence,
+  MenuShape,
+  WindowDescription,
+} from '../../../../common';
+import { getKeyName, mapKeys } from '../../../../common/key-codes';
 import { screen } from 'electron';
 
 /**
  * This backend uses the XTest extension via native C++ code to simulate key presses and
  * mouse movements. It also uses the X11 library to get the currently focused window.
+ * Global shortcuts are grabbed natively with XGrabKey.
  *
  * This backend is the default on X11-based Linux desktops. It should work on most desktop
  * environments, but you could also create derived backends for your specific desktop
  * environments if needed.
  */
 export class X11Backend extends LinuxBackend {
+  /** If true, the menu window is shaped to the area covered by the menu. */
+  private shapeMenuWindow = false;
+
+  /** This is true while the menu window has a shape. */
+  private menuWindowShaped = false;
+
   /**
    * Override this if another type is more suitable for your desktop environment.
    * https://www.electronjs.org/docs/latest/api/browser-window#new-browserwindowoptions
@@ -38,33 +52,235 @@ export class X11Backend extends LinuxBackend {
     };
   }
 
-  /** This is called when the backend is created. Currently, this this does nothing on X11. */
-  public async init() {}
+  /**
+   * This is called when the backend is created. The native module keeps track of the
+   * windows in a background thread. We forward its change notifications as
+   * 'activeWindowChanged' and 'windowsChanged' events. If enabled in the settings, the
+   * native module also tracks the pointer in the background and the menu window is
+   * shaped to the menu.
+   */
+  public async init(generalSettings: Settings<GeneralSettings>) {
+    this.setPointerTracking(generalSettings.get('x11PointerTracking'));
+    generalSettings.onChange('x11PointerTracking', (newValue) => {
+      this.setPointerTracking(newValue);
+    });
+
+    this.shapeMenuWindow = generalSettings.get('x11ShapeMenuWindow');
+    generalSettings.onChange('x11ShapeMenuWindow', (newValue) => {
+      this.shapeMenuWindow = newValue;
+    });
+
+    native.onActiveWindowChanged((window) => {
+      this.emit('activeWindowChanged', window ? toWindowDescription(window) : null);
+    });
 
-  /** We only need to unbind all shortcuts when the backend is destroyed. */
+    native.onWindowsChanged((windows) => {
+      this.emit('windowsChanged', windows.map(toWindowDescription));
+    });
+
+    native.onShortcutEvent((shortcut, pressed) => {
+      if (pressed) {
+        this.onShortcutPressed(shortcut);
+      } else {
+        this.onShortcutReleased(shortcut);
+      }
+    });
+  }
+
+  /** We unbind all shortcuts and unsubscribe from the window changes. */
   public async deinit(): Promise<void> {
+    native.onActiveWindowChanged();
+    native.onWindowsChanged();
+    native.onShortcutEvent();
+    native.setPointerTrackingEnabled(false);
     await this.bindShortcuts([]);
   }
 
-  /** Uses _NET_CLIENT_LIST to enumerate all open windows. */
+  /**
+   * Starts or stops the XInput2 pointer tracker of the native module. If the X server
+   * does not support raw motion events, the pointer is queried when needed instead.
+   */
+  private setPointerTracking(enabled: boolean) {
+    if (native.setPointerTrackingEnabled(enabled) !== enabled) {
+      console.warn('XInput 2.1 is not available. Pointer tracking is disabled.');
+    }
+  }
+
+  /**
+   * This binds the shortcuts with XGrabKey. Inhibiting a single shortcut only sets a flag
+   * in the native module, so the menu's shortcut does not have to be re-grabbed each time
+   * a menu is opened and closed. Only if all shortcuts are inhibited, we release the
+   * grabs so that other applications can use the keys.
+   *
+   * @param currentShortcuts The shortcuts that should be bound now.
+   * @param previousShortcuts The shortcuts that were bound before this call.
+   * @param currentEffectiveShortcuts The currently bound shortcuts minus the inhibited
+   *   ones.
+   * @returns A promise which resolves when the shortcuts have been updated.
+   */
+  protected override async onShortcutsChanged(
+    currentShortcuts: string[],
+    previousShortcuts: string[],
+    currentEffectiveShortcuts: string[]
+  ): Promise<void> {
+    const shortcuts = this.isShortcutInhibited('*') ? [] : currentShortcuts;
+
+    for (const shortcut of native.bindShortcuts(shortcuts)) {
+      console.warn(`Failed to bind shortcut '${shortcut}'. Is it already in use?`);
+    }
+
+    for (const shortcut of shortcuts) {
+      const inhibited = !currentEffectiveShortcuts.includes(shortcut);
+      native.setShortcutInhibited(shortcut, inhibited);
+    }
+  }
+
+  /**
+   * Uses _NET_CLIENT_LIST to enumerate all open windows. The most recently used windows
+   * come first.
+   */
   public async getOpenWindows() {
-    return native.getOpenWindows().map(({ app, window }) => ({
-      appName: app,
-      windowName: window,
-    }));
+    return native.getOpenWindows().map(toWindowDescription);
   }
 
-  /** Sends a _NET_ACTIVE_WINDOW client message to focus the given window. */
+  /**
+   * Sends a _NET_ACTIVE_WINDOW client message to focus the given window. If the window
+   * comes from getOpenWindows(), the native module looks it up by its ID.
+   */
   public async focusWindow(window: WindowDescription) {
-    native.focusWindow(window.windowName, window.appName);
+    native.focusWindow(window.windowName, window.appName, window.id);
+  }
+
+  /**
+   * Reads the icon theme from the XSETTINGS manager. This does not spawn any process. If
+   * no XSETTINGS manager is running, the icon theme is read from the settings of the
+   * desktop environment instead.
+   */
+  protected override getNativeIconTheme() {
+    return native.getIconTheme();
+  }
+
+  /**
+   * Reads the _NET_WM_ICON property of the given window. The native module caches the
+   * scaled icons per window and only reads the property again if it has changed. The
+   * window is looked up by its ID, so windows with the same title are not confused.
+   */
+  public async getWindowIcon(window: WindowDescription, size: number) {
+    return native.getWindowIcon(window.windowName, window.appName, size, window.id);
+  }
+
+  /**
+   * Captures the windows with XComposite. The native module keeps the thumbnails until
+   * XDamage reports that the content of a window has changed.
+   */
+  public async getWindowThumbnails(windows: WindowDescription[], size: number) {
+    const thumbnails = native.getWindowThumbnails(
+      windows.map(({ appName, windowName, id }) => ({
+        app: appName,
+        window: windowName,
+        id,
+      })),
+      size
+    );
+
+    return thumbnails ?? windows.map(() => null);
+  }
+
+  /**
+   * Reads the given rectangle of the root window over MIT-SHM and blurs it in the native
+   * module. The rectangle is given in DIPs, so it is converted to physical pixels first.
+   */
+  public async captureBackdrop(region: Electron.Rectangle, sigma: number) {
+    const scale = native.getScalingFactor();
+    return native.captureBackdrop(
+      Math.round(region.x * scale),
+      Math.round(region.y * scale),
+      Math.round(region.width * scale),
+      Math.round(region.height * scale),
+      sigma * scale
+    );
+  }
+
+  /**
+   * Sets the bounding and input regions of the menu window with the SHAPE extension if
+   * this is enabled in the settings. The shape is given in DIPs, so it is converted to
+   * physical pixels first. The window handle contains the XID of the window. A shape is
+   * always removed, even if the setting has been disabled in the meantime.
+   */
+  public async setMenuWindowShape(windowHandle: Buffer, shape: MenuShape | null) {
+    if (shape && !this.shapeMenuWindow) {
+      return false;
+    }
+
+    if (!shape && !this.menuWindowShaped) {
+      return true;
+    }
+
+    const scale = native.getScalingFactor();
+    const scaled = shape && {
+      circles: shape.circles.map((c) => ({
+        x: c.x * scale,
+        y: c.y * scale,
+        radius: c.radius * scale,
+      })),
+      rectangles: shape.rectangles.map((r) => ({
+        x: r.x * scale,
+        y: r.y * scale,
+        width: r.width * scale,
+        height: r.height * scale,
+      })),
+    };
+
+    const success = native.setWindowShape(windowHandle.readUInt32LE(0), scaled);
+    this.menuWindowShaped = success && shape !== null;
+    return success;
+  }
+
+  /**
+   * Records key events with the RECORD extension of the X server. The native module
+   * collects them on a background thread.
+   */
+  public async startMacroRecording() {
+    return native.startMacroRecording();
+  }
+
+  /**
+   * Converts the recorded X11 key codes to key names. Pointer buttons and unknown keys
+   * cannot be part of a KeySequence. They are dropped, but their delay is added to the
+   * next key stroke so that the timing of the remaining keys is preserved.
+   */
+  public async stopMacroRecording() {
+    const events = native.stopMacroRecording();
+    if (!events) {
+      return null;
+    }
+
+    const keys: KeySequence = [];
+    let delay = 0;
+
+    for (const event of events) {
+      delay += event.delay;
+
+      const name =
+        event.keycode === undefined ? undefined : getKeyName(event.keycode, 'linux');
+
+      if (name) {
+        keys.push({ name, down: event.down, delay: keys.length === 0 ? 0 : delay });
+        delay = 0;
+      }
+    }
+
+    return keys;
   }
 
   /**
    * This uses the X11 library to get the name and app of the currently focused window. In
-   * addition, it returns the current pointer position.
+   * addition, it returns the current pointer position and the work area of the monitor
+   * under the pointer. The native module answers the window part and the work area from
+   * its window table, so only the pointer requires a round trip.
    *
    * @returns The name and app of the currently focused window as well as the current
-   *   pointer position.
+   *   pointer position and work area.
    */
   public async getWMInfo() {
     // Starting with Electron 29, the cursorScreenPoint() method is unreliable on X11. It
@@ -82,10 +298,19 @@ export class X11Backend extends LinuxBackend {
       appName: info.app || '',
       pointerX: info.pointerX || 0,
       pointerY: info.pointerY || 0,
-      workArea: screen.getDisplayNearestPoint({
-        x: info.pointerX || 0,
-        y: info.pointerY || 0,
-      }).workArea,
+      // The native module usually knows the work area from its monitor index. Only if it
+      // is not ready yet, we ask Electron.
+      workArea:
+        info.workArea ||
+        screen.getDisplayNearestPoint({
+          x: info.pointerX || 0,
+          y: info.pointerY || 0,
+        }).workArea,
+      pid: info.pid,
+      executable: info.executable,
+      commandLine: info.commandLine,
+      hoveredAppName: info.hoveredApp,
+      hoveredWindowName: info.hoveredWindow,
     };
   }
 
@@ -123,4 +348,39 @@ export class X11Backend extends LinuxBackend {
       native.simulateKey(keyCodes[i], keys[i].down);
     }
   }
+
+  /**
+   * This types the given text into the currently focused window using the XTest X11
+   * extension. The keys are looked up in the current keyboard layout by the native
+   * module.
+   *
+   * @param text The text to type.
+   */
+  public override async simulateText(text: string) {
+    return native.simulateText(text);
+  }
+
+  /**
+   * This takes ownership of the CLIPBOARD selection. The native module answers the
+   * requests of other clients from a background thread, so the content stays available
+   * while Kando's windows are hidden. Large payloads are sent incrementally.
+   *
+   * @param entries The representations of the content.
+   * @param primary If true, the PRIMARY selection is set instead of the CLIPBOARD.
+   */
+  public override async setClipboard(entries: ClipboardEntry[], primary = false) {
+    return native.setClipboard(entries, primary);
+  }
+}
+
+/** Converts an entry of the native window table to a window description. */
+function toWindowDescription(window: NativeWindow): WindowDescription {
+  return {
+    appName: window.app,
+    windowName: window.window,
+    id: window.id,
+    workspace: window.workspace,
+    monitor: window.monitor,
+    minimized: window.minimized,
+  };
 }
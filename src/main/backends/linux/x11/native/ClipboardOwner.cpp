@@ -0,0 +1,497 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "ClipboardOwner.hpp"
+
+#include <X11/Xatom.h>
+
+#include <algorithm>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// If the connection to the X server is lost, the owner thread retries after this many
+// milliseconds.
+constexpr int RECONNECT_INTERVAL = 1000;
+
+// The maximum time set() waits for the owner thread to acquire a selection.
+constexpr auto ACQUIRE_TIMEOUT = std::chrono::seconds(1);
+
+// Incremental transfers are dropped if the requestor does not ask for the next chunk
+// within this time.
+constexpr auto TRANSFER_TIMEOUT = std::chrono::seconds(5);
+
+// Payloads larger than this are sent incrementally, even if the X server would accept
+// larger requests. This limits the amount of memory the X server has to allocate for a
+// single property. Some bytes of each request are reserved for its header.
+constexpr size_t MAX_CHUNK_SIZE   = 256 * 1024;
+constexpr size_t REQUEST_OVERHEAD = 1024;
+
+// The windows of other clients may be destroyed at any time. Errors of checked requests
+// are not passed to the Xlib error handler, which would terminate the process.
+// Discarding the reply drops the error without waiting for it.
+void ignoreErrors(xcb_connection_t* xcb, xcb_void_cookie_t cookie) {
+  xcb_discard_reply(xcb, cookie.sequence);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+ClipboardOwner::~ClipboardOwner() {
+  stop();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ClipboardOwner::start() {
+  if (mRunning) {
+    return true;
+  }
+
+  // We connect synchronously so that we can report whether the X server is reachable.
+  if (!mConnection.get() || !createWindow()) {
+    return false;
+  }
+
+  mWakeupFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  mRunning  = true;
+  mThread   = std::thread(&ClipboardOwner::run, this);
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::stop() {
+  if (!mRunning) {
+    return;
+  }
+
+  // The lock makes sure that a waiting call to set() does not miss the notification.
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRunning = false;
+  }
+
+  mCondition.notify_all();
+
+  uint64_t value = 1;
+  write(mWakeupFd, &value, sizeof(value));
+
+  mThread.join();
+
+  close(mWakeupFd);
+  mWakeupFd = -1;
+
+  // Destroying the window gives up the ownership of both selections.
+  Display* display = mConnection.get();
+  if (display && mCreatedOn == mConnection.getConnectionsOpened()) {
+    XDestroyWindow(display, mWindow);
+    XFlush(display);
+  }
+
+  mWindow = None;
+  mClipboard.reset();
+  mPrimary.reset();
+  mTransfers.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ClipboardOwner::isRunning() const {
+  return mRunning;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ClipboardOwner::set(std::vector<ClipboardEntry> entries, bool primary) {
+  if (!mRunning || getClipboardOffers(entries).empty()) {
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mRequest = Request{std::move(entries), primary};
+  mResult.reset();
+
+  uint64_t value = 1;
+  write(mWakeupFd, &value, sizeof(value));
+
+  mCondition.wait_for(
+      lock, ACQUIRE_TIMEOUT, [this]() { return mResult.has_value() || !mRunning; });
+
+  // If the owner thread did not pick up the request in time, it is discarded.
+  mRequest.reset();
+
+  return mResult.value_or(false);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::run() {
+  while (mRunning) {
+    Display* display = mConnection.get();
+
+    std::optional<Request> request;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      request = std::move(mRequest);
+      mRequest.reset();
+    }
+
+    // After a reconnect, we have to create a new window. All selections have been lost
+    // together with the old connection. If there is no connection, pending requests
+    // fail and we try again after a while.
+    bool reconnected = mCreatedOn != mConnection.getConnectionsOpened();
+    bool connected   = display && (!reconnected || createWindow());
+
+    if (request) {
+      bool acquired = connected && acquire(std::move(*request));
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mResult = acquired;
+      }
+      mCondition.notify_all();
+    }
+
+    int timeout = RECONNECT_INTERVAL;
+
+    if (connected) {
+      while (XPending(display) > 0) {
+        XEvent event;
+        XNextEvent(display, &event);
+        handleEvent(event);
+      }
+
+      timeout = expireTransfers();
+
+      XFlush(display);
+      xcb_flush(mConnection.getXCB());
+    }
+
+    pollfd fds[2] = {
+        {.fd = mWakeupFd, .events = POLLIN},
+        {.fd = connected ? ConnectionNumber(display) : -1, .events = POLLIN},
+    };
+
+    if (poll(fds, 2, timeout) > 0 && (fds[0].revents & POLLIN)) {
+      uint64_t value;
+      read(mWakeupFd, &value, sizeof(value));
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ClipboardOwner::createWindow() {
+  Display* display = mConnection.getDisplay();
+
+  // The window is never mapped. It only receives the selection events and the property
+  // changes we use to get the server time.
+  XSetWindowAttributes attributes = {};
+  attributes.event_mask           = PropertyChangeMask;
+
+  mWindow = XCreateWindow(display, mConnection.getRoot(), -1, -1, 1, 1, 0, CopyFromParent,
+      InputOnly, CopyFromParent, CWEventMask, &attributes);
+
+  // The maximum request length is given in units of four bytes.
+  size_t maxRequestSize = xcb_get_maximum_request_length(mConnection.getXCB()) * 4;
+  mChunkSize            = std::min(MAX_CHUNK_SIZE, maxRequestSize - REQUEST_OVERHEAD);
+
+  mClipboard.reset();
+  mPrimary.reset();
+  mTransfers.clear();
+
+  mCreatedOn = mConnection.getConnectionsOpened();
+
+  return mWindow != None;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ClipboardOwner::acquire(Request request) {
+  Display*     display = mConnection.getDisplay();
+  Atoms const& atoms   = mConnection.getAtoms();
+
+  auto offers  = getClipboardOffers(request.entries);
+  auto content = std::make_shared<Content>();
+  convertLatin1Offers(request.entries, offers);
+
+  // The target atoms of the offers are interned in one batch.
+  std::vector<char*> names;
+  for (auto const& offer : offers) {
+    names.push_back(const_cast<char*>(offer.target.c_str()));
+    content->targetEntries.push_back(offer.entry);
+  }
+
+  content->targets.resize(offers.size());
+  XInternAtoms(display, names.data(), names.size(), False, content->targets.data());
+
+  content->entries = std::move(request.entries);
+  content->time    = getServerTime();
+
+  // The ICCCM forbids CurrentTime here. We check whether we actually got the selection as
+  // the X server ignores the request if someone else acquired it more recently.
+  Atom selection = request.primary ? XA_PRIMARY : atoms.clipboard;
+  XSetSelectionOwner(display, selection, mWindow, content->time);
+
+  if (XGetSelectionOwner(display, selection) != mWindow) {
+    return false;
+  }
+
+  (request.primary ? mPrimary : mClipboard) = std::move(content);
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Time ClipboardOwner::getServerTime() {
+  Display* display = mConnection.getDisplay();
+  Atom     property = mConnection.getAtoms().timestamp;
+
+  // Appending nothing to a property does not change it, but the X server still sends a
+  // PropertyNotify event with the current time. Other events stay in the queue.
+  XChangeProperty(
+      display, mWindow, property, XA_INTEGER, 32, PropModeAppend, nullptr, 0);
+
+  auto isTimestamp = [](Display*, XEvent* event, XPointer arg) -> Bool {
+    auto* self = reinterpret_cast<ClipboardOwner*>(arg);
+    return event->type == PropertyNotify && event->xproperty.window == self->mWindow &&
+           event->xproperty.atom == self->mConnection.getAtoms().timestamp;
+  };
+
+  XEvent event;
+  XIfEvent(display, &event, isTimestamp, reinterpret_cast<XPointer>(this));
+
+  return event.xproperty.time;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::handleEvent(XEvent const& event) {
+  if (event.type == SelectionRequest) {
+    handleSelectionRequest(event.xselectionrequest);
+
+  } else if (event.type == SelectionClear) {
+    XSelectionClearEvent const& clear = event.xselectionclear;
+
+    auto& content = clear.selection == XA_PRIMARY ? mPrimary : mClipboard;
+
+    // The event may refer to an ownership which we have already replaced by a more
+    // recent one. Running transfers are completed nevertheless.
+    if (content && static_cast<int32_t>(clear.time - content->time) >= 0) {
+      content.reset();
+    }
+
+  } else if (event.type == PropertyNotify && event.xproperty.state == PropertyDelete) {
+    handlePropertyDelete(event.xproperty);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::handleSelectionRequest(XSelectionRequestEvent const& event) {
+  Atoms const& atoms = mConnection.getAtoms();
+
+  std::shared_ptr<Content const> content;
+  if (event.selection == XA_PRIMARY) {
+    content = mPrimary;
+  } else if (event.selection == atoms.clipboard) {
+    content = mClipboard;
+  }
+
+  // Requests for times before we acquired the selection have to be refused.
+  if (!content || event.owner != mWindow ||
+      (event.time != CurrentTime &&
+          static_cast<int32_t>(event.time - content->time) < 0)) {
+    notify(event, None);
+    return;
+  }
+
+  // Obsolete clients do not specify a property. They expect the target to be used.
+  Atom property = event.property == None ? event.target : event.property;
+
+  if (event.target == atoms.targets) {
+    std::vector<uint32_t> targets = {
+        static_cast<uint32_t>(atoms.targets), static_cast<uint32_t>(atoms.timestamp)};
+
+    for (Atom target : content->targets) {
+      targets.push_back(static_cast<uint32_t>(target));
+    }
+
+    changeProperty(
+        event.requestor, property, XA_ATOM, 32, targets.data(), targets.size());
+    notify(event, property);
+    return;
+  }
+
+  if (event.target == atoms.timestamp) {
+    uint32_t time = static_cast<uint32_t>(content->time);
+    changeProperty(event.requestor, property, XA_INTEGER, 32, &time, 1);
+    notify(event, property);
+    return;
+  }
+
+  // MULTIPLE and all other targets we do not offer are refused.
+  auto it = std::find(content->targets.begin(), content->targets.end(), event.target);
+  if (it == content->targets.end()) {
+    notify(event, None);
+    return;
+  }
+
+  size_t      entry = content->targetEntries[it - content->targets.begin()];
+  auto const& data  = content->entries[entry].data;
+
+  // TEXT lets the owner choose the encoding. We always send UTF-8.
+  Atom type = event.target == atoms.text ? atoms.utf8String : event.target;
+
+  if (data.size() <= mChunkSize) {
+    changeProperty(event.requestor, property, type, 8, data.data(), data.size());
+    notify(event, property);
+    return;
+  }
+
+  // Large payloads are sent incrementally. We have to watch the requestor's properties
+  // before announcing the transfer so that we do not miss the deletion of the INCR
+  // property. Its value is a lower bound for the size of the payload.
+  selectPropertyChanges(event.requestor, true);
+
+  uint32_t size = static_cast<uint32_t>(std::min<size_t>(data.size(), UINT32_MAX));
+  changeProperty(event.requestor, property, atoms.incr, 32, &size, 1);
+  notify(event, property);
+
+  Transfer transfer;
+  transfer.requestor = event.requestor;
+  transfer.property  = property;
+  transfer.type      = type;
+  transfer.content   = content;
+  transfer.entry     = entry;
+  transfer.deadline  = std::chrono::steady_clock::now() + TRANSFER_TIMEOUT;
+  mTransfers.push_back(std::move(transfer));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::handlePropertyDelete(XPropertyEvent const& event) {
+
+  // The requestor deletes the property once it has read a chunk.
+  auto it = std::find_if(mTransfers.begin(), mTransfers.end(),
+      [&event](Transfer const& transfer) {
+        return transfer.requestor == event.window && transfer.property == event.atom;
+      });
+
+  if (it == mTransfers.end()) {
+    return;
+  }
+
+  if (!continueTransfer(*it)) {
+    Window requestor = it->requestor;
+    mTransfers.erase(it);
+    releaseRequestor(requestor);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ClipboardOwner::continueTransfer(Transfer& transfer) {
+  auto const& data   = transfer.content->entries[transfer.entry].data;
+  size_t      length = std::min(mChunkSize, data.size() - transfer.offset);
+
+  // The final chunk is empty. It tells the requestor that the transfer is complete.
+  changeProperty(transfer.requestor, transfer.property, transfer.type, 8,
+      data.data() + transfer.offset, length);
+
+  transfer.offset += length;
+  transfer.deadline = std::chrono::steady_clock::now() + TRANSFER_TIMEOUT;
+
+  return length > 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int ClipboardOwner::expireTransfers() {
+  auto now     = std::chrono::steady_clock::now();
+  int  timeout = -1;
+
+  std::vector<Window> expired;
+
+  for (auto it = mTransfers.begin(); it != mTransfers.end();) {
+    if (it->deadline <= now) {
+      expired.push_back(it->requestor);
+      it = mTransfers.erase(it);
+      continue;
+    }
+
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(it->deadline - now);
+    if (timeout < 0 || remaining.count() < timeout) {
+      timeout = static_cast<int>(remaining.count());
+    }
+
+    ++it;
+  }
+
+  for (Window requestor : expired) {
+    releaseRequestor(requestor);
+  }
+
+  return timeout;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::releaseRequestor(Window requestor) {
+  bool used = std::any_of(mTransfers.begin(), mTransfers.end(),
+      [requestor](Transfer const& transfer) { return transfer.requestor == requestor; });
+
+  if (!used) {
+    selectPropertyChanges(requestor, false);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::selectPropertyChanges(Window window, bool select) {
+  uint32_t mask = select ? XCB_EVENT_MASK_PROPERTY_CHANGE : XCB_EVENT_MASK_NO_EVENT;
+
+  xcb_connection_t* xcb = mConnection.getXCB();
+  ignoreErrors(
+      xcb, xcb_change_window_attributes_checked(xcb, window, XCB_CW_EVENT_MASK, &mask));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::notify(XSelectionRequestEvent const& event, Atom property) {
+  xcb_selection_notify_event_t notification = {};
+  notification.response_type                = XCB_SELECTION_NOTIFY;
+  notification.time                         = static_cast<uint32_t>(event.time);
+  notification.requestor                    = static_cast<uint32_t>(event.requestor);
+  notification.selection                    = static_cast<uint32_t>(event.selection);
+  notification.target                       = static_cast<uint32_t>(event.target);
+  notification.property                     = static_cast<uint32_t>(property);
+
+  xcb_connection_t* xcb = mConnection.getXCB();
+  ignoreErrors(xcb, xcb_send_event_checked(xcb, false, event.requestor,
+                        XCB_EVENT_MASK_NO_EVENT,
+                        reinterpret_cast<const char*>(&notification)));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ClipboardOwner::changeProperty(Window window, Atom property, Atom type, int format,
+    const void* data, size_t elements) {
+  xcb_connection_t* xcb = mConnection.getXCB();
+  ignoreErrors(xcb, xcb_change_property_checked(xcb, XCB_PROP_MODE_REPLACE, window,
+                        property, type, format, elements, data));
+}
@@ -0,0 +1,163 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CLIPBOARD_OWNER_HPP
+#define CLIPBOARD_OWNER_HPP
+
+#include "ClipboardContent.hpp"
+#include "Connection.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/**
+ * This class owns the CLIPBOARD and the PRIMARY selection on behalf of Kando. It runs a
+ * thread with its own connection and an invisible window which answers the conversion
+ * requests of other clients. Hence, the content stays available no matter whether any
+ * of Kando's windows exist and large payloads never block the calling thread.
+ *
+ * The content can be offered under several targets at once. The TARGETS and TIMESTAMP
+ * targets are supported as well. Payloads which do not fit into a single request are
+ * sent incrementally using the INCR mechanism described in the ICCCM. Each transfer
+ * keeps a reference to the content it was started with, so setting new content does not
+ * disturb transfers which are still running.
+ *
+ * The ownership is lost when another client takes over the selection, when the owner is
+ * stopped, or when the connection to the X server is lost.
+ */
+class ClipboardOwner {
+ public:
+  ClipboardOwner() = default;
+  ~ClipboardOwner();
+
+  ClipboardOwner(ClipboardOwner const& other)            = delete;
+  ClipboardOwner& operator=(ClipboardOwner const& other) = delete;
+
+  /**
+   * Connects to the X server, creates the window, and starts the owner thread. Returns
+   * false if the X server cannot be reached. Does nothing if the owner is already
+   * running.
+   */
+  bool start();
+
+  /** Stops the owner thread. This gives up the ownership of both selections. */
+  void stop();
+
+  /** Returns true if the owner thread is running. */
+  bool isRunning() const;
+
+  /**
+   * Takes ownership of the CLIPBOARD selection or, if primary is true, of the PRIMARY
+   * selection and offers the given entries. This waits until the owner thread has
+   * acquired the selection. Returns false if the owner is not running, if there is
+   * nothing to offer, or if the X server did not grant the ownership.
+   */
+  bool set(std::vector<ClipboardEntry> entries, bool primary = false);
+
+ private:
+  // The content of one selection together with the atoms of its targets.
+  struct Content {
+    std::vector<ClipboardEntry> entries;
+    std::vector<Atom>           targets;
+    std::vector<size_t>         targetEntries;
+
+    // The server time at which the ownership has been acquired.
+    Time time = CurrentTime;
+  };
+
+  // A payload which is sent in chunks to a requestor.
+  struct Transfer {
+    Window                         requestor = None;
+    Atom                           property  = None;
+    Atom                           type      = None;
+    std::shared_ptr<Content const> content;
+    size_t                         entry  = 0;
+    size_t                         offset = 0;
+
+    // The transfer is dropped if the requestor does not ask for the next chunk in time.
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  // A call to set() which has not been processed by the owner thread yet.
+  struct Request {
+    std::vector<ClipboardEntry> entries;
+    bool                        primary = false;
+  };
+
+  void run();
+
+  // Creates the invisible window. This has to be done again after a reconnect. All
+  // previous content and transfers are discarded.
+  bool createWindow();
+
+  // Takes ownership of the requested selection. Returns false if this fails.
+  bool acquire(Request request);
+
+  // Asks the X server for the current time by changing a property of our window.
+  Time getServerTime();
+
+  void handleEvent(XEvent const& event);
+  void handleSelectionRequest(XSelectionRequestEvent const& event);
+  void handlePropertyDelete(XPropertyEvent const& event);
+
+  // Writes the next chunk of the given transfer. Returns false once it is complete.
+  bool continueTransfer(Transfer& transfer);
+
+  // Drops all transfers which have not made any progress for a while and returns the
+  // time in milliseconds until the next one expires or -1 if there are none.
+  int expireTransfers();
+
+  // Stops listening for property changes of the given window if no transfer needs them
+  // anymore.
+  void releaseRequestor(Window requestor);
+
+  // Starts or stops listening for property changes of a window of another client.
+  void selectPropertyChanges(Window window, bool select);
+
+  // Sends a SelectionNotify event to the requestor. If property is None, the conversion
+  // is refused.
+  void notify(XSelectionRequestEvent const& event, Atom property);
+
+  // Changes a property of a window of another client. Like the two methods above, this
+  // does not fail if the window has been destroyed in the meantime.
+  void changeProperty(Window window, Atom property, Atom type, int format,
+      const void* data, size_t elements);
+
+  Connection  mConnection;
+  std::thread mThread;
+
+  // This eventfd is used to wake up the owner thread when it should stop or when a new
+  // request is pending.
+  int               mWakeupFd = -1;
+  std::atomic<bool> mRunning  = false;
+
+  // The pending request and the result of the last one are handed over with this mutex.
+  std::mutex              mMutex;
+  std::condition_variable mCondition;
+  std::optional<Request>  mRequest;
+  std::optional<bool>     mResult;
+
+  // These are only accessed from the owner thread once it is running.
+  Window                         mWindow    = None;
+  uint32_t                       mCreatedOn = 0;
+  size_t                         mChunkSize = 0;
+  std::shared_ptr<Content const> mClipboard;
+  std::shared_ptr<Content const> mPrimary;
+  std::vector<Transfer>          mTransfers;
+};
+
+#endif // CLIPBOARD_OWNER_HPP
@@ -0,0 +1,225 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "Connection.hpp"
+
+#include <poll.h>
+
+#include <atomic>
+#include <string>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The names of all atoms in the Atoms struct. They are interned with a single
+// XInternAtoms() call which only needs one round trip to the X server.
+struct AtomName {
+  const char* name;
+  Atom Atoms::*member;
+};
+
+const AtomName ATOM_NAMES[] = {
+    {"CLIPBOARD", &Atoms::clipboard},
+    {"INCR", &Atoms::incr},
+    {"MANAGER", &Atoms::manager},
+    {"TARGETS", &Atoms::targets},
+    {"TEXT", &Atoms::text},
+    {"TIMESTAMP", &Atoms::timestamp},
+    {"UTF8_STRING", &Atoms::utf8String},
+    {"_NET_ACTIVE_WINDOW", &Atoms::netActiveWindow},
+    {"_NET_CLIENT_LIST", &Atoms::netClientList},
+    {"_NET_CLIENT_LIST_STACKING", &Atoms::netClientListStacking},
+    {"_NET_CURRENT_DESKTOP", &Atoms::netCurrentDesktop},
+    {"_NET_FRAME_EXTENTS", &Atoms::netFrameExtents},
+    {"_NET_WM_DESKTOP", &Atoms::netWmDesktop},
+    {"_NET_WM_ICON", &Atoms::netWmIcon},
+    {"_NET_WM_NAME", &Atoms::netWmName},
+    {"_NET_WM_PID", &Atoms::netWmPid},
+    {"_NET_WM_STATE", &Atoms::netWmState},
+    {"_NET_WM_STATE_HIDDEN", &Atoms::netWmStateHidden},
+    {"_NET_WORKAREA", &Atoms::netWorkarea},
+    {"_XSETTINGS_SETTINGS", &Atoms::xsettingsSettings},
+};
+
+constexpr int ATOM_COUNT = sizeof(ATOM_NAMES) / sizeof(ATOM_NAMES[0]);
+
+// These count the display connections of all parts of the addon. They are updated from
+// the background threads as well.
+std::atomic<uint32_t> totalConnectionsOpened = 0;
+std::atomic<uint32_t> openConnections        = 0;
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Connection::~Connection() {
+  disconnect();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Display* Connection::get() {
+
+  // If the server went away, the socket is hung up. We check this before handing out the
+  // display so that the caller does not run into an I/O error in the middle of a query.
+  if (mDisplay && !mConnectionLost) {
+    pollfd pfd = {.fd = ConnectionNumber(mDisplay), .events = 0};
+    if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLHUP | POLLERR | POLLNVAL))) {
+      mConnectionLost = true;
+    }
+
+    // XCB does not report errors to the Xlib I/O error handler.
+    if (xcb_connection_has_error(mXCB)) {
+      mConnectionLost = true;
+    }
+  }
+
+  // The lost connection is replaced silently. The counters of getConnectionsOpened()
+  // show whether this happens.
+  if (mConnectionLost) {
+    disconnect();
+  }
+
+  if (!mDisplay) {
+    connect();
+  }
+
+  return mDisplay;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Display* Connection::getDisplay() const {
+  return mDisplay;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+xcb_connection_t* Connection::getXCB() const {
+  return mXCB;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Window Connection::getRoot() const {
+  return mRoot;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Atoms const& Connection::getAtoms() const {
+  return mAtoms;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t Connection::getConnectionsOpened() const {
+  return mConnectionsOpened;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t Connection::getTotalConnectionsOpened() {
+  return totalConnectionsOpened;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t Connection::getOpenConnections() {
+  return openConnections;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Display* Connection::openDisplay() {
+  Display* display = XOpenDisplay(nullptr);
+  if (display) {
+    ++totalConnectionsOpened;
+    ++openConnections;
+  }
+
+  return display;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Connection::closeDisplay(Display* display) {
+  if (display) {
+    XCloseDisplay(display);
+    --openConnections;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+PropertyReader& Connection::getPropertyReader() {
+  return mPropertyReader;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Connection::connect() {
+  mDisplay = openDisplay();
+  if (!mDisplay) {
+    return;
+  }
+
+  ++mConnectionsOpened;
+  mConnectionLost = false;
+
+  // Per default, Xlib terminates the process if the connection to the X server is lost.
+  // Instead, we only want to reconnect on the next call.
+  XSetIOErrorExitHandler(mDisplay, &Connection::onIOError, this);
+
+  mXCB  = XGetXCBConnection(mDisplay);
+  mRoot = DefaultRootWindow(mDisplay);
+
+  // The name of the XSETTINGS selection depends on the screen number. It is interned in
+  // the same batch as the other atoms.
+  std::string selection = "_XSETTINGS_S" + std::to_string(DefaultScreen(mDisplay));
+
+  char* names[ATOM_COUNT + 1];
+  Atom  atoms[ATOM_COUNT + 1];
+  for (int i = 0; i < ATOM_COUNT; ++i) {
+    names[i] = const_cast<char*>(ATOM_NAMES[i].name);
+  }
+  names[ATOM_COUNT] = selection.data();
+
+  XInternAtoms(mDisplay, names, ATOM_COUNT + 1, False, atoms);
+
+  for (int i = 0; i < ATOM_COUNT; ++i) {
+    mAtoms.*(ATOM_NAMES[i].member) = atoms[i];
+  }
+  mAtoms.xsettingsSelection = atoms[ATOM_COUNT];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Connection::disconnect() {
+  if (mDisplay) {
+    closeDisplay(mDisplay);
+    mDisplay = nullptr;
+  }
+
+  mXCB            = nullptr;
+  mRoot           = None;
+  mAtoms          = {};
+  mConnectionLost = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Connection::onIOError(Display* display, void* userData) {
+  auto* connection            = static_cast<Connection*>(userData);
+  connection->mConnectionLost = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
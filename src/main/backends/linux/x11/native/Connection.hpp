@@ -0,0 +1,138 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CONNECTION_HPP
+#define CONNECTION_HPP
+
+#include "PropertyReader.hpp"
+
+#include <X11/Xlib-xcb.h>
+#include <X11/Xlib.h>
+
+#include <cstdint>
+
+/**
+ * All atoms used by the X11 backend. They are interned once in a single batch when the
+ * connection to the X server is established.
+ */
+struct Atoms {
+  Atom clipboard;
+  Atom incr;
+  Atom manager;
+  Atom targets;
+  Atom text;
+  Atom timestamp;
+  Atom utf8String;
+  Atom netActiveWindow;
+  Atom netClientList;
+  Atom netClientListStacking;
+  Atom netCurrentDesktop;
+  Atom netFrameExtents;
+  Atom netWmDesktop;
+  Atom netWmIcon;
+  Atom netWmName;
+  Atom netWmPid;
+  Atom netWmState;
+  Atom netWmStateHidden;
+  Atom netWorkarea;
+  Atom xsettingsSettings;
+
+  // The _XSETTINGS_S<n> selection of the default screen.
+  Atom xsettingsSelection;
+};
+
+/**
+ * This class owns the connection to the X server which is used by the native addon. The
+ * connection is opened lazily when it is requested for the first time and then kept open
+ * for the entire lifetime of the addon. If the X server drops the connection, the next
+ * call to get() will transparently open a new one.
+ *
+ * Without this, each call into the addon would have to open and close its own connection
+ * which is by far the most expensive part of most of the queries.
+ */
+class Connection {
+ public:
+  Connection() = default;
+  ~Connection();
+
+  Connection(Connection const& other)            = delete;
+  Connection& operator=(Connection const& other) = delete;
+
+  /**
+   * Returns the display connection. If there is no connection yet, or if the previous
+   * connection has been lost, a new one is opened. This returns nullptr if the X server
+   * cannot be reached.
+   */
+  Display* get();
+
+  /**
+   * Returns the display connection without checking whether it is still alive. Only
+   * valid after get() succeeded.
+   */
+  Display* getDisplay() const;
+
+  /**
+   * Returns the XCB connection underlying the Xlib display. This can be used to pipeline
+   * requests. Only valid after get() succeeded.
+   */
+  xcb_connection_t* getXCB() const;
+
+  /** Returns the root window of the default screen. Only valid after get() succeeded. */
+  Window getRoot() const;
+
+  /** Returns the interned atoms. Only valid after get() succeeded. */
+  Atoms const& getAtoms() const;
+
+  /**
+   * Returns the number of connections which have been opened so far. In normal operation,
+   * this should stay at one. It is mostly useful to verify that the connection is reused.
+   */
+  uint32_t getConnectionsOpened() const;
+
+  /**
+   * Opens and closes a display connection which is not owned by a Connection object.
+   * All connections of the addon are opened with these, so that the counters below
+   * include the connections of the background threads.
+   */
+  static Display* openDisplay();
+  static void     closeDisplay(Display* display);
+
+  /** Returns the number of connections opened by any part of the addon so far. */
+  static uint32_t getTotalConnectionsOpened();
+
+  /** Returns the number of connections of the addon which are currently open. */
+  static uint32_t getOpenConnections();
+
+  /**
+   * Returns the reader which is used for large window properties. Its buffer is reused
+   * by all queries on this connection.
+   */
+  PropertyReader& getPropertyReader();
+
+ private:
+  void connect();
+  void disconnect();
+
+  /**
+   * Called by Xlib if an I/O error occurs on our connection. We only mark the connection
+   * as lost so that it gets reopened on the next call to get().
+   */
+  static void onIOError(Display* display, void* userData);
+
+  Display*          mDisplay           = nullptr;
+  xcb_connection_t* mXCB               = nullptr;
+  Window            mRoot              = None;
+  Atoms             mAtoms             = {};
+  bool              mConnectionLost    = false;
+  uint32_t          mConnectionsOpened = 0;
+  PropertyReader    mPropertyReader;
+};
+
+#endif // CONNECTION_HPP
@@ -0,0 +1,183 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "ImageReader.hpp"
+
+#include <sys/shm.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The shared memory segment is grown in steps of this many bytes up to MAX_SHM_SIZE.
+// Rectangles which are even larger are read with a plain GetImage request.
+constexpr size_t SHM_GRANULARITY = 1024 * 1024;
+constexpr size_t MAX_SHM_SIZE    = 64 * 1024 * 1024;
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+uint8_t bitsPerPixel(xcb_connection_t* xcb, uint8_t depth) {
+  auto it = xcb_setup_pixmap_formats_iterator(xcb_get_setup(xcb));
+  for (; it.rem > 0; xcb_format_next(&it)) {
+    if (it.data->depth == depth) {
+      return it.data->bits_per_pixel;
+    }
+  }
+
+  return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+ImageReader::~ImageReader() {
+  freeImage();
+
+  // The connection may already be closed, so we only detach locally.
+  if (mShmData) {
+    shmdt(mShmData);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ImageReader::reset(xcb_connection_t* xcb) {
+  freeImage();
+
+  // The segment has been released by the old X server when the connection was closed.
+  if (mShmData) {
+    shmdt(mShmData);
+  }
+
+  mXCB        = xcb;
+  mShmSegment = XCB_NONE;
+  mShmData    = nullptr;
+  mShmSize    = 0;
+  mHasShm     = false;
+
+  // Requests to extensions which are not available would close the connection.
+  if (xcb_get_extension_data(xcb, &xcb_shm_id)->present) {
+    auto* reply = xcb_shm_query_version_reply(xcb, xcb_shm_query_version(xcb), nullptr);
+    mHasShm     = reply != nullptr;
+    free(reply);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t* ImageReader::read(
+    xcb_drawable_t drawable, int16_t x, int16_t y, uint16_t width, uint16_t height) {
+
+  freeImage();
+
+  if (reserveSharedMemory(size_t(width) * height * 4)) {
+    auto* reply = xcb_shm_get_image_reply(mXCB,
+        xcb_shm_get_image(mXCB, drawable, x, y, width, height, ~0u,
+            XCB_IMAGE_FORMAT_Z_PIXMAP, mShmSegment, 0),
+        nullptr);
+
+    if (!reply) {
+      return nullptr;
+    }
+
+    free(reply);
+    return reinterpret_cast<uint32_t*>(mShmData);
+  }
+
+  mImage = xcb_get_image_reply(mXCB,
+      xcb_get_image(mXCB, XCB_IMAGE_FORMAT_Z_PIXMAP, drawable, x, y, width, height, ~0u),
+      nullptr);
+
+  if (!mImage) {
+    return nullptr;
+  }
+
+  return reinterpret_cast<uint32_t*>(xcb_get_image_data(mImage));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ImageReader::release() {
+  freeImage();
+
+  if (!mShmData) {
+    return;
+  }
+
+  xcb_shm_detach(mXCB, mShmSegment);
+  shmdt(mShmData);
+
+  mShmSegment = XCB_NONE;
+  mShmData    = nullptr;
+  mShmSize    = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ImageReader::reserveSharedMemory(size_t size) {
+  if (!mHasShm || size > MAX_SHM_SIZE) {
+    return false;
+  }
+
+  if (size <= mShmSize) {
+    return true;
+  }
+
+  release();
+
+  size = std::min(MAX_SHM_SIZE, (size + SHM_GRANULARITY - 1) / SHM_GRANULARITY *
+                                    SHM_GRANULARITY);
+
+  int id = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+  if (id < 0) {
+    return false;
+  }
+
+  void* data = shmat(id, nullptr, 0);
+  if (data == reinterpret_cast<void*>(-1)) {
+    shmctl(id, IPC_RMID, nullptr);
+    return false;
+  }
+
+  xcb_shm_seg_t        segment = xcb_generate_id(mXCB);
+  xcb_generic_error_t* error =
+      xcb_request_check(mXCB, xcb_shm_attach_checked(mXCB, segment, id, false));
+
+  // The segment is destroyed once both we and the X server have detached from it.
+  shmctl(id, IPC_RMID, nullptr);
+
+  // This fails for instance if the X server runs on another machine. In this case, we do
+  // not try again.
+  if (error) {
+    free(error);
+    shmdt(data);
+    mHasShm = false;
+    return false;
+  }
+
+  mShmSegment = segment;
+  mShmData    = static_cast<uint8_t*>(data);
+  mShmSize    = size;
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void ImageReader::freeImage() {
+  free(mImage);
+  mImage = nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
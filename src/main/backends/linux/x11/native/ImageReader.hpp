@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef IMAGE_READER_HPP
+#define IMAGE_READER_HPP
+
+#include <xcb/shm.h>
+#include <xcb/xcb.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Returns the number of bits per pixel in images of the given depth or zero if the X
+ * server does not support this depth.
+ */
+uint8_t bitsPerPixel(xcb_connection_t* xcb, uint8_t depth);
+
+/**
+ * This class reads rectangles of drawables with 32 bits per pixel. If the X server
+ * supports MIT-SHM, the pixels are transferred through a shared memory segment which is
+ * kept around and reused for subsequent reads. It is only grown if a larger rectangle is
+ * requested. Else, or if the rectangle is too large for the segment, a plain GetImage
+ * request is used.
+ *
+ * The reader is bound to one connection. It is not thread-safe.
+ */
+class ImageReader {
+ public:
+  ImageReader() = default;
+  ~ImageReader();
+
+  ImageReader(ImageReader const& other)            = delete;
+  ImageReader& operator=(ImageReader const& other) = delete;
+
+  /**
+   * Binds the reader to the given connection and checks whether MIT-SHM is available.
+   * Any segment of a previous connection is dropped without talking to the old X server.
+   * This makes a round trip to the X server.
+   */
+  void reset(xcb_connection_t* xcb);
+
+  /**
+   * Reads the given rectangle of the drawable in Z-pixmap format. The rows of the
+   * returned pixels are tightly packed. They stay valid until the next call to read(),
+   * reset() or release(). Returns nullptr if the rectangle could not be read, for
+   * instance because it is not fully inside the drawable.
+   */
+  uint32_t* read(
+      xcb_drawable_t drawable, int16_t x, int16_t y, uint16_t width, uint16_t height);
+
+  /** Detaches the shared memory segment from the X server and frees all pixels. */
+  void release();
+
+ private:
+  // Makes sure that the shared memory segment has at least the given size. Returns false
+  // if shared memory cannot be used.
+  bool reserveSharedMemory(size_t size);
+
+  void freeImage();
+
+  xcb_connection_t*      mXCB        = nullptr;
+  bool                   mHasShm     = false;
+  xcb_shm_seg_t          mShmSegment = XCB_NONE;
+  uint8_t*               mShmData    = nullptr;
+  size_t                 mShmSize    = 0;
+  xcb_get_image_reply_t* mImage      = nullptr;
+};
+
+#endif // IMAGE_READER_HPP
@@ -0,0 +1,538 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "KeyGrabber.hpp"
+
+#include <X11/XF86keysym.h>
+#include <X11/XKBlib.h>
+#include <X11/keysym.h>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// If the X server cannot be reached, the event thread retries after this many
+// milliseconds.
+constexpr int RECONNECT_INTERVAL = 1000;
+
+// The modifier bits of the core protocol. Everything else in the state field of key
+// events (pointer buttons and the keyboard group) is ignored.
+constexpr unsigned int MODIFIER_MASK =
+    ShiftMask | LockMask | ControlMask | Mod1Mask | Mod2Mask | Mod3Mask | Mod4Mask |
+    Mod5Mask;
+
+// The modifier names supported by Electron's accelerators. Like Electron on Linux, we
+// map Command to the Super key. Only CommandOrControl becomes Control.
+const std::unordered_map<std::string, unsigned int> MODIFIERS = {
+    {"command", Mod4Mask},
+    {"cmd", Mod4Mask},
+    {"control", ControlMask},
+    {"ctrl", ControlMask},
+    {"commandorcontrol", ControlMask},
+    {"cmdorctrl", ControlMask},
+    {"alt", Mod1Mask},
+    {"option", Mod1Mask},
+    {"altgr", Mod5Mask},
+    {"shift", ShiftMask},
+    {"super", Mod4Mask},
+    {"meta", Mod4Mask},
+};
+
+// The key names supported by Electron's accelerators which consist of more than one
+// character. Function keys and the number pad keys are handled separately.
+const std::unordered_map<std::string, KeySym> KEYS = {
+    {"plus", XK_plus},
+    {"space", XK_space},
+    {"tab", XK_Tab},
+    {"capslock", XK_Caps_Lock},
+    {"numlock", XK_Num_Lock},
+    {"scrolllock", XK_Scroll_Lock},
+    {"backspace", XK_BackSpace},
+    {"delete", XK_Delete},
+    {"insert", XK_Insert},
+    {"return", XK_Return},
+    {"enter", XK_Return},
+    {"up", XK_Up},
+    {"down", XK_Down},
+    {"left", XK_Left},
+    {"right", XK_Right},
+    {"home", XK_Home},
+    {"end", XK_End},
+    {"pageup", XK_Page_Up},
+    {"pagedown", XK_Page_Down},
+    {"escape", XK_Escape},
+    {"esc", XK_Escape},
+    {"printscreen", XK_Print},
+    {"volumeup", XF86XK_AudioRaiseVolume},
+    {"volumedown", XF86XK_AudioLowerVolume},
+    {"volumemute", XF86XK_AudioMute},
+    {"medianexttrack", XF86XK_AudioNext},
+    {"mediaprevioustrack", XF86XK_AudioPrev},
+    {"mediastop", XF86XK_AudioStop},
+    {"mediaplaypause", XF86XK_AudioPlay},
+    {"numdec", XK_KP_Decimal},
+    {"numadd", XK_KP_Add},
+    {"numsub", XK_KP_Subtract},
+    {"nummult", XK_KP_Multiply},
+    {"numdiv", XK_KP_Divide},
+};
+
+// Returns the number in the given string or -1 if it is not a small positive number.
+int parseNumber(std::string const& string) {
+  if (string.empty() || string.size() > 2 ||
+      !std::all_of(string.begin(), string.end(), ::isdigit)) {
+    return -1;
+  }
+
+  return std::atoi(string.c_str());
+}
+
+std::optional<KeySym> parseKey(std::string const& name) {
+
+  // All printable ASCII characters have a keysym with the same value.
+  if (name.size() == 1 && name[0] > ' ' && name[0] <= '~') {
+    return KeySym(name[0]);
+  }
+
+  auto it = KEYS.find(name);
+  if (it != KEYS.end()) {
+    return it->second;
+  }
+
+  if (name[0] == 'f') {
+    int number = parseNumber(name.substr(1));
+    if (number >= 1 && number <= 24) {
+      return XK_F1 + number - 1;
+    }
+  }
+
+  if (name.rfind("num", 0) == 0) {
+    int number = parseNumber(name.substr(3));
+    if (number >= 0 && number <= 9 && name.size() == 4) {
+      return XK_KP_0 + number;
+    }
+  }
+
+  return std::nullopt;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<Accelerator> parseAccelerator(std::string const& accelerator) {
+  Accelerator result;
+  size_t      start = 0;
+
+  while (start <= accelerator.size()) {
+    size_t end = accelerator.find('+', start);
+    if (end == std::string::npos) {
+      end = accelerator.size();
+    }
+
+    std::string name = accelerator.substr(start, end - start);
+    if (name.empty()) {
+      return std::nullopt;
+    }
+
+    // Letters are stored as lower-case keysyms. Their upper-case variants map to the
+    // same keycode anyway.
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    auto modifier = MODIFIERS.find(name);
+    if (modifier != MODIFIERS.end()) {
+      result.modifiers |= modifier->second;
+    } else {
+      std::optional<KeySym> key = parseKey(name);
+      if (!key || result.keysym != NoSymbol) {
+        return std::nullopt;
+      }
+
+      result.keysym = *key;
+    }
+
+    start = end + 1;
+  }
+
+  if (result.keysym == NoSymbol) {
+    return std::nullopt;
+  }
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+KeyGrabber::~KeyGrabber() {
+  stop();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KeyGrabber::start() {
+  if (mRunning) {
+    return;
+  }
+
+  mWakeupFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  mRunning  = true;
+  mThread   = std::thread(&KeyGrabber::run, this);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KeyGrabber::stop() {
+  if (!mRunning) {
+    return;
+  }
+
+  mRunning = false;
+
+  uint64_t value = 1;
+  write(mWakeupFd, &value, sizeof(value));
+
+  mThread.join();
+
+  close(mWakeupFd);
+  mWakeupFd = -1;
+
+  // The keys should not stay grabbed once we do not listen anymore.
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mSynced) {
+    for (auto& [accelerator, shortcut] : mShortcuts) {
+      ungrab(shortcut);
+    }
+
+    xcb_flush(mConnection.getXCB());
+  }
+
+  mSynced = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::string> KeyGrabber::setShortcuts(
+    std::vector<std::string> const& accelerators) {
+  std::vector<std::string> failed;
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (auto it = mShortcuts.begin(); it != mShortcuts.end();) {
+      if (std::find(accelerators.begin(), accelerators.end(), it->first) ==
+          accelerators.end()) {
+        if (mSynced) {
+          ungrab(it->second);
+        }
+        it = mShortcuts.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    for (auto const& accelerator : accelerators) {
+      if (mShortcuts.count(accelerator)) {
+        continue;
+      }
+
+      std::optional<Accelerator> parsed = parseAccelerator(accelerator);
+      if (!parsed) {
+        failed.push_back(accelerator);
+        continue;
+      }
+
+      // If we are not connected yet, the shortcut will be grabbed once we are.
+      Shortcut shortcut;
+      shortcut.accelerator = *parsed;
+      if (mSynced && !grab(shortcut)) {
+        failed.push_back(accelerator);
+      }
+
+      mShortcuts.emplace(accelerator, shortcut);
+    }
+
+    if (mSynced) {
+      xcb_flush(mConnection.getXCB());
+    }
+  }
+
+  // Waiting for the replies may have moved events to the event queue of Xlib. We wake
+  // up the event thread so that it processes them.
+  if (mRunning) {
+    uint64_t value = 1;
+    write(mWakeupFd, &value, sizeof(value));
+  }
+
+  return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KeyGrabber::setInhibited(std::string const& accelerator, bool inhibited) {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  auto it = mShortcuts.find(accelerator);
+  if (it != mShortcuts.end()) {
+    it->second.inhibited = inhibited;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KeyGrabber::setCallback(ShortcutCallback callback) {
+  std::lock_guard<std::mutex> lock(mCallbackMutex);
+  mCallback = std::move(callback);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KeyGrabber::run() {
+  while (mRunning) {
+
+    // (Re-)Connect to the X server if necessary. If this fails, we wait a bit and try
+    // again. The wakeup fd interrupts the waiting if the thread should stop.
+    bool synced;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      synced = mSynced || sync();
+    }
+
+    if (!synced) {
+      pollfd pfd = {.fd = mWakeupFd, .events = POLLIN};
+      poll(&pfd, 1, RECONNECT_INTERVAL);
+      continue;
+    }
+
+    Display* display = mConnection.getDisplay();
+
+    while (XPending(display) > 0) {
+      XEvent event;
+      XNextEvent(display, &event);
+      handleEvent(event);
+    }
+
+    if (xcb_connection_has_error(mConnection.getXCB())) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mSynced = false;
+      continue;
+    }
+
+    pollfd fds[2] = {
+        {.fd = ConnectionNumber(display), .events = POLLIN},
+        {.fd = mWakeupFd, .events = POLLIN},
+    };
+
+    poll(fds, 2, -1);
+
+    if (fds[1].revents & POLLIN) {
+      uint64_t value;
+      read(mWakeupFd, &value, sizeof(value));
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool KeyGrabber::sync() {
+  Display* display = mConnection.get();
+  if (!display) {
+    return false;
+  }
+
+  // With detectable auto-repeat, holding a key produces a series of key presses followed
+  // by a single release instead of pairs of presses and releases. The state events tell
+  // us when the modifiers of a shortcut are released.
+  int opcode, error, major = XkbMajorVersion, minor = XkbMinorVersion;
+  if (XkbQueryExtension(display, &opcode, &mXkbEventType, &error, &major, &minor)) {
+    XkbSetDetectableAutoRepeat(display, True, nullptr);
+    XkbSelectEventDetails(display, XkbUseCoreKbd, XkbStateNotify, XkbModifierStateMask,
+                          XkbModifierStateMask);
+  }
+
+  mNumLockMask = XkbKeysymToModifiers(display, XK_Num_Lock);
+
+  // After a reconnect, all grabs are gone.
+  for (auto& [accelerator, shortcut] : mShortcuts) {
+    shortcut.grabbed = false;
+    grab(shortcut);
+  }
+
+  mHeld.reset();
+  mModifiers = 0;
+
+  xcb_flush(mConnection.getXCB());
+  mSynced = !xcb_connection_has_error(mConnection.getXCB());
+
+  return mSynced;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KeyGrabber::handleEvent(XEvent& event) {
+
+  // If the keyboard layout changes, the keycodes of our shortcuts may change as well.
+  if (event.type == MappingNotify) {
+    XRefreshKeyboardMapping(&event.xmapping);
+
+    if (event.xmapping.request != MappingPointer) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      for (auto& [accelerator, shortcut] : mShortcuts) {
+        ungrab(shortcut);
+      }
+
+      mNumLockMask = XkbKeysymToModifiers(mConnection.getDisplay(), XK_Num_Lock);
+
+      for (auto& [accelerator, shortcut] : mShortcuts) {
+        grab(shortcut);
+      }
+    }
+
+    return;
+  }
+
+  if (event.type == mXkbEventType) {
+    auto* xkb = reinterpret_cast<XkbEvent*>(&event);
+    if (xkb->any.xkb_type == XkbStateNotify) {
+      mModifiers = xkb->state.mods;
+      checkRelease(xkb->state.time);
+    }
+
+    return;
+  }
+
+  if (event.type == KeyPress) {
+    XKeyEvent& key = event.xkey;
+    mModifiers     = key.state & MODIFIER_MASK;
+
+    // Further presses of the held key are auto-repeat events.
+    if (mHeld && mHeld->keycode == key.keycode && mHeld->keyDown) {
+      return;
+    }
+
+    unsigned int modifiers = key.state & MODIFIER_MASK & ~(LockMask | mNumLockMask);
+    bool         inhibited = false;
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+
+      auto it = std::find_if(mShortcuts.begin(), mShortcuts.end(), [&](auto const& s) {
+        return s.second.grabbed && s.second.keycode == key.keycode &&
+               s.second.accelerator.modifiers == modifiers;
+      });
+
+      if (it == mShortcuts.end()) {
+        return;
+      }
+
+      mHeld     = HeldShortcut{it->first, it->second.keycode, modifiers, true};
+      inhibited = it->second.inhibited;
+    }
+
+    if (!inhibited) {
+      report(mHeld->accelerator, true, key.time);
+    }
+
+    return;
+  }
+
+  if (event.type == KeyRelease) {
+    if (mHeld && mHeld->keycode == event.xkey.keycode) {
+      mHeld->keyDown = false;
+      checkRelease(event.xkey.time);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool KeyGrabber::grab(Shortcut& shortcut) {
+  Display*          display = mConnection.getDisplay();
+  xcb_connection_t* xcb     = mConnection.getXCB();
+
+  shortcut.keycode = XKeysymToKeycode(display, shortcut.accelerator.keysym);
+  if (shortcut.keycode == 0) {
+    return false;
+  }
+
+  // We grab all combinations of Caps Lock and Num Lock in one batch and then wait for
+  // the errors. If another client grabbed the key already, we get a BadAccess error.
+  unsigned int const locks[4] = {0, LockMask, mNumLockMask, LockMask | mNumLockMask};
+  xcb_void_cookie_t  cookies[4];
+
+  for (int i = 0; i < 4; ++i) {
+    cookies[i] = xcb_grab_key_checked(xcb, 1, mConnection.getRoot(),
+        shortcut.accelerator.modifiers | locks[i], shortcut.keycode,
+        XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+  }
+
+  bool success = true;
+  for (auto const& cookie : cookies) {
+    xcb_generic_error_t* error = xcb_request_check(xcb, cookie);
+    if (error) {
+      success = false;
+      free(error);
+    }
+  }
+
+  shortcut.grabbed = true;
+
+  if (!success) {
+    ungrab(shortcut);
+  }
+
+  return success;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KeyGrabber::ungrab(Shortcut& shortcut) {
+  if (!shortcut.grabbed) {
+    return;
+  }
+
+  xcb_connection_t*  xcb      = mConnection.getXCB();
+  unsigned int const locks[4] = {0, LockMask, mNumLockMask, LockMask | mNumLockMask};
+
+  for (unsigned int lock : locks) {
+    xcb_ungrab_key(xcb, shortcut.keycode, mConnection.getRoot(),
+        shortcut.accelerator.modifiers | lock);
+  }
+
+  shortcut.grabbed = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KeyGrabber::checkRelease(uint32_t time) {
+  if (mHeld && !mHeld->keyDown && (mModifiers & mHeld->modifiers) == 0) {
+    report(mHeld->accelerator, false, time);
+    mHeld.reset();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KeyGrabber::report(std::string const& accelerator, bool pressed, uint32_t time) {
+  std::lock_guard<std::mutex> lock(mCallbackMutex);
+  if (mCallback) {
+    mCallback(accelerator, pressed, time);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
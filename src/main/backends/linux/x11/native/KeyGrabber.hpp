@@ -0,0 +1,150 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef KEY_GRABBER_HPP
+#define KEY_GRABBER_HPP
+
+#include "Connection.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/** A key combination as parsed from an Electron accelerator string. */
+struct Accelerator {
+  KeySym       keysym    = NoSymbol;
+  unsigned int modifiers = 0;
+};
+
+/**
+ * Parses an accelerator like "Control+Shift+K" as used by Electron's globalShortcut
+ * module. Key and modifier names are case-insensitive. Returns nothing if the string
+ * contains unknown names or not exactly one non-modifier key.
+ */
+std::optional<Accelerator> parseAccelerator(std::string const& accelerator);
+
+/**
+ * This class binds global shortcuts with XGrabKey. It runs a thread with its own
+ * connection to the X server which receives the key events of the grabbed keys. Each
+ * shortcut is grabbed once for every combination of Caps Lock and Num Lock so that it
+ * also works if one of them is active.
+ *
+ * Shortcuts can be inhibited. This only flips a flag: The keys stay grabbed, but presses
+ * are not reported anymore. Releases are always reported. A shortcut is considered to be
+ * released once its key and all of its modifiers have been released. As XKB state events
+ * are delivered regardless of the input focus, this works even if no Kando window is
+ * focused. Key repeat is detected with XKB's detectable auto-repeat so that holding a
+ * shortcut is reported as a single press.
+ */
+class KeyGrabber {
+ public:
+  KeyGrabber() = default;
+  ~KeyGrabber();
+
+  KeyGrabber(KeyGrabber const& other)            = delete;
+  KeyGrabber& operator=(KeyGrabber const& other) = delete;
+
+  /** Starts the event thread. Does nothing if it is already running. */
+  void start();
+
+  /** Stops the event thread, releases all grabs, and waits for the thread to finish. */
+  void stop();
+
+  /**
+   * Replaces the set of grabbed shortcuts. Only the difference to the previous set is
+   * grabbed or ungrabbed. Returns the accelerators which could not be parsed or which
+   * are already grabbed by another client. Inhibition flags of shortcuts which stay bound
+   * are kept.
+   */
+  std::vector<std::string> setShortcuts(std::vector<std::string> const& accelerators);
+
+  /**
+   * Sets whether presses of the given shortcut should be reported. Does nothing if the
+   * shortcut is not bound.
+   */
+  void setInhibited(std::string const& accelerator, bool inhibited);
+
+  using ShortcutCallback =
+      std::function<void(std::string const& accelerator, bool pressed, uint32_t time)>;
+
+  /**
+   * Sets the callback which is called from the event thread whenever a shortcut is
+   * pressed or released. The time is the X server time of the event in milliseconds.
+   * Pass an empty function to remove the callback. Once this returns, the previous
+   * callback will not be called anymore.
+   */
+  void setCallback(ShortcutCallback callback);
+
+ private:
+  struct Shortcut {
+    Accelerator accelerator;
+    KeyCode     keycode   = 0;
+    bool        grabbed   = false;
+    bool        inhibited = false;
+  };
+
+  // The shortcut which is currently held down. It is released once its key and all of
+  // its modifiers have been released.
+  struct HeldShortcut {
+    std::string  accelerator;
+    KeyCode      keycode   = 0;
+    unsigned int modifiers = 0;
+    bool         keyDown   = true;
+  };
+
+  void run();
+
+  // Connects to the X server (if necessary), enables detectable auto-repeat, selects the
+  // XKB state events and grabs all shortcuts. Must be called with mMutex locked.
+  bool sync();
+
+  void handleEvent(XEvent& event);
+
+  // Grabs or ungrabs the given shortcut for all lock modifier combinations. Must be
+  // called with mMutex locked. Returns false if another client has grabbed the key.
+  bool grab(Shortcut& shortcut);
+  void ungrab(Shortcut& shortcut);
+
+  // Reports the release of the held shortcut if its key and modifiers are up.
+  void checkRelease(uint32_t time);
+
+  void report(std::string const& accelerator, bool pressed, uint32_t time);
+
+  Connection  mConnection;
+  std::thread mThread;
+
+  // This eventfd is used to wake up the event thread when it should stop.
+  int               mWakeupFd = -1;
+  std::atomic<bool> mRunning  = false;
+
+  // These are only accessed from the event thread.
+  int                         mXkbEventType = -1;
+  unsigned int                mModifiers    = 0;
+  std::optional<HeldShortcut> mHeld;
+
+  // These are protected by mMutex as they are modified from the main thread.
+  std::mutex                                mMutex;
+  std::unordered_map<std::string, Shortcut> mShortcuts;
+  bool                                      mSynced      = false;
+  unsigned int                              mNumLockMask  = 0;
+
+  // The callback is protected by its own mutex so that it can be called without blocking
+  // the main thread.
+  std::mutex       mCallbackMutex;
+  ShortcutCallback mCallback;
+};
+
+#endif // KEY_GRABBER_HPP
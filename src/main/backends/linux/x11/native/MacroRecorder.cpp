@@ -0,0 +1,258 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "MacroRecorder.hpp"
+
+#include "Connection.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Once the context has been disabled, the X server sends the remaining events followed
+// by an end-of-data reply. If this does not arrive within this many milliseconds, the
+// recording is stopped anyway.
+constexpr int STOP_TIMEOUT = 500;
+
+// A macro is meant to be a short sequence. If the recording is left running by accident,
+// we stop collecting events at some point.
+constexpr size_t MAX_EVENTS = 10000;
+
+// The size of a protocol event and the offsets of the fields we need.
+constexpr size_t EVENT_SIZE    = 32;
+constexpr size_t TYPE_OFFSET   = 0;
+constexpr size_t DETAIL_OFFSET = 1;
+constexpr size_t TIME_OFFSET   = 4;
+
+// The most significant bit of the type is set for events sent with SendEvent.
+constexpr uint8_t SEND_EVENT_MASK = 0x80;
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<RecordedEvent> parseRecordedEvent(uint8_t const* data, size_t length) {
+  if (length < EVENT_SIZE) {
+    return std::nullopt;
+  }
+
+  uint8_t type = data[TYPE_OFFSET] & ~SEND_EVENT_MASK;
+  if (type < KeyPress || type > ButtonRelease) {
+    return std::nullopt;
+  }
+
+  RecordedEvent event;
+  event.detail   = data[DETAIL_OFFSET];
+  event.isButton = type == ButtonPress || type == ButtonRelease;
+  event.down     = type == KeyPress || type == ButtonPress;
+  std::memcpy(&event.time, data + TIME_OFFSET, sizeof(event.time));
+
+  return event;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+MacroRecorder::~MacroRecorder() {
+  stop();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool MacroRecorder::start() {
+  stop();
+
+  mControlDisplay = Connection::openDisplay();
+  mDataDisplay    = Connection::openDisplay();
+
+  int major = 0, minor = 0;
+  if (!mControlDisplay || !mDataDisplay ||
+      !XRecordQueryVersion(mControlDisplay, &major, &minor)) {
+    disconnect();
+    return false;
+  }
+
+  // We are interested in key and button events of all devices. These are not
+  // associated with a client, so there is no need to record client data.
+  XRecordRange* range = XRecordAllocRange();
+  if (!range) {
+    disconnect();
+    return false;
+  }
+
+  range->device_events.first = KeyPress;
+  range->device_events.last  = ButtonRelease;
+
+  XRecordClientSpec clients = XRecordAllClients;
+  mContext = XRecordCreateContext(mControlDisplay, 0, &clients, 1, &range, 1);
+  XFree(range);
+
+  // The context has to exist on the server before it can be enabled on the data
+  // connection.
+  XSync(mControlDisplay, False);
+
+  if (!mContext) {
+    disconnect();
+    return false;
+  }
+
+  mWakeupFd  = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  mStopping  = false;
+  mEndOfData = false;
+  mEvents.clear();
+
+  mThread = std::thread(&MacroRecorder::run, this);
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<RecordedEvent> MacroRecorder::stop() {
+  if (!mThread.joinable()) {
+    return {};
+  }
+
+  // Disabling the context makes the X server flush the pending events to the data
+  // connection and send an end-of-data reply. The recording thread stops once it
+  // receives this.
+  XRecordDisableContext(mControlDisplay, mContext);
+  XSync(mControlDisplay, False);
+
+  mStopping      = true;
+  uint64_t value = 1;
+  write(mWakeupFd, &value, sizeof(value));
+
+  mThread.join();
+
+  XRecordFreeContext(mControlDisplay, mContext);
+  mContext = 0;
+
+  disconnect();
+
+  std::vector<RecordedEvent> events = std::move(mEvents);
+  mEvents.clear();
+
+  // Unsigned arithmetic handles the wrap-around of the server time after 49.7 days.
+  for (size_t i = 1; i < events.size(); ++i) {
+    events[i].delay = events[i].time - events[i - 1].time;
+  }
+
+  return events;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool MacroRecorder::isRecording() const {
+  return mThread.joinable();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void MacroRecorder::run() {
+
+  // This does not block. The recorded data is delivered to onData() whenever
+  // XRecordProcessReplies() is called.
+  if (!XRecordEnableContextAsync(mDataDisplay, mContext, &MacroRecorder::onData,
+          reinterpret_cast<XPointer>(this))) {
+    return;
+  }
+
+  pollfd fds[2] = {
+      {.fd = ConnectionNumber(mDataDisplay), .events = POLLIN},
+      {.fd = mWakeupFd, .events = POLLIN},
+  };
+
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+
+  while (!mEndOfData) {
+    XRecordProcessReplies(mDataDisplay);
+
+    if (mEndOfData) {
+      break;
+    }
+
+    int timeout = -1;
+    if (mStopping) {
+      auto now = std::chrono::steady_clock::now();
+      if (!deadline) {
+        deadline = now + std::chrono::milliseconds(STOP_TIMEOUT);
+      }
+
+      if (now >= *deadline) {
+        break;
+      }
+
+      timeout = int(
+          std::chrono::duration_cast<std::chrono::milliseconds>(*deadline - now).count());
+    }
+
+    poll(fds, 2, timeout);
+
+    if (fds[0].revents & (POLLERR | POLLHUP)) {
+      break;
+    }
+
+    if (fds[1].revents & POLLIN) {
+      uint64_t value;
+      read(mWakeupFd, &value, sizeof(value));
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void MacroRecorder::disconnect() {
+  if (mControlDisplay) {
+    Connection::closeDisplay(mControlDisplay);
+    mControlDisplay = nullptr;
+  }
+
+  if (mDataDisplay) {
+    Connection::closeDisplay(mDataDisplay);
+    mDataDisplay = nullptr;
+  }
+
+  if (mWakeupFd >= 0) {
+    close(mWakeupFd);
+    mWakeupFd = -1;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void MacroRecorder::onData(XPointer closure, XRecordInterceptData* data) {
+  auto* self = reinterpret_cast<MacroRecorder*>(closure);
+
+  if (data->category == XRecordEndOfData) {
+    self->mEndOfData = true;
+  } else if (data->category == XRecordFromServer && self->mEvents.size() < MAX_EVENTS) {
+    std::optional<RecordedEvent> event =
+        parseRecordedEvent(data->data, size_t(data->data_len) * 4);
+
+    if (event) {
+      if (data->client_swapped) {
+        event->time = __builtin_bswap32(event->time);
+      }
+
+      self->mEvents.push_back(*event);
+    }
+  }
+
+  XRecordFreeData(data);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
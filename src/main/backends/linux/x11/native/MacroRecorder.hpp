@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef MACRO_RECORDER_HPP
+#define MACRO_RECORDER_HPP
+
+#include <X11/Xlib.h>
+#include <X11/extensions/record.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/** A key or pointer button event captured by the MacroRecorder. */
+struct RecordedEvent {
+  // The X11 keycode for key events or the button number for button events.
+  uint8_t detail   = 0;
+  bool    isButton = false;
+  bool    down     = false;
+
+  // The X server time of the event in milliseconds.
+  uint32_t time = 0;
+
+  // The milliseconds since the previous recorded event. This is zero for the first one.
+  uint32_t delay = 0;
+};
+
+/**
+ * Parses a protocol event as delivered by the RECORD extension. Returns nothing if the
+ * data is not a key or button event. The delay of the result is not set.
+ */
+std::optional<RecordedEvent> parseRecordedEvent(uint8_t const* data, size_t length);
+
+/**
+ * This class records the key presses and pointer button presses of all clients with the
+ * RECORD extension. This is used to record macros for the execute-macro action.
+ *
+ * The extension requires two connections to the X server: The context is created and
+ * disabled on a control connection while the data connection is blocked by the
+ * recording. Both are opened in start() and closed in stop(), so no connection is kept
+ * open while nothing is recorded. The data connection is read by a thread which only
+ * appends the events to a list. The time stamps are taken from the X server, so the
+ * delays do not depend on how quickly the thread is scheduled.
+ *
+ * All methods have to be called from the same thread.
+ */
+class MacroRecorder {
+ public:
+  MacroRecorder() = default;
+  ~MacroRecorder();
+
+  MacroRecorder(MacroRecorder const& other)            = delete;
+  MacroRecorder& operator=(MacroRecorder const& other) = delete;
+
+  /**
+   * Starts recording. A previous recording is discarded. Returns false if the X server
+   * cannot be reached or does not support the RECORD extension.
+   */
+  bool start();
+
+  /**
+   * Stops recording and returns the recorded events in the order in which they were
+   * processed by the X server. The delays are computed from the server time stamps.
+   * Returns an empty list if nothing is being recorded.
+   */
+  std::vector<RecordedEvent> stop();
+
+  /** Returns true between a successful call to start() and the next call to stop(). */
+  bool isRecording() const;
+
+ private:
+  void run();
+
+  // Closes both connections and the wakeup fd.
+  void disconnect();
+
+  static void onData(XPointer closure, XRecordInterceptData* data);
+
+  Display*       mControlDisplay = nullptr;
+  Display*       mDataDisplay    = nullptr;
+  XRecordContext mContext        = 0;
+  std::thread    mThread;
+
+  // This eventfd is used to wake up the recording thread once the context has been
+  // disabled.
+  int               mWakeupFd = -1;
+  std::atomic<bool> mStopping = false;
+
+  // These are only accessed from the recording thread while it is running.
+  bool                       mEndOfData = false;
+  std::vector<RecordedEvent> mEvents;
+};
+
+#endif // MACRO_RECORDER_HPP
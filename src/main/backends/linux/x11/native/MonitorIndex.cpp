@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "MonitorIndex.hpp"
+
+#include <algorithm>
+#include <climits>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void MonitorIndex::build(std::vector<Monitor> monitors) {
+  mMonitors = std::move(monitors);
+  mBounds   = {};
+  mCells.clear();
+
+  if (mMonitors.empty()) {
+    return;
+  }
+
+  // The cells store the monitor indices as uint8_t. There will never be that many
+  // monitors.
+  if (mMonitors.size() > UINT8_MAX) {
+    mMonitors.resize(UINT8_MAX);
+  }
+
+  // First, we compute the bounding box of all monitors.
+  int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+  for (auto const& monitor : mMonitors) {
+    minX = std::min(minX, monitor.geometry.x);
+    minY = std::min(minY, monitor.geometry.y);
+    maxX = std::max(maxX, monitor.geometry.x + monitor.geometry.width);
+    maxY = std::max(maxY, monitor.geometry.y + monitor.geometry.height);
+  }
+
+  mBounds = {minX, minY, std::max(maxX - minX, 1), std::max(maxY - minY, 1)};
+
+  // Then we add each monitor to all cells it overlaps.
+  mCells.resize(GRID_SIZE * GRID_SIZE);
+
+  auto cellX = [this](int x) {
+    return std::clamp(
+        static_cast<int>((int64_t(x) - mBounds.x) * GRID_SIZE / mBounds.width), 0,
+        GRID_SIZE - 1);
+  };
+
+  auto cellY = [this](int y) {
+    return std::clamp(
+        static_cast<int>((int64_t(y) - mBounds.y) * GRID_SIZE / mBounds.height), 0,
+        GRID_SIZE - 1);
+  };
+
+  for (size_t i = 0; i < mMonitors.size(); ++i) {
+    Rect const& geometry = mMonitors[i].geometry;
+
+    if (geometry.width <= 0 || geometry.height <= 0) {
+      continue;
+    }
+
+    int x0 = cellX(geometry.x);
+    int y0 = cellY(geometry.y);
+    int x1 = cellX(geometry.x + geometry.width - 1);
+    int y1 = cellY(geometry.y + geometry.height - 1);
+
+    for (int y = y0; y <= y1; ++y) {
+      for (int x = x0; x <= x1; ++x) {
+        mCells[y * GRID_SIZE + x].push_back(static_cast<uint8_t>(i));
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Monitor const* MonitorIndex::find(int x, int y) const {
+  if (mMonitors.empty()) {
+    return nullptr;
+  }
+
+  if (mBounds.contains(x, y)) {
+    int cx = static_cast<int>((int64_t(x) - mBounds.x) * GRID_SIZE / mBounds.width);
+    int cy = static_cast<int>((int64_t(y) - mBounds.y) * GRID_SIZE / mBounds.height);
+
+    for (uint8_t i : mCells[cy * GRID_SIZE + cx]) {
+      if (mMonitors[i].geometry.contains(x, y)) {
+        return &mMonitors[i];
+      }
+    }
+  }
+
+  // The position is in a gap between the monitors or outside of all of them. This should
+  // not happen for the pointer, so a linear search is fine here.
+  return findClosest(x, y);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Monitor> const& MonitorIndex::getMonitors() const {
+  return mMonitors;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Monitor const* MonitorIndex::findClosest(int x, int y) const {
+  Monitor const* closest         = nullptr;
+  int64_t        closestDistance = INT64_MAX;
+
+  for (auto const& monitor : mMonitors) {
+    Rect const& geometry = monitor.geometry;
+
+    int64_t dx = std::max({geometry.x - x, 0, x - (geometry.x + geometry.width - 1)});
+    int64_t dy = std::max({geometry.y - y, 0, y - (geometry.y + geometry.height - 1)});
+
+    int64_t distance = dx * dx + dy * dy;
+    if (distance < closestDistance) {
+      closest         = &monitor;
+      closestDistance = distance;
+    }
+  }
+
+  return closest;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef MONITOR_INDEX_HPP
+#define MONITOR_INDEX_HPP
+
+#include <cstdint>
+#include <vector>
+
+/** An axis-aligned rectangle in physical pixels. */
+struct Rect {
+  int x      = 0;
+  int y      = 0;
+  int width  = 0;
+  int height = 0;
+
+  bool contains(int px, int py) const {
+    return px >= x && py >= y && px < x + width && py < y + height;
+  }
+
+  bool operator==(Rect const& other) const {
+    return x == other.x && y == other.y && width == other.width && height == other.height;
+  }
+};
+
+/** A monitor as reported by XRandR. */
+struct Monitor {
+  /** The area of the root window which is covered by the monitor. */
+  Rect geometry;
+
+  /**
+   * The part of the geometry which is not covered by panels or docks. This is the
+   * intersection of the geometry with the _NET_WORKAREA of the current desktop.
+   */
+  Rect workArea;
+
+  /**
+   * X11 has no notion of per-monitor scaling. This is the Xft.dpi scaling factor which is
+   * used for all monitors. It is stored per monitor so that the callers do not have to
+   * care.
+   */
+  double scalingFactor = 1.0;
+};
+
+/**
+ * This is a spatial index over all monitors. It divides the bounding box of all monitors
+ * into a fixed grid of cells and stores for each cell the monitors which overlap it.
+ * Finding the monitor at a given position is then a division to find the cell followed by
+ * testing the one or two monitors which usually overlap it. So the lookup takes constant
+ * time, independent of the number of monitors.
+ */
+class MonitorIndex {
+ public:
+  /** Replaces the monitors of the index. */
+  void build(std::vector<Monitor> monitors);
+
+  /**
+   * Returns the monitor containing the given position. If the position is not on any
+   * monitor, the closest one is returned. Returns nullptr only if there are no monitors
+   * at all. The pointer is valid until the next call to build().
+   */
+  Monitor const* find(int x, int y) const;
+
+  /** Returns all monitors in the order they have been passed to build(). */
+  std::vector<Monitor> const& getMonitors() const;
+
+ private:
+  // The bounding box of all monitors is divided into GRID_SIZE x GRID_SIZE cells.
+  static constexpr int GRID_SIZE = 16;
+
+  Monitor const* findClosest(int x, int y) const;
+
+  std::vector<Monitor> mMonitors;
+  Rect                 mBounds;
+
+  // For each cell, this contains the indices of all monitors which overlap it. The cells
+  // are stored row by row.
+  std::vector<std::vector<uint8_t>> mCells;
+};
+
+#endif // MONITOR_INDEX_HPP
@@ -9,27 +9,123 @@
 // SPDX-License-Identifier: MIT
 
 #include "Native.hpp"
+#include "Blur.hpp"
+#include "WindowQueries.hpp"
+#include "WindowShape.hpp"
 
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
-#include <X11/Xresource.h>
 #include <X11/extensions/XTest.h>
 #include <X11/keysym.h>
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <optional>
 #include <string>
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// Converts RGBA pixels to a JavaScript object with a width, a height, and an ArrayBuffer
+// containing the pixels. Electron does not allow external buffers, so the pixels are
+// copied.
+Napi::Value toImage(Napi::Env env, uint32_t width, uint32_t height,
+    std::vector<uint8_t> const& rgba) {
+  Napi::ArrayBuffer data = Napi::ArrayBuffer::New(env, rgba.size());
+  std::copy(rgba.begin(), rgba.end(), static_cast<uint8_t*>(data.Data()));
+
+  Napi::Object obj = Napi::Object::New(env);
+  obj.Set("width", width);
+  obj.Set("height", height);
+  obj.Set("data", data);
+
+  return obj;
+}
+
+// Converts an icon or a thumbnail to a JavaScript object. See above.
+Napi::Value toImage(Napi::Env env, std::shared_ptr<const Icon> const& icon) {
+  if (!icon) {
+    return env.Null();
+  }
+
+  return toImage(env, icon->width, icon->height, icon->rgba);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
 Native::Native(Napi::Env env, Napi::Object exports) {
   DefineAddon(exports, {
                            InstanceMethod("movePointer", &Native::movePointer),
                            InstanceMethod("simulateKey", &Native::simulateKey),
+                           InstanceMethod("simulateText", &Native::simulateText),
+                           InstanceMethod("setClipboard", &Native::setClipboard),
                            InstanceMethod("getWMInfo", &Native::getWMInfo),
                            InstanceMethod("getOpenWindows", &Native::getOpenWindows),
                            InstanceMethod("focusWindow", &Native::focusWindow),
+                           InstanceMethod(
+                               "getConnectionsOpened", &Native::getConnectionsOpened),
+                           InstanceMethod(
+                               "onActiveWindowChanged", &Native::onActiveWindowChanged),
+                           InstanceMethod("onWindowsChanged", &Native::onWindowsChanged),
+                           InstanceMethod("getScalingFactor", &Native::getScalingFactor),
+                           InstanceMethod("getIconTheme", &Native::getIconTheme),
+                           InstanceMethod("setPointerTrackingEnabled",
+                                          &Native::setPointerTrackingEnabled),
+                           InstanceMethod(
+                               "getTrackedPointer", &Native::getTrackedPointer),
+                           InstanceMethod("bindShortcuts", &Native::bindShortcuts),
+                           InstanceMethod(
+                               "setShortcutInhibited", &Native::setShortcutInhibited),
+                           InstanceMethod("onShortcutEvent", &Native::onShortcutEvent),
+                           InstanceMethod("getWindowIcon", &Native::getWindowIcon),
+                           InstanceMethod(
+                               "getWindowThumbnails", &Native::getWindowThumbnails),
+                           InstanceMethod("captureBackdrop", &Native::captureBackdrop),
+                           InstanceMethod(
+                               "startMacroRecording", &Native::startMacroRecording),
+                           InstanceMethod(
+                               "stopMacroRecording", &Native::stopMacroRecording),
+                           InstanceMethod("setWindowShape", &Native::setWindowShape),
                        });
+
+  // The window table uses its own connection on a background thread. The other
+  // background connections are only opened once their feature is used.
+  XInitThreads();
+  mWindowTable.start();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Native::~Native() {
+  mMacroRecorder.stop();
+  mClipboardOwner.stop();
+  mThumbnails.stop();
+  mKeyGrabber.stop();
+  mPointerTracker.stop();
+  mWindowTable.stop();
+
+  // The spare keycodes which have been assigned for typing text are cleared again.
+  if (mTextTyperConnection != 0 &&
+      mTextTyperConnection == mConnection.getConnectionsOpened()) {
+    mTextTyper.restoreSpareKeys(mConnection.getDisplay());
+  }
+
+  if (mActiveWindowCallback) {
+    mActiveWindowCallback.Release();
+  }
+
+  if (mWindowsCallback) {
+    mWindowsCallback.Release();
+  }
+
+  if (mShortcutCallback) {
+    mShortcutCallback.Release();
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -41,14 +137,18 @@ void Native::movePointer(const Napi::CallbackInfo& info) {
     Napi::TypeError::New(env, "Two Numbers expected").ThrowAsJavaScriptException();
   }
 
-  auto display = XOpenDisplay(nullptr);
+  auto display = mConnection.get();
+  if (!display) {
+    Napi::Error::New(env, "Failed to connect to the X server!")
+        .ThrowAsJavaScriptException();
+    return;
+  }
 
   auto dx = info[0].As<Napi::Number>().Int32Value();
   auto dy = info[1].As<Napi::Number>().Int32Value();
 
   XTestFakeRelativeMotionEvent(display, dx, dy, CurrentTime);
-
-  XCloseDisplay(display);
+  XFlush(display);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -60,74 +160,132 @@ void Native::simulateKey(const Napi::CallbackInfo& info) {
     Napi::TypeError::New(env, "Number and Boolean expected").ThrowAsJavaScriptException();
   }
 
-  auto    display = XOpenDisplay(nullptr);
+  auto display = mConnection.get();
+  if (!display) {
+    Napi::Error::New(env, "Failed to connect to the X server!")
+        .ThrowAsJavaScriptException();
+    return;
+  }
+
   KeyCode keycode = info[0].As<Napi::Number>().Int32Value();
   bool    press   = info[1].As<Napi::Boolean>().Value();
 
   XTestFakeKeyEvent(display, keycode, press, CurrentTime);
-
-  XCloseDisplay(display);
+  XFlush(display);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
-// This is based on https://github.com/yvesh/active-windows
-
-namespace {
+Napi::Value Native::simulateText(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
 
-unsigned char* getStringProperty(
-    Display* display, Window window, std::string const& name) {
-  Atom           actual_type, filter_atom;
-  int            actual_format, status;
-  unsigned long  nitems, bytes_after;
-  unsigned char* prop;
+  if (info.Length() != 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "String expected").ThrowAsJavaScriptException();
+    return env.Null();
+  }
 
-  filter_atom = XInternAtom(display, name.c_str(), 1);
-  status = XGetWindowProperty(display, window, filter_atom, 0, 1000, 0, AnyPropertyType,
-      &actual_type, &actual_format, &nitems, &bytes_after, &prop);
+  auto display = mConnection.get();
+  if (!display) {
+    Napi::Error::New(env, "Failed to connect to the X server!")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
 
-  if (status != Success) {
-    return 0;
+  if (mTextTyperConnection != mConnection.getConnectionsOpened()) {
+    mTextTyper.reset(display);
+    mTextTyperConnection = mConnection.getConnectionsOpened();
   }
 
-  return prop;
+  std::string text = info[0].As<Napi::String>().Utf8Value();
+  return Napi::Boolean::New(env, mTextTyper.type(display, text));
 }
 
-unsigned long getLongProperty(Display* display, Window window, std::string const& name) {
-  unsigned char* prop = getStringProperty(display, window, name);
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::setClipboard(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
 
-  if (prop == 0) {
-    return 0;
+  if (info.Length() < 1 || !info[0].IsArray() ||
+      (info.Length() > 1 && !info[1].IsBoolean())) {
+    Napi::TypeError::New(env, "Array and optional boolean expected")
+        .ThrowAsJavaScriptException();
+    return env.Null();
   }
 
-  unsigned long long_property =
-      prop[0] + (prop[1] << 8) + (prop[2] << 16) + (prop[3] << 24);
-  return long_property;
-}
+  auto array = info[0].As<Napi::Array>();
 
-bool getWindowAppAndName(
-    Display* display, Window window, std::string& appName, std::string& windowName) {
-  char* wm_class = reinterpret_cast<char*>(getStringProperty(display, window, "WM_CLASS"));
-  if (!wm_class || wm_class[0] == '\0') {
-    return false;
-  }
+  std::vector<ClipboardEntry> entries;
+  for (uint32_t i = 0; i < array.Length(); ++i) {
+    Napi::Value value = array.Get(i);
+    if (!value.IsObject()) {
+      Napi::TypeError::New(env, "Clipboard entries must be objects")
+          .ThrowAsJavaScriptException();
+      return env.Null();
+    }
 
-  unsigned char* net_wm_name = getStringProperty(display, window, "_NET_WM_NAME");
-  if (net_wm_name != nullptr) {
-    windowName = reinterpret_cast<const char*>(net_wm_name);
-  } else {
-    unsigned char* wm_name_prop = getStringProperty(display, window, "WM_NAME");
-    if (wm_name_prop != nullptr) {
-      windowName = reinterpret_cast<const char*>(wm_name_prop);
+    auto object   = value.As<Napi::Object>();
+    auto mimeType = object.Get("mimeType");
+    auto data     = object.Get("data");
+
+    if (!mimeType.IsString() || !(data.IsString() || data.IsBuffer())) {
+      Napi::TypeError::New(env, "Clipboard entries need a MIME type and data")
+          .ThrowAsJavaScriptException();
+      return env.Null();
     }
+
+    ClipboardEntry entry;
+    entry.mimeType = mimeType.As<Napi::String>().Utf8Value();
+
+    if (data.IsBuffer()) {
+      auto buffer = data.As<Napi::Buffer<char>>();
+      entry.data.assign(buffer.Data(), buffer.Length());
+    } else {
+      entry.data = data.As<Napi::String>().Utf8Value();
+    }
+
+    entries.push_back(std::move(entry));
+  }
+
+  bool primary = info.Length() > 1 && info[1].As<Napi::Boolean>().Value();
+
+  if (!mClipboardOwner.start()) {
+    return Napi::Boolean::New(env, false);
+  }
+
+  return Napi::Boolean::New(env, mClipboardOwner.set(std::move(entries), primary));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Converts the given window to the object which is passed to JavaScript.
+Napi::Object toObject(Napi::Env env, WindowInfo const& window) {
+  Napi::Object obj = Napi::Object::New(env);
+  obj.Set("app", window.appName);
+  obj.Set("window", window.windowName);
+  obj.Set("id", Napi::Number::New(env, window.id));
+  obj.Set("minimized", window.minimized);
+
+  // Sticky windows and windows of window managers without workspaces have no workspace.
+  if (window.desktop != 0xFFFFFFFF) {
+    obj.Set("workspace", Napi::Number::New(env, window.desktop));
   }
 
-  if (windowName.empty()) {
-    return false;
+  if (window.monitor >= 0) {
+    obj.Set("monitor", window.monitor);
   }
 
-  appName = wm_class;
-  return true;
+  return obj;
+}
+
+// Creates a thread-safe function for the given JavaScript callback. It does not keep the
+// event loop alive.
+Napi::ThreadSafeFunction createCallback(Napi::Env env, Napi::Function const& callback,
+    const char* name) {
+  auto tsfn = Napi::ThreadSafeFunction::New(env, callback, name, 0, 1);
+  tsfn.Unref(env);
+  return tsfn;
 }
 
 } // namespace
@@ -139,51 +297,85 @@ Napi::Value Native::getWMInfo(const Napi::CallbackInfo& info) {
 
   Napi::Object obj = Napi::Object::New(env);
 
-  Display* display = XOpenDisplay(nullptr);
-  int      screen  = XDefaultScreen(display);
-  Window   root    = RootWindow(display, screen);
-
-  if (root) {
-    Window window = getLongProperty(display, root, "_NET_ACTIVE_WINDOW");
-
-    if (window) {
-      std::string appName;
-      std::string windowName;
-      if (getWindowAppAndName(display, window, appName, windowName)) {
-        obj.Set("app", appName);
-        obj.Set("window", windowName);
-      }
-    }
+  if (!mConnection.get()) {
+    Napi::Error::New(env, "Failed to connect to the X server!")
+        .ThrowAsJavaScriptException();
+    return env.Null();
   }
 
-  // Get pointer location.
-  int          root_x, root_y, win_x, win_y;
-  unsigned int mask;
-  Window       child;
-  XQueryPointer(display, root, &child, &child, &root_x, &root_y, &win_x, &win_y, &mask);
+  WindowInfo                activeWindow;
+  PointerPosition           pointer;
+  double                    scalingFactor;
+  std::optional<Monitor>    monitor;
+  std::optional<WindowInfo> hoveredWindow;
+
+  if (mWindowTable.isSynced()) {
+    // If the window table is up to date, we already know the active window, the scaling
+    // factor, and the monitors. Only the pointer position requires a round trip, unless
+    // the pointer tracker is running and has seen the pointer move.
+    activeWindow  = mWindowTable.getActiveWindow();
+    scalingFactor = mWindowTable.getScalingFactor();
+
+    std::optional<PointerSnapshot> snapshot = mPointerTracker.getSnapshot();
+    if (mPointerTracker.isRunning() && snapshot) {
+      pointer = {snapshot->x, snapshot->y};
+    } else {
+      pointer = queryPointer(mConnection);
+    }
 
-  // Get the DPI scaling factor
-  double scaling_factor  = 1.0;
-  char*  resource_string = XResourceManagerString(display);
+    monitor       = mWindowTable.findMonitor(pointer.x, pointer.y);
+    hoveredWindow = mWindowTable.findWindowAt(pointer.x, pointer.y);
+  } else {
+    // Else we retrieve the active window, its properties, the pointer position and the
+    // resources in two pipelined batches.
+    WMState state = queryWMState(mConnection);
+    activeWindow  = state.activeWindow;
+    scalingFactor = parseScalingFactor(state.resources);
+    pointer       = {state.pointerX, state.pointerY};
+  }
 
-  if (resource_string) {
-    XrmDatabase db = XrmGetStringDatabase(resource_string);
+  if (activeWindow.hasAppAndName()) {
+    obj.Set("app", activeWindow.appName);
+    obj.Set("window", activeWindow.windowName);
+  }
 
-    char*    type;
-    XrmValue value;
+  // Like the work area below, the window under the pointer is only known if the window
+  // table is up to date. It is found in the cached window geometries.
+  if (hoveredWindow && hoveredWindow->hasAppAndName()) {
+    obj.Set("hoveredApp", hoveredWindow->appName);
+    obj.Set("hoveredWindow", hoveredWindow->windowName);
+  }
 
-    if (XrmGetResource(db, "Xft.dpi", "Xft.Dpi", &type, &value)) {
-      double dpi     = atof(value.addr);
-      scaling_factor = dpi / 96.0; // Assuming 96 DPI as the baseline for 1.0 scaling
+  // The process information is only read from /proc the first time a process is seen.
+  std::shared_ptr<const ProcessInfo> process = mProcessCache.get(activeWindow.pid);
+  if (process) {
+    Napi::Array commandLine = Napi::Array::New(env, process->commandLine.size());
+    for (uint32_t i = 0; i < process->commandLine.size(); ++i) {
+      commandLine.Set(i, process->commandLine[i]);
     }
 
-    XrmDestroyDatabase(db);
+    obj.Set("pid", process->pid);
+    obj.Set("executable", process->executable);
+    obj.Set("commandLine", commandLine);
   }
 
-  obj.Set("pointerX", 1.0 * root_x / scaling_factor);
-  obj.Set("pointerY", 1.0 * root_y / scaling_factor);
-
-  XCloseDisplay(display);
+  obj.Set("pointerX", 1.0 * pointer.x / scalingFactor);
+  obj.Set("pointerY", 1.0 * pointer.y / scalingFactor);
+  obj.Set("scalingFactor", scalingFactor);
+
+  // The work area of the monitor under the pointer is only known if the window table is
+  // up to date. Else the caller has to find it on its own.
+  if (monitor) {
+    Rect const& area  = monitor->workArea;
+    double      scale = monitor->scalingFactor;
+
+    Napi::Object workArea = Napi::Object::New(env);
+    workArea.Set("x", area.x / scale);
+    workArea.Set("y", area.y / scale);
+    workArea.Set("width", area.width / scale);
+    workArea.Set("height", area.height / scale);
+    obj.Set("workArea", workArea);
+  }
 
   return obj;
 }
@@ -194,127 +386,706 @@ Napi::Value Native::getOpenWindows(const Napi::CallbackInfo& info) {
   Napi::Env   env    = info.Env();
   Napi::Array result = Napi::Array::New(env);
 
-  Display* display = XOpenDisplay(nullptr);
+  std::vector<WindowInfo> windows;
+
+  // Usually, the window table is up to date. Only if its event thread has not yet
+  // connected, we query the X server directly.
+  if (mWindowTable.isSynced()) {
+    windows = mWindowTable.getWindows();
+  } else if (mConnection.get()) {
+    windows = queryWindowInfos(mConnection, queryClientList(mConnection));
+  }
+
+  uint32_t index = 0;
+
+  for (auto const& window : windows) {
+    if (window.hasAppAndName()) {
+      result.Set(index++, toObject(env, window));
+    }
+  }
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::focusWindow(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString() ||
+      (info.Length() > 2 && !info[2].IsNumber() && !info[2].IsUndefined())) {
+    Napi::TypeError::New(env, "Two strings and an optional number expected")
+        .ThrowAsJavaScriptException();
+    return;
+  }
+
+  std::string targetWindowName = info[0].As<Napi::String>().Utf8Value();
+  std::string targetAppName    = info[1].As<Napi::String>().Utf8Value();
+
+  Display* display = mConnection.get();
   if (!display) {
-    return result;
+    return;
+  }
+
+  Window       root  = mConnection.getRoot();
+  Atoms const& atoms = mConnection.getAtoms();
+
+  // If the ID of a window from getOpenWindows() is given, the window can be looked up
+  // directly. Else the most recently used window with the given app and title is used.
+  std::optional<Window> id;
+  if (info.Length() > 2 && info[2].IsNumber()) {
+    id = info[2].As<Napi::Number>().Uint32Value();
   }
 
-  int    screen = XDefaultScreen(display);
-  Window root   = RootWindow(display, screen);
+  std::optional<std::vector<WindowInfo>> windows;
+  std::optional<WindowInfo>              target =
+      findWindow(id, targetAppName, targetWindowName, windows);
 
-  Atom          actual_type;
-  int           actual_format;
-  unsigned long nitems, bytes_after;
-  unsigned char* data = nullptr;
+  if (!target) {
+    return;
+  }
 
-  Atom net_client_list = XInternAtom(display, "_NET_CLIENT_LIST", False);
-  int  status          = XGetWindowProperty(display, root, net_client_list, 0, ~0L, False,
-      XA_WINDOW, &actual_type, &actual_format, &nitems, &bytes_after, &data);
+  WindowInfo const& window = *target;
+
+  // Switch to the window's workspace first so the WM moves to it rather
+  // than just showing an activation notification.
+  // _NET_WM_DESKTOP value 0xFFFFFFFF means "all desktops" – no switch needed.
+  if (window.desktop != 0xFFFFFFFF) {
+    XEvent desktopEvent               = {};
+    desktopEvent.type                 = ClientMessage;
+    desktopEvent.xclient.window       = root;
+    desktopEvent.xclient.message_type = atoms.netCurrentDesktop;
+    desktopEvent.xclient.format       = 32;
+    desktopEvent.xclient.data.l[0]    = static_cast<long>(window.desktop);
+    desktopEvent.xclient.data.l[1]    = CurrentTime;
+
+    XSendEvent(display, root, False,
+        SubstructureNotifyMask | SubstructureRedirectMask, &desktopEvent);
+  }
 
-  if (status == Success && data) {
-    Window*  windows = reinterpret_cast<Window*>(data);
-    uint32_t index   = 0;
+  // Now activate the window using the standard EWMH _NET_ACTIVE_WINDOW message.
+  XEvent event               = {};
+  event.type                 = ClientMessage;
+  event.xclient.window       = window.id;
+  event.xclient.message_type = atoms.netActiveWindow;
+  event.xclient.format       = 32;
+  event.xclient.data.l[0]    = 1; // source indication: 1 = application
+  event.xclient.data.l[1]    = CurrentTime;
+  event.xclient.data.l[2]    = 0; // currently active window (none)
+
+  XSendEvent(display, root, False,
+      SubstructureNotifyMask | SubstructureRedirectMask, &event);
+  XFlush(display);
+}
 
-    for (unsigned long i = 0; i < nitems; i++) {
-      Window win = windows[i];
+//////////////////////////////////////////////////////////////////////////////////////////
 
-      std::string appName;
-      std::string windowName;
-      if (getWindowAppAndName(display, win, appName, windowName)) {
-        Napi::Object obj = Napi::Object::New(env);
-        obj.Set("app", appName);
-        obj.Set("window", windowName);
-        result.Set(index++, obj);
+Napi::Value Native::getConnectionsOpened(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("main", Napi::Number::New(env, mConnection.getConnectionsOpened()));
+  result.Set("total", Napi::Number::New(env, Connection::getTotalConnectionsOpened()));
+  result.Set("open", Napi::Number::New(env, Connection::getOpenConnections()));
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::getScalingFactor(const Napi::CallbackInfo& info) {
+  if (mWindowTable.isSynced()) {
+    return Napi::Number::New(info.Env(), mWindowTable.getScalingFactor());
+  }
+
+  double scalingFactor = 1.0;
+  if (mConnection.get()) {
+    scalingFactor = parseScalingFactor(queryResources(mConnection));
+  }
+
+  return Napi::Number::New(info.Env(), scalingFactor);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::getIconTheme(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  std::optional<std::string> iconTheme;
+
+  if (mWindowTable.isSynced()) {
+    iconTheme = mWindowTable.getIconTheme();
+  } else if (mConnection.get()) {
+    Window owner = queryXSettingsOwner(mConnection);
+    if (owner != None) {
+      std::optional<XSettings> settings = queryXSettings(mConnection, owner);
+      if (settings) {
+        iconTheme = settings->getString("Net/IconThemeName");
       }
     }
+  }
+
+  if (!iconTheme) {
+    return env.Null();
+  }
+
+  return Napi::String::New(env, *iconTheme);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::onActiveWindowChanged(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  // Remove the previous callback first. Once this returns, the event thread will not
+  // use the old thread-safe function anymore.
+  mWindowTable.setActiveWindowCallback(nullptr);
+
+  if (mActiveWindowCallback) {
+    mActiveWindowCallback.Release();
+    mActiveWindowCallback = Napi::ThreadSafeFunction();
+  }
+
+  if (info.Length() == 0 || !info[0].IsFunction()) {
+    return;
+  }
+
+  mActiveWindowCallback =
+      createCallback(env, info[0].As<Napi::Function>(), "onActiveWindowChanged");
+
+  mWindowTable.setActiveWindowCallback(
+      [tsfn = mActiveWindowCallback](WindowInfo const& window) {
+        tsfn.NonBlockingCall(
+            new WindowInfo(window), [](Napi::Env env, Napi::Function callback,
+                                        WindowInfo* window) {
+              if (window->hasAppAndName()) {
+                callback.Call({toObject(env, *window)});
+              } else {
+                callback.Call({env.Null()});
+              }
+              delete window;
+            });
+      });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::onWindowsChanged(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  mWindowTable.setWindowsCallback(nullptr);
+
+  if (mWindowsCallback) {
+    mWindowsCallback.Release();
+    mWindowsCallback = Napi::ThreadSafeFunction();
+  }
+
+  if (info.Length() == 0 || !info[0].IsFunction()) {
+    return;
+  }
+
+  mWindowsCallback =
+      createCallback(env, info[0].As<Napi::Function>(), "onWindowsChanged");
+
+  mWindowTable.setWindowsCallback(
+      [tsfn = mWindowsCallback](std::vector<WindowInfo> const& windows) {
+        tsfn.NonBlockingCall(new std::vector<WindowInfo>(windows),
+            [](Napi::Env env, Napi::Function callback, std::vector<WindowInfo>* windows) {
+              Napi::Array result = Napi::Array::New(env);
+              uint32_t    index  = 0;
+
+              for (auto const& window : *windows) {
+                if (window.hasAppAndName()) {
+                  result.Set(index++, toObject(env, window));
+                }
+              }
+
+              callback.Call({result});
+              delete windows;
+            });
+      });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::setPointerTrackingEnabled(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsBoolean()) {
+    Napi::TypeError::New(env, "Boolean expected").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  if (info[0].As<Napi::Boolean>()) {
+    return Napi::Boolean::New(env, mPointerTracker.start());
+  }
+
+  mPointerTracker.stop();
+  return Napi::Boolean::New(env, false);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::getTrackedPointer(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  std::optional<PointerSnapshot> snapshot = mPointerTracker.getSnapshot();
+  if (!mPointerTracker.isRunning() || !snapshot) {
+    return env.Null();
+  }
+
+  double scalingFactor = mWindowTable.isSynced() ? mWindowTable.getScalingFactor() : 1.0;
+
+  Napi::Object obj = Napi::Object::New(env);
+  obj.Set("pointerX", snapshot->x / scalingFactor);
+  obj.Set("pointerY", snapshot->y / scalingFactor);
+  obj.Set("timestamp", snapshot->timestamp);
+  obj.Set("sampleRate", mPointerTracker.getSampleRate());
+
+  return obj;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::bindShortcuts(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    Napi::TypeError::New(env, "Array expected").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Napi::Array              array = info[0].As<Napi::Array>();
+  std::vector<std::string> shortcuts;
+
+  for (uint32_t i = 0; i < array.Length(); ++i) {
+    Napi::Value value = array.Get(i);
+    if (value.IsString()) {
+      shortcuts.push_back(value.As<Napi::String>().Utf8Value());
+    }
+  }
 
-    XFree(data);
+  // The key grabber opens its connection only once the first shortcut is bound.
+  if (!shortcuts.empty()) {
+    mKeyGrabber.start();
   }
 
-  XCloseDisplay(display);
+  std::vector<std::string> failed = mKeyGrabber.setShortcuts(shortcuts);
+
+  Napi::Array result = Napi::Array::New(env, failed.size());
+  for (uint32_t i = 0; i < failed.size(); ++i) {
+    result.Set(i, failed[i]);
+  }
 
   return result;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
-void Native::focusWindow(const Napi::CallbackInfo& info) {
+void Native::setShortcutInhibited(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
-  if (info.Length() != 2 || !info[0].IsString() || !info[1].IsString()) {
-    Napi::TypeError::New(env, "Two strings expected").ThrowAsJavaScriptException();
+  if (info.Length() < 2 || !info[0].IsString() || !info[1].IsBoolean()) {
+    Napi::TypeError::New(env, "String and Boolean expected").ThrowAsJavaScriptException();
     return;
   }
 
+  mKeyGrabber.setInhibited(
+      info[0].As<Napi::String>().Utf8Value(), info[1].As<Napi::Boolean>());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Native::onShortcutEvent(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  mKeyGrabber.setCallback(nullptr);
+
+  if (mShortcutCallback) {
+    mShortcutCallback.Release();
+    mShortcutCallback = Napi::ThreadSafeFunction();
+  }
+
+  if (info.Length() == 0 || !info[0].IsFunction()) {
+    return;
+  }
+
+  mShortcutCallback =
+      createCallback(env, info[0].As<Napi::Function>(), "onShortcutEvent");
+
+  struct ShortcutEvent {
+    std::string accelerator;
+    bool        pressed;
+    uint32_t    time;
+  };
+
+  mKeyGrabber.setCallback([tsfn = mShortcutCallback](std::string const& accelerator,
+                              bool pressed, uint32_t time) {
+    tsfn.NonBlockingCall(new ShortcutEvent{accelerator, pressed, time},
+        [](Napi::Env env, Napi::Function callback, ShortcutEvent* event) {
+          callback.Call({Napi::String::New(env, event->accelerator),
+              Napi::Boolean::New(env, event->pressed),
+              Napi::Number::New(env, event->time)});
+          delete event;
+        });
+  });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::getWindowIcon(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 3 || !info[0].IsString() || !info[1].IsString() ||
+      !info[2].IsNumber() ||
+      (info.Length() > 3 && !info[3].IsNumber() && !info[3].IsUndefined())) {
+    Napi::TypeError::New(env, "Two strings, a number, and an optional number expected")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
   std::string targetWindowName = info[0].As<Napi::String>().Utf8Value();
   std::string targetAppName    = info[1].As<Napi::String>().Utf8Value();
+  uint32_t    size             = info[2].As<Napi::Number>().Uint32Value();
+
+  std::optional<Window> id;
+  if (info.Length() > 3 && info[3].IsNumber()) {
+    id = info[3].As<Napi::Number>().Uint32Value();
+  }
+
+  if (!mConnection.get()) {
+    Napi::Error::New(env, "Failed to connect to the X server!")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::optional<std::vector<WindowInfo>> windows;
+  std::optional<WindowInfo>              window =
+      findWindow(id, targetAppName, targetWindowName, windows);
+
+  if (!window) {
+    return env.Null();
+  }
+
+  // Forget the icons of closed windows once the cache has grown. The limit grows with the
+  // number of open windows so that the list of windows is only read now and then.
+  if (mIconCache.size() > mIconCachePruneSize) {
+    if (!windows) {
+      windows = mWindowTable.isSynced()
+                    ? mWindowTable.getWindows()
+                    : queryWindowInfos(mConnection, queryClientList(mConnection));
+    }
+
+    std::vector<Window> ids;
+    for (auto const& w : *windows) {
+      ids.push_back(w.id);
+    }
+    mIconCache.retain(ids);
+    mIconCachePruneSize = std::max<size_t>(64, 2 * mIconCache.size());
+  }
+
+  std::shared_ptr<const Icon> icon = mIconCache.get(
+      mConnection, window->id, size, mWindowTable.getIconSerial(window->id));
+
+  return toImage(env, icon);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::getWindowThumbnails(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() != 2 || !info[0].IsArray() || !info[1].IsNumber()) {
+    Napi::TypeError::New(env, "An array and a number expected")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Napi::Array requested = info[0].As<Napi::Array>();
+  uint32_t    size      = info[1].As<Napi::Number>().Uint32Value();
+
+  // The capture thread is only started once thumbnails are needed for the first time.
+  if (!mThumbnails.isRunning() && !mThumbnails.start()) {
+    return env.Null();
+  }
+
+  // The thumbnails are captured on a separate connection, but the windows are looked up
+  // using the main connection.
+  if (!mConnection.get()) {
+    Napi::Error::New(env, "Failed to connect to the X server!")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  // Windows which do not exist result in null. All others are captured in one batch.
+  std::optional<std::vector<WindowInfo>> windows;
+  std::vector<Window>                    ids;
+  std::vector<Window>                    existing;
+  for (uint32_t i = 0; i < requested.Length(); ++i) {
+    Napi::Value value = requested.Get(i);
+    if (!value.IsObject()) {
+      Napi::TypeError::New(env, "Objects with app and window expected")
+          .ThrowAsJavaScriptException();
+      return env.Null();
+    }
+
+    Napi::Value app  = value.As<Napi::Object>().Get("app");
+    Napi::Value name = value.As<Napi::Object>().Get("window");
+    Napi::Value id   = value.As<Napi::Object>().Get("id");
+    if (!app.IsString() || !name.IsString() || !(id.IsUndefined() || id.IsNumber())) {
+      Napi::TypeError::New(env, "Objects with app and window expected")
+          .ThrowAsJavaScriptException();
+      return env.Null();
+    }
+
+    std::optional<Window> targetId;
+    if (id.IsNumber()) {
+      targetId = id.As<Napi::Number>().Uint32Value();
+    }
+
+    std::optional<WindowInfo> window = findWindow(targetId,
+        app.As<Napi::String>().Utf8Value(), name.As<Napi::String>().Utf8Value(), windows);
+
+    if (!window) {
+      ids.push_back(None);
+    } else {
+      ids.push_back(window->id);
+      existing.push_back(window->id);
+    }
+  }
+
+  std::vector<std::shared_ptr<const Icon>> thumbnails = mThumbnails.get(existing, size);
 
-  Display* display = XOpenDisplay(nullptr);
+  Napi::Array result = Napi::Array::New(env, ids.size());
+  for (uint32_t i = 0, j = 0; i < ids.size(); ++i) {
+    result.Set(i, ids[i] == None ? env.Null() : toImage(env, thumbnails[j++]));
+  }
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::captureBackdrop(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() != 5 || !info[0].IsNumber() || !info[1].IsNumber() ||
+      !info[2].IsNumber() || !info[3].IsNumber() || !info[4].IsNumber()) {
+    Napi::TypeError::New(env, "Five numbers expected").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  int32_t x      = info[0].As<Napi::Number>().Int32Value();
+  int32_t y      = info[1].As<Napi::Number>().Int32Value();
+  int32_t width  = info[2].As<Napi::Number>().Int32Value();
+  int32_t height = info[3].As<Napi::Number>().Int32Value();
+  double  sigma  = info[4].As<Napi::Number>().DoubleValue();
+
+  // The sigma comes from the menu theme, so it may be anything. Nothing is captured
+  // unless it is a positive number.
+  if (width <= 0 || height <= 0 || !std::isfinite(sigma) || sigma <= 0) {
+    return env.Null();
+  }
+
+  Display* display = mConnection.get();
   if (!display) {
-    return;
+    return env.Null();
+  }
+
+  // GetImage fails for rectangles which are not fully inside the root window.
+  int screen = DefaultScreen(display);
+  if (x < 0 || y < 0 || x + width > DisplayWidth(display, screen) ||
+      y + height > DisplayHeight(display, screen)) {
+    return env.Null();
+  }
+
+  // The blur expects the usual 32-bit BGRX pixel layout.
+  xcb_connection_t* xcb = mConnection.getXCB();
+  if (DefaultDepth(display, screen) != 24 || bitsPerPixel(xcb, 24) != 32 ||
+      xcb_get_setup(xcb)->image_byte_order != XCB_IMAGE_ORDER_LSB_FIRST) {
+    return env.Null();
+  }
+
+  // The shared memory segment is kept around for subsequent menus. It has to be set up
+  // again if the connection to the X server has been reopened.
+  if (mBackdropConnection != mConnection.getConnectionsOpened()) {
+    mBackdropReader.reset(xcb);
+    mBackdropConnection = mConnection.getConnectionsOpened();
   }
 
-  int    screen = XDefaultScreen(display);
-  Window root   = RootWindow(display, screen);
-
-  Atom          actual_type;
-  int           actual_format;
-  unsigned long nitems, bytes_after;
-  unsigned char* data = nullptr;
-
-  Atom net_client_list = XInternAtom(display, "_NET_CLIENT_LIST", False);
-  int  status          = XGetWindowProperty(display, root, net_client_list, 0, ~0L, False,
-      XA_WINDOW, &actual_type, &actual_format, &nitems, &bytes_after, &data);
-
-  if (status == Success && data) {
-    Window* windows = reinterpret_cast<Window*>(data);
-
-    for (unsigned long i = 0; i < nitems; i++) {
-      Window win = windows[i];
-
-      std::string appName;
-      std::string windowName;
-      if (getWindowAppAndName(display, win, appName, windowName) &&
-          targetAppName == appName && targetWindowName == windowName) {
-        // Switch to the window's workspace first so the WM moves to it rather
-        // than just showing an activation notification.
-        unsigned long desktop = getLongProperty(display, win, "_NET_WM_DESKTOP");
-
-        // _NET_WM_DESKTOP value 0xFFFFFFFF means "all desktops" – no switch needed.
-        if (desktop != 0xFFFFFFFF) {
-          XEvent desktopEvent                    = {};
-          desktopEvent.type                      = ClientMessage;
-          desktopEvent.xclient.window            = root;
-          desktopEvent.xclient.message_type      = XInternAtom(display, "_NET_CURRENT_DESKTOP", False);
-          desktopEvent.xclient.format            = 32;
-          desktopEvent.xclient.data.l[0]         = static_cast<long>(desktop);
-          desktopEvent.xclient.data.l[1]         = CurrentTime;
-
-          XSendEvent(display, root, False,
-              SubstructureNotifyMask | SubstructureRedirectMask, &desktopEvent);
-        }
-
-        // Now activate the window using the standard EWMH _NET_ACTIVE_WINDOW message.
-        XEvent event                    = {};
-        event.type                      = ClientMessage;
-        event.xclient.window            = win;
-        event.xclient.message_type      = XInternAtom(display, "_NET_ACTIVE_WINDOW", False);
-        event.xclient.format            = 32;
-        event.xclient.data.l[0]         = 1; // source indication: 1 = application
-        event.xclient.data.l[1]         = CurrentTime;
-        event.xclient.data.l[2]         = 0; // currently active window (none)
-
-        XSendEvent(display, root, False,
-            SubstructureNotifyMask | SubstructureRedirectMask, &event);
-        XFlush(display);
-        break;
+  uint32_t* pixels = mBackdropReader.read(
+      mConnection.getRoot(), int16_t(x), int16_t(y), uint16_t(width), uint16_t(height));
+  if (!pixels) {
+    return env.Null();
+  }
+
+  BlurredImage image = blurImage(reinterpret_cast<uint8_t const*>(pixels), width, height,
+      size_t(width) * 4, sigma);
+
+  return toImage(env, image.width, image.height, image.rgba);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::startMacroRecording(const Napi::CallbackInfo& info) {
+  return Napi::Boolean::New(info.Env(), mMacroRecorder.start());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::stopMacroRecording(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (!mMacroRecorder.isRecording()) {
+    return env.Null();
+  }
+
+  std::vector<RecordedEvent> events = mMacroRecorder.stop();
+
+  Napi::Array result = Napi::Array::New(env, events.size());
+  for (uint32_t i = 0; i < events.size(); ++i) {
+    Napi::Object event = Napi::Object::New(env);
+    event.Set(events[i].isButton ? "button" : "keycode", events[i].detail);
+    event.Set("down", events[i].down);
+    event.Set("delay", events[i].delay);
+    result.Set(i, event);
+  }
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Napi::Value Native::setWindowShape(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() != 2 || !info[0].IsNumber() ||
+      !(info[1].IsObject() || info[1].IsNull())) {
+    Napi::TypeError::New(env, "A number and an object or null expected")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  if (!mConnection.get()) {
+    return Napi::Boolean::New(env, false);
+  }
+
+  Window window = info[0].As<Napi::Number>().Uint32Value();
+
+  if (info[1].IsNull()) {
+    return Napi::Boolean::New(env, ::resetWindowShape(mConnection.getXCB(), window));
+  }
+
+  auto shape = info[1].As<Napi::Object>();
+
+  // Returns the given property of an element of the shape arrays if it is a finite
+  // number. The elements come from the renderer process, so nothing is assumed. As the X
+  // protocol uses 16-bit coordinates, larger values are clamped.
+  auto get = [](Napi::Value const& element, const char* key) -> std::optional<double> {
+    if (!element.IsObject()) {
+      return std::nullopt;
+    }
+
+    Napi::Value value = element.As<Napi::Object>().Get(key);
+    if (!value.IsNumber()) {
+      return std::nullopt;
+    }
+
+    double number = value.As<Napi::Number>().DoubleValue();
+    if (!std::isfinite(number)) {
+      return std::nullopt;
+    }
+
+    return std::clamp(number, double(INT16_MIN), double(INT16_MAX));
+  };
+
+  Napi::Value circlesValue    = shape.Get("circles");
+  Napi::Value rectanglesValue = shape.Get("rectangles");
+
+  if (!(circlesValue.IsArray() || circlesValue.IsUndefined()) ||
+      !(rectanglesValue.IsArray() || rectanglesValue.IsUndefined())) {
+    Napi::TypeError::New(env, "Arrays of circles and rectangles expected")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::vector<ShapeCircle> circles;
+  if (circlesValue.IsArray()) {
+    auto array = circlesValue.As<Napi::Array>();
+    for (uint32_t i = 0; i < array.Length(); ++i) {
+      Napi::Value element = array.Get(i);
+
+      auto x      = get(element, "x");
+      auto y      = get(element, "y");
+      auto radius = get(element, "radius");
+      if (!x || !y || !radius) {
+        Napi::TypeError::New(env, "Circles need a numeric x, y, and radius")
+            .ThrowAsJavaScriptException();
+        return env.Null();
+      }
+
+      circles.push_back({*x, *y, *radius});
+    }
+  }
+
+  std::vector<Rect> rectangles;
+  if (rectanglesValue.IsArray()) {
+    auto array = rectanglesValue.As<Napi::Array>();
+    for (uint32_t i = 0; i < array.Length(); ++i) {
+      Napi::Value element = array.Get(i);
+
+      auto x      = get(element, "x");
+      auto y      = get(element, "y");
+      auto width  = get(element, "width");
+      auto height = get(element, "height");
+      if (!x || !y || !width || !height) {
+        Napi::TypeError::New(env, "Rectangles need a numeric x, y, width, and height")
+            .ThrowAsJavaScriptException();
+        return env.Null();
       }
+
+      int x0 = std::floor(*x);
+      int y0 = std::floor(*y);
+      int x1 = std::ceil(*x + *width);
+      int y1 = std::ceil(*y + *height);
+      rectangles.push_back({x0, y0, x1 - x0, y1 - y0});
+    }
+  }
+
+  bool success = ::setWindowShape(
+      mConnection.getXCB(), window, rasterizeShape(circles, rectangles));
+
+  return Napi::Boolean::New(env, success);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<WindowInfo> Native::findWindow(std::optional<Window> id,
+    std::string const& appName, std::string const& windowName,
+    std::optional<std::vector<WindowInfo>>& windows) {
+
+  if (id && mWindowTable.isSynced()) {
+    std::optional<WindowInfo> window = mWindowTable.getWindow(*id);
+    if (window && window->appName == appName) {
+      return window;
     }
+  }
 
-    XFree(data);
+  // As the list is ordered by recent use, this finds the most recently used match.
+  if (!windows) {
+    windows = mWindowTable.isSynced()
+                  ? mWindowTable.getWindows()
+                  : queryWindowInfos(mConnection, queryClientList(mConnection));
+  }
+
+  for (auto const& window : *windows) {
+    if (window.hasAppAndName() && appName == window.appName &&
+        windowName == window.windowName) {
+      return window;
+    }
   }
 
-  XCloseDisplay(display);
+  return std::nullopt;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -11,16 +11,37 @@
 #ifndef NATIVE_HPP
 #define NATIVE_HPP
 
+#include "ClipboardOwner.hpp"
+#include "Connection.hpp"
+#include "ImageReader.hpp"
+#include "KeyGrabber.hpp"
+#include "MacroRecorder.hpp"
+#include "PointerTracker.hpp"
+#include "ProcessCache.hpp"
+#include "TextTyper.hpp"
+#include "WindowIcons.hpp"
+#include "WindowTable.hpp"
+#include "WindowThumbnails.hpp"
+
 #include <napi.h>
 
+#include <optional>
+#include <string>
+#include <vector>
+
 /**
  * This class allows moving the mouse pointer, simulating key presses, and getting the
  * active window's name and class. Using Xlib calls, this is pretty straight-forward to
  * implement.
+ *
+ * All calls share a single connection to the X server which is kept open for the
+ * lifetime of the addon. See Connection.hpp for details. In addition, a background thread
+ * keeps track of all open windows, see WindowTable.hpp.
  */
 class Native : public Napi::Addon<Native> {
  public:
   Native(Napi::Env env, Napi::Object exports);
+  virtual ~Native();
 
  private:
   /**
@@ -44,10 +65,38 @@ class Native : public Napi::Addon<Native> {
    */
   void simulateKey(const Napi::CallbackInfo& info);
 
+  /**
+   * This function is called when the simulateText function is called from JavaScript.
+   * It types the given text into the focused window with XTest. The keys are looked up
+   * in the current keyboard layout. Characters which are not part of the layout are
+   * typed via a temporarily assigned spare keycode. It returns false if the X server
+   * does not support XKB.
+   *
+   * @param info The arguments passed to the simulateText function. It should contain a
+   *             string.
+   */
+  Napi::Value simulateText(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the setClipboard function is called from JavaScript.
+   * It takes ownership of the CLIPBOARD or the PRIMARY selection and offers the given
+   * entries to other clients. The conversion requests are answered by the clipboard
+   * owner thread which is started on the first call. It returns false if the selection
+   * could not be acquired.
+   *
+   * @param info The arguments passed to the setClipboard function. It should contain an
+   *             array of objects with a 'mimeType' string and a 'data' string or buffer
+   *             and optionally a boolean which selects the PRIMARY selection.
+   */
+  Napi::Value setClipboard(const Napi::CallbackInfo& info);
+
   /**
    * This function is called when the getWMInfo function is called from JavaScript.
    * It returns the app and class of the currently active window, as well as the
-   * current pointer position.
+   * current pointer position. If the active window has a _NET_WM_PID, the PID, the
+   * executable, and the command line of its process are returned as well. Once the
+   * window table is synced, the app and the title of the window under the pointer are
+   * looked up in its cached window geometries.
    *
    * @param info The arguments passed to the getWMInfo function. It should contain
    *            no arguments.
@@ -72,6 +121,244 @@ class Native : public Napi::Addon<Native> {
    *             two strings: the window title and the app name.
    */
   void focusWindow(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the getConnectionsOpened function is called from
+   * JavaScript. It returns the number of times the main connection has been opened, the
+   * number of connections opened by all parts of the addon including the background
+   * threads, and the number of connections which are currently open.
+   *
+   * @param info The arguments passed to the getConnectionsOpened function. It should
+   *             contain no arguments.
+   */
+  Napi::Value getConnectionsOpened(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the getScalingFactor function is called from
+   * JavaScript. It returns the DPI scaling factor derived from Xft.dpi. Usually, this is
+   * served from the cache of the window table.
+   *
+   * @param info The arguments passed to the getScalingFactor function. It should contain
+   *             no arguments.
+   */
+  Napi::Value getScalingFactor(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the getIconTheme function is called from JavaScript.
+   * It returns the Net/IconThemeName published by the XSETTINGS manager or null if there
+   * is none. Usually, this is served from the cache of the window table.
+   *
+   * @param info The arguments passed to the getIconTheme function. It should contain no
+   *             arguments.
+   */
+  Napi::Value getIconTheme(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the onActiveWindowChanged function is called from
+   * JavaScript. It expects a callback which is called with an object with an 'app' and a
+   * 'window' property whenever the active window changes. If no function is passed, the
+   * previous callback is removed.
+   *
+   * @param info The arguments passed to the onActiveWindowChanged function. It should
+   *             contain a function or nothing.
+   */
+  void onActiveWindowChanged(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the onWindowsChanged function is called from
+   * JavaScript. It expects a callback which is called with the same array as returned by
+   * getOpenWindows whenever a window is opened, closed, or renamed. If no function is
+   * passed, the previous callback is removed.
+   *
+   * @param info The arguments passed to the onWindowsChanged function. It should contain
+   *             a function or nothing.
+   */
+  void onWindowsChanged(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the setPointerTrackingEnabled function is called from
+   * JavaScript. It starts or stops the XInput2 pointer tracker. While it is running,
+   * getWMInfo reads the pointer position from memory. It returns true if the tracker is
+   * running afterwards. This may be false if the X server does not support XInput 2.1.
+   *
+   * @param info The arguments passed to the setPointerTrackingEnabled function. It
+   *             should contain a boolean.
+   */
+  Napi::Value setPointerTrackingEnabled(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the getTrackedPointer function is called from
+   * JavaScript. It returns the last position seen by the pointer tracker together with
+   * the server time of the motion and the observed sample rate. It returns null if the
+   * tracker is not running or if the pointer has not moved yet.
+   *
+   * @param info The arguments passed to the getTrackedPointer function. It should
+   *             contain no arguments.
+   */
+  Napi::Value getTrackedPointer(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the bindShortcuts function is called from JavaScript.
+   * It replaces the globally grabbed shortcuts. The shortcuts are Electron accelerators
+   * like "Control+Shift+K". It returns an array of the shortcuts which could not be
+   * bound, either because they could not be parsed or because another client has
+   * grabbed them already.
+   *
+   * @param info The arguments passed to the bindShortcuts function. It should contain an
+   *             array of strings.
+   */
+  Napi::Value bindShortcuts(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the setShortcutInhibited function is called from
+   * JavaScript. While a shortcut is inhibited, its key stays grabbed but presses are not
+   * reported anymore.
+   *
+   * @param info The arguments passed to the setShortcutInhibited function. It should
+   *             contain a string and a boolean.
+   */
+  void setShortcutInhibited(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the onShortcutEvent function is called from JavaScript.
+   * It expects a callback which is called with the shortcut, whether it has been pressed
+   * or released, and the X server time of the event whenever a bound shortcut is pressed
+   * or released. If no function is passed, the previous callback is removed.
+   *
+   * @param info The arguments passed to the onShortcutEvent function. It should contain
+   *             a function or nothing.
+   */
+  void onShortcutEvent(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the getWindowIcon function is called from JavaScript.
+   * It returns the _NET_WM_ICON of the given window, scaled to the given size. The
+   * window is found like in focusWindow. The result contains the width, the height, and
+   * an ArrayBuffer with RGBA pixels. It returns null if there is no such window or if it
+   * has no icon.
+   *
+   * @param info The arguments passed to the getWindowIcon function. It should contain
+   *             the window title, the app name, the size in pixels, and optionally the
+   *             window ID.
+   */
+  Napi::Value getWindowIcon(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the getWindowThumbnails function is called from
+   * JavaScript. It returns an array with a thumbnail for each of the given windows. Each
+   * thumbnail has the same format as the result of getWindowIcon or is null if the
+   * window could not be captured. Returns null if the X server does not support the
+   * Composite and Damage extensions.
+   *
+   * @param info The arguments passed to the getWindowThumbnails function. It should
+   *             contain an array of objects with an app, a window, and an optional id
+   *             property as well as the size in pixels.
+   */
+  Napi::Value getWindowThumbnails(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the captureBackdrop function is called from JavaScript.
+   * It reads the given rectangle of the root window and blurs it. The result has the
+   * same format as the result of getWindowIcon but is usually smaller than the captured
+   * rectangle. It returns null if the rectangle is not fully on screen or if the screen
+   * does not use 32-bit pixels.
+   *
+   * @param info The arguments passed to the captureBackdrop function. It should contain
+   *             the x, y, width, and height of the rectangle in physical pixels as well
+   *             as the standard deviation of the blur in physical pixels.
+   */
+  Napi::Value captureBackdrop(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the startMacroRecording function is called from
+   * JavaScript. It starts recording all key and pointer button events with the RECORD
+   * extension. It returns false if the X server does not support the extension.
+   *
+   * @param info The arguments passed to the startMacroRecording function. It should
+   *             contain no arguments.
+   */
+  Napi::Value startMacroRecording(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the stopMacroRecording function is called from
+   * JavaScript. It stops the recording and returns an array of objects with either a
+   * 'keycode' or a 'button' property, a 'down' property, and a 'delay' property with the
+   * milliseconds since the previous event. It returns null if nothing is being recorded.
+   *
+   * @param info The arguments passed to the stopMacroRecording function. It should
+   *             contain no arguments.
+   */
+  Napi::Value stopMacroRecording(const Napi::CallbackInfo& info);
+
+  /**
+   * This function is called when the setWindowShape function is called from JavaScript.
+   * It restricts the visible and the clickable area of the window with the given XID to
+   * the given circles and rectangles using the SHAPE extension. The circles are
+   * approximated with horizontal bands. If null is passed instead of the shape, the
+   * window is unshaped again. It returns false if the X server does not support input
+   * shapes or if the window does not exist. A TypeError is thrown if an element of the
+   * arrays is not an object with finite numbers.
+   *
+   * @param info The arguments passed to the setWindowShape function. It should contain
+   *             the XID and an object with an array of circles (x, y, and radius) and an
+   *             array of rectangles (x, y, width, and height) in physical pixels
+   *             relative to the window, or null.
+   */
+  Napi::Value setWindowShape(const Napi::CallbackInfo& info);
+
+  /**
+   * Looks up the window with the given ID in the window table. The app is compared in
+   * case the ID has been reused in the meantime. If there is no such window, the most
+   * recently used window with the given app and title is searched. The list of windows
+   * is stored in the given vector when it is needed for the first time, so that several
+   * lookups read it only once. The main connection has to be open.
+   */
+  std::optional<WindowInfo> findWindow(std::optional<Window> id,
+      std::string const& appName, std::string const& windowName,
+      std::optional<std::vector<WindowInfo>>& windows);
+
+  Connection     mConnection;
+  WindowTable    mWindowTable;
+  PointerTracker mPointerTracker;
+  KeyGrabber     mKeyGrabber;
+
+  // The scaled window icons. This is only used from the main thread. Icons of closed
+  // windows are removed once the cache holds more than mIconCachePruneSize windows.
+  IconCache mIconCache;
+  size_t    mIconCachePruneSize = 64;
+
+  // The processes owning the active windows. This is only used from the main thread.
+  ProcessCache mProcessCache;
+
+  // The thumbnail capture thread is only started when thumbnails are requested.
+  WindowThumbnails mThumbnails;
+
+  // The backdrop of the menu is read from the root window using the main connection.
+  // mBackdropConnection is the connection for which the reader has been set up.
+  ImageReader mBackdropReader;
+  uint32_t    mBackdropConnection = 0;
+
+  // Text is typed on the main connection. The XKB events have to be selected again if
+  // the connection has been reopened. mTextTyperConnection is the connection for which
+  // this has been done.
+  TextTyper mTextTyper;
+  uint32_t  mTextTyperConnection = 0;
+
+  // Macros are recorded on two dedicated connections which only exist while recording.
+  MacroRecorder mMacroRecorder;
+
+  // The clipboard owner thread is only started when the clipboard is set for the first
+  // time. It keeps running so that the content stays available.
+  ClipboardOwner mClipboardOwner;
+
+  // These are used to call the JavaScript callbacks from the event thread of the window
+  // table.
+  Napi::ThreadSafeFunction mActiveWindowCallback;
+  Napi::ThreadSafeFunction mWindowsCallback;
+
+  // This is used to call the JavaScript callback from the event thread of the key
+  // grabber.
+  Napi::ThreadSafeFunction mShortcutCallback;
 };
 
 #endif // NATIVE_HPP
\ No newline at end of file
@@ -0,0 +1,253 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "PointerTracker.hpp"
+
+#include <X11/extensions/XInput2.h>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// If the connection to the X server is lost, the tracker thread retries after this many
+// milliseconds.
+constexpr int RECONNECT_INTERVAL = 1000;
+
+// Raw motion events which are further apart than this many milliseconds are considered
+// to belong to different movements of the pointer.
+constexpr uint32_t MAX_SAMPLE_GAP = 50;
+
+// The sample rate is only updated once a movement lasted this many milliseconds. The
+// measurement starts over once it lasted MAX_BURST_DURATION milliseconds.
+constexpr uint32_t MIN_BURST_DURATION = 250;
+constexpr uint32_t MAX_BURST_DURATION = 1000;
+
+uint64_t pack(PointerSnapshot const& snapshot) {
+  return (uint64_t(snapshot.timestamp) << 32) | (uint64_t(uint16_t(snapshot.x)) << 16) |
+         uint64_t(uint16_t(snapshot.y));
+}
+
+PointerSnapshot unpack(uint64_t value) {
+  PointerSnapshot snapshot;
+  snapshot.x         = int16_t(uint16_t(value >> 16));
+  snapshot.y         = int16_t(uint16_t(value));
+  snapshot.timestamp = uint32_t(value >> 32);
+  return snapshot;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+PointerTracker::~PointerTracker() {
+  stop();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool PointerTracker::start() {
+  if (mRunning) {
+    return true;
+  }
+
+  // We connect and select the events synchronously so that we can report whether the X
+  // server supports raw motion events at all.
+  if (!mConnection.get() || !selectEvents()) {
+    return false;
+  }
+
+  mHasSnapshot      = false;
+  mSampleRate       = 0.0;
+  mBurstSampleCount = 0;
+
+  mWakeupFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  mRunning  = true;
+  mThread   = std::thread(&PointerTracker::run, this);
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void PointerTracker::stop() {
+  if (!mRunning) {
+    return;
+  }
+
+  mRunning = false;
+
+  uint64_t value = 1;
+  write(mWakeupFd, &value, sizeof(value));
+
+  mThread.join();
+
+  close(mWakeupFd);
+  mWakeupFd = -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool PointerTracker::isRunning() const {
+  return mRunning;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<PointerSnapshot> PointerTracker::getSnapshot() const {
+  if (!mHasSnapshot) {
+    return std::nullopt;
+  }
+
+  return unpack(mSnapshot.load(std::memory_order_acquire));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+double PointerTracker::getSampleRate() const {
+  return mSampleRate;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void PointerTracker::run() {
+  while (mRunning) {
+    Display* display = mConnection.get();
+
+    // After a reconnect, we have to select the events again. If this fails, we wait a bit
+    // and try again. The wakeup fd interrupts the waiting if the thread should stop.
+    bool reconnected = mSelectedOn != mConnection.getConnectionsOpened();
+    if (!display || (reconnected && !selectEvents())) {
+      pollfd pfd = {.fd = mWakeupFd, .events = POLLIN};
+      poll(&pfd, 1, RECONNECT_INTERVAL);
+      continue;
+    }
+
+    // All raw events which have arrived since the last iteration result in a single
+    // position query.
+    std::optional<uint32_t> time = readEvents();
+    if (time) {
+      updateSnapshot(*time);
+      continue;
+    }
+
+    pollfd fds[2] = {
+        {.fd = ConnectionNumber(display), .events = POLLIN},
+        {.fd = mWakeupFd, .events = POLLIN},
+    };
+
+    poll(fds, 2, -1);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool PointerTracker::selectEvents() {
+  Display* display = mConnection.get();
+
+  int event, error;
+  if (!XQueryExtension(display, "XInputExtension", &mXIOpcode, &event, &error)) {
+    return false;
+  }
+
+  // Since XInput 2.1, raw events are delivered to the root window regardless of any
+  // grabs.
+  int major = 2, minor = 2;
+  if (XIQueryVersion(display, &major, &minor) != Success ||
+      (major == 2 && minor < 1)) {
+    return false;
+  }
+
+  unsigned char bits[XIMaskLen(XI_LASTEVENT)] = {};
+  XISetMask(bits, XI_RawMotion);
+
+  XIEventMask mask = {
+      .deviceid = XIAllMasterDevices, .mask_len = sizeof(bits), .mask = bits};
+  XISelectEvents(display, mConnection.getRoot(), &mask, 1);
+  XFlush(display);
+
+  mSelectedOn = mConnection.getConnectionsOpened();
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<uint32_t> PointerTracker::readEvents() {
+  Display*                display = mConnection.getDisplay();
+  std::optional<uint32_t> lastTime;
+
+  while (XPending(display) > 0) {
+    XEvent event;
+    XNextEvent(display, &event);
+
+    XGenericEventCookie* cookie = &event.xcookie;
+    if (cookie->type != GenericEvent || cookie->extension != mXIOpcode ||
+        !XGetEventData(display, cookie)) {
+      continue;
+    }
+
+    if (cookie->evtype == XI_RawMotion) {
+      auto* raw = static_cast<XIRawEvent*>(cookie->data);
+      addSample(raw->time);
+      lastTime = raw->time;
+    }
+
+    XFreeEventData(display, cookie);
+  }
+
+  return lastTime;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void PointerTracker::addSample(uint32_t time) {
+
+  // Unsigned arithmetic takes care of the wrap-around of the server time.
+  if (mBurstSampleCount == 0 || time - mLastSample > MAX_SAMPLE_GAP) {
+    mBurstStart       = time;
+    mBurstSampleCount = 0;
+  }
+
+  mLastSample = time;
+  ++mBurstSampleCount;
+
+  uint32_t duration = time - mBurstStart;
+  if (duration >= MIN_BURST_DURATION) {
+    mSampleRate = 1000.0 * (mBurstSampleCount - 1) / duration;
+  }
+
+  if (duration >= MAX_BURST_DURATION) {
+    mBurstStart       = time;
+    mBurstSampleCount = 1;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void PointerTracker::updateSnapshot(uint32_t time) {
+  Display* display = mConnection.getDisplay();
+
+  Window       root, child;
+  int          rootX, rootY, windowX, windowY;
+  unsigned int mask;
+  if (!XQueryPointer(display, mConnection.getRoot(), &root, &child, &rootX, &rootY,
+                     &windowX, &windowY, &mask)) {
+    return;
+  }
+
+  mSnapshot.store(pack({rootX, rootY, time}), std::memory_order_release);
+  mHasSnapshot = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,119 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef POINTER_TRACKER_HPP
+#define POINTER_TRACKER_HPP
+
+#include "Connection.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <thread>
+
+/** The last pointer position seen by the PointerTracker in physical pixels. */
+struct PointerSnapshot {
+  int x = 0;
+  int y = 0;
+
+  // The X server time of the motion event in milliseconds. This wraps around after about
+  // 49 days.
+  uint32_t timestamp = 0;
+};
+
+/**
+ * This class follows the pointer in the background so that its position can be read
+ * without a round trip to the X server. It runs a thread with its own connection which
+ * selects XI_RawMotion events on the root window. These are delivered for every motion
+ * of any pointer device, even if another client has grabbed the pointer. Whenever a batch
+ * of raw events has been read, the absolute position is queried once and stored in a
+ * single atomic word.
+ *
+ * As the thread blocks in poll() until the X server sends an event, it does not consume
+ * any CPU time while the pointer is not moving.
+ *
+ * The tracker also measures the rate at which raw motion events arrive while the pointer
+ * is moving. This roughly corresponds to the polling rate of the input device.
+ */
+class PointerTracker {
+ public:
+  PointerTracker() = default;
+  ~PointerTracker();
+
+  PointerTracker(PointerTracker const& other)            = delete;
+  PointerTracker& operator=(PointerTracker const& other) = delete;
+
+  /**
+   * Connects to the X server, selects the raw motion events and starts the tracker
+   * thread. Returns false if this fails, for instance because the X server does not
+   * support XInput 2.2. Does nothing if the tracker is already running.
+   */
+  bool start();
+
+  /** Stops the tracker thread and waits for it to finish. */
+  void stop();
+
+  /** Returns true if the tracker thread is running. */
+  bool isRunning() const;
+
+  /**
+   * Returns the last pointer position. This is a single atomic load and can be called
+   * from any thread. Returns nothing if the pointer has not moved since the tracker has
+   * been started.
+   */
+  std::optional<PointerSnapshot> getSnapshot() const;
+
+  /**
+   * Returns the rate at which raw motion events have been observed in Hz. This is
+   * measured over the last continuous movement of the pointer which lasted at least a
+   * quarter of a second. Returns zero if no such movement has been observed yet.
+   */
+  double getSampleRate() const;
+
+ private:
+  void run();
+
+  // Selects the raw motion events on the root window. This has to be done again after a
+  // reconnect.
+  bool selectEvents();
+
+  // Reads all pending events and returns the server time of the last raw motion event or
+  // nothing if there was none.
+  std::optional<uint32_t> readEvents();
+
+  // Updates the sample rate measurement with a raw motion event at the given time.
+  void addSample(uint32_t time);
+
+  // Queries the absolute pointer position and stores it together with the given time.
+  void updateSnapshot(uint32_t time);
+
+  Connection  mConnection;
+  std::thread mThread;
+
+  // This eventfd is used to wake up the tracker thread when it should stop.
+  int               mWakeupFd = -1;
+  std::atomic<bool> mRunning  = false;
+
+  // The snapshot is packed into a single word so that it can be read without locking:
+  // The upper 32 bits contain the server time, followed by 16 bits for x and 16 bits for
+  // y. Coordinates are 16 bit signed integers in the X11 protocol, so nothing gets lost.
+  std::atomic<uint64_t> mSnapshot    = 0;
+  std::atomic<bool>     mHasSnapshot = false;
+  std::atomic<double>   mSampleRate  = 0.0;
+
+  // These are only accessed from the tracker thread.
+  int      mXIOpcode         = -1;
+  uint32_t mSelectedOn       = 0;
+  uint32_t mBurstStart       = 0;
+  uint32_t mLastSample       = 0;
+  uint32_t mBurstSampleCount = 0;
+};
+
+#endif // POINTER_TRACKER_HPP
@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "PropertyReader.hpp"
+
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+xcb_get_property_cookie_t PropertyReader::request(
+    xcb_connection_t* xcb, Window window, Atom property, Atom type, uint32_t length) {
+  return xcb_get_property(xcb, 0, window, property, type, 0, length);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<PropertyData> PropertyReader::read(xcb_connection_t* xcb,
+    xcb_get_property_cookie_t cookie, Window window, Atom property, Atom type,
+    uint32_t maxLength) {
+
+  // The previous data is not needed anymore. If it was unusually large, we drop the
+  // buffer instead of keeping the memory around.
+  mBuffer.clear();
+  if (mBuffer.capacity() > MAX_RETAINED_SIZE) {
+    mBuffer.shrink_to_fit();
+  }
+
+  PropertyData result;
+  uint32_t     offset = 0;
+
+  while (true) {
+    xcb_generic_error_t* error = nullptr;
+    XcbReply<xcb_get_property_reply_t> reply(xcb_get_property_reply(xcb, cookie, &error));
+    free(error);
+
+    result.requests += 1;
+
+    if (!reply || reply->type == XCB_NONE) {
+      return std::nullopt;
+    }
+
+    // If the property has been replaced in the meantime, the chunks do not fit together.
+    if (offset > 0 && (reply->type != result.type || reply->format != result.format)) {
+      return std::nullopt;
+    }
+
+    result.type   = reply->type;
+    result.format = reply->format;
+
+    auto*  data   = static_cast<uint8_t const*>(xcb_get_property_value(reply.get()));
+    size_t length = xcb_get_property_value_length(reply.get()) * (reply->format / 8);
+
+    // On the first reply, we know the total size and can reserve the buffer at once.
+    if (offset == 0) {
+      size_t total = std::min<size_t>(length + reply->bytes_after, maxLength * 4ul);
+      mBuffer.reserve(total);
+    }
+
+    mBuffer.insert(mBuffer.end(), data, data + length);
+
+    // The offset of GetProperty is given in 32-bit units. Every chunk but the last one
+    // has a length which is a multiple of four bytes.
+    offset = mBuffer.size() / 4;
+
+    if (reply->bytes_after == 0 || offset >= maxLength || length == 0) {
+      break;
+    }
+
+    uint32_t next = std::min(CHUNK_LENGTH, maxLength - offset);
+    cookie = xcb_get_property(xcb, 0, window, property, type, offset, next);
+  }
+
+  result.size = std::min<size_t>(mBuffer.size(), maxLength * 4ul);
+  result.data = mBuffer.data();
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+size_t PropertyReader::getBufferCapacity() const {
+  return mBuffer.capacity();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
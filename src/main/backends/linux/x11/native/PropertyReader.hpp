@@ -0,0 +1,95 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef PROPERTY_READER_HPP
+#define PROPERTY_READER_HPP
+
+#include <X11/Xlib.h>
+#include <xcb/xcb.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <vector>
+
+/** Frees replies and errors returned by XCB. */
+struct XcbDeleter {
+  void operator()(void* pointer) const {
+    free(pointer);
+  }
+};
+
+/** An XCB reply which is freed when it goes out of scope. */
+template <typename T>
+using XcbReply = std::unique_ptr<T, XcbDeleter>;
+
+/** The data of a window property as returned by PropertyReader::read(). */
+struct PropertyData {
+  Atom    type   = None;
+  uint8_t format = 0;
+
+  // This points into the buffer of the PropertyReader. It is only valid until the next
+  // call to PropertyReader::read().
+  uint8_t const* data = nullptr;
+  size_t         size = 0;
+
+  // The number of GetProperty requests which were needed to read the property. Each
+  // request after the first one is an additional round trip.
+  uint32_t requests = 0;
+};
+
+/**
+ * This class reads window properties of arbitrary size in chunks of bounded length. The
+ * first chunk is requested with request() so that it can be pipelined with other
+ * requests. If the property is larger than this, read() fetches the remaining chunks.
+ * The total amount of data is limited so that a client cannot make us allocate
+ * unbounded amounts of memory by setting a huge property.
+ *
+ * All chunks are copied into a buffer which is reused for subsequent reads. Hence, most
+ * reads do not allocate at all. If an unusually large property has been read, the buffer
+ * is released on the next call so that the reader does not hold on to the memory.
+ *
+ * All methods have to be called from the same thread.
+ */
+class PropertyReader {
+ public:
+  // The number of 32-bit units which are requested at once.
+  static constexpr uint32_t CHUNK_LENGTH = 16384;
+
+  // The number of bytes of the buffer which are kept between reads.
+  static constexpr size_t MAX_RETAINED_SIZE = 256 * 1024;
+
+  /**
+   * Requests the first chunk of the given property. The reply has to be collected with
+   * read(), else it will leak.
+   */
+  static xcb_get_property_cookie_t request(xcb_connection_t* xcb, Window window,
+      Atom property, Atom type, uint32_t length = CHUNK_LENGTH);
+
+  /**
+   * Waits for the reply of a request sent with request() and reads the remaining chunks
+   * if the property is larger. At most maxLength 32-bit units are read, the rest of the
+   * property is ignored. Returns nothing if the window or the property does not exist or
+   * if the property is changed while it is being read.
+   */
+  std::optional<PropertyData> read(xcb_connection_t* xcb,
+      xcb_get_property_cookie_t cookie, Window window, Atom property, Atom type,
+      uint32_t maxLength);
+
+  /** Returns the current capacity of the reused buffer in bytes. */
+  size_t getBufferCapacity() const;
+
+ private:
+  std::vector<uint8_t> mBuffer;
+};
+
+#endif // PROPERTY_READER_HPP
@@ -0,0 +1,72 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "RandR.hpp"
+
+#include <X11/extensions/Xrandr.h>
+
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int selectScreenChangeEvents(Display* display, Window root) {
+  int eventBase, errorBase;
+  if (!XRRQueryExtension(display, &eventBase, &errorBase)) {
+    return -1;
+  }
+
+  XRRSelectInput(display, root, RRScreenChangeNotifyMask);
+
+  return eventBase + RRScreenChangeNotify;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Rect> queryCrtcGeometries(Display* display, Window root, uint32_t* requests) {
+  std::vector<Rect> geometries;
+
+  int eventBase, errorBase;
+  if (!XRRQueryExtension(display, &eventBase, &errorBase)) {
+    return geometries;
+  }
+
+  XRRScreenResources* resources = XRRGetScreenResourcesCurrent(display, root);
+  if (!resources) {
+    return geometries;
+  }
+
+  for (int i = 0; i < resources->ncrtc; ++i) {
+    XRRCrtcInfo* crtc = XRRGetCrtcInfo(display, resources, resources->crtcs[i]);
+    if (!crtc) {
+      continue;
+    }
+
+    if (crtc->mode != None && crtc->width > 0 && crtc->height > 0) {
+      Rect geometry = {crtc->x, crtc->y, static_cast<int>(crtc->width),
+          static_cast<int>(crtc->height)};
+
+      if (std::find(geometries.begin(), geometries.end(), geometry) == geometries.end()) {
+        geometries.push_back(geometry);
+      }
+    }
+
+    XRRFreeCrtcInfo(crtc);
+  }
+
+  if (requests) {
+    *requests += 1 + resources->ncrtc;
+  }
+
+  XRRFreeScreenResources(resources);
+
+  return geometries;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
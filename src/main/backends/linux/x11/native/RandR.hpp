@@ -0,0 +1,35 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef RANDR_HPP
+#define RANDR_HPP
+
+#include "MonitorIndex.hpp"
+
+#include <X11/Xlib.h>
+
+#include <vector>
+
+// The XRandR calls are kept in their own translation unit, as <X11/extensions/randr.h>
+// declares a type called Connection which clashes with our Connection class.
+
+/**
+ * Selects RRScreenChangeNotify events on the given root window. Returns the response type
+ * of these events or -1 if XRandR is not available.
+ */
+int selectScreenChangeEvents(Display* display, Window root);
+
+/**
+ * Returns the geometries of all active CRTCs. Mirrored CRTCs are only returned once. The
+ * number of sent requests is added to the given counter. Each of them costs a round trip.
+ */
+std::vector<Rect> queryCrtcGeometries(Display* display, Window root, uint32_t* requests);
+
+#endif // RANDR_HPP
@@ -0,0 +1,502 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "TextTyper.hpp"
+
+#include "Utf8.hpp"
+
+#include <X11/extensions/XTest.h>
+#include <X11/keysym.h>
+
+#include <bitset>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// At most this many unused keycodes are used for characters which are not in the
+// layout. Usually, there are many more unused keycodes, but we do not want to clutter
+// the keymap more than necessary.
+const size_t MAX_SPARE_KEYS = 32;
+
+// Keys with these symbols are never held down to reach a level, as pressing them would
+// toggle a lock.
+bool isLockingKeysym(KeySym keysym) {
+  return keysym == XK_Caps_Lock || keysym == XK_Shift_Lock || keysym == XK_Num_Lock ||
+         keysym == XK_ISO_Lock || keysym == XK_ISO_Level3_Lock ||
+         keysym == XK_ISO_Level5_Lock;
+}
+
+// Returns the group which is used for the given key if the given group is active. Keys
+// with fewer groups wrap, clamp, or redirect the group as defined in the keymap.
+int getEffectiveGroup(XkbDescPtr xkb, KeyCode keycode, unsigned int group) {
+  int numGroups = XkbKeyNumGroups(xkb, keycode);
+  if (int(group) < numGroups) {
+    return int(group);
+  }
+
+  unsigned char info = XkbKeyGroupInfo(xkb, keycode);
+  switch (XkbOutOfRangeGroupAction(info)) {
+  case XkbClampIntoRange:
+    return numGroups - 1;
+  case XkbRedirectIntoRange:
+    return XkbOutOfRangeGroupNumber(info) < numGroups ? XkbOutOfRangeGroupNumber(info)
+                                                       : 0;
+  default:
+    return int(group) % numGroups;
+  }
+}
+
+// Returns the modifiers which select the given level of the given key type. Only the
+// given modifiers may be used. If there are several possibilities, the one with the
+// fewest modifiers is returned. Returns nothing if the level cannot be reached.
+std::optional<unsigned int> getLevelModifiers(
+    XkbKeyTypePtr type, int level, unsigned int available) {
+  if (level == 0) {
+    return 0u;
+  }
+
+  std::optional<unsigned int> result;
+  for (int i = 0; i < type->map_count; ++i) {
+    XkbKTMapEntryRec const& entry = type->map[i];
+    unsigned int            mask  = entry.mods.mask;
+
+    if (!entry.active || entry.level != level || (mask & ~available) != 0) {
+      continue;
+    }
+
+    if (!result || std::bitset<8>(mask).count() < std::bitset<8>(*result).count()) {
+      result = mask;
+    }
+  }
+
+  return result;
+}
+
+// Returns true if all symbols of the given key are the given keysym.
+bool hasOnlyKeysym(XkbDescPtr xkb, KeyCode keycode, KeySym keysym) {
+  KeySym const* keysyms = XkbKeySymsPtr(xkb, keycode);
+  for (int i = 0; i < XkbKeyNumSyms(xkb, keycode); ++i) {
+    if (keysyms[i] != keysym) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Presses and releases the given key.
+void tapKey(Display* display, KeyCode keycode) {
+  XTestFakeKeyEvent(display, keycode, True, CurrentTime);
+  XTestFakeKeyEvent(display, keycode, False, CurrentTime);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+KeySym keysymFromCodepoint(char32_t codepoint) {
+  switch (codepoint) {
+  case '\n':
+    return XK_Return;
+  case '\t':
+    return XK_Tab;
+  case '\b':
+    return XK_BackSpace;
+  default:
+    break;
+  }
+
+  // This also skips the carriage return of Windows line endings.
+  if (codepoint < 0x20 || (codepoint >= 0x7F && codepoint < 0xA0) ||
+      codepoint > 0x10FFFF) {
+    return NoSymbol;
+  }
+
+  if (codepoint < 0x100) {
+    return codepoint;
+  }
+
+  return 0x01000000 | codepoint;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KeysymTable::add(KeySym keysym, KeyPosition position) {
+  auto [it, inserted] = mPositions.emplace(keysym, position);
+  if (!inserted && std::bitset<8>(position.modifiers).count() <
+                       std::bitset<8>(it->second.modifiers).count()) {
+    it->second = position;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KeysymTable::clear() {
+  mPositions.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<KeyPosition> KeysymTable::find(KeySym keysym) const {
+  auto it = mPositions.find(keysym);
+  if (it == mPositions.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+size_t KeysymTable::size() const {
+  return mPositions.size();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool TextTyper::reset(Display* display) {
+  mInitialized  = false;
+  mTableValid   = false;
+  mNextSpareKey = 0;
+  mCapsLockKey  = 0;
+  mModifierKeys.fill(0);
+  mTable.clear();
+  mSpareKeys.clear();
+  mIsSpareKey.reset();
+
+  int opcode = 0;
+  int error  = 0;
+  int major  = XkbMajorVersion;
+  int minor  = XkbMinorVersion;
+  if (!XkbQueryExtension(display, &opcode, &mXkbEventType, &error, &major, &minor)) {
+    return false;
+  }
+
+  // The state events are only needed for the active group and for Caps Lock.
+  XkbSelectEvents(display, XkbUseCoreKbd, XkbMapNotifyMask | XkbNewKeyboardNotifyMask,
+      XkbMapNotifyMask | XkbNewKeyboardNotifyMask);
+  XkbSelectEventDetails(display, XkbUseCoreKbd, XkbStateNotify,
+      XkbGroupStateMask | XkbModifierLockMask, XkbGroupStateMask | XkbModifierLockMask);
+
+  mInitialized = true;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool TextTyper::type(Display* display, std::string const& text) {
+  if (!mInitialized) {
+    return false;
+  }
+
+  processEvents(display);
+
+  if (!mTableValid && !buildTable(display)) {
+    return false;
+  }
+
+  std::vector<Stroke> strokes;
+  std::bitset<256>    usedInBatch;
+
+  for (char32_t codepoint : decodeUtf8(text)) {
+    KeySym keysym = keysymFromCodepoint(codepoint);
+    if (keysym == NoSymbol) {
+      continue;
+    }
+
+    if (auto position = mTable.find(keysym)) {
+      strokes.push_back(*position);
+      continue;
+    }
+
+    auto keycode = assignSpareKey(display, keysym, usedInBatch);
+
+    // If all spare keys are used by the current batch, we send it and wait until the X
+    // server has processed it before we assign them again.
+    if (!keycode && !strokes.empty()) {
+      sendStrokes(display, strokes);
+      XSync(display, False);
+      strokes.clear();
+      usedInBatch.reset();
+      keycode = assignSpareKey(display, keysym, usedInBatch);
+    }
+
+    // Without any spare keys, the character cannot be typed at all.
+    if (keycode) {
+      strokes.push_back({*keycode, 0});
+    }
+  }
+
+  sendStrokes(display, strokes);
+  XFlush(display);
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void TextTyper::restoreSpareKeys(Display* display) {
+  bool changed = false;
+
+  for (auto& spare : mSpareKeys) {
+    if (spare.keysym != NoSymbol) {
+      KeySym none = NoSymbol;
+      XChangeKeyboardMapping(display, spare.keycode, 1, &none, 1);
+      spare.keysym = NoSymbol;
+      changed      = true;
+    }
+  }
+
+  if (changed) {
+    XFlush(display);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TextTyper::getTableBuilds() const {
+  return mTableBuilds;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void TextTyper::processEvents(Display* display) {
+  // This only picks the XKB events. Nothing else is selected on the connection, but we
+  // do not want to steal events from anyone else.
+  auto isXkbEvent = [](Display*, XEvent* event, XPointer eventType) -> Bool {
+    return event->type == *reinterpret_cast<int*>(eventType);
+  };
+
+  XEvent event;
+  while (XCheckIfEvent(
+      display, &event, isXkbEvent, reinterpret_cast<XPointer>(&mXkbEventType))) {
+    auto const* xkbEvent = reinterpret_cast<XkbEvent const*>(&event);
+
+    switch (xkbEvent->any.xkb_type) {
+    case XkbMapNotify:
+      if (!isOwnChange(xkbEvent->map)) {
+        mTableValid = false;
+      }
+      break;
+    case XkbNewKeyboardNotify:
+      mTableValid = false;
+      break;
+    case XkbStateNotify:
+      mLockedModifiers = xkbEvent->state.locked_mods;
+      if (unsigned(xkbEvent->state.group) != mGroup) {
+        mGroup      = xkbEvent->state.group;
+        mTableValid = false;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool TextTyper::isOwnChange(XkbMapNotifyEvent const& event) const {
+  // The types and the virtual modifiers are never changed by assigning a spare key.
+  if (event.changed & (XkbKeyTypesMask | XkbVirtualModsMask)) {
+    return false;
+  }
+
+  auto onlySpareKeys = [this](int first, int count) {
+    for (int keycode = first; keycode < first + count; ++keycode) {
+      if (keycode > 255 || !mIsSpareKey[keycode]) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  return onlySpareKeys(event.first_key_sym, event.num_key_syms) &&
+         onlySpareKeys(event.first_key_act, event.num_key_acts) &&
+         onlySpareKeys(event.first_key_behavior, event.num_key_behaviors) &&
+         onlySpareKeys(event.first_key_explicit, event.num_key_explicit) &&
+         onlySpareKeys(event.first_modmap_key, event.num_modmap_keys) &&
+         onlySpareKeys(event.first_vmodmap_key, event.num_vmodmap_keys);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool TextTyper::buildTable(Display* display) {
+  XkbDescPtr xkb = XkbGetMap(
+      display, XkbKeyTypesMask | XkbKeySymsMask | XkbModifierMapMask, XkbUseCoreKbd);
+  if (!xkb) {
+    return false;
+  }
+
+  XkbStateRec state;
+  if (XkbGetState(display, XkbUseCoreKbd, &state) == Success) {
+    mGroup           = state.group;
+    mLockedModifiers = state.locked_mods;
+  }
+
+  // Spare keys which still carry one of our keysyms stay assigned.
+  std::unordered_map<KeyCode, KeySym> assigned;
+  for (auto const& spare : mSpareKeys) {
+    if (spare.keysym != NoSymbol) {
+      assigned[spare.keycode] = spare.keysym;
+    }
+  }
+
+  mTable.clear();
+  mSpareKeys.clear();
+  mIsSpareKey.reset();
+  mModifierKeys.fill(0);
+  mCapsLockKey  = 0;
+  mNextSpareKey = 0;
+
+  // In a first pass, we look for the modifier keys and for keys without any symbols.
+  for (int keycode = xkb->min_key_code; keycode <= xkb->max_key_code; ++keycode) {
+    unsigned char modifiers = xkb->map->modmap[keycode];
+    int           numSyms   = XkbKeyNumSyms(xkb, keycode);
+    auto          previous  = assigned.find(keycode);
+
+    if (modifiers == 0) {
+      bool isOurs = previous != assigned.end() &&
+                    hasOnlyKeysym(xkb, keycode, previous->second);
+
+      if (isOurs || (numSyms == 0 && mSpareKeys.size() < MAX_SPARE_KEYS)) {
+        mSpareKeys.push_back({KeyCode(keycode), isOurs ? previous->second : NoSymbol});
+        mIsSpareKey.set(keycode);
+      }
+      continue;
+    }
+
+    KeySym keysym = numSyms > 0 ? XkbKeySymEntry(xkb, keycode, 0, 0) : NoSymbol;
+
+    if (keysym == XK_Caps_Lock && mCapsLockKey == 0) {
+      mCapsLockKey = keycode;
+    }
+
+    if (isLockingKeysym(keysym)) {
+      continue;
+    }
+
+    for (int bit = 0; bit < 8; ++bit) {
+      if ((modifiers & (1 << bit)) && mModifierKeys[bit] == 0) {
+        mModifierKeys[bit] = keycode;
+      }
+    }
+  }
+
+  unsigned int available = 0;
+  for (int bit = 0; bit < 8; ++bit) {
+    if (mModifierKeys[bit] != 0) {
+      available |= 1 << bit;
+    }
+  }
+
+  // In a second pass, we add all symbols of the active group which can be reached with
+  // the available modifiers.
+  for (int keycode = xkb->min_key_code; keycode <= xkb->max_key_code; ++keycode) {
+    if (mIsSpareKey[keycode] || XkbKeyNumGroups(xkb, keycode) == 0) {
+      continue;
+    }
+
+    int           group = getEffectiveGroup(xkb, keycode, mGroup);
+    XkbKeyTypePtr type  = XkbKeyKeyType(xkb, keycode, group);
+
+    for (int level = 0; level < type->num_levels; ++level) {
+      KeySym keysym = XkbKeySymEntry(xkb, keycode, level, group);
+      if (keysym == NoSymbol) {
+        continue;
+      }
+
+      if (auto modifiers = getLevelModifiers(type, level, available)) {
+        mTable.add(keysym, {KeyCode(keycode), *modifiers});
+      }
+    }
+  }
+
+  XkbFreeKeyboard(xkb, 0, True);
+
+  mTableValid = true;
+  ++mTableBuilds;
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<KeyCode> TextTyper::assignSpareKey(
+    Display* display, KeySym keysym, std::bitset<256>& usedInBatch) {
+
+  // The keysym may still be assigned from a previous call.
+  for (auto const& spare : mSpareKeys) {
+    if (spare.keysym == keysym) {
+      usedInBatch.set(spare.keycode);
+      return spare.keycode;
+    }
+  }
+
+  // Else we take the spare keys in turns so that the least recently assigned one is
+  // reassigned first.
+  for (size_t i = 0; i < mSpareKeys.size(); ++i) {
+    SpareKey& spare = mSpareKeys[(mNextSpareKey + i) % mSpareKeys.size()];
+    if (usedInBatch[spare.keycode]) {
+      continue;
+    }
+
+    // The keysym is assigned to both levels. Else the X server would make an alphabetic
+    // key out of it and upper-case letters would be typed in lower case.
+    KeySym keysyms[2] = {keysym, keysym};
+    XChangeKeyboardMapping(display, spare.keycode, 2, keysyms, 1);
+
+    spare.keysym  = keysym;
+    mNextSpareKey = (mNextSpareKey + i + 1) % mSpareKeys.size();
+    usedInBatch.set(spare.keycode);
+
+    return spare.keycode;
+  }
+
+  return std::nullopt;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void TextTyper::sendStrokes(Display* display, std::vector<Stroke> const& strokes) {
+  if (strokes.empty()) {
+    return;
+  }
+
+  // XTest cannot release a lock, so Caps Lock is toggled off while typing.
+  bool toggleCapsLock = (mLockedModifiers & LockMask) && mCapsLockKey != 0;
+  if (toggleCapsLock) {
+    tapKey(display, mCapsLockKey);
+  }
+
+  // Modifiers are kept pressed as long as consecutive strokes need them.
+  unsigned int held = 0;
+
+  auto holdModifiers = [&](unsigned int modifiers) {
+    for (int bit = 0; bit < 8; ++bit) {
+      unsigned int mask = 1 << bit;
+      if ((held & mask) != (modifiers & mask)) {
+        bool press = (modifiers & mask) != 0;
+        XTestFakeKeyEvent(display, mModifierKeys[bit], press, CurrentTime);
+      }
+    }
+    held = modifiers;
+  };
+
+  for (auto const& stroke : strokes) {
+    holdModifiers(stroke.modifiers);
+    tapKey(display, stroke.keycode);
+  }
+
+  holdModifiers(0);
+
+  if (toggleCapsLock) {
+    tapKey(display, mCapsLockKey);
+  }
+}
@@ -0,0 +1,151 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef TEXT_TYPER_HPP
+#define TEXT_TYPER_HPP
+
+#include <X11/XKBlib.h>
+#include <X11/Xlib.h>
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Returns the keysym which produces the given character. Latin-1 characters have their
+ * own keysyms, all others use the Unicode keysym range. Newlines, tabs, and backspaces
+ * are mapped to their keys. Returns NoSymbol for all other control characters.
+ */
+KeySym keysymFromCodepoint(char32_t codepoint);
+
+/** The key and the modifiers which have to be held down to type a keysym. */
+struct KeyPosition {
+  KeyCode      keycode   = 0;
+  unsigned int modifiers = 0;
+};
+
+/**
+ * This maps keysyms to the keys which produce them. If a keysym can be typed in several
+ * ways, the one requiring the fewest modifiers is kept. Among those, the first one which
+ * has been added wins.
+ */
+class KeysymTable {
+ public:
+  void add(KeySym keysym, KeyPosition position);
+  void clear();
+
+  std::optional<KeyPosition> find(KeySym keysym) const;
+  size_t                     size() const;
+
+ private:
+  std::unordered_map<KeySym, KeyPosition> mPositions;
+};
+
+/**
+ * This class types arbitrary text with XTest. The keysyms of the current keyboard layout
+ * are looked up in a table which is built from the XKB keymap. The table is only rebuilt
+ * if the X server reports that the keymap or the active layout group has changed. For
+ * this, XKB events are selected on the given connection. They are picked from its event
+ * queue without a round trip at the start of each call to type().
+ *
+ * Characters which cannot be typed with the current layout are temporarily assigned to a
+ * spare keycode which has no symbols. Such an assignment is kept until the keycode is
+ * needed for another character or until restoreSpareKeys() is called. Restoring it right
+ * away would race with clients which look up the symbols of the key only after they
+ * received the key event.
+ *
+ * All events of one call are sent with a single flush. Only if a text contains more
+ * distinct missing characters than there are spare keycodes, it is sent in several
+ * batches, with a round trip after each one.
+ *
+ * All methods have to be called from the same thread.
+ */
+class TextTyper {
+ public:
+  TextTyper() = default;
+
+  TextTyper(TextTyper const& other)            = delete;
+  TextTyper& operator=(TextTyper const& other) = delete;
+
+  /**
+   * Forgets all state and selects the XKB events on the given display. This has to be
+   * called before the first call to type() and whenever the connection has been
+   * reopened. Returns false if the X server does not support XKB.
+   */
+  bool reset(Display* display);
+
+  /**
+   * Types the given UTF-8 text into the focused window. Returns false if reset() has not
+   * succeeded or if the keymap cannot be read.
+   */
+  bool type(Display* display, std::string const& text);
+
+  /** Removes the symbols from all spare keycodes which have been assigned by type(). */
+  void restoreSpareKeys(Display* display);
+
+  /** Returns how often the table has been built. This is mostly useful for testing. */
+  uint32_t getTableBuilds() const;
+
+ private:
+  // A spare keycode and the keysym which is currently assigned to it, if any.
+  struct SpareKey {
+    KeyCode keycode = 0;
+    KeySym  keysym  = NoSymbol;
+  };
+
+  // A single key stroke together with the modifiers which have to be held down.
+  using Stroke = KeyPosition;
+
+  // Picks the XKB events from the event queue of the display and marks the table as
+  // outdated if necessary.
+  void processEvents(Display* display);
+
+  // Returns true if the given event only reports changes of our own spare keycodes.
+  bool isOwnChange(XkbMapNotifyEvent const& event) const;
+
+  // Reads the keymap and rebuilds the table, the modifier keys, and the spare keycodes.
+  bool buildTable(Display* display);
+
+  // Returns the spare keycode for the given keysym. If it is not assigned yet, a spare
+  // keycode which is not in the given set is assigned to it and the set is updated.
+  // Returns nothing if all spare keycodes are in the set.
+  std::optional<KeyCode> assignSpareKey(
+      Display* display, KeySym keysym, std::bitset<256>& usedInBatch);
+
+  // Sends the given strokes with XTest. This presses and releases the modifiers as
+  // required and toggles Caps Lock if it is active.
+  void sendStrokes(Display* display, std::vector<Stroke> const& strokes);
+
+  bool     mInitialized  = false;
+  int      mXkbEventType = 0;
+  bool     mTableValid   = false;
+  uint32_t mTableBuilds  = 0;
+
+  // The active layout group and the locked modifiers as reported by XKB.
+  unsigned int mGroup           = 0;
+  unsigned int mLockedModifiers = 0;
+
+  KeysymTable mTable;
+
+  // A key for each of the eight modifiers which can be held down to reach higher levels.
+  // Modifiers bound only to locking keys have none.
+  std::array<KeyCode, 8> mModifierKeys{};
+  KeyCode                mCapsLockKey = 0;
+
+  std::vector<SpareKey> mSpareKeys;
+  std::bitset<256>      mIsSpareKey;
+  size_t                mNextSpareKey = 0;
+};
+
+#endif // TEXT_TYPER_HPP
@@ -0,0 +1,269 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "WindowIcons.hpp"
+#include "WindowQueries.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Each source pixel contributes at most 255 * 255 to the sum of a channel. The SSE2 code
+// accumulates in 32-bit lanes, so it can only be used if the boxes are not larger than
+// this many pixels.
+constexpr uint32_t MAX_SIMD_BOX_AREA = 65536;
+
+// An ARGB image which is not owned, for instance an icon inside the _NET_WM_ICON data.
+struct IconView {
+  uint32_t        width  = 0;
+  uint32_t        height = 0;
+  uint32_t const* pixels = nullptr;
+};
+
+std::optional<IconView> pickIcon(std::vector<uint32_t> const& data, uint32_t size) {
+  std::optional<IconView> best;
+
+  size_t i = 0;
+  while (i + 2 <= data.size()) {
+    uint64_t width  = data[i];
+    uint64_t height = data[i + 1];
+
+    // Stop at the first malformed entry.
+    if (width == 0 || height == 0 || width * height > data.size() - i - 2) {
+      break;
+    }
+
+    IconView icon{uint32_t(width), uint32_t(height), data.data() + i + 2};
+    i += 2 + width * height;
+
+    if (!best) {
+      best = icon;
+      continue;
+    }
+
+    uint32_t extent     = std::max(icon.width, icon.height);
+    uint32_t bestExtent = std::max(best->width, best->height);
+
+    // Prefer the smallest icon which is large enough. If there is none, prefer the
+    // largest one.
+    if (bestExtent >= size ? (extent >= size && extent < bestExtent)
+                           : (extent > bestExtent)) {
+      best = icon;
+    }
+  }
+
+  return best;
+}
+
+// Writes the average of the given premultiplied channel sums as non-premultiplied RGBA.
+// The sums are in the order of the ARGB bytes in memory, so blue, green, red, and alpha.
+// Alpha is multiplied by 255 as well.
+void storeAverage(uint64_t const sums[4], uint64_t count, uint8_t* out) {
+  if (sums[3] == 0) {
+    std::fill(out, out + 4, 0);
+    return;
+  }
+
+  out[0] = uint8_t((sums[2] * 255 + sums[3] / 2) / sums[3]);
+  out[1] = uint8_t((sums[1] * 255 + sums[3] / 2) / sums[3]);
+  out[2] = uint8_t((sums[0] * 255 + sums[3] / 2) / sums[3]);
+  out[3] = uint8_t((sums[3] + 255 * count / 2) / (255 * count));
+}
+
+// Sums up the premultiplied channels of all pixels in the given box.
+void sumBox(IconView const& icon, uint32_t x0, uint32_t x1, uint32_t y0, uint32_t y1,
+    uint64_t sums[4]) {
+
+#if defined(__SSE2__)
+  if ((x1 - x0) * (y1 - y0) <= MAX_SIMD_BOX_AREA) {
+    __m128i const zero = _mm_setzero_si128();
+
+    // The alpha channel is multiplied by 255 instead of by itself.
+    __m128i const colorMask = _mm_setr_epi16(-1, -1, -1, 0, 0, 0, 0, 0);
+    __m128i const alphaOne  = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 0);
+
+    __m128i sum = zero;
+
+    for (uint32_t y = y0; y < y1; ++y) {
+      uint32_t const* row = icon.pixels + size_t(y) * icon.width;
+
+      for (uint32_t x = x0; x < x1; ++x) {
+        __m128i pixel  = _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(row[x])), zero);
+        __m128i alpha  = _mm_shufflelo_epi16(pixel, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i factor = _mm_or_si128(_mm_and_si128(alpha, colorMask), alphaOne);
+        __m128i scaled = _mm_mullo_epi16(pixel, factor);
+        sum            = _mm_add_epi32(sum, _mm_unpacklo_epi16(scaled, zero));
+      }
+    }
+
+    alignas(16) uint32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), sum);
+    std::copy(lanes, lanes + 4, sums);
+    return;
+  }
+#endif
+
+  std::fill(sums, sums + 4, 0);
+
+  for (uint32_t y = y0; y < y1; ++y) {
+    uint32_t const* row = icon.pixels + size_t(y) * icon.width;
+
+    for (uint32_t x = x0; x < x1; ++x) {
+      uint32_t pixel = row[x];
+      uint32_t alpha = pixel >> 24;
+      sums[0] += (pixel & 0xFF) * alpha;
+      sums[1] += ((pixel >> 8) & 0xFF) * alpha;
+      sums[2] += ((pixel >> 16) & 0xFF) * alpha;
+      sums[3] += alpha * 255;
+    }
+  }
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const Icon> scaleIcon(std::vector<uint32_t> const& data, uint32_t size) {
+  std::optional<IconView> source = pickIcon(data, size);
+  if (!source) {
+    return nullptr;
+  }
+
+  return scaleImage(source->pixels, source->width, source->height, size);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const Icon> scaleImage(
+    uint32_t const* pixels, uint32_t width, uint32_t height, uint32_t size) {
+  if (width == 0 || height == 0 || size == 0) {
+    return nullptr;
+  }
+
+  IconView source{width, height, pixels};
+
+  auto     icon   = std::make_shared<Icon>();
+  uint32_t extent = std::max(width, height);
+
+  // If the image is small enough, we only have to convert it from ARGB to RGBA.
+  if (extent <= size) {
+    icon->width  = width;
+    icon->height = height;
+    icon->rgba.resize(size_t(icon->width) * icon->height * 4);
+
+    for (size_t i = 0; i < size_t(icon->width) * icon->height; ++i) {
+      uint32_t pixel        = pixels[i];
+      icon->rgba[i * 4 + 0] = (pixel >> 16) & 0xFF;
+      icon->rgba[i * 4 + 1] = (pixel >> 8) & 0xFF;
+      icon->rgba[i * 4 + 2] = pixel & 0xFF;
+      icon->rgba[i * 4 + 3] = pixel >> 24;
+    }
+
+    return icon;
+  }
+
+  // Else we scale it down so that its larger side matches the requested size. Each
+  // target pixel is the average of a box of source pixels.
+  icon->width  = std::max(1u, uint32_t(uint64_t(source.width) * size / extent));
+  icon->height = std::max(1u, uint32_t(uint64_t(source.height) * size / extent));
+  icon->rgba.resize(size_t(icon->width) * icon->height * 4);
+
+  for (uint32_t y = 0; y < icon->height; ++y) {
+    uint32_t y0 = uint64_t(y) * source.height / icon->height;
+    uint32_t y1 = uint64_t(y + 1) * source.height / icon->height;
+
+    for (uint32_t x = 0; x < icon->width; ++x) {
+      uint32_t x0 = uint64_t(x) * source.width / icon->width;
+      uint32_t x1 = uint64_t(x + 1) * source.width / icon->width;
+
+      uint64_t sums[4];
+      sumBox(source, x0, x1, y0, y1, sums);
+      storeAverage(sums, uint64_t(x1 - x0) * (y1 - y0),
+          icon->rgba.data() + (size_t(y) * icon->width + x) * 4);
+    }
+  }
+
+  return icon;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t hashIcon(std::vector<uint32_t> const& data) {
+  uint64_t hash = 14695981039346656037ull;
+
+  for (uint32_t value : data) {
+    hash = (hash ^ value) * 1099511628211ull;
+  }
+
+  return hash;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const Icon> IconCache::get(Connection& connection, Window window,
+    uint32_t size, std::optional<uint64_t> serial) {
+
+  // If the property did not change, this is only a lookup.
+  auto entry = mEntries.find(window);
+  if (serial && entry != mEntries.end() && entry->second.serial == serial) {
+    auto icon = entry->second.icons.find(size);
+    if (icon != entry->second.icons.end()) {
+      return icon->second;
+    }
+  }
+
+  std::vector<uint32_t> data = queryIcon(connection, window);
+  uint64_t              hash = hashIcon(data);
+
+  if (entry == mEntries.end()) {
+    entry = mEntries.emplace(window, Entry()).first;
+  } else if (entry->second.hash != hash) {
+    entry->second.icons.clear();
+  }
+
+  entry->second.serial = serial;
+  entry->second.hash   = hash;
+
+  auto icon = entry->second.icons.find(size);
+  if (icon != entry->second.icons.end()) {
+    return icon->second;
+  }
+
+  // Windows without an icon are cached as well.
+  std::shared_ptr<const Icon> scaled = scaleIcon(data, size);
+  entry->second.icons.emplace(size, scaled);
+
+  return scaled;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void IconCache::retain(std::vector<Window> const& windows) {
+  std::unordered_set<Window> alive(windows.begin(), windows.end());
+
+  for (auto it = mEntries.begin(); it != mEntries.end();) {
+    it = alive.count(it->first) ? std::next(it) : mEntries.erase(it);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+size_t IconCache::size() const {
+  return mEntries.size();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef WINDOW_ICONS_HPP
+#define WINDOW_ICONS_HPP
+
+#include "Connection.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+/** A window icon with 8-bit RGBA pixels which are not premultiplied. */
+struct Icon {
+  uint32_t             width  = 0;
+  uint32_t             height = 0;
+  std::vector<uint8_t> rgba;
+};
+
+/**
+ * Picks the best-fitting icon from the given _NET_WM_ICON data. This is the smallest one
+ * which is at least as large as the requested size or, if there is none, the largest
+ * one. If it is larger than the requested size, it is downscaled with a box filter so
+ * that its larger side matches the requested size. Icons are never upscaled. Returns
+ * nullptr if the data does not contain a valid icon.
+ */
+std::shared_ptr<const Icon> scaleIcon(std::vector<uint32_t> const& data, uint32_t size);
+
+/**
+ * Scales the given image down with a box filter so that its larger side matches the
+ * requested size. The pixels are stored row-by-row as non-premultiplied 32-bit ARGB
+ * values, just like in _NET_WM_ICON. Images are never upscaled, smaller ones are only
+ * converted to RGBA. Returns nullptr if the image or the size is empty.
+ */
+std::shared_ptr<const Icon> scaleImage(
+    uint32_t const* pixels, uint32_t width, uint32_t height, uint32_t size);
+
+/** Returns a 64-bit FNV-1a hash of the given _NET_WM_ICON data. */
+uint64_t hashIcon(std::vector<uint32_t> const& data);
+
+/**
+ * This caches the scaled icons of windows. Each window stores the hash of its
+ * _NET_WM_ICON property and the icons which have been requested so far, one per size.
+ *
+ * To avoid reading the property again, the caller can pass a serial number which changes
+ * whenever the property changes. If the serial is the same as on the previous call, the
+ * cached icon is returned right away. Else the property is read again, but the icon is
+ * only scaled again if its hash changed.
+ */
+class IconCache {
+ public:
+  /**
+   * Returns the icon of the given window, scaled to the given size. Returns nullptr if
+   * the window has no icon. The serial should be nothing if it is not known.
+   */
+  std::shared_ptr<const Icon> get(Connection& connection, Window window, uint32_t size,
+      std::optional<uint64_t> serial);
+
+  /** Removes all windows from the cache which are not in the given list. */
+  void retain(std::vector<Window> const& windows);
+
+  /** Returns the number of windows in the cache. */
+  size_t size() const;
+
+ private:
+  struct Entry {
+    std::optional<uint64_t>                                   serial;
+    uint64_t                                                  hash = 0;
+    std::unordered_map<uint32_t, std::shared_ptr<const Icon>> icons;
+  };
+
+  std::unordered_map<Window, Entry> mEntries;
+};
+
+#endif // WINDOW_ICONS_HPP
@@ -0,0 +1,570 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "WindowQueries.hpp"
+#include "PropertyReader.hpp"
+#include "RandR.hpp"
+
+#include <X11/Xresource.h>
+#include <xcb/xcb.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The maximum number of 32-bit units we request for string properties. Window titles
+// which are longer than this are truncated.
+constexpr uint32_t MAX_STRING_LENGTH = 1024;
+
+// The maximum number of 32-bit units we read from properties of unbounded size like the
+// icon or the resource database. Anything beyond this is ignored.
+constexpr uint32_t MAX_PROPERTY_LENGTH = 1024 * 1024;
+
+using PropertyReply = XcbReply<xcb_get_property_reply_t>;
+
+// The cookies of all requests we send for a single window.
+struct WindowCookies {
+  xcb_get_property_cookie_t wmClass;
+  xcb_get_property_cookie_t netWmName;
+  xcb_get_property_cookie_t wmName;
+  xcb_get_property_cookie_t netWmDesktop;
+  xcb_get_property_cookie_t netWmPid;
+  xcb_get_property_cookie_t netWmState;
+  xcb_get_property_cookie_t netFrameExtents;
+
+  xcb_get_window_attributes_cookie_t attributes;
+  xcb_get_geometry_cookie_t          geometry;
+
+  // The position of the window relative to the root window. The geometry is relative to
+  // the parent, which is usually a frame of the window manager.
+  xcb_translate_coordinates_cookie_t position;
+};
+
+// The maximum number of atoms we read from _NET_WM_STATE.
+constexpr uint32_t MAX_STATES = 32;
+
+xcb_get_property_cookie_t requestProperty(
+    xcb_connection_t* xcb, Window window, Atom property, Atom type, uint32_t length) {
+  return xcb_get_property(xcb, 0, window, property, type, 0, length);
+}
+
+// Waits for the reply of the given cookie. Returns nullptr if the property does not exist
+// or if the window has been destroyed in the meantime.
+PropertyReply waitForProperty(xcb_connection_t* xcb, xcb_get_property_cookie_t cookie) {
+  xcb_generic_error_t* error = nullptr;
+  PropertyReply        reply(xcb_get_property_reply(xcb, cookie, &error));
+  free(error);
+
+  if (reply && reply->type == XCB_NONE) {
+    return nullptr;
+  }
+
+  return reply;
+}
+
+// Waits for the first chunk of a property requested with PropertyReader::request() and
+// reads the rest of it. The additional round trips are added to the stats.
+std::optional<PropertyData> readProperty(Connection& connection,
+    xcb_get_property_cookie_t cookie, Window window, Atom property, Atom type,
+    QueryStats* stats) {
+  auto data = connection.getPropertyReader().read(
+      connection.getXCB(), cookie, window, property, type, MAX_PROPERTY_LENGTH);
+
+  if (stats && data && data->requests > 1) {
+    stats->requests += data->requests - 1;
+    stats->roundTrips += data->requests - 1;
+  }
+
+  return data;
+}
+
+// Returns the first null-terminated string of the given property. For WM_CLASS, this is
+// the instance name.
+std::string takeString(PropertyReply const& reply) {
+  if (!reply) {
+    return "";
+  }
+
+  auto*  data   = static_cast<const char*>(xcb_get_property_value(reply.get()));
+  size_t length = xcb_get_property_value_length(reply.get());
+
+  return std::string(data, strnlen(data, length));
+}
+
+// Same as above for properties which have been read with the PropertyReader.
+std::string takeString(std::optional<PropertyData> const& property) {
+  if (!property) {
+    return "";
+  }
+
+  auto* data = reinterpret_cast<const char*>(property->data);
+  return std::string(data, strnlen(data, property->size));
+}
+
+// Returns the first 32-bit value of the given property or the fallback if there is none.
+uint32_t takeValue(PropertyReply const& reply, uint32_t fallback) {
+  if (!reply) {
+    return fallback;
+  }
+
+  if (reply->format == 32 && xcb_get_property_value_length(reply.get()) >= 4) {
+    return *static_cast<uint32_t*>(xcb_get_property_value(reply.get()));
+  }
+
+  return fallback;
+}
+
+// Returns the 32-bit values of the given property. Contrary to XGetWindowProperty(), XCB
+// returns 32-bit values as 32-bit integers.
+template <typename T>
+std::vector<T> takeValues(std::optional<PropertyData> const& property) {
+  std::vector<T> values;
+
+  if (property && property->format == 32) {
+    values.resize(property->size / sizeof(T));
+    std::memcpy(values.data(), property->data, values.size() * sizeof(T));
+  }
+
+  return values;
+}
+
+// Returns the intersection of both rectangles. If they do not overlap, the first one is
+// returned.
+Rect intersect(Rect const& a, Rect const& b) {
+  int x0 = std::max(a.x, b.x);
+  int y0 = std::max(a.y, b.y);
+  int x1 = std::min(a.x + a.width, b.x + b.width);
+  int y1 = std::min(a.y + a.height, b.y + b.height);
+
+  if (x1 <= x0 || y1 <= y0) {
+    return a;
+  }
+
+  return {x0, y0, x1 - x0, y1 - y0};
+}
+
+void sendWindowRequests(Connection& connection, Window window, WindowCookies& cookies,
+    QueryStats* stats) {
+  xcb_connection_t* xcb   = connection.getXCB();
+  Atoms const&      atoms = connection.getAtoms();
+
+  cookies.wmClass = requestProperty(xcb, window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 64);
+  cookies.netWmName =
+      requestProperty(xcb, window, atoms.netWmName, atoms.utf8String, MAX_STRING_LENGTH);
+  cookies.wmName =
+      requestProperty(xcb, window, XCB_ATOM_WM_NAME, XCB_ATOM_ANY, MAX_STRING_LENGTH);
+  cookies.netWmDesktop =
+      requestProperty(xcb, window, atoms.netWmDesktop, XCB_ATOM_CARDINAL, 1);
+  cookies.netWmPid = requestProperty(xcb, window, atoms.netWmPid, XCB_ATOM_CARDINAL, 1);
+  cookies.netWmState =
+      requestProperty(xcb, window, atoms.netWmState, XCB_ATOM_ATOM, MAX_STATES);
+  cookies.netFrameExtents =
+      requestProperty(xcb, window, atoms.netFrameExtents, XCB_ATOM_CARDINAL, 4);
+  cookies.attributes = xcb_get_window_attributes(xcb, window);
+  cookies.geometry   = xcb_get_geometry(xcb, window);
+  cookies.position =
+      xcb_translate_coordinates(xcb, window, connection.getRoot(), 0, 0);
+
+  if (stats) {
+    stats->requests += 10;
+  }
+}
+
+WindowInfo collectWindowReplies(
+    Connection& connection, Window window, WindowCookies const& cookies) {
+  xcb_connection_t* xcb = connection.getXCB();
+
+  WindowInfo info;
+  info.id      = window;
+  info.appName = takeString(waitForProperty(xcb, cookies.wmClass));
+
+  // _NET_WM_NAME takes precedence over WM_NAME. We have to collect both replies anyway so
+  // that they are freed.
+  std::string netWmName = takeString(waitForProperty(xcb, cookies.netWmName));
+  std::string wmName    = takeString(waitForProperty(xcb, cookies.wmName));
+  info.windowName       = netWmName.empty() ? wmName : netWmName;
+
+  info.desktop = takeValue(waitForProperty(xcb, cookies.netWmDesktop), 0xFFFFFFFF);
+  info.pid     = takeValue(waitForProperty(xcb, cookies.netWmPid), 0);
+
+  auto state = waitForProperty(xcb, cookies.netWmState);
+  if (state && state->format == 32) {
+    auto* begin = static_cast<xcb_atom_t*>(xcb_get_property_value(state.get()));
+    auto* end = begin + xcb_get_property_value_length(state.get()) / sizeof(xcb_atom_t);
+    info.minimized = std::find(begin, end, connection.getAtoms().netWmStateHidden) != end;
+  }
+
+  // The extents are given as left, right, top, and bottom.
+  auto extents = waitForProperty(xcb, cookies.netFrameExtents);
+  if (extents && extents->format == 32 &&
+      xcb_get_property_value_length(extents.get()) >= 16) {
+    auto* values      = static_cast<uint32_t*>(xcb_get_property_value(extents.get()));
+    info.frameExtents = {static_cast<int>(values[0]), static_cast<int>(values[1]),
+        static_cast<int>(values[2]), static_cast<int>(values[3])};
+  }
+
+  // Errors are returned instead of being put into the event queue. The window may have
+  // been destroyed in the meantime.
+  xcb_generic_error_t*                         error = nullptr;
+  XcbReply<xcb_get_window_attributes_reply_t> attributes(
+      xcb_get_window_attributes_reply(xcb, cookies.attributes, &error));
+  free(error);
+
+  info.mapped = attributes && attributes->map_state != XCB_MAP_STATE_UNMAPPED;
+
+  error = nullptr;
+  XcbReply<xcb_get_geometry_reply_t> geometry(
+      xcb_get_geometry_reply(xcb, cookies.geometry, &error));
+  free(error);
+
+  error = nullptr;
+  XcbReply<xcb_translate_coordinates_reply_t> position(
+      xcb_translate_coordinates_reply(xcb, cookies.position, &error));
+  free(error);
+
+  if (geometry && position) {
+    info.geometry = {position->dst_x, position->dst_y, geometry->width, geometry->height};
+  }
+
+  return info;
+}
+
+// Returns the windows stored in the given property of the root window.
+std::vector<Window> queryWindowList(
+    Connection& connection, Atom property, QueryStats* stats) {
+  Window root   = connection.getRoot();
+  auto   cookie = PropertyReader::request(
+      connection.getXCB(), root, property, XCB_ATOM_WINDOW);
+
+  if (stats) {
+    stats->requests += 1;
+    stats->roundTrips += 1;
+  }
+
+  auto data = readProperty(connection, cookie, root, property, XCB_ATOM_WINDOW, stats);
+
+  std::vector<Window> windows;
+  for (xcb_window_t window : takeValues<xcb_window_t>(data)) {
+    windows.push_back(window);
+  }
+
+  return windows;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Window> queryClientList(Connection& connection, QueryStats* stats) {
+  return queryWindowList(connection, connection.getAtoms().netClientList, stats);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Window> queryStackingOrder(Connection& connection, QueryStats* stats) {
+  return queryWindowList(connection, connection.getAtoms().netClientListStacking, stats);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<WindowInfo> queryWindowInfos(
+    Connection& connection, std::vector<Window> const& windows, QueryStats* stats) {
+
+  // First, we send the requests for all windows...
+  std::vector<WindowCookies> cookies(windows.size());
+  for (size_t i = 0; i < windows.size(); ++i) {
+    sendWindowRequests(connection, windows[i], cookies[i], stats);
+  }
+
+  xcb_flush(connection.getXCB());
+
+  // ... and then we collect all replies. Only the first one will actually block.
+  std::vector<WindowInfo> infos;
+  infos.reserve(windows.size());
+  for (size_t i = 0; i < windows.size(); ++i) {
+    infos.push_back(collectWindowReplies(connection, windows[i], cookies[i]));
+  }
+
+  if (stats && !windows.empty()) {
+    stats->roundTrips += 1;
+  }
+
+  return infos;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Window queryActiveWindow(Connection& connection, QueryStats* stats) {
+  xcb_connection_t* xcb    = connection.getXCB();
+  auto              cookie = requestProperty(xcb, connection.getRoot(),
+      connection.getAtoms().netActiveWindow, XCB_ATOM_WINDOW, 1);
+
+  if (stats) {
+    stats->requests += 1;
+    stats->roundTrips += 1;
+  }
+
+  return takeValue(waitForProperty(xcb, cookie), static_cast<uint32_t>(None));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t queryCurrentDesktop(Connection& connection, QueryStats* stats) {
+  xcb_connection_t* xcb    = connection.getXCB();
+  auto              cookie = requestProperty(xcb, connection.getRoot(),
+      connection.getAtoms().netCurrentDesktop, XCB_ATOM_CARDINAL, 1);
+
+  if (stats) {
+    stats->requests += 1;
+    stats->roundTrips += 1;
+  }
+
+  return takeValue(waitForProperty(xcb, cookie), 0xFFFFFFFF);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::string queryResources(Connection& connection, QueryStats* stats) {
+  Window root   = connection.getRoot();
+  auto   cookie = PropertyReader::request(
+      connection.getXCB(), root, XCB_ATOM_RESOURCE_MANAGER, XCB_ATOM_STRING);
+
+  if (stats) {
+    stats->requests += 1;
+    stats->roundTrips += 1;
+  }
+
+  return takeString(readProperty(
+      connection, cookie, root, XCB_ATOM_RESOURCE_MANAGER, XCB_ATOM_STRING, stats));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Window queryXSettingsOwner(Connection& connection, QueryStats* stats) {
+  xcb_connection_t* xcb = connection.getXCB();
+  auto              cookie =
+      xcb_get_selection_owner(xcb, connection.getAtoms().xsettingsSelection);
+  XcbReply<xcb_get_selection_owner_reply_t> reply(
+      xcb_get_selection_owner_reply(xcb, cookie, nullptr));
+
+  if (stats) {
+    stats->requests += 1;
+    stats->roundTrips += 1;
+  }
+
+  return reply ? reply->owner : None;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<XSettings> queryXSettings(
+    Connection& connection, Window owner, QueryStats* stats) {
+  Atom property = connection.getAtoms().xsettingsSettings;
+  auto cookie   = PropertyReader::request(connection.getXCB(), owner, property, property);
+
+  if (stats) {
+    stats->requests += 1;
+    stats->roundTrips += 1;
+  }
+
+  auto data = readProperty(connection, cookie, owner, property, property, stats);
+
+  if (!data) {
+    return std::nullopt;
+  }
+
+  return parseXSettings(data->data, data->size);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint32_t> queryIcon(
+    Connection& connection, Window window, QueryStats* stats) {
+  Atom property = connection.getAtoms().netWmIcon;
+  auto cookie =
+      PropertyReader::request(connection.getXCB(), window, property, XCB_ATOM_CARDINAL);
+
+  if (stats) {
+    stats->requests += 1;
+    stats->roundTrips += 1;
+  }
+
+  return takeValues<uint32_t>(
+      readProperty(connection, cookie, window, property, XCB_ATOM_CARDINAL, stats));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+PointerPosition queryPointer(Connection& connection, QueryStats* stats) {
+  PointerPosition position;
+
+  xcb_connection_t* xcb    = connection.getXCB();
+  auto              cookie = xcb_query_pointer(xcb, connection.getRoot());
+
+  XcbReply<xcb_query_pointer_reply_t> pointer(
+      xcb_query_pointer_reply(xcb, cookie, nullptr));
+  if (pointer) {
+    position.x = pointer->root_x;
+    position.y = pointer->root_y;
+  }
+
+  if (stats) {
+    stats->requests += 1;
+    stats->roundTrips += 1;
+  }
+
+  return position;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+WMState queryWMState(Connection& connection, QueryStats* stats) {
+  WMState state;
+
+  xcb_connection_t* xcb   = connection.getXCB();
+  Window            root  = connection.getRoot();
+  Atoms const&      atoms = connection.getAtoms();
+
+  // The first batch queries everything we can get from the root window.
+  auto activeCookie =
+      requestProperty(xcb, root, atoms.netActiveWindow, XCB_ATOM_WINDOW, 1);
+  auto pointerCookie   = xcb_query_pointer(xcb, root);
+  auto resourcesCookie =
+      PropertyReader::request(xcb, root, XCB_ATOM_RESOURCE_MANAGER, XCB_ATOM_STRING);
+  xcb_flush(xcb);
+
+  Window activeWindow =
+      takeValue(waitForProperty(xcb, activeCookie), static_cast<uint32_t>(None));
+
+  XcbReply<xcb_query_pointer_reply_t> pointer(
+      xcb_query_pointer_reply(xcb, pointerCookie, nullptr));
+  if (pointer) {
+    state.pointerX = pointer->root_x;
+    state.pointerY = pointer->root_y;
+  }
+
+  if (stats) {
+    stats->requests += 3;
+    stats->roundTrips += 1;
+  }
+
+  state.resources = takeString(readProperty(connection, resourcesCookie, root,
+      XCB_ATOM_RESOURCE_MANAGER, XCB_ATOM_STRING, stats));
+
+  // The second batch needs the ID of the active window, so it cannot be merged with the
+  // first one.
+  if (activeWindow != None) {
+    WindowCookies cookies;
+    sendWindowRequests(connection, activeWindow, cookies, stats);
+    xcb_flush(xcb);
+    state.activeWindow = collectWindowReplies(connection, activeWindow, cookies);
+
+    if (stats) {
+      stats->roundTrips += 1;
+    }
+  }
+
+  return state;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Monitor> queryMonitors(
+    Connection& connection, double scalingFactor, QueryStats* stats) {
+  xcb_connection_t* xcb   = connection.getXCB();
+  Window            root  = connection.getRoot();
+  Atoms const&      atoms = connection.getAtoms();
+
+  // We send the requests for the work area first so that the replies are already there
+  // once we have talked to XRandR.
+  auto workAreaCookie =
+      PropertyReader::request(xcb, root, atoms.netWorkarea, XCB_ATOM_CARDINAL);
+  auto desktopCookie =
+      requestProperty(xcb, root, atoms.netCurrentDesktop, XCB_ATOM_CARDINAL, 1);
+  xcb_flush(xcb);
+
+  uint32_t          randrRequests = 0;
+  std::vector<Rect> geometries =
+      queryCrtcGeometries(connection.getDisplay(), root, &randrRequests);
+
+  // Each XRandR request is a round trip. The work area replies arrive in the meantime.
+  if (stats) {
+    stats->requests += 2 + randrRequests;
+    stats->roundTrips += std::max(randrRequests, 1u);
+  }
+
+  // Without XRandR, the root window is treated as a single monitor.
+  if (geometries.empty()) {
+    Screen* screen = DefaultScreenOfDisplay(connection.getDisplay());
+    geometries.push_back({0, 0, WidthOfScreen(screen), HeightOfScreen(screen)});
+  }
+
+  // _NET_WORKAREA contains one rectangle for each desktop. If it is missing, the work
+  // area is the entire monitor.
+  uint32_t desktop = takeValue(waitForProperty(xcb, desktopCookie), 0);
+  auto     values  = takeValues<uint32_t>(readProperty(
+      connection, workAreaCookie, root, atoms.netWorkarea, XCB_ATOM_CARDINAL, stats));
+
+  Rect     workArea    = {};
+  bool     hasWorkArea = false;
+  uint32_t count       = values.size() / 4;
+
+  if (count > 0) {
+    uint32_t i  = desktop < count ? desktop : 0;
+    workArea    = {static_cast<int>(values[4 * i]), static_cast<int>(values[4 * i + 1]),
+           static_cast<int>(values[4 * i + 2]), static_cast<int>(values[4 * i + 3])};
+    hasWorkArea = true;
+  }
+
+  std::vector<Monitor> monitors;
+  monitors.reserve(geometries.size());
+
+  for (auto const& geometry : geometries) {
+    Monitor monitor;
+    monitor.geometry      = geometry;
+    monitor.workArea      = hasWorkArea ? intersect(geometry, workArea) : geometry;
+    monitor.scalingFactor = scalingFactor;
+    monitors.push_back(monitor);
+  }
+
+  return monitors;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+double parseScalingFactor(std::string const& resources) {
+  double scalingFactor = 1.0;
+
+  if (resources.empty()) {
+    return scalingFactor;
+  }
+
+  XrmDatabase db = XrmGetStringDatabase(resources.c_str());
+
+  char*    type;
+  XrmValue value;
+
+  if (XrmGetResource(db, "Xft.dpi", "Xft.Dpi", &type, &value)) {
+    double dpi = atof(value.addr);
+    if (dpi > 0.0) {
+      scalingFactor = dpi / 96.0; // Assuming 96 DPI as the baseline for 1.0 scaling
+    }
+  }
+
+  XrmDestroyDatabase(db);
+
+  return scalingFactor;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,201 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef WINDOW_QUERIES_HPP
+#define WINDOW_QUERIES_HPP
+
+#include "Connection.hpp"
+#include "MonitorIndex.hpp"
+#include "XSettings.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// The functions in this file query window properties using XCB on the Xlib connection of
+// the given Connection. Contrary to XGetWindowProperty(), XCB allows us to send all
+// requests at once and collect the replies afterwards. So no matter how many windows are
+// queried, this only costs a single round trip to the X server.
+
+/** The decorations of a window manager around a client window in physical pixels. */
+struct FrameExtents {
+  int left   = 0;
+  int right  = 0;
+  int top    = 0;
+  int bottom = 0;
+};
+
+/** The properties of a client window which are relevant for Kando. */
+struct WindowInfo {
+  Window id = None;
+
+  /** The instance name from WM_CLASS. */
+  std::string appName;
+
+  /** The title from _NET_WM_NAME or, if that is not set, from WM_NAME. */
+  std::string windowName;
+
+  /** The value of _NET_WM_DESKTOP. 0xFFFFFFFF means "all desktops" or "unknown". */
+  uint32_t desktop = 0xFFFFFFFF;
+
+  /** The value of _NET_WM_PID. 0 means that the window does not announce its process. */
+  uint32_t pid = 0;
+
+  /** Whether _NET_WM_STATE contains _NET_WM_STATE_HIDDEN. */
+  bool minimized = false;
+
+  /** Whether the window is mapped. Minimized windows are usually unmapped. */
+  bool mapped = false;
+
+  /** The area covered by the window relative to the root window in physical pixels. */
+  Rect geometry;
+
+  /** The value of _NET_FRAME_EXTENTS. This is zero if the window has no decorations. */
+  FrameExtents frameExtents;
+
+  /**
+   * The index of the monitor containing the center of the window. This is only set by
+   * the WindowTable and is -1 otherwise.
+   */
+  int monitor = -1;
+
+  /** Returns the geometry including the decorations of the window manager. */
+  Rect getFrame() const {
+    return {geometry.x - frameExtents.left, geometry.y - frameExtents.top,
+        geometry.width + frameExtents.left + frameExtents.right,
+        geometry.height + frameExtents.top + frameExtents.bottom};
+  }
+
+  /** Windows without a class or a title are not reported to JavaScript. */
+  bool hasAppAndName() const {
+    return !appName.empty() && !windowName.empty();
+  }
+};
+
+/** The state of the window manager which is required when opening a menu. */
+struct WMState {
+  WindowInfo activeWindow;
+
+  /** The pointer position in physical pixels relative to the root window. */
+  int pointerX = 0;
+  int pointerY = 0;
+
+  /** The content of the RESOURCE_MANAGER property of the root window. */
+  std::string resources;
+};
+
+/** The pointer position in physical pixels relative to the root window. */
+struct PointerPosition {
+  int x = 0;
+  int y = 0;
+};
+
+/**
+ * Some statistics about the X server traffic caused by a query. This is used by the
+ * benchmarks to compare the pipelined XCB queries with the synchronous Xlib calls.
+ */
+struct QueryStats {
+  uint32_t requests   = 0;
+  uint32_t roundTrips = 0;
+};
+
+/**
+ * Returns the content of the _NET_CLIENT_LIST property of the root window. This costs
+ * one round trip.
+ */
+std::vector<Window> queryClientList(Connection& connection, QueryStats* stats = nullptr);
+
+/**
+ * Returns the content of the _NET_CLIENT_LIST_STACKING property of the root window. The
+ * windows are ordered from bottom to top. This costs one round trip.
+ */
+std::vector<Window> queryStackingOrder(
+    Connection& connection, QueryStats* stats = nullptr);
+
+/**
+ * Queries WM_CLASS, _NET_WM_NAME, WM_NAME, _NET_WM_DESKTOP, _NET_WM_PID, _NET_WM_STATE,
+ * _NET_FRAME_EXTENTS, the map state, and the geometry of all given windows. All requests
+ * are sent in one batch, so this costs a single round trip. The result contains one
+ * entry for each given window, in the same order. Windows which do not exist anymore are
+ * returned with empty names.
+ */
+std::vector<WindowInfo> queryWindowInfos(Connection& connection,
+    std::vector<Window> const& windows, QueryStats* stats = nullptr);
+
+/**
+ * Returns the content of the _NET_ACTIVE_WINDOW property of the root window. This costs
+ * one round trip.
+ */
+Window queryActiveWindow(Connection& connection, QueryStats* stats = nullptr);
+
+/**
+ * Returns the content of the _NET_CURRENT_DESKTOP property of the root window or
+ * 0xFFFFFFFF if it is not set. This costs one round trip.
+ */
+uint32_t queryCurrentDesktop(Connection& connection, QueryStats* stats = nullptr);
+
+/**
+ * Returns the content of the RESOURCE_MANAGER property of the root window. This costs one
+ * round trip for each 64 KiB of data. At most 4 MiB are read.
+ */
+std::string queryResources(Connection& connection, QueryStats* stats = nullptr);
+
+/**
+ * Returns the content of the _NET_WM_ICON property of the given window. It contains any
+ * number of icons, each given as width and height followed by width * height ARGB
+ * pixels. This costs one round trip for each 64 KiB of data. At most 4 MiB are read, so
+ * very large icon sets may be truncated.
+ */
+std::vector<uint32_t> queryIcon(
+    Connection& connection, Window window, QueryStats* stats = nullptr);
+
+/** Returns the current pointer position. This costs one round trip. */
+PointerPosition queryPointer(Connection& connection, QueryStats* stats = nullptr);
+
+/**
+ * Queries the active window, the pointer position, and the resource string in a first
+ * batch and the properties of the active window in a second batch. So this costs two
+ * round trips.
+ */
+WMState queryWMState(Connection& connection, QueryStats* stats = nullptr);
+
+/**
+ * Returns all active monitors as reported by XRandR. Mirrored monitors are only reported
+ * once. The work area of each monitor is computed from the _NET_WORKAREA of the current
+ * desktop. XRandR requires one round trip per CRTC, so this should only be called if the
+ * screen configuration changed. If XRandR is not available, the root window is returned
+ * as single monitor.
+ */
+std::vector<Monitor> queryMonitors(
+    Connection& connection, double scalingFactor, QueryStats* stats = nullptr);
+
+/**
+ * Returns the owner of the XSETTINGS selection of the default screen. This is None if no
+ * XSETTINGS manager is running. This costs one round trip.
+ */
+Window queryXSettingsOwner(Connection& connection, QueryStats* stats = nullptr);
+
+/**
+ * Reads and parses the _XSETTINGS_SETTINGS property of the given XSETTINGS manager
+ * window. Returns nothing if the window does not exist anymore or if the property is
+ * malformed. This costs one round trip.
+ */
+std::optional<XSettings> queryXSettings(
+    Connection& connection, Window owner, QueryStats* stats = nullptr);
+
+/**
+ * Returns the DPI scaling factor from the Xft.dpi entry of the given resource string. A
+ * DPI of 96 corresponds to a scaling factor of one. If there is no such entry, one is
+ * returned.
+ */
+double parseScalingFactor(std::string const& resources);
+
+#endif // WINDOW_QUERIES_HPP
@@ -0,0 +1,149 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "WindowShape.hpp"
+
+#include <xcb/shape.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Clamps the given value to the range of the 16-bit coordinates used by the X protocol.
+int16_t toCoordinate(double value) {
+  return static_cast<int16_t>(std::clamp(value, double(INT16_MIN), double(INT16_MAX)));
+}
+
+uint16_t toExtent(double value) {
+  return static_cast<uint16_t>(std::clamp(value, 0.0, double(UINT16_MAX)));
+}
+
+// Input shapes have been added in version 1.1 of the SHAPE extension. Requests to an
+// extension which is not available would close the connection.
+bool supportsInputShapes(xcb_connection_t* xcb) {
+  if (!xcb_get_extension_data(xcb, &xcb_shape_id)->present) {
+    return false;
+  }
+
+  auto* reply = xcb_shape_query_version_reply(xcb, xcb_shape_query_version(xcb), nullptr);
+  bool  supported =
+      reply && (reply->major_version > 1 ||
+                   (reply->major_version == 1 && reply->minor_version >= 1));
+  free(reply);
+  return supported;
+}
+
+// Waits for all given requests. Errors are returned here instead of being reported to
+// the error handler of Xlib. Returns false if any of them failed.
+bool checkRequests(xcb_connection_t* xcb, std::vector<xcb_void_cookie_t> const& cookies) {
+  bool success = true;
+
+  for (auto cookie : cookies) {
+    xcb_generic_error_t* error = xcb_request_check(xcb, cookie);
+    if (error) {
+      success = false;
+      free(error);
+    }
+  }
+
+  return success;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<xcb_rectangle_t> rasterizeShape(std::vector<ShapeCircle> const& circles,
+    std::vector<Rect> const& rectangles, int bandHeight) {
+  std::vector<xcb_rectangle_t> result;
+  bandHeight = std::max(bandHeight, 1);
+
+  for (auto const& circle : circles) {
+    if (circle.radius <= 0.0) {
+      continue;
+    }
+
+    double top    = std::floor(circle.y - circle.radius);
+    double bottom = std::ceil(circle.y + circle.radius);
+
+    for (double y = top; y < bottom; y += bandHeight) {
+      double y1 = std::min(y + bandHeight, bottom);
+
+      // The circle is widest at the point of the band which is closest to its center.
+      double dy        = std::max({0.0, y - circle.y, circle.y - y1});
+      double radius2   = circle.radius * circle.radius;
+      double halfWidth = std::sqrt(std::max(0.0, radius2 - dy * dy));
+
+      if (halfWidth <= 0.0) {
+        continue;
+      }
+
+      double x0 = std::floor(circle.x - halfWidth);
+      double x1 = std::ceil(circle.x + halfWidth);
+
+      result.push_back({toCoordinate(x0), toCoordinate(y), toExtent(x1 - x0),
+          toExtent(y1 - y)});
+    }
+  }
+
+  for (auto const& rect : rectangles) {
+    if (rect.width > 0 && rect.height > 0) {
+      result.push_back({toCoordinate(rect.x), toCoordinate(rect.y), toExtent(rect.width),
+          toExtent(rect.height)});
+    }
+  }
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool setWindowShape(xcb_connection_t* xcb, xcb_window_t window,
+    std::vector<xcb_rectangle_t> const& rectangles) {
+  if (!supportsInputShapes(xcb)) {
+    return false;
+  }
+
+  // The rectangles may overlap, so we cannot claim any ordering. Both regions are sent
+  // in one batch.
+  std::vector<xcb_void_cookie_t> cookies;
+
+  for (auto kind : {XCB_SHAPE_SK_BOUNDING, XCB_SHAPE_SK_INPUT}) {
+    cookies.push_back(xcb_shape_rectangles_checked(xcb, XCB_SHAPE_SO_SET, kind,
+        XCB_CLIP_ORDERING_UNSORTED, window, 0, 0, rectangles.size(), rectangles.data()));
+  }
+
+  return checkRequests(xcb, cookies);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool resetWindowShape(xcb_connection_t* xcb, xcb_window_t window) {
+  if (!supportsInputShapes(xcb)) {
+    return false;
+  }
+
+  // Setting the mask to None removes the region.
+  std::vector<xcb_void_cookie_t> cookies;
+
+  for (auto kind : {XCB_SHAPE_SK_BOUNDING, XCB_SHAPE_SK_INPUT}) {
+    cookies.push_back(xcb_shape_mask_checked(
+        xcb, XCB_SHAPE_SO_SET, kind, window, 0, 0, XCB_PIXMAP_NONE));
+  }
+
+  return checkRequests(xcb, cookies);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,55 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef WINDOW_SHAPE_HPP
+#define WINDOW_SHAPE_HPP
+
+#include "MonitorIndex.hpp"
+
+#include <xcb/xcb.h>
+
+#include <vector>
+
+/** A circle in window coordinates. All values are in physical pixels. */
+struct ShapeCircle {
+  double x      = 0.0;
+  double y      = 0.0;
+  double radius = 0.0;
+};
+
+/**
+ * Approximates the union of the given circles and rectangles with a list of rectangles
+ * which can be passed to setWindowShape(). Each circle is split into horizontal bands of
+ * the given height. Each band is as wide as the circle is at its widest point inside the
+ * band, so the circle is always covered completely. Smaller bands fit the circle more
+ * tightly but result in more rectangles.
+ */
+std::vector<xcb_rectangle_t> rasterizeShape(std::vector<ShapeCircle> const& circles,
+    std::vector<Rect> const& rectangles, int bandHeight = 8);
+
+/**
+ * Sets the bounding and the input region of the given window to the union of the given
+ * rectangles using the SHAPE extension. Everything outside is neither drawn by the
+ * compositor nor receives pointer input, so clicks go through to the windows below.
+ * Shaping only the bounding region would have the same effect on input, as the X server
+ * clips the input region to the bounding region. This costs one round trip. Returns
+ * false if the X server does not support input shapes or if the window does not exist.
+ */
+bool setWindowShape(xcb_connection_t* xcb, xcb_window_t window,
+    std::vector<xcb_rectangle_t> const& rectangles);
+
+/**
+ * Removes the bounding and the input region of the given window so that it is drawn and
+ * receives input in its entire area again. Returns false if the X server does not
+ * support input shapes or if the window does not exist.
+ */
+bool resetWindowShape(xcb_connection_t* xcb, xcb_window_t window);
+
+#endif // WINDOW_SHAPE_HPP
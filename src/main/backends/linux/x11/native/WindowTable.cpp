@@ -0,0 +1,697 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "WindowTable.hpp"
+#include "RandR.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// If the X server cannot be reached, the event thread retries after this many
+// milliseconds.
+constexpr int RECONNECT_INTERVAL = 1000;
+
+// The geometry is not compared. Only a change of the monitor is reported.
+bool isSameWindow(WindowInfo const& a, WindowInfo const& b) {
+  return a.id == b.id && a.appName == b.appName && a.windowName == b.windowName &&
+         a.desktop == b.desktop && a.pid == b.pid && a.minimized == b.minimized &&
+         a.monitor == b.monitor;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+WindowTable::~WindowTable() {
+  stop();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::start() {
+  if (mRunning) {
+    return;
+  }
+
+  mWakeupFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  mRunning  = true;
+  mThread   = std::thread(&WindowTable::run, this);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::stop() {
+  if (!mRunning) {
+    return;
+  }
+
+  mRunning = false;
+
+  uint64_t value = 1;
+  write(mWakeupFd, &value, sizeof(value));
+
+  mThread.join();
+
+  close(mWakeupFd);
+  mWakeupFd = -1;
+  mSynced   = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool WindowTable::isSynced() const {
+  return mSynced;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<WindowInfo> WindowTable::getWindows() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  std::vector<WindowInfo> windows;
+  windows.reserve(mClients.size());
+
+  std::unordered_set<Window> added;
+  auto                       add = [&](Window window) {
+    if (mWindows.count(window) && added.insert(window).second) {
+      windows.push_back(mWindows.at(window));
+    }
+  };
+
+  // The focus history comes first, most recent first. The stacking order goes from
+  // bottom to top, so we iterate it backwards. Clients which are not in the stacking
+  // order yet come last.
+  std::for_each(mFocusHistory.begin(), mFocusHistory.end(), add);
+  std::for_each(mStacking.rbegin(), mStacking.rend(), add);
+  std::for_each(mClients.begin(), mClients.end(), add);
+
+  return windows;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<WindowInfo> WindowTable::getWindow(Window window) const {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  auto it = mWindows.find(window);
+  if (it == mWindows.end()) {
+    return std::nullopt;
+  }
+
+  return it->second;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+WindowInfo WindowTable::getActiveWindow() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  auto it = mWindows.find(mActiveWindow);
+  return it != mWindows.end() ? it->second : WindowInfo();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+double WindowTable::getScalingFactor() const {
+  return mScalingFactor;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<Monitor> WindowTable::findMonitor(int x, int y) const {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  Monitor const* monitor = mMonitors.find(x, y);
+  if (!monitor) {
+    return std::nullopt;
+  }
+
+  return *monitor;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<WindowInfo> WindowTable::findWindowAt(int x, int y) const {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  auto isHit = [&](Window window) {
+    auto it = mWindows.find(window);
+    if (it == mWindows.end()) {
+      return false;
+    }
+
+    WindowInfo const& info = it->second;
+
+    if (!info.mapped || info.minimized) {
+      return false;
+    }
+
+    // Windows which are on all desktops have 0xFFFFFFFF as well.
+    if (mCurrentDesktop != 0xFFFFFFFF && info.desktop != 0xFFFFFFFF &&
+        info.desktop != mCurrentDesktop) {
+      return false;
+    }
+
+    return info.getFrame().contains(x, y);
+  };
+
+  // The stacking order goes from bottom to top, so we iterate it backwards.
+  std::vector<Window> const& order = mStacking.empty() ? mClients : mStacking;
+
+  auto it = std::find_if(order.rbegin(), order.rend(), isHit);
+  if (it == order.rend()) {
+    return std::nullopt;
+  }
+
+  return mWindows.at(*it);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Monitor> WindowTable::getMonitors() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mMonitors.getMonitors();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<std::string> WindowTable::getIconTheme() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mIconTheme;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<uint64_t> WindowTable::getIconSerial(Window window) const {
+  if (!mSynced) {
+    return std::nullopt;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  auto it = mIconSerials.find(window);
+  if (it == mIconSerials.end()) {
+    return std::nullopt;
+  }
+
+  return it->second;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::setActiveWindowCallback(ActiveWindowCallback callback) {
+  std::lock_guard<std::mutex> lock(mCallbackMutex);
+  mActiveWindowCallback = std::move(callback);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::setWindowsCallback(WindowsCallback callback) {
+  std::lock_guard<std::mutex> lock(mCallbackMutex);
+  mWindowsCallback = std::move(callback);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::run() {
+  while (mRunning) {
+
+    // (Re-)Connect to the X server if necessary. If this fails, we wait a bit and try
+    // again. The wakeup fd interrupts the waiting if the thread should stop.
+    if (!mSynced && !sync()) {
+      pollfd pfd = {.fd = mWakeupFd, .events = POLLIN};
+      poll(&pfd, 1, RECONNECT_INTERVAL);
+      continue;
+    }
+
+    xcb_connection_t* xcb = mConnection.getXCB();
+
+    // First, we process all pending events. The handlers only mark things as dirty.
+    xcb_generic_event_t* event = xcb_poll_for_event(xcb);
+    if (event) {
+      handleEvent(event);
+      free(event);
+      continue;
+    }
+
+    // Then we query everything which has changed in as few batches as possible. As this
+    // may read new events from the socket, we start over afterwards.
+    if (mClientListDirty || mStackingDirty || mActiveWindowDirty || mResourcesDirty ||
+        mMonitorsDirty || mXSettingsDirty || !mDirtyWindows.empty()) {
+      if (mClientListDirty) {
+        updateClientList();
+      }
+
+      if (mStackingDirty) {
+        updateStackingOrder();
+      }
+
+      if (mActiveWindowDirty) {
+        updateActiveWindow();
+      }
+
+      if (mResourcesDirty) {
+        updateScalingFactor();
+      }
+
+      if (mMonitorsDirty) {
+        updateMonitors();
+      }
+
+      if (mXSettingsDirty) {
+        updateXSettings();
+      }
+
+      updateDirtyWindows();
+      continue;
+    }
+
+    if (xcb_connection_has_error(xcb)) {
+      mSynced = false;
+      continue;
+    }
+
+    // Once everything has settled, we tell the world about the changes.
+    notify();
+
+    // Finally, we sleep until something happens.
+    pollfd fds[2] = {
+        {.fd = xcb_get_file_descriptor(xcb), .events = POLLIN},
+        {.fd = mWakeupFd, .events = POLLIN},
+    };
+
+    poll(fds, 2, -1);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool WindowTable::sync() {
+  Display* display = mConnection.get();
+  if (!display) {
+    return false;
+  }
+
+  // We read all events using XCB.
+  XSetEventQueueOwner(display, XCBOwnsEventQueue);
+
+  xcb_connection_t* xcb = mConnection.getXCB();
+
+  // The structure notify mask is required for the MANAGER client messages which announce
+  // a new XSETTINGS manager.
+  uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+  xcb_change_window_attributes(xcb, mConnection.getRoot(), XCB_CW_EVENT_MASK, &mask);
+
+  mScreenChangeEvent = selectScreenChangeEvents(display, mConnection.getRoot());
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mClients.clear();
+    mStacking.clear();
+    mFocusHistory.clear();
+    mWindows.clear();
+    mIconSerials.clear();
+    mActiveWindow = None;
+  }
+
+  mDirtyWindows.clear();
+  mXSettingsOwner = None;
+  updateClientList();
+  updateStackingOrder();
+  updateActiveWindow();
+  updateScalingFactor();
+  updateMonitors();
+  updateXSettings();
+  updateDirtyWindows();
+
+  // After a reconnect, the windows may have changed in the meantime.
+  mWindowsChanged = true;
+
+  mSynced = !xcb_connection_has_error(xcb);
+
+  return mSynced;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::handleEvent(xcb_generic_event_t* event) {
+  int type = event->response_type & ~0x80;
+
+  if (type == mScreenChangeEvent) {
+    mMonitorsDirty = true;
+    return;
+  }
+
+  if (type == XCB_CONFIGURE_NOTIFY) {
+    auto* configure = reinterpret_cast<xcb_configure_notify_event_t*>(event);
+
+    if (mWindows.count(configure->window) == 0) {
+      return;
+    }
+
+    // Reparenting window managers send a synthetic event with the position relative to
+    // the root window whenever they move the frame. Real events are relative to the
+    // parent, so in this case we query the translated geometry again.
+    if (event->response_type & 0x80) {
+      std::lock_guard<std::mutex> lock(mMutex);
+
+      WindowInfo& info = mWindows.at(configure->window);
+      info.geometry    = {
+          configure->x, configure->y, configure->width, configure->height};
+
+      if (updateWindowMonitor(info)) {
+        mWindowsChanged = true;
+      }
+    } else {
+      mDirtyWindows.insert(configure->window);
+    }
+
+    return;
+  }
+
+  // Minimized windows and windows on other desktops are usually unmapped by the window
+  // manager. The mapping state is not reported to the callbacks, so we only store it.
+  if (type == XCB_MAP_NOTIFY || type == XCB_UNMAP_NOTIFY) {
+    Window window = type == XCB_MAP_NOTIFY
+                        ? reinterpret_cast<xcb_map_notify_event_t*>(event)->window
+                        : reinterpret_cast<xcb_unmap_notify_event_t*>(event)->window;
+
+    if (mWindows.count(window)) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mWindows.at(window).mapped = type == XCB_MAP_NOTIFY;
+    }
+
+    return;
+  }
+
+  Atoms const& atoms = mConnection.getAtoms();
+
+  // A new XSETTINGS manager announces itself with a MANAGER client message. If the
+  // current one exits, its window is destroyed.
+  if (type == XCB_CLIENT_MESSAGE) {
+    auto* message = reinterpret_cast<xcb_client_message_event_t*>(event);
+    if (message->type == atoms.manager &&
+        message->data.data32[1] == atoms.xsettingsSelection) {
+      mXSettingsDirty = true;
+    }
+    return;
+  }
+
+  if (type == XCB_DESTROY_NOTIFY) {
+    auto* destroy = reinterpret_cast<xcb_destroy_notify_event_t*>(event);
+    if (destroy->window != None && destroy->window == mXSettingsOwner) {
+      mXSettingsDirty = true;
+    }
+    return;
+  }
+
+  // Errors have a response type of zero. They usually occur if a window has been
+  // destroyed before we could select events on it. We can safely ignore them.
+  if (type != XCB_PROPERTY_NOTIFY) {
+    return;
+  }
+
+  auto* notify = reinterpret_cast<xcb_property_notify_event_t*>(event);
+
+  if (notify->window != None && notify->window == mXSettingsOwner) {
+    if (notify->atom == atoms.xsettingsSettings) {
+      mXSettingsDirty = true;
+    }
+    return;
+  }
+
+  if (notify->window == mConnection.getRoot()) {
+    if (notify->atom == atoms.netClientList) {
+      mClientListDirty = true;
+    } else if (notify->atom == atoms.netClientListStacking) {
+      mStackingDirty = true;
+    } else if (notify->atom == atoms.netActiveWindow) {
+      mActiveWindowDirty = true;
+    } else if (notify->atom == XCB_ATOM_RESOURCE_MANAGER) {
+      mResourcesDirty = true;
+    } else if (notify->atom == atoms.netWorkarea ||
+               notify->atom == atoms.netCurrentDesktop) {
+      mMonitorsDirty = true;
+    }
+
+    return;
+  }
+
+  // The event thread is the only one which modifies mWindows, so we do not need to lock
+  // the mutex for reading here.
+  if (mWindows.count(notify->window) == 0) {
+    return;
+  }
+
+  if (notify->atom == XCB_ATOM_WM_CLASS || notify->atom == XCB_ATOM_WM_NAME ||
+      notify->atom == atoms.netWmName || notify->atom == atoms.netWmDesktop ||
+      notify->atom == atoms.netWmPid || notify->atom == atoms.netWmState ||
+      notify->atom == atoms.netFrameExtents) {
+    mDirtyWindows.insert(notify->window);
+  } else if (notify->atom == atoms.netWmIcon) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mIconSerials[notify->window] = mNextIconSerial++;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::updateClientList() {
+  mClientListDirty = false;
+
+  xcb_connection_t*   xcb     = mConnection.getXCB();
+  std::vector<Window> clients = queryClientList(mConnection);
+
+  // We start listening to property changes and movements of new windows before we query
+  // their properties. This way, we cannot miss any change.
+  uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+  for (Window window : clients) {
+    if (mWindows.count(window) == 0) {
+      xcb_change_window_attributes(xcb, window, XCB_CW_EVENT_MASK, &mask);
+      mDirtyWindows.insert(window);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (clients != mClients) {
+    mWindowsChanged = true;
+  }
+
+  std::unordered_map<Window, WindowInfo> windows;
+  std::unordered_map<Window, uint64_t>   iconSerials;
+  for (Window window : clients) {
+    auto it = mWindows.find(window);
+    if (it != mWindows.end()) {
+      windows.emplace(window, std::move(it->second));
+      iconSerials.emplace(window, mIconSerials[window]);
+    } else {
+      WindowInfo info;
+      info.id = window;
+      windows.emplace(window, info);
+      iconSerials.emplace(window, mNextIconSerial++);
+    }
+  }
+
+  mClients     = std::move(clients);
+  mWindows     = std::move(windows);
+  mIconSerials = std::move(iconSerials);
+
+  mFocusHistory.erase(std::remove_if(mFocusHistory.begin(), mFocusHistory.end(),
+                          [&](Window window) { return mWindows.count(window) == 0; }),
+      mFocusHistory.end());
+
+  // Forget about windows which are not in the list anymore.
+  for (auto it = mDirtyWindows.begin(); it != mDirtyWindows.end();) {
+    it = mWindows.count(*it) ? std::next(it) : mDirtyWindows.erase(it);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::updateDirtyWindows() {
+  if (mDirtyWindows.empty()) {
+    return;
+  }
+
+  std::vector<Window> windows(mDirtyWindows.begin(), mDirtyWindows.end());
+  mDirtyWindows.clear();
+
+  std::vector<WindowInfo> infos = queryWindowInfos(mConnection, windows);
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (auto& info : infos) {
+    auto it = mWindows.find(info.id);
+    if (it == mWindows.end()) {
+      continue;
+    }
+
+    // The geometry is always stored, but only other changes are reported.
+    updateWindowMonitor(info);
+
+    if (!isSameWindow(it->second, info)) {
+      mWindowsChanged = true;
+    }
+
+    it->second = std::move(info);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::updateStackingOrder() {
+  mStackingDirty = false;
+
+  std::vector<Window> stacking = queryStackingOrder(mConnection);
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (stacking != mStacking) {
+    mStacking       = std::move(stacking);
+    mWindowsChanged = true;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::updateActiveWindow() {
+  mActiveWindowDirty = false;
+
+  Window activeWindow = queryActiveWindow(mConnection);
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mActiveWindow = activeWindow;
+
+  // Only client windows are part of the focus history.
+  if (mWindows.count(activeWindow) &&
+      (mFocusHistory.empty() || mFocusHistory.front() != activeWindow)) {
+    mFocusHistory.erase(
+        std::remove(mFocusHistory.begin(), mFocusHistory.end(), activeWindow),
+        mFocusHistory.end());
+    mFocusHistory.insert(mFocusHistory.begin(), activeWindow);
+    mWindowsChanged = true;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool WindowTable::updateWindowMonitor(WindowInfo& info) const {
+  Rect const&    geometry = info.geometry;
+  Monitor const* monitor  = mMonitors.find(
+      geometry.x + geometry.width / 2, geometry.y + geometry.height / 2);
+
+  int index = monitor ? int(monitor - mMonitors.getMonitors().data()) : -1;
+  if (index == info.monitor) {
+    return false;
+  }
+
+  info.monitor = index;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::updateScalingFactor() {
+  mResourcesDirty = false;
+
+  double scalingFactor = parseScalingFactor(queryResources(mConnection));
+
+  // The monitors store the scaling factor as well.
+  if (scalingFactor != mScalingFactor) {
+    mScalingFactor = scalingFactor;
+    mMonitorsDirty = true;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::updateMonitors() {
+  mMonitorsDirty = false;
+
+  std::vector<Monitor> monitors       = queryMonitors(mConnection, mScalingFactor);
+  uint32_t             currentDesktop = queryCurrentDesktop(mConnection);
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mMonitors.build(std::move(monitors));
+  mCurrentDesktop = currentDesktop;
+
+  for (auto& [window, info] : mWindows) {
+    if (updateWindowMonitor(info)) {
+      mWindowsChanged = true;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::updateXSettings() {
+  mXSettingsDirty = false;
+
+  // We start listening to the new manager before reading its settings. This way, we
+  // cannot miss any change.
+  Window owner = queryXSettingsOwner(mConnection);
+  if (owner != None && owner != mXSettingsOwner) {
+    uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+    xcb_change_window_attributes(mConnection.getXCB(), owner, XCB_CW_EVENT_MASK, &mask);
+  }
+
+  mXSettingsOwner = owner;
+
+  std::optional<std::string> iconTheme;
+  if (owner != None) {
+    std::optional<XSettings> settings = queryXSettings(mConnection, owner);
+    if (settings) {
+      iconTheme = settings->getString("Net/IconThemeName");
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mIconTheme = std::move(iconTheme);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowTable::notify() {
+  WindowInfo activeWindow        = getActiveWindow();
+  bool       activeWindowChanged = !isSameWindow(activeWindow, mNotifiedActiveWindow);
+
+  if (!mWindowsChanged && !activeWindowChanged) {
+    return;
+  }
+
+  std::vector<WindowInfo> windows;
+  if (mWindowsChanged) {
+    windows = getWindows();
+  }
+
+  std::lock_guard<std::mutex> lock(mCallbackMutex);
+
+  if (mWindowsChanged && mWindowsCallback) {
+    mWindowsCallback(windows);
+  }
+
+  if (activeWindowChanged && mActiveWindowCallback) {
+    mActiveWindowCallback(activeWindow);
+  }
+
+  mWindowsChanged       = false;
+  mNotifiedActiveWindow = std::move(activeWindow);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,238 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef WINDOW_TABLE_HPP
+#define WINDOW_TABLE_HPP
+
+#include "Connection.hpp"
+#include "MonitorIndex.hpp"
+#include "WindowQueries.hpp"
+
+#include <xcb/xcb.h>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * This class keeps an in-memory table of all client windows. It runs a background thread
+ * with its own connection to the X server which listens for PropertyNotify events on the
+ * root window's _NET_CLIENT_LIST and on the WM_CLASS, _NET_WM_NAME, WM_NAME,
+ * _NET_WM_DESKTOP, _NET_WM_PID, and _NET_WM_STATE properties of each client. Whenever
+ * something changes, only the affected windows are queried again. The position of each
+ * client is taken from the synthetic ConfigureNotify events which window managers send
+ * when they move a frame. MapNotify and UnmapNotify keep track of which clients are
+ * visible and _NET_FRAME_EXTENTS gives the size of their decorations.
+ *
+ * This way, listing the open windows is a simple copy of the cached data and does not
+ * require any round trip to the X server. Similarly, the window under the pointer can be
+ * found by testing the cached frames in stacking order.
+ *
+ * Besides the windows, the event thread caches the DPI scaling factor which is derived
+ * from the Xft.dpi entry of the RESOURCE_MANAGER property of the root window. It is only
+ * parsed again if that property changes. Similarly, it keeps an index of all monitors and
+ * their work areas which is rebuilt on RRScreenChangeNotify or if _NET_WORKAREA or
+ * _NET_CURRENT_DESKTOP change.
+ *
+ * If an XSETTINGS manager owns the _XSETTINGS_S<n> selection, the event thread also reads
+ * Net/IconThemeName from its _XSETTINGS_SETTINGS property. It follows changes of the
+ * property and of the selection owner, so the icon theme can be read without spawning
+ * any process.
+ *
+ * For each client, the table counts changes of _NET_WM_ICON. This allows callers to
+ * cache window icons without reading the property again.
+ *
+ * The windows are kept in most-recently-used order. The table remembers the order in
+ * which windows have been activated. Windows which have not been activated since the
+ * table was populated follow in the order of _NET_CLIENT_LIST_STACKING, top-most first.
+ *
+ * The table also follows _NET_ACTIVE_WINDOW. Interested parties can register callbacks
+ * which are called whenever the active window or the list of windows changes. Both are
+ * called from the event thread, once after the table has been populated and then after
+ * each batch of changes.
+ */
+class WindowTable {
+ public:
+  WindowTable() = default;
+  ~WindowTable();
+
+  WindowTable(WindowTable const& other)            = delete;
+  WindowTable& operator=(WindowTable const& other) = delete;
+
+  /** Starts the event thread. Does nothing if it is already running. */
+  void start();
+
+  /** Stops the event thread and waits for it to finish. */
+  void stop();
+
+  /**
+   * Returns true once the event thread has connected to the X server and populated the
+   * table. As long as this returns false, callers should query the X server directly.
+   */
+  bool isSynced() const;
+
+  /** Returns a copy of all client windows in most-recently-used order. */
+  std::vector<WindowInfo> getWindows() const;
+
+  /** Returns a copy of the given client window. This is a constant-time lookup. */
+  std::optional<WindowInfo> getWindow(Window window) const;
+
+  /**
+   * Returns a copy of the currently active window. If there is no active window or if it
+   * is not a client window, the returned info has empty names.
+   */
+  WindowInfo getActiveWindow() const;
+
+  /**
+   * Returns the cached DPI scaling factor. This is a simple memory read and is always
+   * up to date once isSynced() returns true.
+   */
+  double getScalingFactor() const;
+
+  /**
+   * Returns the monitor at the given position in physical pixels. If the position is not
+   * on any monitor, the closest one is returned. This is a constant-time lookup in the
+   * monitor index.
+   */
+  std::optional<Monitor> findMonitor(int x, int y) const;
+
+  /**
+   * Returns the top-most client window whose frame contains the given position in
+   * physical pixels. Windows which are unmapped, minimized, or on another desktop are
+   * skipped. The windows are tested in the order of _NET_CLIENT_LIST_STACKING; if the
+   * window manager does not publish it, the order of _NET_CLIENT_LIST is used instead.
+   * This does not require any round trip to the X server.
+   */
+  std::optional<WindowInfo> findWindowAt(int x, int y) const;
+
+  /** Returns a copy of all monitors. */
+  std::vector<Monitor> getMonitors() const;
+
+  /**
+   * Returns the Net/IconThemeName published by the XSETTINGS manager. This is a simple
+   * memory read. Returns nothing if no XSETTINGS manager is running, if it does not
+   * publish an icon theme, or if the table is not synced.
+   */
+  std::optional<std::string> getIconTheme() const;
+
+  /**
+   * Returns a serial number which changes whenever the _NET_WM_ICON property of the given
+   * window changes. Returns nothing if the window is not a client window or if the table
+   * is not synced.
+   */
+  std::optional<uint64_t> getIconSerial(Window window) const;
+
+  using ActiveWindowCallback = std::function<void(WindowInfo const&)>;
+  using WindowsCallback      = std::function<void(std::vector<WindowInfo> const&)>;
+
+  /**
+   * Sets the callback which is called from the event thread whenever the active window
+   * or the title of the active window changes. Pass an empty function to remove the
+   * callback. Once this returns, the previous callback will not be called anymore.
+   */
+  void setActiveWindowCallback(ActiveWindowCallback callback);
+
+  /**
+   * Sets the callback which is called from the event thread whenever a window is added,
+   * removed, or changed. Pass an empty function to remove the callback. Once this
+   * returns, the previous callback will not be called anymore.
+   */
+  void setWindowsCallback(WindowsCallback callback);
+
+ private:
+  void run();
+
+  // Connects to the X server (if necessary), selects the events on the root window and
+  // reads the complete client list.
+  bool sync();
+
+  void handleEvent(xcb_generic_event_t* event);
+
+  // Reads _NET_CLIENT_LIST again, starts listening to newly added windows and removes
+  // windows which are not in the list anymore.
+  void updateClientList();
+
+  // Queries all windows in mDirtyWindows in one batch and stores the results.
+  void updateDirtyWindows();
+
+  // Reads _NET_CLIENT_LIST_STACKING again.
+  void updateStackingOrder();
+
+  // Reads _NET_ACTIVE_WINDOW again and moves it to the front of the focus history.
+  void updateActiveWindow();
+
+  // Stores the index of the monitor containing the center of the given window. Returns
+  // true if it changed. Must be called with mMutex locked.
+  bool updateWindowMonitor(WindowInfo& info) const;
+
+  // Reads RESOURCE_MANAGER again and parses the scaling factor.
+  void updateScalingFactor();
+
+  // Queries the monitors and their work areas and rebuilds the monitor index. This also
+  // reads _NET_CURRENT_DESKTOP again.
+  void updateMonitors();
+
+  // Looks up the owner of the XSETTINGS selection, starts listening to it, and reads the
+  // icon theme from its settings.
+  void updateXSettings();
+
+  // Calls the callbacks if something changed since the last call.
+  void notify();
+
+  Connection  mConnection;
+  std::thread mThread;
+
+  // This eventfd is used to wake up the event thread when it should stop.
+  int               mWakeupFd = -1;
+  std::atomic<bool> mRunning  = false;
+  std::atomic<bool> mSynced   = false;
+
+  std::atomic<double> mScalingFactor = 1.0;
+
+  // These are only accessed from the event thread.
+  std::unordered_set<Window> mDirtyWindows;
+  bool                       mClientListDirty   = false;
+  bool                       mStackingDirty     = false;
+  bool                       mActiveWindowDirty = false;
+  bool                       mResourcesDirty    = false;
+  bool                       mMonitorsDirty     = false;
+  bool                       mXSettingsDirty    = false;
+  Window                     mXSettingsOwner    = None;
+  int                        mScreenChangeEvent = -1;
+  bool                       mWindowsChanged    = false;
+  WindowInfo                 mNotifiedActiveWindow;
+
+  // These are protected by mMutex as they are read from the main thread.
+  mutable std::mutex                     mMutex;
+  std::vector<Window>                    mClients;
+  std::vector<Window>                    mStacking;
+  std::vector<Window>                    mFocusHistory;
+  std::unordered_map<Window, WindowInfo> mWindows;
+  Window                                 mActiveWindow   = None;
+  uint32_t                               mCurrentDesktop = 0xFFFFFFFF;
+  MonitorIndex                           mMonitors;
+  std::unordered_map<Window, uint64_t>   mIconSerials;
+  uint64_t                               mNextIconSerial = 0;
+  std::optional<std::string>             mIconTheme;
+
+  // The callbacks are protected by their own mutex so that they can be called without
+  // blocking readers of the table.
+  std::mutex           mCallbackMutex;
+  ActiveWindowCallback mActiveWindowCallback;
+  WindowsCallback      mWindowsCallback;
+};
+
+#endif // WINDOW_TABLE_HPP
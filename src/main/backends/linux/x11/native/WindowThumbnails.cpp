@@ -0,0 +1,546 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#include "WindowThumbnails.hpp"
+
+#include <xcb/composite.h>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// If the connection to the X server is lost, the capture thread retries after this many
+// milliseconds.
+constexpr int RECONNECT_INTERVAL = 1000;
+
+// A request waits at most this many milliseconds for the capture thread.
+constexpr int CAPTURE_TIMEOUT = 500;
+
+// The cached thumbnails never use more than this many bytes.
+constexpr size_t MAX_MEMORY_USAGE = 32 * 1024 * 1024;
+
+// Windows with a depth of 24 bits have undefined values in the upper byte of each pixel.
+// Windows with a depth of 32 bits store premultiplied colors. scaleImage() expects
+// non-premultiplied ARGB, so we convert the pixels in place.
+void toStraightAlpha(uint32_t* pixels, size_t count, bool hasAlpha) {
+  if (!hasAlpha) {
+    for (size_t i = 0; i < count; ++i) {
+      pixels[i] |= 0xFF000000;
+    }
+
+    return;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t pixel = pixels[i];
+    uint32_t alpha = pixel >> 24;
+
+    if (alpha == 255 || alpha == 0) {
+      continue;
+    }
+
+    uint32_t r = std::min(255u, ((pixel >> 16) & 0xFF) * 255 / alpha);
+    uint32_t g = std::min(255u, ((pixel >> 8) & 0xFF) * 255 / alpha);
+    uint32_t b = std::min(255u, (pixel & 0xFF) * 255 / alpha);
+    pixels[i]  = (alpha << 24) | (r << 16) | (g << 8) | b;
+  }
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+WindowThumbnails::~WindowThumbnails() {
+  stop();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool WindowThumbnails::start() {
+  if (mRunning) {
+    return true;
+  }
+
+  // We connect and check the extensions synchronously so that we can report whether
+  // thumbnails are supported at all.
+  if (!sync()) {
+    return false;
+  }
+
+  mWakeupFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  mRunning  = true;
+  mThread   = std::thread(&WindowThumbnails::run, this);
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowThumbnails::stop() {
+  if (!mRunning) {
+    return;
+  }
+
+  // Wake up any waiting request.
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRunning = false;
+  }
+  mRequestDone.notify_all();
+
+  uint64_t value = 1;
+  write(mWakeupFd, &value, sizeof(value));
+
+  mThread.join();
+
+  close(mWakeupFd);
+  mWakeupFd = -1;
+
+  // The X server should not have to composite the windows for us anymore.
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mSynced) {
+    for (auto const& [window, entry] : mEntries) {
+      untrack(entry);
+    }
+
+    mImageReader.release();
+    xcb_flush(mConnection.getXCB());
+  }
+
+  mEntries.clear();
+  mDamages.clear();
+  mFrames.clear();
+  mMemoryUsage = 0;
+  mSynced      = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool WindowThumbnails::isRunning() const {
+  return mRunning;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::shared_ptr<const Icon>> WindowThumbnails::get(
+    std::vector<Window> const& windows, uint32_t size) {
+
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  ++mClock;
+
+  // If all thumbnails are up to date, this is only a lookup.
+  bool complete = std::all_of(windows.begin(), windows.end(), [&](Window window) {
+    auto it = mEntries.find(window);
+    return it != mEntries.end() && !it->second.dirty && it->second.size == size;
+  });
+
+  // Else we hand the whole batch to the capture thread and wait for it.
+  if (!complete && mRunning) {
+    mRequestedWindows = windows;
+    mRequestedSize    = size;
+    uint64_t serial   = ++mRequestSerial;
+
+    uint64_t value = 1;
+    write(mWakeupFd, &value, sizeof(value));
+
+    mRequestDone.wait_for(lock, std::chrono::milliseconds(CAPTURE_TIMEOUT),
+        [&]() { return mDoneSerial >= serial || !mRunning; });
+  }
+
+  std::vector<std::shared_ptr<const Icon>> thumbnails;
+  thumbnails.reserve(windows.size());
+
+  for (Window window : windows) {
+    auto it = mEntries.find(window);
+    if (it != mEntries.end() && it->second.size == size) {
+      it->second.lastUsed = mClock;
+      thumbnails.push_back(it->second.thumbnail);
+    } else {
+      thumbnails.push_back(nullptr);
+    }
+  }
+
+  return thumbnails;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+size_t WindowThumbnails::getMemoryUsage() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mMemoryUsage;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowThumbnails::run() {
+  while (mRunning) {
+
+    // (Re-)Connect to the X server if necessary. If this fails, we wait a bit and try
+    // again. The wakeup fd interrupts the waiting if the thread should stop.
+    if (!mSynced && !sync()) {
+      pollfd pfd = {.fd = mWakeupFd, .events = POLLIN};
+      poll(&pfd, 1, RECONNECT_INTERVAL);
+      continue;
+    }
+
+    xcb_connection_t* xcb = mConnection.getXCB();
+
+    // First, we process all pending events. The handlers only mark windows as dirty.
+    xcb_generic_event_t* event = xcb_poll_for_event(xcb);
+    if (event) {
+      handleEvent(event);
+      free(event);
+      continue;
+    }
+
+    if (xcb_connection_has_error(xcb)) {
+      mSynced = false;
+      continue;
+    }
+
+    // Then we capture everything which has been requested. As this may read new events
+    // from the socket, we start over afterwards.
+    bool pending;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      pending = mDoneSerial != mRequestSerial;
+    }
+
+    if (pending) {
+      processRequest();
+      continue;
+    }
+
+    // Finally, we sleep until something happens.
+    pollfd fds[2] = {
+        {.fd = xcb_get_file_descriptor(xcb), .events = POLLIN},
+        {.fd = mWakeupFd, .events = POLLIN},
+    };
+
+    poll(fds, 2, -1);
+
+    if (fds[1].revents & POLLIN) {
+      uint64_t value;
+      read(mWakeupFd, &value, sizeof(value));
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool WindowThumbnails::sync() {
+  Display* display = mConnection.get();
+  if (!display) {
+    return false;
+  }
+
+  // We read all events using XCB.
+  XSetEventQueueOwner(display, XCBOwnsEventQueue);
+
+  xcb_connection_t* xcb = mConnection.getXCB();
+
+  // Requests to extensions which are not available would close the connection, so we
+  // have to check them first.
+  if (!xcb_get_extension_data(xcb, &xcb_composite_id)->present ||
+      !xcb_get_extension_data(xcb, &xcb_damage_id)->present) {
+    return false;
+  }
+
+  // Naming the pixmap of a window requires Composite 0.2.
+  auto compositeCookie = xcb_composite_query_version(xcb, 0, 2);
+  auto damageCookie    = xcb_damage_query_version(xcb, 1, 1);
+
+  auto* composite = xcb_composite_query_version_reply(xcb, compositeCookie, nullptr);
+  auto* damage    = xcb_damage_query_version_reply(xcb, damageCookie, nullptr);
+
+  bool supported = composite && damage &&
+                   (composite->major_version > 0 || composite->minor_version >= 2);
+
+  free(composite);
+  free(damage);
+
+  if (!supported) {
+    return false;
+  }
+
+  // The windows of a previous connection have been released by the X server.
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.clear();
+    mMemoryUsage = 0;
+  }
+
+  mDamages.clear();
+  mFrames.clear();
+
+  mImageReader.reset(xcb);
+  mDamageEvent = xcb_get_extension_data(xcb, &xcb_damage_id)->first_event;
+
+  mSynced = !xcb_connection_has_error(xcb);
+
+  return mSynced;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowThumbnails::handleEvent(xcb_generic_event_t* event) {
+  int type = event->response_type & ~0x80;
+
+  // The content of a window changed. We will capture it again on the next request.
+  if (type == mDamageEvent + XCB_DAMAGE_NOTIFY) {
+    auto* notify = reinterpret_cast<xcb_damage_notify_event_t*>(event);
+    auto  damage = mDamages.find(notify->damage);
+    if (damage == mDamages.end()) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto entry = mEntries.find(damage->second);
+    if (entry != mEntries.end()) {
+      entry->second.dirty = true;
+    }
+
+    return;
+  }
+
+  // If a frame is destroyed, its Damage object is destroyed as well.
+  if (type == XCB_DESTROY_NOTIFY) {
+    auto* notify = reinterpret_cast<xcb_destroy_notify_event_t*>(event);
+    auto  frame  = mFrames.find(notify->window);
+    if (frame == mFrames.end()) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto entry = mEntries.find(frame->second);
+    if (entry != mEntries.end()) {
+      if (entry->second.thumbnail) {
+        mMemoryUsage -= entry->second.thumbnail->rgba.size();
+      }
+
+      mDamages.erase(entry->second.damage);
+      mEntries.erase(entry);
+    }
+
+    mFrames.erase(frame);
+  }
+
+  // Errors have a response type of zero. They usually occur if a window has been
+  // destroyed before we could capture it. We can safely ignore them.
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowThumbnails::processRequest() {
+  xcb_connection_t* xcb = mConnection.getXCB();
+
+  std::vector<Window> windows;
+  uint32_t            size;
+  uint64_t            serial;
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    windows = mRequestedWindows;
+    size    = mRequestedSize;
+    serial  = mRequestSerial;
+  }
+
+  for (Window window : windows) {
+
+    // The capture thread is the only one which adds or removes entries, so we do not
+    // need to lock the mutex for reading here.
+    auto it = mEntries.find(window);
+
+    if (it == mEntries.end()) {
+      Entry entry;
+      if (!track(window, entry)) {
+        continue;
+      }
+
+      std::lock_guard<std::mutex> lock(mMutex);
+      it = mEntries.emplace(window, entry).first;
+    }
+
+    if (!it->second.dirty && it->second.size == size) {
+      continue;
+    }
+
+    // We re-arm the Damage object before reading the content. This way, we cannot miss
+    // any change which happens while we are capturing.
+    xcb_damage_subtract(xcb, it->second.damage, XCB_NONE, XCB_NONE);
+
+    std::shared_ptr<const Icon> thumbnail = capture(it->second.frame, size);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    it->second.dirty    = false;
+    it->second.lastUsed = mClock;
+
+    // Unmapped windows cannot be captured. If there is a thumbnail of the requested size
+    // from the time when the window was still visible, we keep it.
+    if (!thumbnail && it->second.size == size) {
+      continue;
+    }
+
+    if (it->second.thumbnail) {
+      mMemoryUsage -= it->second.thumbnail->rgba.size();
+    }
+
+    if (thumbnail) {
+      mMemoryUsage += thumbnail->rgba.size();
+    }
+
+    it->second.thumbnail = thumbnail;
+    it->second.size      = size;
+  }
+
+  enforceMemoryCap();
+  xcb_flush(xcb);
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDoneSerial = serial;
+  }
+
+  mRequestDone.notify_all();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool WindowThumbnails::track(Window window, Entry& entry) {
+  xcb_connection_t* xcb = mConnection.getXCB();
+
+  // Reparenting window managers put each client into a frame window. Only top-level
+  // windows can be redirected, so we walk up the tree until we reach a child of the root
+  // window.
+  xcb_window_t frame = window;
+  while (true) {
+    auto* tree = xcb_query_tree_reply(xcb, xcb_query_tree(xcb, frame), nullptr);
+    if (!tree) {
+      return false;
+    }
+
+    xcb_window_t parent = tree->parent;
+    xcb_window_t root   = tree->root;
+    free(tree);
+
+    if (parent == root || parent == XCB_NONE) {
+      break;
+    }
+
+    frame = parent;
+  }
+
+  // We want to know when the frame is destroyed.
+  uint32_t mask = XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+  xcb_change_window_attributes(xcb, frame, XCB_CW_EVENT_MASK, &mask);
+
+  // Automatic redirection keeps the content of the frame in an off-screen pixmap even if
+  // it is covered. If a compositing manager redirected it already, this changes nothing.
+  xcb_composite_redirect_window(xcb, frame, XCB_COMPOSITE_REDIRECT_AUTOMATIC);
+
+  entry.frame  = frame;
+  entry.damage = xcb_generate_id(xcb);
+  xcb_damage_create(xcb, entry.damage, frame, XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+
+  mDamages[entry.damage] = window;
+  mFrames[frame]         = window;
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowThumbnails::untrack(Entry const& entry) {
+  xcb_connection_t* xcb = mConnection.getXCB();
+
+  xcb_damage_destroy(xcb, entry.damage);
+  xcb_composite_unredirect_window(xcb, entry.frame, XCB_COMPOSITE_REDIRECT_AUTOMATIC);
+
+  mDamages.erase(entry.damage);
+  mFrames.erase(entry.frame);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const Icon> WindowThumbnails::capture(xcb_window_t frame, uint32_t size) {
+  xcb_connection_t* xcb = mConnection.getXCB();
+
+  auto* geometry = xcb_get_geometry_reply(xcb, xcb_get_geometry(xcb, frame), nullptr);
+  if (!geometry) {
+    return nullptr;
+  }
+
+  uint8_t  depth  = geometry->depth;
+  uint16_t width  = geometry->width;
+  uint16_t height = geometry->height;
+  uint16_t border = geometry->border_width;
+  free(geometry);
+
+  // We only support the usual 32-bit BGRA pixel layout.
+  if ((depth != 24 && depth != 32) || bitsPerPixel(xcb, depth) != 32 ||
+      xcb_get_setup(xcb)->image_byte_order != XCB_IMAGE_ORDER_LSB_FIRST) {
+    return nullptr;
+  }
+
+  // This fails if the frame is not viewable.
+  xcb_pixmap_t         pixmap = xcb_generate_id(xcb);
+  xcb_generic_error_t* error  = xcb_request_check(
+      xcb, xcb_composite_name_window_pixmap_checked(xcb, frame, pixmap));
+  if (error) {
+    free(error);
+    return nullptr;
+  }
+
+  // The pixmap includes the border of the frame.
+  uint32_t* pixels = mImageReader.read(pixmap, border, border, width, height);
+
+  xcb_free_pixmap(xcb, pixmap);
+
+  std::shared_ptr<const Icon> thumbnail;
+
+  if (pixels) {
+    toStraightAlpha(pixels, size_t(width) * height, depth == 32);
+    thumbnail = scaleImage(pixels, width, height, size);
+  }
+
+  return thumbnail;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void WindowThumbnails::enforceMemoryCap() {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  while (mMemoryUsage > MAX_MEMORY_USAGE) {
+    auto oldest = std::min_element(mEntries.begin(), mEntries.end(),
+        [](auto const& a, auto const& b) {
+          return a.second.thumbnail && (!b.second.thumbnail ||
+                                           a.second.lastUsed < b.second.lastUsed);
+        });
+
+    mMemoryUsage -= oldest->second.thumbnail->rgba.size();
+    untrack(oldest->second);
+    mEntries.erase(oldest);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
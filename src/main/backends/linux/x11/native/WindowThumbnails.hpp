@@ -0,0 +1,141 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef WINDOW_THUMBNAILS_HPP
+#define WINDOW_THUMBNAILS_HPP
+
+#include "Connection.hpp"
+#include "ImageReader.hpp"
+#include "WindowIcons.hpp"
+
+#include <xcb/damage.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * This class captures downscaled thumbnails of client windows. It runs a thread with its
+ * own connection to the X server. When a thumbnail is requested for the first time, the
+ * top-level frame of the window is redirected with XComposite so that its content is
+ * available even if it is covered by other windows. The content is then read from the
+ * pixmap of the frame over MIT-SHM (or with a plain GetImage if shared memory is not
+ * available) and scaled down with the same box filter as window icons.
+ *
+ * For each captured window, a Damage object reports when its content changes. Until
+ * that happens, requesting the thumbnail again is a simple lookup in the cache. If
+ * nothing has to be captured, no round trip to the X server is required at all.
+ *
+ * The memory used by the cached thumbnails is capped. If the cap is exceeded, the least
+ * recently requested windows are dropped from the cache and are not tracked anymore.
+ */
+class WindowThumbnails {
+ public:
+  WindowThumbnails() = default;
+  ~WindowThumbnails();
+
+  WindowThumbnails(WindowThumbnails const& other)            = delete;
+  WindowThumbnails& operator=(WindowThumbnails const& other) = delete;
+
+  /**
+   * Connects to the X server and starts the capture thread. Returns false if this fails,
+   * for instance because the X server does not support the Composite or the Damage
+   * extension. Does nothing if the thread is already running.
+   */
+  bool start();
+
+  /** Stops the capture thread, releases all windows, and clears the cache. */
+  void stop();
+
+  /** Returns true if the capture thread is running. */
+  bool isRunning() const;
+
+  /**
+   * Returns the thumbnails of the given windows, scaled so that their larger side is at
+   * most the given size. Windows which have not changed since the last request are served
+   * from the cache. All others are captured in one batch by the capture thread. This
+   * waits at most half a second for the batch; windows which have not been captured
+   * until then get their previous thumbnail. The result contains nullptr for windows
+   * which could not be captured, for instance because they have never been mapped.
+   */
+  std::vector<std::shared_ptr<const Icon>> get(
+      std::vector<Window> const& windows, uint32_t size);
+
+  /** Returns the number of bytes used by all cached thumbnails. */
+  size_t getMemoryUsage() const;
+
+ private:
+  struct Entry {
+    xcb_window_t                frame  = XCB_NONE;
+    xcb_damage_damage_t         damage = XCB_NONE;
+    bool                        dirty  = true;
+    uint32_t                    size   = 0;
+    std::shared_ptr<const Icon> thumbnail;
+    uint64_t                    lastUsed = 0;
+  };
+
+  void run();
+
+  // Connects to the X server (if necessary) and checks for the required extensions.
+  bool sync();
+
+  void handleEvent(xcb_generic_event_t* event);
+
+  // Captures all windows of the pending request which are not up to date.
+  void processRequest();
+
+  // Finds the frame of the given client, redirects it and creates a Damage object for
+  // it. Returns false if the window does not exist anymore.
+  bool track(Window window, Entry& entry);
+
+  // Destroys the Damage object of the given entry and stops redirecting its frame.
+  void untrack(Entry const& entry);
+
+  // Reads the content of the given frame and scales it down.
+  std::shared_ptr<const Icon> capture(xcb_window_t frame, uint32_t size);
+
+  // Drops the least recently used entries until the memory cap is met.
+  void enforceMemoryCap();
+
+  Connection  mConnection;
+  std::thread mThread;
+
+  // This eventfd is used to wake up the capture thread when it should stop or when there
+  // is a new request.
+  int               mWakeupFd = -1;
+  std::atomic<bool> mRunning  = false;
+  std::atomic<bool> mSynced   = false;
+
+  // These are only accessed from the capture thread.
+  int         mDamageEvent = -1;
+  ImageReader mImageReader;
+
+  std::unordered_map<xcb_damage_damage_t, Window> mDamages;
+  std::unordered_map<xcb_window_t, Window>        mFrames;
+
+  // These are protected by mMutex. The entries are only modified by the capture thread,
+  // so it can read them without locking.
+  mutable std::mutex                mMutex;
+  std::condition_variable           mRequestDone;
+  std::unordered_map<Window, Entry> mEntries;
+  std::vector<Window>               mRequestedWindows;
+  uint32_t                          mRequestedSize = 0;
+  uint64_t                          mRequestSerial = 0;
+  uint64_t                          mDoneSerial    = 0;
+  uint64_t                          mClock         = 0;
+  size_t                            mMemoryUsage   = 0;
+};
+
+#endif // WINDOW_THUMBNAILS_HPP
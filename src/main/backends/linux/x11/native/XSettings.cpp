@@ -0,0 +1,150 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+
+#include "XSettings.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The setting types as defined by the specification.
+constexpr uint8_t TYPE_INTEGER = 0;
+constexpr uint8_t TYPE_STRING  = 1;
+constexpr uint8_t TYPE_COLOR   = 2;
+
+// The byte order as given in the first byte of the data.
+constexpr uint8_t MSB_FIRST = 1;
+
+// Reads the data front to back. Once a read goes beyond the end, all further reads fail
+// as well.
+class Reader {
+ public:
+  Reader(uint8_t const* data, size_t length)
+      : mData(data)
+      , mLength(length) {
+  }
+
+  void setBigEndian(bool bigEndian) {
+    mBigEndian = bigEndian;
+  }
+
+  bool failed() const {
+    return mFailed;
+  }
+
+  uint8_t const* take(size_t count) {
+    if (mFailed || mLength - mOffset < count) {
+      mFailed = true;
+      return nullptr;
+    }
+
+    uint8_t const* result = mData + mOffset;
+    mOffset += count;
+    return result;
+  }
+
+  // Skips the padding which aligns the given number of bytes to four.
+  void pad(size_t count) {
+    take((4 - count % 4) % 4);
+  }
+
+  uint32_t readUnsigned(size_t bytes) {
+    uint8_t const* data = take(bytes);
+    if (!data) {
+      return 0;
+    }
+
+    uint32_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+      size_t shift = mBigEndian ? (bytes - 1 - i) * 8 : i * 8;
+      value |= uint32_t(data[i]) << shift;
+    }
+
+    return value;
+  }
+
+  std::string readString(size_t length) {
+    uint8_t const* data = take(length);
+    pad(length);
+    return data ? std::string(reinterpret_cast<const char*>(data), length) : "";
+  }
+
+ private:
+  uint8_t const* mData      = nullptr;
+  size_t         mLength    = 0;
+  size_t         mOffset    = 0;
+  bool           mBigEndian = false;
+  bool           mFailed    = false;
+};
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<std::string> XSettings::getString(std::string const& name) const {
+  auto it = values.find(name);
+  if (it == values.end() || !std::holds_alternative<std::string>(it->second)) {
+    return std::nullopt;
+  }
+
+  return std::get<std::string>(it->second);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<XSettings> parseXSettings(uint8_t const* data, size_t length) {
+  Reader reader(data, length);
+
+  uint8_t const* byteOrder = reader.take(4);
+  if (!byteOrder) {
+    return std::nullopt;
+  }
+
+  reader.setBigEndian(byteOrder[0] == MSB_FIRST);
+
+  XSettings settings;
+  settings.serial = reader.readUnsigned(4);
+  uint32_t count  = reader.readUnsigned(4);
+
+  for (uint32_t i = 0; i < count && !reader.failed(); ++i) {
+    uint8_t type = uint8_t(reader.readUnsigned(1));
+    reader.take(1);
+
+    std::string name = reader.readString(reader.readUnsigned(2));
+
+    // The serial of the last change of this setting.
+    reader.readUnsigned(4);
+
+    if (type == TYPE_INTEGER) {
+      settings.values[name] = int32_t(reader.readUnsigned(4));
+    } else if (type == TYPE_STRING) {
+      settings.values[name] = reader.readString(reader.readUnsigned(4));
+    } else if (type == TYPE_COLOR) {
+      // The channels are stored in the order red, blue, green, alpha.
+      XSettingsColor color;
+      color.red             = uint16_t(reader.readUnsigned(2));
+      color.blue            = uint16_t(reader.readUnsigned(2));
+      color.green           = uint16_t(reader.readUnsigned(2));
+      color.alpha           = uint16_t(reader.readUnsigned(2));
+      settings.values[name] = color;
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  if (reader.failed()) {
+    return std::nullopt;
+  }
+
+  return settings;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
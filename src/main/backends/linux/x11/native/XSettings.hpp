@@ -0,0 +1,52 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+
+#ifndef XSETTINGS_HPP
+#define XSETTINGS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <variant>
+
+/** A color setting. Each channel is given as 16-bit value. */
+struct XSettingsColor {
+  uint16_t red   = 0;
+  uint16_t green = 0;
+  uint16_t blue  = 0;
+  uint16_t alpha = 0;
+};
+
+using XSettingsValue = std::variant<int32_t, std::string, XSettingsColor>;
+
+/**
+ * The settings published by the XSETTINGS manager of a screen, for instance
+ * Net/IconThemeName or Xft/DPI. The manager increments the serial whenever it changes a
+ * setting.
+ */
+struct XSettings {
+  uint32_t                                        serial = 0;
+  std::unordered_map<std::string, XSettingsValue> values;
+
+  /** Returns the given setting if it exists and is a string. Else nothing is returned. */
+  std::optional<std::string> getString(std::string const& name) const;
+};
+
+/**
+ * Parses the content of the _XSETTINGS_SETTINGS property as described in the XSETTINGS
+ * specification. Both byte orders are supported. Returns nothing if the data is
+ * truncated or malformed.
+ */
+std::optional<XSettings> parseXSettings(uint8_t const* data, size_t length);
+
+#endif // XSETTINGS_HPP
@@ -8,12 +8,81 @@
 // SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
 // SPDX-License-Identifier: MIT
 
+/**
+ * An entry of the window table of the native module. The id is the X11 window ID. The
+ * workspace is the _NET_WM_DESKTOP of the window and is omitted for sticky windows. The
+ * monitor is the index of the monitor which contains the center of the window.
+ */
+export type NativeWindow = {
+  app: string;
+  window: string;
+  id: number;
+  workspace?: number;
+  monitor?: number;
+  minimized: boolean;
+};
+
 export type Native = {
   /**
    * This uses XLib calls to get the name and the class of the currently focused
-   * application window, as well as the current pointer position.
+   * application window, as well as the current pointer position. The pointer position is
+   * divided by the scaling factor which is returned as well. If the monitor index of the
+   * native module is ready, the work area of the monitor under the pointer is returned
+   * as well. If the focused window announces its _NET_WM_PID, the executable and the
+   * command line of the process are returned, too. They are cached per process, so /proc
+   * is only read the first time a process is seen. If the monitor index is ready, the app
+   * and the title of the top-most window under the pointer are returned as well. They are
+   * found by testing the cached window frames in stacking order.
+   */
+  getWMInfo(): {
+    app: string;
+    window: string;
+    pointerX: number;
+    pointerY: number;
+    scalingFactor: number;
+    workArea?: { x: number; y: number; width: number; height: number };
+    pid?: number;
+    executable?: string;
+    commandLine?: string[];
+    hoveredApp?: string;
+    hoveredWindow?: string;
+  };
+
+  /**
+   * Returns the DPI scaling factor derived from the Xft.dpi resource. It is cached and
+   * only parsed again when the RESOURCE_MANAGER property of the root window changes.
    */
-  getWMInfo(): { app: string; window: string; pointerX: number; pointerY: number };
+  getScalingFactor(): number;
+
+  /**
+   * Returns the Net/IconThemeName published by the XSETTINGS manager or null if there is
+   * none. The window table of the native module follows the _XSETTINGS_S<n> selection and
+   * the _XSETTINGS_SETTINGS property, so this is usually a simple memory read.
+   */
+  getIconTheme(): string | null;
+
+  /**
+   * Starts or stops a background thread which follows the pointer using XInput2 raw
+   * motion events. While it is running, getWMInfo() does not need to ask the X server for
+   * the pointer position. Returns true if the tracker is running afterwards. This is
+   * false if it was disabled or if the X server does not support XInput 2.1.
+   *
+   * @param enabled Whether the pointer should be tracked.
+   */
+  setPointerTrackingEnabled(enabled: boolean): boolean;
+
+  /**
+   * Returns the last pointer position seen by the pointer tracker in device-independent
+   * pixels, the X server time of the last motion in milliseconds, and the rate at which
+   * the input device has reported motion events in Hz. Returns null if the tracker is not
+   * running or if the pointer has not moved since it was started.
+   */
+  getTrackedPointer(): {
+    pointerX: number;
+    pointerY: number;
+    timestamp: number;
+    sampleRate: number;
+  } | null;
 
   /**
    * This simulates a mouse movement.
@@ -31,11 +100,40 @@ export type Native = {
    */
   simulateKey(keycode: number, down: boolean): void;
 
+  /**
+   * This types the given text into the focused window. The keys are looked up in the
+   * current keyboard layout. Characters which are not part of the layout are typed via a
+   * temporarily assigned spare keycode. All key events are sent at once.
+   *
+   * @param text The text to type.
+   * @returns False if the X server does not support the XKB extension.
+   */
+  simulateText(text: string): boolean;
+
+  /**
+   * This takes ownership of the clipboard and offers the given entries to other clients.
+   * Plain text is additionally offered under the legacy X11 targets like UTF8_STRING.
+   * The requests of other clients are answered by a background thread, so large
+   * payloads are sent incrementally without blocking the main thread.
+   *
+   * @param entries The representations of the content, like text/plain and text/html.
+   * @param primary If true, the PRIMARY selection is set instead of the CLIPBOARD.
+   * @returns False if the selection could not be acquired.
+   */
+  setClipboard(
+    entries: Array<{ mimeType: string; data: string | Buffer }>,
+    primary?: boolean
+  ): boolean;
+
   /**
    * Returns an array of all currently open windows, each with an 'app' (WM_CLASS instance
-   * name) and a 'window' (_NET_WM_NAME title) property.
+   * name) and a 'window' (_NET_WM_NAME title) property. The list is served from a window
+   * table which is kept up to date by listening to property changes, so this does not
+   * require a round trip to the X server. The windows are ordered by recent use: The
+   * focus history recorded by the window table comes first, followed by the remaining
+   * windows in the order of _NET_CLIENT_LIST_STACKING from top to bottom.
    */
-  getOpenWindows(): Array<{ app: string; window: string }>;
+  getOpenWindows(): Array<NativeWindow>;
 
   /**
    * Focuses the window with the given title and app name by sending a _NET_ACTIVE_WINDOW
@@ -43,8 +141,162 @@ export type Native = {
    *
    * @param windowName The _NET_WM_NAME title of the window to focus.
    * @param appName The WM_CLASS instance name of the window to focus.
+   * @param id The ID as returned by getOpenWindows(). If given, the window is looked up
+   *   directly instead of searching for the title.
+   */
+  focusWindow(windowName: string, appName: string, id?: number): void;
+
+  /**
+   * Returns how many connections to the X server the native module has opened. `main` is
+   * the connection which is reused for all calls. It should usually be one and only
+   * increases if the X server dropped the connection. `total` also counts the
+   * connections of the background threads: one for the window table and one for each
+   * feature which has been used, like the shortcuts, the pointer tracking, thumbnails,
+   * the clipboard, or macro recording (two). `open` counts the currently open ones.
+   */
+  getConnectionsOpened(): { main: number; total: number; open: number };
+
+  /**
+   * Registers a callback which is called whenever _NET_ACTIVE_WINDOW or the title of the
+   * active window changes. It is called asynchronously from the background thread which
+   * maintains the window table. The callback receives null if there is no active window.
+   * Call this without a callback to unsubscribe.
+   */
+  onActiveWindowChanged(callback?: (window: NativeWindow | null) => void): void;
+
+  /**
+   * Registers a callback which is called with the same array as returned by
+   * getOpenWindows() whenever a window is opened, closed, renamed, moved to another
+   * monitor, minimized, or restored and whenever the order changes. Call this without a
+   * callback to unsubscribe.
+   */
+  onWindowsChanged(callback?: (windows: Array<NativeWindow>) => void): void;
+
+  /**
+   * Grabs the given shortcuts with XGrabKey. The shortcuts are Electron accelerators like
+   * 'Control+Shift+K'. Each call replaces the previously bound shortcuts, but only the
+   * difference is grabbed or ungrabbed. Returns the shortcuts which could not be bound,
+   * either because they are invalid or because another application uses them already.
+   *
+   * @param shortcuts The shortcuts to bind.
+   */
+  bindShortcuts(shortcuts: string[]): string[];
+
+  /**
+   * While a shortcut is inhibited, its key stays grabbed but presses are not reported to
+   * the callback given to onShortcutEvent() anymore. Releases are still reported.
+   *
+   * @param shortcut The shortcut as passed to bindShortcuts().
+   * @param inhibited Whether presses should be ignored.
+   */
+  setShortcutInhibited(shortcut: string, inhibited: boolean): void;
+
+  /**
+   * Registers a callback which is called whenever a bound shortcut is pressed or
+   * released. A shortcut is released once its key and all of its modifiers have been
+   * released. This works regardless of which window has the input focus. The time is the
+   * X server time of the event in milliseconds. Call this without a callback to
+   * unsubscribe.
+   */
+  onShortcutEvent(
+    callback?: (shortcut: string, pressed: boolean, time: number) => void
+  ): void;
+
+  /**
+   * Returns the _NET_WM_ICON of the given window. The window is found like in
+   * focusWindow(). The icon closest to the given size is picked and scaled down if it is
+   * larger. The pixels are non-premultiplied RGBA. The scaled icons are cached per
+   * window, so repeated calls for an unchanged window do not need to talk to the X
+   * server. Returns null if there is no such window or if it does not have an icon.
+   *
+   * @param windowName The title of the window.
+   * @param appName The app name of the window.
+   * @param size The maximum width and height of the icon in pixels.
+   * @param id The ID as returned by getOpenWindows(). If given, the window is looked up
+   *   directly instead of searching for the title.
+   */
+  getWindowIcon(
+    windowName: string,
+    appName: string,
+    size: number,
+    id?: number
+  ): { width: number; height: number; data: ArrayBuffer } | null;
+
+  /**
+   * Returns thumbnails of the given windows in one batch. On the first call, a background
+   * thread is started which redirects the requested windows with XComposite and reads
+   * their content over MIT-SHM. The thumbnails are cached until XDamage reports a change,
+   * so repeated calls for unchanged windows are cheap. The cache has a fixed memory
+   * limit. Each thumbnail has the same format as the result of getWindowIcon() or is null
+   * if the window does not exist or could not be captured. Returns null if the X server
+   * does not support the Composite and Damage extensions.
+   *
+   * @param windows The windows as returned by getOpenWindows(). They are found like in
+   *   focusWindow().
+   * @param size The maximum width and height of the thumbnails in pixels.
+   */
+  getWindowThumbnails(
+    windows: Array<{ app: string; window: string; id?: number }>,
+    size: number
+  ): Array<{ width: number; height: number; data: ArrayBuffer } | null> | null;
+
+  /**
+   * Reads the given rectangle of the screen and blurs it. Only the rectangle is
+   * transferred from the X server, so the cost depends on its size rather than on the
+   * size of the screen. The result is usually smaller than the rectangle and has to be
+   * scaled up. Returns null if the rectangle is not fully on screen.
+   *
+   * @param x The left edge of the rectangle in physical pixels.
+   * @param y The top edge of the rectangle in physical pixels.
+   * @param width The width of the rectangle in physical pixels.
+   * @param height The height of the rectangle in physical pixels.
+   * @param sigma The standard deviation of the blur in physical pixels.
+   */
+  captureBackdrop(
+    x: number,
+    y: number,
+    width: number,
+    height: number,
+    sigma: number
+  ): { width: number; height: number; data: ArrayBuffer } | null;
+
+  /**
+   * Starts recording all key and pointer button events with the RECORD extension. The
+   * events are collected by a background thread on dedicated connections to the X
+   * server. A previous recording is discarded. Returns false if the X server does not
+   * support the extension.
+   */
+  startMacroRecording(): boolean;
+
+  /**
+   * Stops the recording and returns the recorded events. Key events have an X11 keycode,
+   * button events a button number. The delay is the number of milliseconds since the
+   * previous event, computed from the time stamps of the X server. Returns null if
+   * nothing is being recorded.
+   */
+  stopMacroRecording(): Array<{
+    keycode?: number;
+    button?: number;
+    down: boolean;
+    delay: number;
+  }> | null;
+
+  /**
+   * Restricts the visible and the clickable area of the window with the given XID to the
+   * given circles and rectangles using the SHAPE extension. Pointer events outside of
+   * the shape go to the windows below. If null is passed, the whole window is visible
+   * and clickable again. Returns false if the X server does not support input shapes.
+   *
+   * @param window The XID of the window.
+   * @param shape The shape in physical pixels relative to the window or null.
    */
-  focusWindow(windowName: string, appName: string): void;
+  setWindowShape(
+    window: number,
+    shape: {
+      circles: Array<{ x: number; y: number; radius: number }>;
+      rectangles: Array<{ x: number; y: number; width: number; height: number }>;
+    } | null
+  ): boolean;
 };
 
 const native: Native = require('./../../../../../../build/Release/NativeX11.node');
@@ -22,10 +22,15 @@ import {
   MenuInteractionType,
   RootMenuItem,
   Vec2,
+  MenuBackdrop,
+  MenuShape,
+  FocusWindowAction,
+  WindowImage,
 } from '../common';
 import { IPCCallback } from '../common/ipc';
 import * as math from '../common/math';
 import { WorkflowExecutor } from './workflow-executor';
+import { findMatchingWindow } from './actions/focus-window';
 import { KandoApp } from './app';
 
 declare const MENU_WINDOW_PRELOAD_WEBPACK_ENTRY: string;
@@ -67,6 +72,9 @@ export class MenuWindow extends BrowserWindow {
   /** This is true if the window is currently visible. */
   private visible = false;
 
+  /** This is true if the backend has shaped the window to the menu. */
+  private shaped = false;
+
   /**
    * This is set to a value > 0 if we have currently inhibited the shortcut of the active
    * menu.
@@ -267,6 +275,25 @@ export class MenuWindow extends BrowserWindow {
     this.menuOpeningPointerPosition = { x: info.pointerX, y: info.pointerY };
     this.noopInteraction = true;
 
+    // Usually, the menu is shown at the pointer position.
+    const mousePosition = {
+      x: (info.pointerX - info.workArea.x) / this.webContents.getZoomFactor(),
+      y: (info.pointerY - info.workArea.y) / this.webContents.getZoomFactor(),
+    };
+
+    // We have to pass the size of the window to the renderer because window.innerWidth
+    // and window.innerHeight are not reliable when the window has just been resized.
+    // Also, we incorporate the zoom factor of the window so that the clamping to the
+    // work area is done correctly.
+    const windowSize = {
+      x: info.workArea.width / this.webContents.getZoomFactor(),
+      y: info.workArea.height / this.webContents.getZoomFactor(),
+    };
+
+    // The backdrop has to be captured before the window is shown. Else we would capture
+    // the window itself.
+    const backdrop = await this.captureBackdrop(info, mousePosition, windowSize);
+
     this.show();
 
     // Also, there is this long-standing issue with Windows where the window is not
@@ -294,21 +321,6 @@ export class MenuWindow extends BrowserWindow {
       setTimeout(() => this.setBounds(info.workArea, false));
     }
 
-    // Usually, the menu is shown at the pointer position.
-    const mousePosition = {
-      x: (info.pointerX - info.workArea.x) / this.webContents.getZoomFactor(),
-      y: (info.pointerY - info.workArea.y) / this.webContents.getZoomFactor(),
-    };
-
-    // We have to pass the size of the window to the renderer because window.innerWidth
-    // and window.innerHeight are not reliable when the window has just been resized.
-    // Also, we incorporate the zoom factor of the window so that the clamping to the
-    // work area is done correctly.
-    const windowSize = {
-      x: info.workArea.width / this.webContents.getZoomFactor(),
-      y: info.workArea.height / this.webContents.getZoomFactor(),
-    };
-
     // Send the menu to the renderer process. If the menu is centered, we delay the
     // turbo mode. This way, a key has to be pressed first before the turbo mode is
     // activated. Else, the turbo mode would be activated immediately when the menu is
@@ -330,6 +342,7 @@ export class MenuWindow extends BrowserWindow {
         anchoredMode: this.lastMenu.anchored,
         hoverMode: this.lastMenu.hoverMode,
         systemIconsChanged,
+        backdrop,
       },
       {
         appName: info.appName,
@@ -342,6 +355,79 @@ export class MenuWindow extends BrowserWindow {
     );
   }
 
+  /**
+   * If the menu theme requests a blurred backdrop, this captures the screen below the
+   * menu. Only a square around the center of the menu is captured, so the cost depends on
+   * the size of the menu rather than on the size of the screen.
+   *
+   * @param info The current WMInfo.
+   * @param mousePosition The pointer position relative to the window in CSS pixels.
+   * @param windowSize The size of the window in CSS pixels.
+   * @returns The backdrop or undefined if none is requested or if capturing failed. This
+   *   never rejects, so that a broken theme or backend cannot keep the menu from opening.
+   */
+  private async captureBackdrop(
+    info: WMInfo,
+    mousePosition: Vec2,
+    windowSize: Vec2
+  ): Promise<MenuBackdrop | undefined> {
+    try {
+      return await this.captureBackdropImpl(info, mousePosition, windowSize);
+    } catch (error) {
+      console.error(
+        'Failed to capture the backdrop:',
+        error instanceof Error ? error.message : error
+      );
+      return undefined;
+    }
+  }
+
+  /** This does the actual work of captureBackdrop() and may throw. */
+  private async captureBackdropImpl(
+    info: WMInfo,
+    mousePosition: Vec2,
+    windowSize: Vec2
+  ): Promise<MenuBackdrop | undefined> {
+    const theme = await this.kando.getMenuThemeDescription();
+
+    // If the window is still visible, for instance when cycling through menus, we would
+    // capture the previous menu. The check is written this way round so that values
+    // which are not numbers disable the backdrop as well.
+    if (!(theme.backdropBlur > 0) || this.isVisible()) {
+      return undefined;
+    }
+
+    // This has to match the initial menu position computed by the renderer.
+    const center = this.lastMenu.useFixedPosition
+      ? {
+          x: windowSize.x * this.lastMenu.fixedMenuPosition.x,
+          y: windowSize.y * this.lastMenu.fixedMenuPosition.y,
+        }
+      : math.clampToMonitor(mousePosition, theme.maxMenuRadius, windowSize);
+
+    const x = Math.max(0, Math.floor(center.x - theme.maxMenuRadius));
+    const y = Math.max(0, Math.floor(center.y - theme.maxMenuRadius));
+    const width = Math.min(windowSize.x, Math.ceil(center.x + theme.maxMenuRadius)) - x;
+    const height = Math.min(windowSize.y, Math.ceil(center.y + theme.maxMenuRadius)) - y;
+
+    if (width <= 0 || height <= 0) {
+      return undefined;
+    }
+
+    const zoom = this.webContents.getZoomFactor();
+    const image = await this.kando.getBackend().captureBackdrop(
+      {
+        x: info.workArea.x + x * zoom,
+        y: info.workArea.y + y * zoom,
+        width: width * zoom,
+        height: height * zoom,
+      },
+      theme.backdropBlur * zoom
+    );
+
+    return image ? { x, y, width, height, image } : undefined;
+  }
+
   /** This shows the window. */
   public override show() {
     // Cancel any ongoing window-hiding.
@@ -495,6 +581,19 @@ export class MenuWindow extends BrowserWindow {
           super.hide();
         }
 
+        // If the window has been shaped to the menu, the next menu may be shown
+        // somewhere else. So we make the whole window visible and clickable again.
+        this.shaped = false;
+        this.kando
+          .getBackend()
+          .setMenuWindowShape(this.getNativeWindowHandle(), null)
+          .catch((error) => {
+            console.error(
+              'Failed to reset the shape of the menu window:',
+              error instanceof Error ? error.message : error
+            );
+          });
+
         this.hideTimeout = null;
 
         resolve();
@@ -618,6 +717,44 @@ export class MenuWindow extends BrowserWindow {
         }
       }
 
+      // The command line is only known on some backends. If it is not known, the
+      // condition is not met.
+      if (menu.conditions.commandLine) {
+        let commandLine = '';
+        if (info.commandLine) {
+          const args = info.commandLine.slice(1);
+          commandLine = [info.executable || info.commandLine[0], ...args].join(' ');
+        }
+
+        if (testStringCondition(menu.conditions.commandLine, commandLine)) {
+          scores[index] += 1;
+        } else {
+          scores[index] = 0;
+          return;
+        }
+      }
+
+      // The window under the pointer is only known on some backends as well.
+      if (menu.conditions.hoveredAppName) {
+        const appName = info.hoveredAppName || '';
+        if (testStringCondition(menu.conditions.hoveredAppName, appName)) {
+          scores[index] += 1;
+        } else {
+          scores[index] = 0;
+          return;
+        }
+      }
+
+      if (menu.conditions.hoveredWindowName) {
+        const windowName = info.hoveredWindowName || '';
+        if (testStringCondition(menu.conditions.hoveredWindowName, windowName)) {
+          scores[index] += 1;
+        } else {
+          scores[index] = 0;
+          return;
+        }
+      }
+
       // And for screenArea condition.
       if (
         menu.conditions.screenArea?.xMin != null ||
@@ -713,6 +850,15 @@ export class MenuWindow extends BrowserWindow {
    * ../menu-renderer/menu-window-api.ts for the corresponding renderer API.
    */
   private initMenuRendererAPI() {
+    // Some backends report the release of a shortcut even if the menu window does not
+    // receive the key events. We forward this for the shortcut which opened the current
+    // menu so that turbo mode and release-to-select work without keyboard focus.
+    this.kando.getBackend().on('shortcutReleased', (shortcut: string) => {
+      if (this.visible && shortcut === this.lastRequest?.trigger) {
+        this.webContents.send('menu-window.shortcut-released');
+      }
+    });
+
     // Move the mouse pointer. This is used to move the pointer to the center of the
     // menu when the menu is opened too close to the screen edge.
     ipcMain.on('menu-window.move-pointer', (event, dist) => {
@@ -874,6 +1020,86 @@ export class MenuWindow extends BrowserWindow {
     ipcMain.on('menu-window.show-settings', () => {
       this.kando.showSettings();
     });
+
+    // The renderer can show the icon or a thumbnail of the window which a focus-window
+    // item would focus. We look up the open windows only once for all items and request
+    // the thumbnails in one batch.
+    ipcMain.handle(
+      'menu-window.get-window-images',
+      async (
+        event,
+        actions: FocusWindowAction[],
+        type: 'icon' | 'thumbnail',
+        size: number
+      ): Promise<Array<WindowImage | null>> => {
+        const backend = this.kando.getBackend();
+        const openWindows = await backend.getOpenWindows();
+        const windows = actions.map((a) => findMatchingWindow(a, openWindows));
+
+        // Several items may focus the same window. Each window is requested only once.
+        const unique = [...new Set(windows.filter((window) => window !== undefined))];
+
+        let images: Array<WindowImage | null>;
+        if (type === 'thumbnail') {
+          images = await backend.getWindowThumbnails(unique, size);
+        } else {
+          images = await Promise.all(unique.map((w) => backend.getWindowIcon(w, size)));
+        }
+
+        return windows.map((window) => (window ? images[unique.indexOf(window)] : null));
+      }
+    );
+
+    // The renderer reports the area covered by the menu whenever a submenu is opened or
+    // closed. Some backends use this to shape the window. The shape is given in CSS
+    // pixels, so we have to apply the zoom factor.
+    ipcMain.on('menu-window.set-shape', (event, shape: MenuShape) => {
+      if (!this.visible) {
+        return;
+      }
+
+      const zoom = this.webContents.getZoomFactor();
+      const scaled: MenuShape = {
+        circles: shape.circles.map((c) => ({
+          x: c.x * zoom,
+          y: c.y * zoom,
+          radius: c.radius * zoom,
+        })),
+        rectangles: shape.rectangles.map((r) => ({
+          x: r.x * zoom,
+          y: r.y * zoom,
+          width: r.width * zoom,
+          height: r.height * zoom,
+        })),
+      };
+
+      this.kando
+        .getBackend()
+        .setMenuWindowShape(this.getNativeWindowHandle(), scaled)
+        .then((shaped) => {
+          this.shaped = this.shaped || shaped;
+        })
+        .catch((error) => {
+          console.error(
+            'Failed to shape the menu window:',
+            error instanceof Error ? error.message : error
+          );
+        });
+    });
+
+    // If the window has been shaped to the menu, clicks outside of the menu go to the
+    // windows below and the renderer does not see them. So we close the menu once the
+    // clicked window takes the focus, as clicking the background would do.
+    this.on('blur', () => {
+      if (this.visible && this.shaped) {
+        this.closeMenu().catch((error) => {
+          console.error(
+            'Failed to close the menu:',
+            error instanceof Error ? error.message : error
+          );
+        });
+      }
+    });
   }
 
   /**
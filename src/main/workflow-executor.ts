@@ -25,6 +25,7 @@ import { execute as openSettings } from './actions/open-settings';
 import { execute as openURI } from './actions/open-uri';
 import { execute as setClipboard } from './actions/set-clipboard';
 import { execute as simulateHotkey } from './actions/simulate-hotkey';
+import { execute as typeText } from './actions/type-text';
 import { execute as delay } from './actions/delay';
 
 type WorkflowActionExecutor<T extends WorkflowActionType> = (
@@ -49,6 +50,7 @@ const ACTION_EXECUTORS = new Map<
   ['open-uri', openURI],
   ['set-clipboard', setClipboard],
   ['simulate-hotkey', simulateHotkey],
+  ['type-text', typeText],
 ]);
 
 /**
@@ -133,6 +133,12 @@ Promise.all([
     menu.triggerInteraction(type);
   });
 
+  // If the shortcut which opened the menu is released while the menu window does not
+  // receive the key events, the host process tells us.
+  window.menuAPI.onShortcutReleased(() => {
+    menu.onShortcutReleased();
+  });
+
   // Tell the host process about interactions triggered by the user or also by the host
   // process itself via the onTriggerInteraction function.
   menu.on('interaction', (type, path, time, source) => {
@@ -172,6 +178,25 @@ Promise.all([
     window.menuAPI.movePointer(dist);
   });
 
+  // If enabled, items which focus a window show the icon or a thumbnail of this window.
+  // The images are fetched after the menu has been shown so that opening the menu is not
+  // delayed. The size is large enough for the items of most menu themes.
+  menu.on('window-images-requested', (actions, type) => {
+    const size = Math.round(128 * window.devicePixelRatio);
+    window.menuAPI
+      .getWindowImages(actions, type, size)
+      .then((images) => menu.setWindowImages(actions, images))
+      .catch((error) => {
+        window.commonAPI.log(`Failed to get window images: ${error}`);
+      });
+  });
+
+  // Whenever a submenu is opened or closed, we report the area covered by the menu and
+  // the settings button. Some backends shape the window accordingly.
+  menu.on('shape-changed', (circles) => {
+    window.menuAPI.setShape({ circles, rectangles: [settingsButton.getBounds()] });
+  });
+
   document.body.addEventListener('keydown', async (ev) => {
     // Hide the menu when the user presses escape.
     if (ev.key === 'Escape') {
@@ -72,6 +72,12 @@ export class PointerInput extends InputMethod {
    */
   private deferredTurboMode = false;
 
+  /**
+   * The release of all keys may be reported twice: Once by the key-up event of the menu
+   * window and once by the host process. This is used to handle only the first one.
+   */
+  private keysReleased = false;
+
   /** The position where the mouse was when the user pressed a mouse button the last time. */
   private clickPosition: Vec2 = { x: 0, y: 0 };
 
@@ -135,6 +141,7 @@ export class PointerInput extends InputMethod {
     this.ignoreMotionEvents = 2;
     this.buttonState = ButtonState.eReleased;
     this.deferredTurboMode = deferTurboMode;
+    this.keysReleased = false;
   }
 
   /*
@@ -290,6 +297,8 @@ export class PointerInput extends InputMethod {
 
   /** This method should be called when a key is pressed. */
   public onKeyDownEvent() {
+    this.keysReleased = false;
+
     if (!this.deferredTurboMode) {
       this.keydownPosition = {
         x: this.pointerPosition.x,
@@ -319,32 +328,46 @@ export class PointerInput extends InputMethod {
       event.altKey;
 
     if (!stillAnyModifierPressed) {
-      this.deferredTurboMode = false;
-
-      // Only if triggerCenterClickOnKeyRelease is enabled, we trigger the center-click-
-      // workflow when a key is released while hovering over the center of a menu. Else,
-      // we do not trigger selections on the center item in turbo mode.
-      let triggerSelection = false;
-
-      if (this.triggerCenterClickOnKeyRelease) {
-        triggerSelection = true;
-      } else {
-        triggerSelection =
-          this.buttonState === ButtonState.eDragged &&
-          math.getDistance(this.pointerPosition, this.centerPosition) > this.centerRadius;
-      }
+      this.onAllKeysReleased();
+    }
+  }
 
-      if (triggerSelection) {
-        this.gestureDetector.reset();
-        this.selectCallback(
-          this.pointerPosition,
-          SelectionType.eActiveItem,
-          SelectionSource.eGesture
-        );
-      }
+  /**
+   * This method should be called when all keys have been released. This is called by
+   * onKeyUpEvent() but also if the host process reports that the shortcut which opened
+   * the menu has been released.
+   */
+  public onAllKeysReleased() {
+    if (!this.enableTurboMode || this.keysReleased) {
+      return;
+    }
 
-      this.update(this.pointerPosition, this.centerPosition, ButtonState.eReleased);
+    this.keysReleased = true;
+    this.deferredTurboMode = false;
+
+    // Only if triggerCenterClickOnKeyRelease is enabled, we trigger the center-click-
+    // workflow when a key is released while hovering over the center of a menu. Else,
+    // we do not trigger selections on the center item in turbo mode.
+    let triggerSelection = false;
+
+    if (this.triggerCenterClickOnKeyRelease) {
+      triggerSelection = true;
+    } else {
+      triggerSelection =
+        this.buttonState === ButtonState.eDragged &&
+        math.getDistance(this.pointerPosition, this.centerPosition) > this.centerRadius;
     }
+
+    if (triggerSelection) {
+      this.gestureDetector.reset();
+      this.selectCallback(
+        this.pointerPosition,
+        SelectionType.eActiveItem,
+        SelectionSource.eGesture
+      );
+    }
+
+    this.update(this.pointerPosition, this.centerPosition, ButtonState.eReleased);
   }
 
   // Private interface -------------------------------------------------------------------
@@ -8,7 +8,12 @@
 // SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
 // SPDX-License-Identifier: MIT
 
-import { GeneralSettings, MenuItem, MenuThemeDescription } from '../common';
+import {
+  GeneralSettings,
+  MenuItem,
+  MenuThemeDescription,
+  WindowImage,
+} from '../common';
 import { IconThemeRegistry } from '../common/icon-themes/icon-theme-registry';
 import { getClosestEquivalentAngle } from '../common/math';
 import { RenderedMenuItem } from './rendered-menu-item';
@@ -231,6 +236,43 @@ export class MenuTheme {
     return nodeDiv;
   }
 
+  /**
+   * Replaces the content of all icon layers of an item which has been created with
+   * createItem() by the given image. The image is drawn into a canvas which is scaled to
+   * the size of the icon by the browser.
+   *
+   * @param nodeDiv The html element which has been returned by createItem().
+   * @param image The image to show instead of the icon.
+   */
+  public replaceIcon(nodeDiv: HTMLElement, image: WindowImage) {
+    for (const layer of this.description.layers) {
+      if (layer.content !== 'icon') {
+        continue;
+      }
+
+      for (const layerDiv of Array.from(nodeDiv.children)) {
+        if (!layerDiv.classList.contains(layer.class)) {
+          continue;
+        }
+
+        const containerDiv = document.createElement('div');
+        containerDiv.classList.add('icon-container');
+
+        const canvas = document.createElement('canvas');
+        canvas.width = image.width;
+        canvas.height = image.height;
+
+        const pixels = new Uint8ClampedArray(image.data);
+        canvas
+          .getContext('2d')
+          .putImageData(new ImageData(pixels, image.width, image.height), 0, 0);
+
+        containerDiv.appendChild(canvas);
+        layerDiv.replaceChildren(containerDiv);
+      }
+    }
+  }
+
   /** Sets the colors defined in the theme description as CSS properties. */
   public setColors(colors: Record<string, string>) {
     Object.entries(colors).forEach(([name, color]) => {
@@ -17,6 +17,9 @@ import {
   SelectionSource,
   MenuInteractionType,
   RootMenuItem,
+  MenuShape,
+  FocusWindowAction,
+  WindowImage,
 } from '../common';
 
 /**
@@ -42,6 +45,17 @@ export const MENU_WINDOW_API = {
     ipcRenderer.send('menu-window.move-pointer', dist);
   },
 
+  /**
+   * This reports the area of the window which is covered by the menu to the host
+   * process. Some backends use this to restrict the visible and clickable area of the
+   * window.
+   *
+   * @param shape The area covered by the menu in CSS pixels.
+   */
+  setShape: (shape: MenuShape) => {
+    ipcRenderer.send('menu-window.set-shape', shape);
+  },
+
   /**
    * This will be triggered by the host process when a new menu should be shown.
    *
@@ -69,6 +83,17 @@ export const MENU_WINDOW_API = {
     ipcRenderer.on('menu-window.trigger-interaction', (event, type) => func(type));
   },
 
+  /**
+   * This will be called by the host process when the shortcut which opened the menu has
+   * been released. Backends which grab shortcuts natively report this even if the menu
+   * window does not have the keyboard focus.
+   *
+   * @param callback This callback will be called when the shortcut has been released.
+   */
+  onShortcutReleased: (func: () => void) => {
+    ipcRenderer.on('menu-window.shortcut-released', () => func());
+  },
+
   /**
    * Menu interactions can be triggered by the user in the renderer process, for example
    * by clicking a menu item or hovering over a submenu. They can also be triggered by the
@@ -97,6 +122,24 @@ export const MENU_WINDOW_API = {
     ipcRenderer.send('menu-window.finalize-interaction', type, path, time, source);
   },
 
+  /**
+   * This returns the icons or thumbnails of the windows which the given focus-window
+   * actions would focus. All images are requested in one batch.
+   *
+   * @param actions The focus-window actions of the menu items.
+   * @param type Whether the icons or thumbnails of the windows should be returned.
+   * @param size The maximum width and height of the images in pixels.
+   * @returns One image per action. An image is null if there is no matching window or if
+   *   the backend cannot provide an image for it.
+   */
+  getWindowImages: (
+    actions: FocusWindowAction[],
+    type: 'icon' | 'thumbnail',
+    size: number
+  ): Promise<Array<WindowImage | null>> => {
+    return ipcRenderer.invoke('menu-window.get-window-images', actions, type, size);
+  },
+
   /** This will be called by the render process to show the settings window. */
   showSettings: () => {
     ipcRenderer.send('menu-window.show-settings');
@@ -14,11 +14,15 @@ import * as math from '../common/math';
 import KeyMapper from '../common/key-mapper';
 import {
   GeneralSettings,
+  MenuBackdrop,
+  MenuShape,
   ShowMenuOptions,
   Vec2,
   SelectionSource,
   MenuInteractionType,
   TypedEventEmitter,
+  FocusWindowAction,
+  WindowImage,
 } from '../common';
 import {
   RenderedChildMenuItem,
@@ -64,6 +68,15 @@ type MenuEvents = {
   // pointer to the center of the menu when it is shown.
   // eslint-disable-next-line @typescript-eslint/naming-convention
   'move-pointer': [dist: Vec2];
+  // Fired when a submenu has been opened or closed. The circles cover the visible part of
+  // the menu.
+  // eslint-disable-next-line @typescript-eslint/naming-convention
+  'shape-changed': [circles: MenuShape['circles']];
+  // Fired when the menu has been shown and contains items which focus a window. The
+  // images of the matching windows have to be passed to setWindowImages() together with
+  // the same actions array.
+  // eslint-disable-next-line @typescript-eslint/naming-convention
+  'window-images-requested': [actions: FocusWindowAction[], type: 'icon' | 'thumbnail'];
 };
 
 export class Menu extends (EventEmitter as new () => TypedEventEmitter<MenuEvents>) {
@@ -136,6 +149,13 @@ export class Menu extends (EventEmitter as new () => TypedEventEmitter<MenuEvent
    */
   private menuShownTime: number;
 
+  /**
+   * The focus-window actions for which the images of the matching windows have been
+   * requested when the menu was shown. The items are stored in the same order.
+   */
+  private windowImageActions: FocusWindowAction[] = null;
+  private windowImageItems: RenderedMenuItem[] = [];
+
   /**
    * The constructor will attach event listeners to the given container element. It will
    * also initialize the input tracker and the gesture detection.
@@ -198,8 +218,13 @@ export class Menu extends (EventEmitter as new () => TypedEventEmitter<MenuEvent
     this.pointerInput.triggerCenterClickOnKeyRelease =
       this.settings.triggerCenterClickOnKeyRelease;
 
+    if (showMenuOptions.backdrop) {
+      this.createBackdrop(showMenuOptions.backdrop);
+    }
+
     this.root = root;
     this.createRenderData(this.root, this.container);
+    this.requestWindowImages();
 
     if (this.theme.drawSelectionWedges && this.settings.enableSelectionWedges) {
       this.selectionWedges = new SelectionWedges(this.container);
@@ -273,6 +298,76 @@ export class Menu extends (EventEmitter as new () => TypedEventEmitter<MenuEvent
     }
   }
 
+  /**
+   * Draws the blurred screen content which has been captured by the main process into a
+   * canvas with the class "backdrop". The canvas covers the captured area, so the browser
+   * scales the image up. It is added before all other elements of the menu.
+   *
+   * @param backdrop The captured area and the blurred image.
+   */
+  private createBackdrop(backdrop: MenuBackdrop) {
+    const { image } = backdrop;
+
+    const canvas = document.createElement('canvas');
+    canvas.classList.add('backdrop');
+    canvas.width = image.width;
+    canvas.height = image.height;
+    canvas.style.left = `${backdrop.x}px`;
+    canvas.style.top = `${backdrop.y}px`;
+    canvas.style.width = `${backdrop.width}px`;
+    canvas.style.height = `${backdrop.height}px`;
+
+    const pixels = new Uint8ClampedArray(image.data);
+    canvas
+      .getContext('2d')
+      .putImageData(new ImageData(pixels, image.width, image.height), 0, 0);
+
+    this.container.prepend(canvas);
+  }
+
+  /**
+   * Collects all button items which focus a window and still use the default icon of the
+   * focus-window action. If the user enabled this, a 'window-images-requested' event is
+   * emitted so that the icons of these items can be replaced by the icons or thumbnails
+   * of the matching windows.
+   */
+  private requestWindowImages() {
+    const type = this.settings.x11FocusWindowItemImages;
+    if (type === 'none') {
+      return;
+    }
+
+    const actions: FocusWindowAction[] = [];
+    const items: RenderedMenuItem[] = [];
+    const queue: RenderedMenuItem[] = [this.root];
+
+    while (queue.length > 0) {
+      const item = queue.shift();
+
+      if (item.type === 'submenu' || item.type === 'root') {
+        queue.push(...item.children);
+      } else if (
+        item.type === 'button' &&
+        item.iconTheme === 'kando' &&
+        item.icon === 'focus-window-item.svg'
+      ) {
+        const workflowActions = item.selectWorkflow?.actions ?? [];
+        const action = workflowActions.find((a) => a.type === 'focus-window');
+
+        if (action) {
+          actions.push(action as FocusWindowAction);
+          items.push(item);
+        }
+      }
+    }
+
+    if (actions.length > 0) {
+      this.windowImageActions = actions;
+      this.windowImageItems = items;
+      this.emit('window-images-requested', actions, type);
+    }
+  }
+
   /** Removes all DOM elements from the menu and resets the root menu item. */
   public clear() {
     this.container.className = 'hidden';
@@ -288,6 +383,31 @@ export class Menu extends (EventEmitter as new () => TypedEventEmitter<MenuEvent
     clearTimeout(this.initialPositionTimeout);
     this.hideTimeout = null;
     this.initialPositionTimeout = null;
+    this.windowImageActions = null;
+    this.windowImageItems = [];
+  }
+
+  /**
+   * Shows the given window images instead of the icons of the items which have been
+   * reported by the 'window-images-requested' event. If the menu has been cleared or
+   * shown again in the meantime, the images are ignored.
+   *
+   * @param actions The actions which have been passed to the event.
+   * @param images One image per action. Items without an image keep their icon.
+   */
+  public setWindowImages(
+    actions: FocusWindowAction[],
+    images: Array<WindowImage | null>
+  ) {
+    if (actions !== this.windowImageActions) {
+      return;
+    }
+
+    images.forEach((image, i) => {
+      if (image) {
+        this.theme.replaceIcon(this.windowImageItems[i].renderData.nodeDiv, image);
+      }
+    });
   }
 
   /**
@@ -358,6 +478,16 @@ export class Menu extends (EventEmitter as new () => TypedEventEmitter<MenuEvent
     }
   }
 
+  /**
+   * This should be called if the host process reports that the shortcut which opened the
+   * menu has been released. This is treated like the release of all keys.
+   */
+  public onShortcutReleased() {
+    if (!this.container.classList.contains('hidden')) {
+      this.pointerInput.onAllKeysReleased();
+    }
+  }
+
   // --------------------------------------------------------------------- private methods
 
   /**
@@ -756,6 +886,8 @@ export class Menu extends (EventEmitter as new () => TypedEventEmitter<MenuEvent
     this.updateCSSClasses();
     this.updateConnectors();
     this.redraw();
+
+    this.emit('shape-changed', this.getShapeCircles());
   }
 
   /**
@@ -1526,6 +1658,47 @@ export class Menu extends (EventEmitter as new () => TypedEventEmitter<MenuEvent
     return position;
   }
 
+  /**
+   * Computes circles which cover the visible part of the menu. Each item in the selection
+   * chain is covered by a circle with the maximum menu radius of the theme. This includes
+   * the children of the center item. The connectors between the items are covered by a
+   * chain of smaller circles.
+   *
+   * @returns The circles in CSS pixels relative to the window.
+   */
+  private getShapeCircles() {
+    const radius = this.theme.maxMenuRadius;
+    const circles: MenuShape['circles'] = [];
+
+    let item = this.centerItem;
+    let position = this.getCenterItemPosition();
+
+    while (item) {
+      circles.push({ x: position.x, y: position.y, radius });
+
+      const parent = item.renderData.parent;
+
+      if (parent) {
+        const offset = item.renderData.position;
+        const steps = Math.ceil(math.getLength(offset) / radius);
+
+        for (let i = 1; i < steps; ++i) {
+          circles.push({
+            x: position.x - (offset.x * i) / steps,
+            y: position.y - (offset.y * i) / steps,
+            radius: radius / 2,
+          });
+        }
+
+        position = math.subtract(position, offset);
+      }
+
+      item = parent;
+    }
+
+    return circles;
+  }
+
   /**
    * This method computes the initial position of the root item. If the menu is in
    * centered mode, the root item will be positioned at the center of the window.
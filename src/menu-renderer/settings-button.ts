@@ -48,6 +48,22 @@ export class SettingsButton extends EventEmitter {
     this.button.classList.add('hidden');
   }
 
+  /**
+   * Returns the area covered by the button in CSS pixels. Even an invisible button
+   * appears on hover, so it is always included. The area is enlarged to contain the
+   * shadow and the slide-in animation of the button.
+   */
+  getBounds() {
+    const margin = 20;
+    const { x, y, width, height } = this.button.getBoundingClientRect();
+    return {
+      x: x - margin,
+      y: y - margin,
+      width: width + 2 * margin,
+      height: height + 2 * margin,
+    };
+  }
+
   /**
    * Allow changing the options at run-time.
    *
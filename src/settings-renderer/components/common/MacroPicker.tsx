@@ -48,6 +48,49 @@ export default function MacroPicker(props: Props) {
   const [recording, setRecording] = React.useState(false);
   const inputRef = React.useRef<HTMLTextAreaElement>(null);
 
+  // If the backend can record key strokes, this is set while recording. The key strokes
+  // recorded in the text field are only used for immediate feedback then. Once the
+  // recording is stopped, they are replaced by the recorded ones which have the exact
+  // timing.
+  const nativeRecording = React.useRef<Promise<boolean> | null>(null);
+
+  const stopRecording = async (value: string) => {
+    setRecording(false);
+
+    let macro = convertToMacro(value);
+
+    const started = nativeRecording.current;
+    nativeRecording.current = null;
+
+    if (started && (await started)) {
+      const keys = await window.settingsAPI.stopMacroRecording();
+      if (keys && keys.length > 0) {
+        macro = keys.map(
+          (key): MacroEvent => ({
+            type: key.down ? 'keyDown' : 'keyUp',
+            key: key.name,
+            delay: key.delay,
+          })
+        );
+        setTextValue(convertToString(macro));
+      }
+    }
+
+    if (macro) {
+      props.onChange?.(macro);
+    }
+  };
+
+  // Make sure that the recording does not continue if the picker is removed.
+  React.useEffect(
+    () => () => {
+      if (nativeRecording.current) {
+        window.settingsAPI.stopMacroRecording();
+      }
+    },
+    []
+  );
+
   // Update the value when the initialValue prop changes. This is necessary because the
   // initialValue prop might change after the component has been initialized.
   React.useEffect(
@@ -72,7 +115,8 @@ export default function MacroPicker(props: Props) {
           }
 
           if (recording) {
-            setRecording(false);
+            stopRecording(textValue);
+            return;
           }
 
           const macro = convertToMacro(textValue);
@@ -114,15 +158,13 @@ export default function MacroPicker(props: Props) {
         variant="secondary"
         onClick={() => {
           if (recording) {
-            const macro = convertToMacro(textValue);
-            if (macro) {
-              props.onChange?.(macro);
-            }
+            stopRecording(textValue);
           } else {
             setTextValue('');
             inputRef.current?.focus();
+            nativeRecording.current = window.settingsAPI.startMacroRecording();
+            setRecording(true);
           }
-          setRecording(!recording);
         }}
       />
     </div>
@@ -416,6 +416,50 @@ export default function GeneralSettingsDialog() {
               settingsKey="windowsInkWorkaround"
             />
           )}
+          {['X11', 'KDE X11', 'Cinnamon'].includes(backend.name) && (
+            <>
+              <SettingsCheckbox
+                info={i18next.t(
+                  'settings.general-settings-dialog.x11-pointer-tracking-info'
+                )}
+                label={i18next.t('settings.general-settings-dialog.x11-pointer-tracking')}
+                settingsKey="x11PointerTracking"
+              />
+              <SettingsCheckbox
+                info={i18next.t(
+                  'settings.general-settings-dialog.x11-shape-menu-window-info'
+                )}
+                label={i18next.t(
+                  'settings.general-settings-dialog.x11-shape-menu-window'
+                )}
+                settingsKey="x11ShapeMenuWindow"
+              />
+              <SettingsDropdown
+                info={i18next.t(
+                  'settings.general-settings-dialog.x11-focus-window-item-images-info'
+                )}
+                label={i18next.t(
+                  'settings.general-settings-dialog.x11-focus-window-item-images'
+                )}
+                maxWidth={200}
+                options={[
+                  {
+                    value: 'none',
+                    label: i18next.t('settings.general-settings-dialog.none'),
+                  },
+                  {
+                    value: 'icon',
+                    label: i18next.t('settings.general-settings-dialog.window-icon'),
+                  },
+                  {
+                    value: 'thumbnail',
+                    label: i18next.t('settings.general-settings-dialog.window-thumbnail'),
+                  },
+                ]}
+                settingsKey="x11FocusWindowItemImages"
+              />
+            </>
+          )}
           <Swirl marginBottom={20} marginTop={40} variant="2" width={350} />
           <Note isCentered useMarkdown>
             {i18next.t('settings.general-settings-dialog.learn-interaction-mode', {
@@ -625,6 +669,15 @@ export default function GeneralSettingsDialog() {
                 ]}
                 settingsKey="wlrootsPointerGetTimeoutDefaultBehavior"
               />
+              <SettingsCheckbox
+                info={i18next.t(
+                  'settings.general-settings-dialog.wlroots-keep-pointer-surface-info'
+                )}
+                label={i18next.t(
+                  'settings.general-settings-dialog.wlroots-keep-pointer-surface'
+                )}
+                settingsKey="wlrootsKeepPointerSurface"
+              />
             </>
           )}
           <Swirl marginBottom={20} marginTop={40} variant="2" width={350} />
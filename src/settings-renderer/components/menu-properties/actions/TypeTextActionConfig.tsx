@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/menu/kando           //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+import React from 'react';
+import i18next from 'i18next';
+
+import { TextInput } from '../../common';
+import { TypeTextAction } from '../../../../common';
+
+type Props = {
+  /** The action to configure. */
+  readonly action: TypeTextAction;
+
+  /** Function to call when the action changes. */
+  readonly onUpdateAction: (action: TypeTextAction) => void;
+};
+
+/**
+ * The configuration component for type-text actions is primarily a text input field for
+ * the text to type.
+ */
+export function TypeTextActionConfig(props: Props) {
+  return (
+    <TextInput
+      isMultiline
+      initialValue={props.action.text}
+      placeholder={i18next.t('menu-actions.type-text.placeholder')}
+      onChange={(value) => {
+        props.onUpdateAction({ ...props.action, text: value });
+      }}
+    />
+  );
+}
@@ -19,6 +19,7 @@ import { OpenMenuActionConfig } from './OpenMenuActionConfig';
 import { OpenURIActionConfig } from './OpenURIActionConfig';
 import { SetClipboardActionConfig } from './SetClipboardActionConfig';
 import { SimulateHotkeyActionConfig } from './SimulateHotkeyActionConfig';
+import { TypeTextActionConfig } from './TypeTextActionConfig';
 import { WorkflowAction } from '../../../../common';
 
 /**
@@ -88,5 +89,9 @@ export function getConfigComponent(
     return <SimulateHotkeyActionConfig action={action} onUpdateAction={onUpdateAction} />;
   }
 
+  if (action.type === 'type-text') {
+    return <TypeTextActionConfig action={action} onUpdateAction={onUpdateAction} />;
+  }
+
   return null;
 }
@@ -19,6 +19,7 @@ import {
   WMInfo,
   SystemInfo,
   AppDescription,
+  KeySequence,
   LevelProgress,
   SettingsWindowSidebarWidths,
 } from '../common';
@@ -105,6 +106,22 @@ export const SETTINGS_WINDOW_API = {
     return ipcRenderer.invoke('settings-window.get-installed-apps');
   },
 
+  /**
+   * This starts recording key strokes system-wide. The returned promise resolves to false
+   * if the backend does not support this.
+   */
+  startMacroRecording: (): Promise<boolean> => {
+    return ipcRenderer.invoke('settings-window.start-macro-recording');
+  },
+
+  /**
+   * This stops the recording started with startMacroRecording() and returns the recorded
+   * key strokes. The promise resolves to null if nothing has been recorded.
+   */
+  stopMacroRecording: (): Promise<KeySequence | null> => {
+    return ipcRenderer.invoke('settings-window.stop-macro-recording');
+  },
+
   /** This will return the current level and achievements progress. */
   getLevelProgress: (): Promise<LevelProgress> => {
     return ipcRenderer.invoke('settings-window.get-level-progress');
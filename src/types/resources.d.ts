@@ -248,6 +248,11 @@ export default interface Resources {
               "hotkey-info": "This hotkey will be triggered when the item is selected. When recording, you do not have to press all keys at once, you can also press them one after another. This is useful if a hotkey is already bound to some global action!",
               "name": "Simulate Hotkey",
               "recording-placeholder": "Type a hotkey…"
+          },
+          "type-text": {
+              "description": "Types the given text for you using your current keyboard layout. Make sure to add a close-menu action before this if you want the text to be typed into the active application and not the menu!",
+              "name": "Type Text",
+              "placeholder": "Insert any text…"
           }
       },
       "menu-items": {
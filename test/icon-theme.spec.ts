@@ -0,0 +1,55 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+import { expect } from 'chai';
+import childProcess from 'child_process';
+
+import { getCurrentIconTheme } from '../src/main/backends/linux/icon-theme';
+
+describe('getCurrentIconTheme', () => {
+  const originalExecSync = childProcess.execSync;
+  const originalEnv = { ...process.env };
+
+  // Records all commands which would have been spawned.
+  let spawned: string[] = [];
+
+  beforeEach(() => {
+    spawned = [];
+    (childProcess as { execSync: unknown }).execSync = (command: string) => {
+      spawned.push(command);
+      throw new Error('Spawning processes is not allowed in this test.');
+    };
+
+    delete process.env.ICON_THEME;
+    process.env.XDG_CURRENT_DESKTOP = 'GNOME';
+  });
+
+  afterEach(() => {
+    (childProcess as { execSync: unknown }).execSync = originalExecSync;
+    process.env = { ...originalEnv };
+  });
+
+  it('should use the native icon theme without spawning a process', async () => {
+    expect(await getCurrentIconTheme('Papirus')).to.equal('Papirus');
+    expect(spawned).to.be.empty;
+  });
+
+  it('should prefer the ICON_THEME environment variable', async () => {
+    process.env.ICON_THEME = 'Breeze';
+    expect(await getCurrentIconTheme('Papirus')).to.equal('Breeze');
+    expect(spawned).to.be.empty;
+  });
+
+  it('should ask the desktop environment if there is no native icon theme', async () => {
+    await getCurrentIconTheme(null);
+    expect(spawned).to.have.lengthOf(1);
+    expect(spawned[0]).to.contain('gsettings');
+  });
+});
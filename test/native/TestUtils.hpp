@@ -0,0 +1,52 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef TEST_UTILS_HPP
+#define TEST_UTILS_HPP
+
+// These helpers are shared by all native tests. Each test is a small executable which
+// prints one line per check and returns a non-zero exit code if any of them failed:
+//
+//   return failures == 0 ? 0 : 1;
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// The number of failed checks so far.
+inline int failures = 0;
+
+// Prints the result of a single check and counts it if it failed.
+inline void check(bool condition, std::string const& description) {
+  std::cout << (condition ? "[PASS] " : "[FAIL] ") << description << std::endl;
+  if (!condition) {
+    ++failures;
+  }
+}
+
+// Waits until the given condition is true. Returns false if this takes longer than five
+// seconds.
+inline bool waitFor(std::function<bool()> const& condition) {
+  auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+  while (std::chrono::steady_clock::now() < timeout) {
+    if (condition()) {
+      return true;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+
+  return false;
+}
+
+#endif // TEST_UTILS_HPP
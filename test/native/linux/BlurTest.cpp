@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test blurs some synthetic images and checks the size and the content of the
+// results.
+
+#include "Blur.hpp"
+#include "TestUtils.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Creates an XRGB image with the given color in the left half and black in the right.
+std::vector<uint8_t> createImage(uint32_t width, uint32_t height, uint32_t color) {
+  std::vector<uint8_t> pixels(size_t(width) * height * 4, 0);
+
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < width / 2; ++x) {
+      uint8_t* pixel = pixels.data() + (size_t(y) * width + x) * 4;
+      pixel[0]       = color & 0xFF;
+      pixel[1]       = (color >> 8) & 0xFF;
+      pixel[2]       = (color >> 16) & 0xFF;
+      pixel[3]       = 0x42;
+    }
+  }
+
+  return pixels;
+}
+
+uint8_t const* pixelAt(BlurredImage const& image, uint32_t x, uint32_t y) {
+  return image.rgba.data() + (size_t(y) * image.width + x) * 4;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  auto pixels = createImage(400, 300, 0xFF8000);
+
+  // Without a blur, the image is only converted to RGBA.
+  BlurredImage plain = blurImage(pixels.data(), 400, 300, 400 * 4, 0.0);
+  check(plain.width == 400 && plain.height == 300, "Small blurs keep the size");
+
+  uint8_t const* left = pixelAt(plain, 0, 0);
+  check(left[0] == 0xFF && left[1] == 0x80 && left[2] == 0x00 && left[3] == 255,
+      "Pixels are converted to opaque RGBA");
+
+  BlurredImage swapped = blurImage(pixels.data(), 400, 300, 400 * 4, 0.0, true);
+  check(pixelAt(swapped, 0, 0)[0] == 0x00 && pixelAt(swapped, 0, 0)[2] == 0xFF,
+      "Red and blue can be swapped");
+
+  // Large blurs are done at a reduced resolution.
+  BlurredImage blurred = blurImage(pixels.data(), 400, 300, 400 * 4, 16.0);
+  check(blurred.width == 50 && blurred.height == 37, "Large blurs reduce the size");
+  check(blurred.rgba.size() == size_t(blurred.width) * blurred.height * 4,
+      "The pixel data matches the size");
+
+  // Far away from the edge, the colors do not change. Close to it, they are mixed.
+  uint8_t const* inside  = pixelAt(blurred, 2, 18);
+  uint8_t const* outside = pixelAt(blurred, 47, 18);
+  uint8_t const* edge    = pixelAt(blurred, 25, 18);
+
+  check(inside[0] == 0xFF && inside[1] == 0x80 && inside[2] == 0x00,
+      "Uniform areas stay uniform");
+  check(outside[0] == 0 && outside[1] == 0 && outside[2] == 0, "Black stays black");
+  check(edge[0] > 0x40 && edge[0] < 0xC0, "Edges are smoothed");
+  check(pixelAt(blurred, 24, 18)[0] > edge[0] && edge[0] > pixelAt(blurred, 26, 18)[0],
+      "Edges fall off monotonically");
+  check(pixelAt(blurred, 25, 0)[0] == edge[0], "Rows are blurred equally");
+  check(edge[3] == 255, "The result is opaque");
+
+  // The stride may be larger than the row.
+  std::vector<uint8_t> padded(size_t(512) * 300 * 4, 0);
+  for (uint32_t y = 0; y < 300; ++y) {
+    std::copy(pixels.begin() + y * 400 * 4, pixels.begin() + (y + 1) * 400 * 4,
+        padded.begin() + y * 512 * 4);
+  }
+
+  BlurredImage strided = blurImage(padded.data(), 400, 300, 512 * 4, 16.0);
+  check(strided.rgba == blurred.rgba, "The stride is respected");
+
+  check(blurImage(pixels.data(), 0, 0, 0, 4.0).rgba.empty(), "Empty images are empty");
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test checks under which targets the clipboard content is offered.
+
+#include "ClipboardContent.hpp"
+#include "TestUtils.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Returns the index of the entry offered under the given target or -1 if the target is
+// not offered.
+int findEntry(std::vector<ClipboardOffer> const& offers, std::string const& target) {
+  for (auto const& offer : offers) {
+    if (offer.target == target) {
+      return static_cast<int>(offer.entry);
+    }
+  }
+
+  return -1;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  check(getClipboardOffers({}).empty(), "Nothing is offered without entries");
+
+  auto offers = getClipboardOffers({{"text/plain", "Kando"}});
+  check(offers.size() == 5 && offers[0].target == "text/plain",
+      "Plain text is offered under its own type first");
+  check(findEntry(offers, "UTF8_STRING") == 0 && findEntry(offers, "TEXT") == 0 &&
+            findEntry(offers, "text/plain;charset=utf-8") == 0,
+      "Plain text is offered under the legacy names");
+  check(findEntry(offers, "STRING") == 0 && offers.back().latin1,
+      "Plain text is offered as Latin-1");
+
+  offers = getClipboardOffers({{"text/html", "<b>Kando</b>"}, {"text/plain", "Kando"}});
+  check(offers.size() == 6 && offers[0].target == "text/html" &&
+            findEntry(offers, "text/html") == 0,
+      "HTML is offered under its own type");
+  check(findEntry(offers, "UTF8_STRING") == 1, "The aliases refer to the plain text");
+
+  offers = getClipboardOffers({{"text/plain", "a"}, {"UTF8_STRING", "b"}});
+  check(findEntry(offers, "UTF8_STRING") == 1,
+      "Explicit entries take precedence over the aliases");
+
+  offers = getClipboardOffers({{"text/plain", "a"}, {"STRING", "b"}});
+  check(findEntry(offers, "STRING") == 1 && !offers[1].latin1,
+      "Explicit Latin-1 entries are not converted");
+
+  std::vector<ClipboardEntry> entries = {{"text/plain", "K\xC3\xA4nd\xE2\x82\xAC"}};
+  offers = getClipboardOffers(entries);
+  convertLatin1Offers(entries, offers);
+  check(entries.size() == 2 && entries[1].data == "K\xE4nd?" &&
+            findEntry(offers, "STRING") == 1 && findEntry(offers, "UTF8_STRING") == 0,
+      "Latin-1 offers refer to a converted copy of the text");
+
+  offers = getClipboardOffers({{"image/png", "1"}, {"image/png", "2"}, {"", "3"}});
+  check(offers.size() == 1 && offers[0].entry == 0,
+      "Duplicates and entries without a type are skipped");
+
+  return failures == 0 ? 0 : 1;
+}
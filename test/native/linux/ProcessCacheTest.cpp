@@ -0,0 +1,68 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test reads the information about its own process and about a child process and
+// checks that the cache notices when the child exits.
+
+#include "ProcessCache.hpp"
+#include "TestUtils.hpp"
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+  uint32_t self = getpid();
+
+  auto info = readProcessInfo(self);
+  check(info.has_value(), "The own process is found");
+  check(info && info->executable.find("ProcessCacheTest") != std::string::npos,
+      "The executable is read");
+  check(info && info->commandLine.size() == size_t(argc) &&
+            info->commandLine[0] == argv[0],
+      "The command line is split into arguments");
+  check(info && readProcessStartTime(self) == info->startTime,
+      "The start time does not change");
+
+  ProcessCache cache;
+  check(!cache.get(0), "PID zero is ignored");
+
+  auto first  = cache.get(self);
+  auto second = cache.get(self);
+  check(first && first == second, "Known processes are cached");
+  check(cache.getLookups() == 1, "Known processes are not read again");
+
+  pid_t child = fork();
+  if (child == 0) {
+    pause();
+    _exit(0);
+  }
+
+  check(cache.get(child) != nullptr, "The child process is found");
+  check(cache.getLookups() == 2, "The child process is read once");
+
+  kill(child, SIGKILL);
+  waitpid(child, nullptr, 0);
+
+  check(!cache.get(child), "Exited processes are not reported");
+  check(!readProcessInfo(child), "Exited processes cannot be read");
+
+  cache.clear();
+  check(cache.get(self) != nullptr, "Processes are read again after clearing");
+
+  return failures == 0 ? 0 : 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test decodes some valid and some malformed UTF-8 strings.
+
+#include "TestUtils.hpp"
+#include "Utf8.hpp"
+
+#include <iostream>
+#include <string>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  check(decodeUtf8("").empty(), "Empty strings are empty");
+  check(decodeUtf8("Kando!\n") == U"Kando!\n", "ASCII is decoded");
+  check(decodeUtf8("\xC3\xA4\xE2\x82\xAC\xF0\x9F\x8D\xB0") == U"ä€\U0001F370",
+      "Two, three, and four byte sequences are decoded");
+
+  check(decodeUtf8("a\x80" "b") == U"a\uFFFD" "b",
+      "Stray continuation bytes are replaced");
+  check(decodeUtf8("a\xE2\x82" "b") == U"a\uFFFD" "b",
+      "Truncated sequences are replaced as a whole");
+  check(decodeUtf8("\xE2\x82") == U"\uFFFD",
+      "Sequences truncated by the end are replaced");
+  check(decodeUtf8("\xC0\xAF") == U"\uFFFD", "Overlong encodings are replaced");
+  check(decodeUtf8("\xED\xA0\x80") == U"\uFFFD", "Surrogates are replaced");
+  check(decodeUtf8("\xF4\x90\x80\x80") == U"\uFFFD",
+      "Code points above U+10FFFF are replaced");
+  check(decodeUtf8("\xFF" "a") == U"\uFFFD" "a", "Invalid lead bytes are replaced");
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This benchmark compares sending virtual key events with one roundtrip per event, as
+// simulateKey() does, with the batched path of simulateKeys() which waits only once per
+// sequence. It has to be run on a Wayland compositor which supports the
+// virtual-keyboard-unstable-v1 protocol. Only the left Shift key is pressed and released,
+// so the focused window should not receive any text. Usage:
+//
+//   ./VirtualKeyboardBenchmark [iterations] [sequence length]
+
+#include "VirtualKeyboard.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The XKB keycode of the left Shift key.
+const xkb_keycode_t SHIFT_KEYCODE = 50;
+
+struct Globals {
+  wl_seat*                         seat    = nullptr;
+  zwp_virtual_keyboard_manager_v1* manager = nullptr;
+};
+
+void addGlobal(void* data, wl_registry* registry, uint32_t name, const char* interface,
+    uint32_t version) {
+  auto* globals = static_cast<Globals*>(data);
+
+  if (std::strcmp(interface, wl_seat_interface.name) == 0 && !globals->seat) {
+    globals->seat = static_cast<wl_seat*>(
+        wl_registry_bind(registry, name, &wl_seat_interface, 1));
+  } else if (std::strcmp(
+                 interface, zwp_virtual_keyboard_manager_v1_interface.name) == 0) {
+    globals->manager = static_cast<zwp_virtual_keyboard_manager_v1*>(
+        wl_registry_bind(registry, name, &zwp_virtual_keyboard_manager_v1_interface, 1));
+  }
+}
+
+void removeGlobal(void*, wl_registry*, uint32_t) {
+}
+
+// The virtual keyboard needs a keymap before it accepts key events. We use the default
+// keymap of libxkbcommon.
+bool sendKeymap(zwp_virtual_keyboard_v1* keyboard, xkb_keymap* keymap) {
+  char* text = xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
+  if (!text) {
+    return false;
+  }
+
+  std::string keymapText(text);
+  free(text);
+
+  int fd = memfd_create("kando-benchmark-keymap", MFD_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  // The size includes the terminating null byte.
+  ssize_t size = keymapText.size() + 1;
+  if (write(fd, keymapText.c_str(), size) != size) {
+    close(fd);
+    return false;
+  }
+
+  zwp_virtual_keyboard_v1_keymap(keyboard, WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1, fd, size);
+  close(fd);
+  return true;
+}
+
+// Runs the given function the given number of times and prints the average wall time
+// per sequence, the number of events per second, and the number of roundtrips per
+// sequence.
+template <typename F>
+void run(std::string const& name, int iterations, int events, F&& function) {
+  int roundTrips = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    roundTrips += function();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double micros = std::chrono::duration<double, std::micro>(end - start).count();
+
+  std::cout << std::left << std::setw(24) << name << std::right << std::setw(14)
+            << std::fixed << std::setprecision(1) << micros / iterations << std::setw(14)
+            << std::setprecision(0) << 1e6 * events * iterations / micros << std::setw(14)
+            << roundTrips / iterations << std::endl;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 100;
+  int length     = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  wl_display* display = wl_display_connect(nullptr);
+  if (!display) {
+    std::cerr << "Failed to connect to the Wayland display!" << std::endl;
+    return 1;
+  }
+
+  Globals                    globals;
+  wl_registry*               registry = wl_display_get_registry(display);
+  const wl_registry_listener listener = {addGlobal, removeGlobal};
+  wl_registry_add_listener(registry, &listener, &globals);
+  wl_display_roundtrip(display);
+
+  if (!globals.seat || !globals.manager) {
+    std::cerr << "The compositor does not support virtual keyboards!" << std::endl;
+    return 1;
+  }
+
+  zwp_virtual_keyboard_v1* keyboard =
+      zwp_virtual_keyboard_manager_v1_create_virtual_keyboard(
+          globals.manager, globals.seat);
+
+  xkb_context* context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+  xkb_keymap*  keymap =
+      xkb_keymap_new_from_names(context, nullptr, XKB_KEYMAP_COMPILE_NO_FLAGS);
+  if (!keymap || !sendKeymap(keyboard, keymap)) {
+    std::cerr << "Failed to send the keymap!" << std::endl;
+    return 1;
+  }
+
+  xkb_state* state = xkb_state_new(keymap);
+  wl_display_roundtrip(display);
+
+  // A sequence of alternating presses and releases like a short macro.
+  std::vector<KeyEvent> sequence;
+  for (int i = 0; i < length; ++i) {
+    sequence.push_back({SHIFT_KEYCODE, i % 2 == 0});
+  }
+  if (length % 2 == 1) {
+    sequence.push_back({SHIFT_KEYCODE, false});
+  }
+
+  int events = sequence.size();
+
+  std::cout << "Benchmarking sequences of " << events << " key events with "
+            << iterations << " iterations." << std::endl
+            << std::endl;
+
+  std::cout << std::left << std::setw(24) << "Path" << std::right << std::setw(14)
+            << "Time [us]" << std::setw(14) << "Events / s" << std::setw(14)
+            << "Round Trips" << std::endl;
+
+  run("simulateKey per event", iterations, events, [&]() {
+    for (auto const& event : sequence) {
+      sendKeyEvents(keyboard, state, {event});
+      wl_display_roundtrip(display);
+    }
+    return events;
+  });
+
+  run("simulateKeys", iterations, events, [&]() {
+    sendKeyEvents(keyboard, state, sequence);
+    wl_display_roundtrip(display);
+    return 1;
+  });
+
+  xkb_state_unref(state);
+  xkb_keymap_unref(keymap);
+  xkb_context_unref(context);
+  zwp_virtual_keyboard_v1_destroy(keyboard);
+  zwp_virtual_keyboard_manager_v1_destroy(globals.manager);
+  wl_seat_destroy(globals.seat);
+  wl_registry_destroy(registry);
+  wl_display_disconnect(display);
+
+  return 0;
+}
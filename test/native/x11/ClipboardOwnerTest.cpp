@@ -0,0 +1,239 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test sets the clipboard with the ClipboardOwner and reads it back from another
+// connection like any other client would. It also transfers a payload which is large
+// enough to be sent incrementally. It needs an X server, like Xvfb.
+
+#include "ClipboardOwner.hpp"
+#include "TestUtils.hpp"
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Waits for an event which satisfies the given condition.
+std::optional<XEvent> waitForEvent(
+    Display* display, std::function<bool(XEvent const&)> const& condition) {
+  auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+  while (std::chrono::steady_clock::now() < timeout) {
+    while (XPending(display) > 0) {
+      XEvent event;
+      XNextEvent(display, &event);
+      if (condition(event)) {
+        return event;
+      }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+
+  return std::nullopt;
+}
+
+// The converted content of a selection.
+struct Conversion {
+  Atom        type = None;
+  std::string data;
+
+  // This contains the values of properties with a format of 32.
+  std::vector<unsigned long> values;
+
+  bool incremental = false;
+};
+
+// Reads and deletes the given property.
+bool readProperty(Display* display, Window window, Atom property, Conversion& result) {
+  Atom           type;
+  int            format;
+  unsigned long  count, remaining;
+  unsigned char* data = nullptr;
+
+  if (XGetWindowProperty(display, window, property, 0, 0x1FFFFFFF, True,
+          AnyPropertyType, &type, &format, &count, &remaining, &data) != Success) {
+    return false;
+  }
+
+  result.type = type;
+
+  if (format == 8) {
+    result.data.append(reinterpret_cast<char*>(data), count);
+  } else if (format == 32) {
+    auto* values = reinterpret_cast<unsigned long*>(data);
+    result.values.assign(values, values + count);
+  }
+
+  XFree(data);
+  return true;
+}
+
+// Asks the owner of the selection to convert it to the given target. Incremental
+// transfers are read until the end. Returns nothing if the conversion is refused.
+std::optional<Conversion> convert(
+    Display* display, Window window, Atom selection, Atom target) {
+  Atom property = XInternAtom(display, "KANDO_TEST", False);
+  Atom incr     = XInternAtom(display, "INCR", False);
+
+  XConvertSelection(display, selection, target, property, window, CurrentTime);
+
+  auto notification = waitForEvent(display, [&](XEvent const& event) {
+    return event.type == SelectionNotify && event.xselection.requestor == window;
+  });
+
+  if (!notification || notification->xselection.property == None) {
+    return std::nullopt;
+  }
+
+  Conversion result;
+  if (!readProperty(display, window, property, result)) {
+    return std::nullopt;
+  }
+
+  if (result.type != incr) {
+    return result;
+  }
+
+  // Deleting the INCR property asks for the first chunk. Each chunk is read and deleted
+  // once it has been written. An empty chunk marks the end.
+  Conversion chunk;
+  result.incremental = true;
+  result.type        = None;
+
+  do {
+    auto written = waitForEvent(display, [&](XEvent const& event) {
+      return event.type == PropertyNotify && event.xproperty.window == window &&
+             event.xproperty.atom == property &&
+             event.xproperty.state == PropertyNewValue;
+    });
+
+    chunk.data.clear();
+    if (!written || !readProperty(display, window, property, chunk)) {
+      return std::nullopt;
+    }
+
+    result.type = chunk.type;
+    result.data += chunk.data;
+  } while (!chunk.data.empty());
+
+  return result;
+}
+
+bool contains(std::vector<unsigned long> const& values, Atom atom) {
+  return std::find(values.begin(), values.end(), atom) != values.end();
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  Display* display = XOpenDisplay(nullptr);
+  if (!display) {
+    std::cerr << "Failed to connect to the X server!" << std::endl;
+    return 1;
+  }
+
+  Atom clipboard  = XInternAtom(display, "CLIPBOARD", False);
+  Atom targets    = XInternAtom(display, "TARGETS", False);
+  Atom timestamp  = XInternAtom(display, "TIMESTAMP", False);
+  Atom text       = XInternAtom(display, "TEXT", False);
+  Atom utf8String = XInternAtom(display, "UTF8_STRING", False);
+  Atom plainText  = XInternAtom(display, "text/plain", False);
+  Atom html       = XInternAtom(display, "text/html", False);
+  Atom png        = XInternAtom(display, "image/png", False);
+
+  // The requestor window. It has to receive property changes for incremental transfers.
+  Window window = XCreateSimpleWindow(
+      display, DefaultRootWindow(display), 0, 0, 1, 1, 0, 0, 0);
+  XSelectInput(display, window, PropertyChangeMask);
+
+  ClipboardOwner owner;
+  check(!owner.set({{"text/plain", "Kando"}}), "Nothing is set before the owner starts");
+  check(owner.start() && owner.isRunning(), "The owner is started");
+  check(!owner.set({}), "Empty content is not set");
+
+  check(owner.set({{"text/plain", "Kando"}, {"text/html", "<b>Kando</b>"}}),
+      "The clipboard is set");
+  check(XGetSelectionOwner(display, clipboard) != None, "The clipboard has an owner");
+
+  auto result = convert(display, window, clipboard, targets);
+  check(result && result->type == XA_ATOM && contains(result->values, targets) &&
+            contains(result->values, timestamp) && contains(result->values, plainText) &&
+            contains(result->values, html) && contains(result->values, utf8String) &&
+            contains(result->values, text),
+      "All targets are announced");
+
+  result = convert(display, window, clipboard, utf8String);
+  check(result && result->type == utf8String && result->data == "Kando",
+      "Plain text is converted to UTF8_STRING");
+
+  result = convert(display, window, clipboard, text);
+  check(result && result->type == utf8String && result->data == "Kando",
+      "TEXT is sent as UTF-8");
+
+  result = convert(display, window, clipboard, html);
+  check(result && result->type == html && result->data == "<b>Kando</b>",
+      "HTML is converted");
+
+  result = convert(display, window, clipboard, timestamp);
+  check(result && result->type == XA_INTEGER && result->values.size() == 1 &&
+            result->values[0] != CurrentTime,
+      "The time of the ownership is reported");
+
+  check(!convert(display, window, clipboard, png), "Other targets are refused");
+
+  // This is larger than the largest chunk, so it is sent incrementally.
+  std::string large(1024 * 1024 + 17, '\0');
+  for (size_t i = 0; i < large.size(); ++i) {
+    large[i] = 'a' + i % 26;
+  }
+
+  check(owner.set({{"text/plain", large}}, true), "The primary selection is set");
+
+  result = convert(display, window, XA_PRIMARY, utf8String);
+  check(result && result->incremental && result->type == utf8String &&
+            result->data == large,
+      "Large payloads are sent incrementally");
+
+  result = convert(display, window, clipboard, plainText);
+  check(result && result->data == "Kando", "The clipboard is not changed by PRIMARY");
+
+  // If another client takes the clipboard, the owner drops its content.
+  XSetSelectionOwner(display, clipboard, window, CurrentTime);
+  XSync(display, False);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  check(owner.set({{"text/plain", "Again"}}), "The clipboard is taken back");
+  result = convert(display, window, clipboard, plainText);
+  check(result && result->data == "Again", "The new content is converted");
+
+  owner.stop();
+  XSync(display, False);
+  check(XGetSelectionOwner(display, clipboard) == None &&
+            XGetSelectionOwner(display, XA_PRIMARY) == None,
+      "The selections are released when the owner stops");
+
+  XCloseDisplay(display);
+
+  return failures == 0 ? 0 : 1;
+}
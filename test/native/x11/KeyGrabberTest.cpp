@@ -0,0 +1,186 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test parses some accelerators and then simulates key presses with XTest to check
+// that the KeyGrabber reports grabbed shortcuts. It should be run on a virtual X server
+// like Xvfb, as it types on the real keyboard.
+
+#include "KeyGrabber.hpp"
+#include "TestUtils.hpp"
+
+#include <X11/XKBlib.h>
+#include <X11/extensions/XTest.h>
+#include <X11/keysym.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+bool parsesTo(std::string const& accelerator, KeySym keysym, unsigned int modifiers) {
+  auto parsed = parseAccelerator(accelerator);
+  return parsed && parsed->keysym == keysym && parsed->modifiers == modifiers;
+}
+
+void simulateKey(Display* display, KeySym keysym, bool down) {
+  XTestFakeKeyEvent(display, XKeysymToKeycode(display, keysym), down, CurrentTime);
+  XFlush(display);
+}
+
+// Collects the events reported by the KeyGrabber. The callback is called from the event
+// thread, so we have to protect the list.
+class Recorder {
+ public:
+  void add(std::string const& accelerator, bool pressed) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEvents.push_back((pressed ? "+" : "-") + accelerator);
+  }
+
+  // Waits until exactly the given events have been reported and clears the list.
+  bool expect(std::vector<std::string> const& events) {
+    bool result = waitFor([&]() {
+      std::lock_guard<std::mutex> lock(mMutex);
+      return mEvents == events;
+    });
+
+    // Make sure that nothing else follows.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    result = result && mEvents == events;
+    mEvents.clear();
+
+    return result;
+  }
+
+ private:
+  std::mutex               mMutex;
+  std::vector<std::string> mEvents;
+};
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  check(parsesTo("Control+Shift+K", XK_k, ControlMask | ShiftMask),
+      "Modifiers are parsed");
+  check(parsesTo("ctrl+alt+Delete", XK_Delete, ControlMask | Mod1Mask),
+      "Names are case-insensitive");
+  check(parsesTo("Super+Plus", XK_plus, Mod4Mask), "Named keys are parsed");
+  check(parsesTo("F12", XK_F12, 0), "Function keys are parsed");
+  check(parsesTo("Alt+num7", XK_KP_7, Mod1Mask), "Number pad keys are parsed");
+  check(parsesTo("Meta+.", XK_period, Mod4Mask), "Punctuation is parsed");
+  check(parsesTo("Command+K", XK_k, Mod4Mask) && parsesTo("Cmd+K", XK_k, Mod4Mask),
+      "Command is the Super key like in Electron");
+  check(parsesTo("CmdOrCtrl+K", XK_k, ControlMask), "CommandOrControl is Control");
+  check(!parseAccelerator("Control+Shift"), "A key is required");
+  check(!parseAccelerator("A+B"), "Only one key is allowed");
+  check(!parseAccelerator("Control++"), "Empty names are rejected");
+  check(!parseAccelerator("Hyper+X"), "Unknown names are rejected");
+
+  XInitThreads();
+
+  Display* display = XOpenDisplay(nullptr);
+  if (!display) {
+    std::cerr << "Failed to connect to the X server!" << std::endl;
+    return 1;
+  }
+
+  // This other client grabs a key before the KeyGrabber tries to.
+  XGrabKey(display, XKeysymToKeycode(display, XK_F1), Mod1Mask,
+      DefaultRootWindow(display), True, GrabModeAsync, GrabModeAsync);
+  XSync(display, False);
+
+  Recorder   recorder;
+  KeyGrabber grabber;
+  grabber.setCallback([&](std::string const& accelerator, bool pressed, uint32_t) {
+    recorder.add(accelerator, pressed);
+  });
+  grabber.start();
+
+  // Shortcuts which are passed before the grabber is connected are grabbed later on. So
+  // we can only detect the conflict once the grabber has connected.
+  check(waitFor([&]() {
+    grabber.setShortcuts({});
+    return grabber.setShortcuts({"Alt+F1"}).size() == 1;
+  }),
+      "Conflicting shortcuts are reported");
+
+  auto failed = grabber.setShortcuts({"Control+K", "Nonsense+K"});
+  check(failed.size() == 1 && failed[0] == "Nonsense+K",
+      "Invalid shortcuts are reported");
+
+  simulateKey(display, XK_Control_L, true);
+  simulateKey(display, XK_k, true);
+  simulateKey(display, XK_k, false);
+  check(recorder.expect({"+Control+K"}), "Pressing a shortcut is reported");
+
+  simulateKey(display, XK_Control_L, false);
+  check(recorder.expect({"-Control+K"}), "Releasing the modifier releases the shortcut");
+
+  simulateKey(display, XK_Control_L, true);
+  simulateKey(display, XK_k, true);
+  simulateKey(display, XK_k, true);
+  simulateKey(display, XK_k, true);
+  simulateKey(display, XK_Control_L, false);
+  simulateKey(display, XK_k, false);
+  check(recorder.expect({"+Control+K", "-Control+K"}),
+      "Key repeat is ignored and the shortcut is released with its key");
+
+  // Lock Num Lock and Caps Lock. The shortcut should still work.
+  unsigned int locks = LockMask | XkbKeysymToModifiers(display, XK_Num_Lock);
+  XkbLockModifiers(display, XkbUseCoreKbd, locks, locks);
+  XFlush(display);
+
+  simulateKey(display, XK_Control_L, true);
+  simulateKey(display, XK_k, true);
+  simulateKey(display, XK_k, false);
+  simulateKey(display, XK_Control_L, false);
+  check(recorder.expect({"+Control+K", "-Control+K"}),
+      "Shortcuts work with Num Lock and Caps Lock");
+
+  XkbLockModifiers(display, XkbUseCoreKbd, locks, 0);
+  XFlush(display);
+
+  grabber.setInhibited("Control+K", true);
+  simulateKey(display, XK_Control_L, true);
+  simulateKey(display, XK_k, true);
+  simulateKey(display, XK_k, false);
+  simulateKey(display, XK_Control_L, false);
+  check(recorder.expect({"-Control+K"}),
+      "Only releases of inhibited shortcuts are reported");
+
+  grabber.setInhibited("Control+K", false);
+  simulateKey(display, XK_Control_L, true);
+  simulateKey(display, XK_k, true);
+  simulateKey(display, XK_k, false);
+  simulateKey(display, XK_Control_L, false);
+  check(recorder.expect({"+Control+K", "-Control+K"}), "Inhibition can be lifted");
+
+  grabber.setShortcuts({});
+  simulateKey(display, XK_Control_L, true);
+  simulateKey(display, XK_k, true);
+  simulateKey(display, XK_k, false);
+  simulateKey(display, XK_Control_L, false);
+  check(recorder.expect({}), "Unbound shortcuts are not reported");
+
+  grabber.stop();
+  XCloseDisplay(display);
+
+  return failures == 0 ? 0 : 1;
+}
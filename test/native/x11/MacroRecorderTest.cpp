@@ -0,0 +1,126 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test simulates key and button presses with XTest while the MacroRecorder is
+// running and checks that they are recorded with the correct delays. XTest delays the
+// events on the server, so the server time stamps have to reflect the delays exactly. It
+// should be run on a virtual X server like Xvfb, as it types on the real keyboard.
+
+#include "MacroRecorder.hpp"
+#include "TestUtils.hpp"
+
+#include <X11/extensions/XTest.h>
+#include <X11/keysym.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Builds a protocol event like the ones delivered by the RECORD extension.
+std::vector<uint8_t> makeEvent(uint8_t type, uint8_t detail, uint32_t time) {
+  std::vector<uint8_t> data(32, 0);
+  data[0] = type;
+  data[1] = detail;
+  std::memcpy(data.data() + 4, &time, sizeof(time));
+  return data;
+}
+
+// The server time may be a bit late if the X server is busy, but never early.
+bool hasDelay(RecordedEvent const& event, uint32_t delay) {
+  return event.delay >= delay && event.delay < delay + 20;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  auto keyPress = makeEvent(KeyPress, 38, 1234);
+  auto parsed   = parseRecordedEvent(keyPress.data(), keyPress.size());
+  check(parsed && parsed->detail == 38 && parsed->down && !parsed->isButton &&
+            parsed->time == 1234,
+      "Key presses are parsed");
+
+  auto buttonRelease = makeEvent(ButtonRelease | 0x80, 3, 0);
+  parsed             = parseRecordedEvent(buttonRelease.data(), buttonRelease.size());
+  check(parsed && parsed->detail == 3 && !parsed->down && parsed->isButton,
+      "Sent button releases are parsed");
+
+  auto motion = makeEvent(MotionNotify, 0, 0);
+  check(!parseRecordedEvent(motion.data(), motion.size()), "Motion events are ignored");
+  check(!parseRecordedEvent(keyPress.data(), 16), "Truncated events are ignored");
+
+  XInitThreads();
+
+  Display* display = XOpenDisplay(nullptr);
+  if (!display) {
+    std::cerr << "Failed to connect to the X server!" << std::endl;
+    return 1;
+  }
+
+  KeyCode a = XKeysymToKeycode(display, XK_a);
+  KeyCode b = XKeysymToKeycode(display, XK_b);
+
+  MacroRecorder recorder;
+  check(recorder.start(), "The recording is started");
+  check(recorder.isRecording(), "The recorder reports that it is recording");
+
+  // The context is enabled asynchronously by the recording thread.
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  XTestFakeKeyEvent(display, a, True, CurrentTime);
+  XTestFakeKeyEvent(display, a, False, 50);
+  XTestFakeKeyEvent(display, b, True, 120);
+  XTestFakeKeyEvent(display, b, False, 30);
+  XTestFakeButtonEvent(display, 1, True, 40);
+  XTestFakeButtonEvent(display, 1, False, 10);
+  XSync(display, False);
+
+  std::vector<RecordedEvent> events = recorder.stop();
+  check(!recorder.isRecording(), "The recording is stopped");
+
+  check(events.size() == 6, "All events are recorded");
+
+  if (events.size() == 6) {
+    check(events[0].detail == a && events[0].down && events[0].delay == 0,
+        "The first event has no delay");
+    check(events[1].detail == a && !events[1].down && hasDelay(events[1], 50),
+        "Key releases are recorded with their delay");
+    check(events[2].detail == b && events[2].down && hasDelay(events[2], 120),
+        "Key presses are recorded with their delay");
+    check(events[3].detail == b && !events[3].down && hasDelay(events[3], 30),
+        "Short delays are preserved");
+    check(events[4].isButton && events[4].detail == 1 && events[4].down &&
+              hasDelay(events[4], 40),
+        "Button presses are recorded");
+    check(events[5].isButton && !events[5].down && hasDelay(events[5], 10),
+        "Button releases are recorded");
+  }
+
+  check(recorder.stop().empty(), "Stopping twice returns nothing");
+
+  // A second recording must not contain the events of the first one.
+  check(recorder.start(), "The recording is restarted");
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  check(recorder.stop().empty(), "A new recording starts empty");
+
+  XCloseDisplay(display);
+
+  return failures == 0 ? 0 : 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,117 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test checks the lookups of the MonitorIndex against a brute-force search for a
+// couple of monitor layouts. It does not need an X server.
+
+#include "MonitorIndex.hpp"
+#include "TestUtils.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+Monitor makeMonitor(int x, int y, int width, int height) {
+  Monitor monitor;
+  monitor.geometry = {x, y, width, height};
+  monitor.workArea = monitor.geometry;
+  return monitor;
+}
+
+// Returns the index of the monitor which contains the given point or -1.
+int bruteForce(std::vector<Monitor> const& monitors, int x, int y) {
+  for (size_t i = 0; i < monitors.size(); ++i) {
+    if (monitors[i].geometry.contains(x, y)) {
+      return static_cast<int>(i);
+    }
+  }
+
+  return -1;
+}
+
+// Compares the index with a brute-force search for many random points on the monitors.
+bool matchesBruteForce(std::vector<Monitor> const& monitors) {
+  MonitorIndex index;
+  index.build(monitors);
+
+  std::mt19937 random(42);
+
+  for (int i = 0; i < 100000; ++i) {
+    Rect const& geometry = monitors[random() % monitors.size()].geometry;
+
+    int x = geometry.x + static_cast<int>(random() % geometry.width);
+    int y = geometry.y + static_cast<int>(random() % geometry.height);
+
+    Monitor const* monitor  = index.find(x, y);
+    int            expected = bruteForce(monitors, x, y);
+
+    if (!monitor || monitor != &index.getMonitors()[expected]) {
+      std::cout << "Wrong monitor at " << x << ", " << y << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  MonitorIndex empty;
+  check(empty.find(0, 0) == nullptr, "Empty index returns nullptr");
+
+  check(matchesBruteForce({makeMonitor(0, 0, 1920, 1080)}), "Single monitor");
+
+  // Two monitors with different resolutions, aligned at the bottom.
+  std::vector<Monitor> pair = {
+      makeMonitor(0, 360, 1920, 1080),
+      makeMonitor(1920, 0, 2560, 1440),
+  };
+  check(matchesBruteForce(pair), "Two monitors with different heights");
+
+  // A 3x2 wall of 4K monitors.
+  std::vector<Monitor> wall;
+  for (int y = 0; y < 2; ++y) {
+    for (int x = 0; x < 3; ++x) {
+      wall.push_back(makeMonitor(x * 3840, y * 2160, 3840, 2160));
+    }
+  }
+  check(matchesBruteForce(wall), "Six monitors in a grid");
+
+  // Eight monitors with odd sizes, a portrait monitor, and negative coordinates.
+  std::vector<Monitor> mixed = {
+      makeMonitor(-1080, -200, 1080, 1920),
+      makeMonitor(0, 0, 2560, 1440),
+      makeMonitor(2560, 0, 1920, 1080),
+      makeMonitor(4480, 100, 1366, 768),
+      makeMonitor(0, 1440, 1280, 1024),
+      makeMonitor(1280, 1440, 1280, 1024),
+      makeMonitor(2560, 1080, 3840, 2160),
+      makeMonitor(6400, 1080, 800, 600),
+  };
+  check(matchesBruteForce(mixed), "Eight monitors with mixed sizes");
+
+  // Points in gaps and outside of all monitors resolve to the closest monitor.
+  MonitorIndex index;
+  index.build(mixed);
+  check(index.find(-5000, 0) == &index.getMonitors()[0], "Far left uses closest monitor");
+  check(index.find(7000, 0) == &index.getMonitors()[3],
+      "Gap on the right uses closest monitor");
+  check(index.find(5000, 5000) == &index.getMonitors()[6],
+      "Below all monitors uses closest monitor");
+
+  return failures == 0 ? 0 : 1;
+}
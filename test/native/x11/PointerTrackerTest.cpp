@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test moves the pointer with XTest and checks that the PointerTracker follows it.
+// It should be run on a virtual X server like Xvfb, as it moves the real pointer.
+
+#include "PointerTracker.hpp"
+#include "TestUtils.hpp"
+
+#include <X11/extensions/XTest.h>
+#include <sys/resource.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+void movePointer(Display* display, int x, int y) {
+  XTestFakeMotionEvent(display, -1, x, y, CurrentTime);
+  XFlush(display);
+}
+
+bool snapshotIs(PointerTracker const& tracker, int x, int y) {
+  return waitFor([&]() {
+    auto snapshot = tracker.getSnapshot();
+    return snapshot && snapshot->x == x && snapshot->y == y;
+  });
+}
+
+// Returns the CPU time used by this process in milliseconds.
+double getCPUTime() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  XInitThreads();
+
+  Display* display = XOpenDisplay(nullptr);
+  if (!display) {
+    std::cerr << "Failed to connect to the X server!" << std::endl;
+    return 1;
+  }
+
+  PointerTracker tracker;
+  check(tracker.start(), "Tracker starts");
+  check(tracker.isRunning(), "Tracker is running");
+  check(!tracker.getSnapshot(), "There is no snapshot before the pointer moved");
+
+  movePointer(display, 100, 200);
+  check(snapshotIs(tracker, 100, 200), "Snapshot follows the pointer");
+
+  movePointer(display, 0, 0);
+  check(snapshotIs(tracker, 0, 0), "Snapshot follows the pointer to the origin");
+
+  // The sample rate should roughly match the rate at which we move the pointer.
+  for (int i = 0; i < 100; ++i) {
+    movePointer(display, 10 + i, 10 + i);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+
+  check(snapshotIs(tracker, 109, 109), "Snapshot follows fast movements");
+
+  double sampleRate = tracker.getSampleRate();
+  check(sampleRate > 20.0 && sampleRate < 250.0,
+      "Sample rate is plausible (" + std::to_string(sampleRate) + " Hz)");
+
+  // The tracker thread should sleep while the pointer is not moving.
+  double cpuTime = getCPUTime();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  double idleTime = getCPUTime() - cpuTime;
+  check(idleTime < 20.0,
+      "Tracker is idle without motion (" + std::to_string(idleTime) + " ms CPU time)");
+
+  tracker.stop();
+  check(!tracker.isRunning(), "Tracker stops");
+
+  check(tracker.start(), "Tracker restarts");
+  movePointer(display, 300, 50);
+  check(snapshotIs(tracker, 300, 50), "Snapshot follows the pointer after a restart");
+  tracker.stop();
+
+  XCloseDisplay(display);
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test checks that large window properties are read in chunks and that the window
+// queries do not leak memory. It calls all queries many times and fails if the resident
+// memory of the process keeps growing. It is also run under valgrind and with the
+// address sanitizer if they are available. In this case, --leaks-only should be passed
+// since the tools affect the memory usage themselves. Usage:
+//
+//   ./QueryLeakTest [iterations] [--leaks-only]
+
+#include "Connection.hpp"
+#include "PropertyReader.hpp"
+#include "TestUtils.hpp"
+#include "WindowQueries.hpp"
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Returns the resident set size of this process in bytes.
+size_t getResidentSize() {
+  std::ifstream statm("/proc/self/statm");
+  size_t        size     = 0;
+  size_t        resident = 0;
+  statm >> size >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+// Calls all queries which read window properties once.
+void runQueries(Connection& connection, Window window) {
+  auto clients = queryClientList(connection);
+  clients.push_back(window);
+
+  queryWindowInfos(connection, clients);
+  queryStackingOrder(connection);
+  queryWMState(connection);
+  queryIcon(connection, window);
+  queryResources(connection);
+  queryMonitors(connection, 1.0);
+  queryXSettingsOwner(connection);
+  queryXSettings(connection, window);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+  int  iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+  bool leaksOnly  = argc > 2 && std::string(argv[2]) == "--leaks-only";
+
+  Display* display = XOpenDisplay(nullptr);
+  if (!display) {
+    std::cerr << "Failed to connect to the X server!" << std::endl;
+    return 1;
+  }
+
+  Window root   = DefaultRootWindow(display);
+  Window window = XCreateSimpleWindow(display, root, 0, 0, 100, 100, 0, 0, 0);
+
+  // The icon is much larger than a single chunk of the PropertyReader.
+  Atom              netWmIcon = XInternAtom(display, "_NET_WM_ICON", False);
+  uint32_t          iconSize  = 256;
+  std::vector<long> icon      = {iconSize, iconSize};
+  for (uint32_t i = 0; i < iconSize * iconSize; ++i) {
+    icon.push_back(i);
+  }
+
+  // Xlib expects 32-bit properties as longs.
+  XChangeProperty(display, window, netWmIcon, XA_CARDINAL, 32, PropModeReplace,
+      reinterpret_cast<unsigned char*>(icon.data()), icon.size());
+
+  // The resource string is larger than a chunk as well. It ends with an odd number of
+  // bytes so that the last chunk is not aligned.
+  std::string resources = "Xft.dpi: 192\n";
+  while (resources.size() < 100000) {
+    resources += "! This comment makes the resource string longer.\n";
+  }
+  resources += "!";
+
+  XChangeProperty(display, root, XA_RESOURCE_MANAGER, XA_STRING, 8, PropModeReplace,
+      reinterpret_cast<unsigned char const*>(resources.data()), resources.size());
+
+  XSync(display, False);
+
+  Connection connection;
+  if (!connection.get()) {
+    std::cerr << "Failed to open the query connection!" << std::endl;
+    return 1;
+  }
+
+  QueryStats stats;
+  auto       data = queryIcon(connection, window, &stats);
+
+  bool iconMatches = data.size() == icon.size();
+  for (size_t i = 0; iconMatches && i < data.size(); ++i) {
+    iconMatches = data[i] == static_cast<uint32_t>(icon[i]);
+  }
+
+  check(iconMatches, "Large icons are read completely");
+  check(stats.roundTrips > 1 && stats.roundTrips == stats.requests,
+      "Large icons are read in chunks");
+
+  stats = {};
+  check(queryResources(connection, &stats) == resources,
+      "Large resource strings are read completely");
+  check(stats.roundTrips > 1, "Large resource strings are read in chunks");
+  check(parseScalingFactor(queryResources(connection)) == 2.0,
+      "The scaling factor is read from the resources");
+
+  // The reader must not read more than it is asked for.
+  PropertyReader reader;
+
+  xcb_connection_t* xcb    = connection.getXCB();
+  auto              cookie = PropertyReader::request(xcb, window, netWmIcon, XA_CARDINAL);
+
+  auto property = reader.read(xcb, cookie, window, netWmIcon, XA_CARDINAL, 1000);
+  check(property && property->size == 4000, "Properties are truncated to the limit");
+
+  cookie   = PropertyReader::request(xcb, window, XA_WM_NAME, XA_STRING);
+  property = reader.read(xcb, cookie, window, XA_WM_NAME, XA_STRING, 1000);
+  check(!property, "Missing properties are reported as such");
+
+  // After reading a large property, the buffer is released again.
+  queryIcon(connection, window);
+  queryClientList(connection);
+  check(connection.getPropertyReader().getBufferCapacity() <=
+            PropertyReader::MAX_RETAINED_SIZE,
+      "The buffer does not keep large allocations");
+
+  // The first iterations may still allocate some caches in Xlib and in the allocator.
+  for (int i = 0; i < 20; ++i) {
+    runQueries(connection, window);
+  }
+
+  size_t before = getResidentSize();
+
+  for (int i = 0; i < iterations; ++i) {
+    runQueries(connection, window);
+  }
+
+  size_t after  = getResidentSize();
+  size_t growth = after > before ? after - before : 0;
+
+  std::cout << "Memory growth after " << iterations << " iterations: " << growth / 1024
+            << " KiB" << std::endl;
+
+  if (!leaksOnly) {
+    check(growth < 2 * 1024 * 1024, "Repeated queries do not increase the memory usage");
+  }
+
+  XDestroyWindow(display, window);
+  XDeleteProperty(display, root, XA_RESOURCE_MANAGER);
+  XCloseDisplay(display);
+
+  return failures == 0 ? 0 : 1;
+}
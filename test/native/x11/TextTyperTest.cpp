@@ -0,0 +1,173 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test types text with the TextTyper into a window and checks which keysyms the
+// window receives. It also checks that the keymap table is only rebuilt if the keymap is
+// changed by someone else. It should be run on a virtual X server like Xvfb, as it types
+// on the real keyboard and changes the keymap.
+
+#include "TestUtils.hpp"
+#include "TextTyper.hpp"
+#include "Utf8.hpp"
+
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Collects the keysyms of the key presses received by the window until the given number
+// has been received or until a second has passed. Presses of modifier keys are skipped.
+std::vector<KeySym> receiveKeysyms(Display* display, size_t count) {
+  std::vector<KeySym> keysyms;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+  while (keysyms.size() < count && std::chrono::steady_clock::now() < deadline) {
+    while (XPending(display) > 0) {
+      XEvent event;
+      XNextEvent(display, &event);
+
+      if (event.type == MappingNotify) {
+        XRefreshKeyboardMapping(&event.xmapping);
+      } else if (event.type == KeyPress) {
+        char   buffer[16];
+        KeySym keysym = NoSymbol;
+        XLookupString(&event.xkey, buffer, sizeof(buffer), &keysym, nullptr);
+        if (!IsModifierKey(keysym)) {
+          keysyms.push_back(keysym);
+        }
+      }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  return keysyms;
+}
+
+std::vector<KeySym> toKeysyms(std::u32string const& text) {
+  std::vector<KeySym> keysyms;
+  for (char32_t codepoint : text) {
+    keysyms.push_back(keysymFromCodepoint(codepoint));
+  }
+  return keysyms;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  check(keysymFromCodepoint('a') == XK_a, "ASCII characters have their own keysyms");
+  check(keysymFromCodepoint(U'ä') == XK_adiaeresis, "Latin-1 has its own keysyms");
+  check(keysymFromCodepoint(U'€') == 0x010020AC, "Other characters use Unicode keysyms");
+  check(keysymFromCodepoint('\n') == XK_Return, "Newlines are typed with Return");
+  check(keysymFromCodepoint('\r') == NoSymbol, "Carriage returns are skipped");
+  check(keysymFromCodepoint(0x7F) == NoSymbol, "Other control characters are skipped");
+
+  KeysymTable table;
+  table.add(XK_a, {38, ShiftMask});
+  table.add(XK_a, {40, 0});
+  table.add(XK_a, {42, 0});
+  table.add(XK_b, {56, ShiftMask | Mod5Mask});
+  table.add(XK_b, {57, Mod5Mask});
+  check(table.size() == 2, "Each keysym is stored once");
+  check(table.find(XK_a) && table.find(XK_a)->keycode == 40,
+      "The first key without modifiers is preferred");
+  check(table.find(XK_b) && table.find(XK_b)->keycode == 57,
+      "Keys with fewer modifiers are preferred");
+  check(!table.find(XK_c), "Missing keysyms are not found");
+
+  Display* display  = XOpenDisplay(nullptr);
+  Display* receiver = XOpenDisplay(nullptr);
+  if (!display || !receiver) {
+    std::cerr << "Failed to connect to the X server!" << std::endl;
+    return 1;
+  }
+
+  // The window which receives the typed text.
+  Window window = XCreateSimpleWindow(
+      receiver, DefaultRootWindow(receiver), 0, 0, 100, 100, 0, 0, 0);
+  XSelectInput(receiver, window, KeyPressMask | StructureNotifyMask);
+  XMapWindow(receiver, window);
+
+  XEvent event;
+  do {
+    XNextEvent(receiver, &event);
+  } while (event.type != MapNotify);
+
+  XSetInputFocus(receiver, window, RevertToParent, CurrentTime);
+  XSync(receiver, False);
+
+  TextTyper typer;
+  check(!typer.type(display, "a"), "Nothing is typed before the typer is reset");
+  check(typer.reset(display), "The typer is reset");
+
+  std::u32string text = U"Hello, World!\n";
+  check(typer.type(display, "Hello, World!\r\n"), "ASCII text is typed");
+  check(receiveKeysyms(receiver, text.size()) == toKeysyms(text),
+      "Shifted and unshifted characters are received in order");
+
+  // These are not part of the US layout of Xvfb.
+  text = U"äÄ€ä";
+  check(typer.type(display, "äÄ€ä"), "Missing characters are typed");
+  check(receiveKeysyms(receiver, text.size()) == toKeysyms(text),
+      "Missing characters are received via spare keys");
+
+  // The events caused by assigning the spare keys must not invalidate the table.
+  XSync(display, False);
+  check(typer.type(display, "a"), "Text is typed again");
+  check(receiveKeysyms(receiver, 1) == toKeysyms(U"a"), "The text is received");
+  check(typer.getTableBuilds() == 1, "The table is built only once");
+
+  // If someone else changes the keymap, the table has to be rebuilt.
+  KeyCode q          = XKeysymToKeycode(receiver, XK_q);
+  KeySym  keysyms[2] = {XK_q, XK_Q};
+  XChangeKeyboardMapping(receiver, q, 2, keysyms, 1);
+  XSync(receiver, False);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  check(typer.type(display, "Qq"), "Text is typed after a keymap change");
+  check(receiveKeysyms(receiver, 2) == toKeysyms(U"Qq"), "The text is still received");
+  check(typer.getTableBuilds() == 2, "The table is rebuilt after a keymap change");
+
+  // With more distinct missing characters than spare keys, the text is sent in batches.
+  // The receiver looks up the keysyms only now, so it would see the last assignment of
+  // the reused spare keys. Hence, only the number of key presses is checked.
+  std::string many = "αβγδεζηθικλμνξοπρστυφχψωабвгдежзийклмнопрстуфхцчшщъыьэюя";
+  text             = decodeUtf8(many);
+  check(typer.type(display, many), "Many missing characters are typed");
+  check(receiveKeysyms(receiver, text.size()).size() == text.size(),
+      "All of them are received");
+
+  typer.restoreSpareKeys(display);
+  XSync(display, False);
+
+  Display* fresh = XOpenDisplay(nullptr);
+  check(fresh && XKeysymToKeycode(fresh, XK_adiaeresis) == 0 &&
+            XKeysymToKeycode(fresh, 0x010020AC) == 0,
+      "The spare keys are cleared again");
+
+  if (fresh) {
+    XCloseDisplay(fresh);
+  }
+
+  XCloseDisplay(receiver);
+  XCloseDisplay(display);
+
+  return failures == 0 ? 0 : 1;
+}
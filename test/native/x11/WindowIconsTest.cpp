@@ -0,0 +1,101 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test checks how icons are picked from _NET_WM_ICON data and how they are scaled
+// down. It does not need an X server.
+
+#include "TestUtils.hpp"
+#include "WindowIcons.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Appends an icon of the given size filled with a single ARGB color.
+void appendIcon(std::vector<uint32_t>& data, uint32_t width, uint32_t height,
+    uint32_t argb) {
+  data.push_back(width);
+  data.push_back(height);
+  data.insert(data.end(), width * height, argb);
+}
+
+// Returns true if all pixels of the icon have the given RGBA color, allowing for an
+// error of one due to rounding.
+bool isUniform(Icon const& icon, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+  uint8_t const expected[4] = {r, g, b, a};
+  for (size_t i = 0; i < icon.rgba.size(); ++i) {
+    if (std::abs(icon.rgba[i] - expected[i % 4]) > 1) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+
+  // Invalid data does not yield an icon.
+  check(!scaleIcon({}, 32), "Empty data has no icon");
+  check(!scaleIcon({16, 16, 0xffffffff}, 32), "Truncated data has no icon");
+
+  // The smallest icon which is at least as large as the requested size is picked.
+  std::vector<uint32_t> data;
+  appendIcon(data, 16, 16, 0xff0000ff);
+  appendIcon(data, 64, 64, 0xff00ff00);
+  appendIcon(data, 48, 48, 0xffff0000);
+
+  auto icon = scaleIcon(data, 48);
+  check(icon && icon->width == 48 && icon->height == 48, "Exact size is picked");
+  check(icon && isUniform(*icon, 255, 0, 0, 255), "ARGB is converted to RGBA");
+
+  icon = scaleIcon(data, 32);
+  check(icon && icon->width == 32 && icon->height == 32, "Larger icon is scaled down");
+  check(icon && isUniform(*icon, 255, 0, 0, 255), "Next larger icon is picked");
+
+  // Icons are never scaled up.
+  icon = scaleIcon(data, 128);
+  check(icon && icon->width == 64 && icon->height == 64, "Largest icon is not scaled up");
+  check(icon && isUniform(*icon, 0, 255, 0, 255), "Largest icon is picked");
+
+  // Non-square icons keep their aspect ratio.
+  data.clear();
+  appendIcon(data, 200, 100, 0x800000ff);
+  icon = scaleIcon(data, 50);
+  check(icon && icon->width == 50 && icon->height == 25, "Aspect ratio is kept");
+  check(icon && isUniform(*icon, 0, 0, 255, 128), "Translucent color is kept");
+
+  // Fully transparent pixels must not darken their neighbors. A checkerboard of opaque
+  // white and transparent black should become half-transparent white.
+  data = {64, 64};
+  for (uint32_t y = 0; y < 64; ++y) {
+    for (uint32_t x = 0; x < 64; ++x) {
+      data.push_back((x + y) % 2 ? 0xffffffff : 0x00000000);
+    }
+  }
+  icon = scaleIcon(data, 16);
+  check(icon && icon->width == 16 && icon->height == 16, "Checkerboard is scaled down");
+  check(icon && isUniform(*icon, 255, 255, 255, 128), "Transparent pixels are ignored");
+
+  // The hash only depends on the data.
+  std::vector<uint32_t> other = data;
+  check(hashIcon(data) == hashIcon(other), "Equal data has equal hashes");
+  other.back() ^= 1;
+  check(hashIcon(data) != hashIcon(other), "Different data has different hashes");
+
+  return failures == 0 ? 0 : 1;
+}
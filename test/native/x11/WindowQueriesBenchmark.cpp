@@ -0,0 +1,193 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This benchmark compares the pipelined XCB window queries of the X11 backend with the
+// synchronous Xlib implementation which was used before. It has to be run on an X11
+// session (or in Xvfb) with some open windows. Usage:
+//
+//   ./WindowQueriesBenchmark [iterations]
+
+#include "Connection.hpp"
+#include "WindowQueries.hpp"
+
+#include <X11/Xatom.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// This is the Xlib implementation of the window queries. Each XGetWindowProperty() call
+// is a synchronous round trip to the X server.
+
+unsigned char* getProperty(
+    Display* display, Window window, Atom property, QueryStats& stats) {
+  Atom           actualType;
+  int            actualFormat;
+  unsigned long  nitems, bytesAfter;
+  unsigned char* prop = nullptr;
+
+  ++stats.requests;
+  ++stats.roundTrips;
+
+  if (XGetWindowProperty(display, window, property, 0, 1000, False, AnyPropertyType,
+          &actualType, &actualFormat, &nitems, &bytesAfter, &prop) != Success) {
+    return nullptr;
+  }
+
+  return prop;
+}
+
+WindowInfo getWindowInfoXlib(Connection& connection, Window window, QueryStats& stats) {
+  Display*     display = connection.get();
+  Atoms const& atoms   = connection.getAtoms();
+
+  WindowInfo info;
+  info.id = window;
+
+  unsigned char* wmClass = getProperty(display, window, XA_WM_CLASS, stats);
+  if (!wmClass || wmClass[0] == '\0') {
+    XFree(wmClass);
+    return info;
+  }
+
+  info.appName = reinterpret_cast<const char*>(wmClass);
+  XFree(wmClass);
+
+  unsigned char* name = getProperty(display, window, atoms.netWmName, stats);
+  if (!name) {
+    name = getProperty(display, window, XA_WM_NAME, stats);
+  }
+
+  if (name) {
+    info.windowName = reinterpret_cast<const char*>(name);
+    XFree(name);
+  }
+
+  return info;
+}
+
+void getOpenWindowsXlib(Connection& connection, QueryStats& stats) {
+  Display*     display = connection.get();
+  Atoms const& atoms   = connection.getAtoms();
+
+  Atom           actualType;
+  int            actualFormat;
+  unsigned long  nitems, bytesAfter;
+  unsigned char* data = nullptr;
+
+  ++stats.requests;
+  ++stats.roundTrips;
+
+  if (XGetWindowProperty(display, connection.getRoot(), atoms.netClientList, 0, ~0L,
+          False, XA_WINDOW, &actualType, &actualFormat, &nitems, &bytesAfter,
+          &data) != Success ||
+      !data) {
+    return;
+  }
+
+  auto* windows = reinterpret_cast<Window*>(data);
+  for (unsigned long i = 0; i < nitems; ++i) {
+    getWindowInfoXlib(connection, windows[i], stats);
+  }
+
+  XFree(data);
+}
+
+void getWMInfoXlib(Connection& connection, QueryStats& stats) {
+  Display*     display = connection.get();
+  Window       root    = connection.getRoot();
+  Atoms const& atoms   = connection.getAtoms();
+
+  unsigned char* active = getProperty(display, root, atoms.netActiveWindow, stats);
+  if (active) {
+    getWindowInfoXlib(connection, *reinterpret_cast<Window*>(active), stats);
+    XFree(active);
+  }
+
+  int          rootX, rootY, winX, winY;
+  unsigned int mask;
+  Window       child;
+  XQueryPointer(display, root, &child, &child, &rootX, &rootY, &winX, &winY, &mask);
+  ++stats.requests;
+  ++stats.roundTrips;
+
+  XFree(getProperty(display, root, XA_RESOURCE_MANAGER, stats));
+}
+
+// Runs the given function the given number of times and prints the average wall time
+// as well as the number of requests and round trips per call.
+template <typename F>
+void run(std::string const& name, int iterations, F&& function) {
+  QueryStats stats;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    function(stats);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double micros = std::chrono::duration<double, std::micro>(end - start).count();
+
+  std::cout << std::left << std::setw(24) << name << std::right << std::setw(12)
+            << std::fixed << std::setprecision(1) << micros / iterations << std::setw(12)
+            << stats.requests / iterations << std::setw(12)
+            << stats.roundTrips / iterations << std::endl;
+}
+
+// Windows may disappear while the benchmark runs. We do not want Xlib to terminate the
+// process in this case.
+int ignoreErrors(Display*, XErrorEvent*) {
+  return 0;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 100;
+
+  Connection connection;
+  if (!connection.get()) {
+    std::cerr << "Failed to connect to the X server!" << std::endl;
+    return 1;
+  }
+
+  XSetErrorHandler(ignoreErrors);
+
+  std::cout << "Benchmarking with " << queryClientList(connection).size()
+            << " client windows and " << iterations << " iterations." << std::endl
+            << std::endl;
+
+  std::cout << std::left << std::setw(24) << "Query" << std::right << std::setw(12)
+            << "Time [us]" << std::setw(12) << "Requests" << std::setw(12)
+            << "Round Trips" << std::endl;
+
+  run("getOpenWindows (Xlib)", iterations,
+      [&](QueryStats& stats) { getOpenWindowsXlib(connection, stats); });
+
+  run("getOpenWindows (XCB)", iterations, [&](QueryStats& stats) {
+    queryWindowInfos(connection, queryClientList(connection, &stats), &stats);
+  });
+
+  run("getWMInfo (Xlib)", iterations,
+      [&](QueryStats& stats) { getWMInfoXlib(connection, stats); });
+
+  run("getWMInfo (XCB)", iterations,
+      [&](QueryStats& stats) { queryWMState(connection, &stats); });
+
+  return 0;
+}
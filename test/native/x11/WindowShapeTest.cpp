@@ -0,0 +1,142 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test checks how circles are approximated with rectangles and whether the bounding
+// and input regions are applied to a window.
+
+#include "TestUtils.hpp"
+#include "WindowShape.hpp"
+
+#include <X11/Xlib-xcb.h>
+#include <X11/Xlib.h>
+#include <xcb/shape.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Returns true if the given point is inside one of the rectangles.
+bool covers(std::vector<xcb_rectangle_t> const& rects, double x, double y) {
+  for (auto const& rect : rects) {
+    if (x >= rect.x && y >= rect.y && x < rect.x + rect.width &&
+        y < rect.y + rect.height) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Checks the given circle against the rectangles on a grid around it. All points inside
+// the circle must be covered. Points which are further away than the given tolerance
+// must not be covered.
+bool approximates(std::vector<xcb_rectangle_t> const& rects, ShapeCircle const& circle,
+    double tolerance) {
+  for (double y = circle.y - circle.radius - 2 * tolerance;
+       y < circle.y + circle.radius + 2 * tolerance; y += 0.5) {
+    for (double x = circle.x - circle.radius - 2 * tolerance;
+         x < circle.x + circle.radius + 2 * tolerance; x += 0.5) {
+      double distance = std::hypot(x - circle.x, y - circle.y);
+
+      if (distance < circle.radius && !covers(rects, x, y)) {
+        return false;
+      }
+
+      if (distance > circle.radius + tolerance && covers(rects, x, y)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// Returns the rectangles of the given region of the window.
+std::vector<xcb_rectangle_t> getRegion(
+    xcb_connection_t* xcb, xcb_window_t window, xcb_shape_kind_t kind) {
+  std::vector<xcb_rectangle_t> rects;
+
+  auto* reply = xcb_shape_get_rectangles_reply(
+      xcb, xcb_shape_get_rectangles(xcb, window, kind), nullptr);
+
+  if (reply) {
+    auto* data = xcb_shape_get_rectangles_rectangles(reply);
+    rects.assign(data, data + xcb_shape_get_rectangles_rectangles_length(reply));
+    free(reply);
+  }
+
+  return rects;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  ShapeCircle circle = {200.5, 150.25, 100.0};
+
+  auto rects = rasterizeShape({circle}, {}, 8);
+  check(rects.size() == 26, "Circles are split into bands");
+  check(approximates(rects, circle, 8.0), "Bands cover the circle tightly");
+
+  rects = rasterizeShape({circle}, {}, 1);
+  check(approximates(rects, circle, 1.5), "Thinner bands cover the circle more tightly");
+
+  rects = rasterizeShape({{0, 0, 0}}, {{10, 20, 30, 40}, {0, 0, 0, 10}}, 8);
+  check(rects.size() == 1 && rects[0].x == 10 && rects[0].y == 20 &&
+            rects[0].width == 30 && rects[0].height == 40,
+      "Empty shapes are skipped");
+
+  rects = rasterizeShape({{-40000, 0, 10}}, {}, 8);
+  check(!rects.empty() && rects[0].x == INT16_MIN, "Coordinates are clamped");
+
+  // The remaining checks need an X server.
+  Display* display = XOpenDisplay(nullptr);
+  if (!display) {
+    std::cerr << "Failed to connect to the X server!" << std::endl;
+    return 1;
+  }
+
+  xcb_connection_t* xcb    = XGetXCBConnection(display);
+  Window            window = XCreateSimpleWindow(
+      display, DefaultRootWindow(display), 0, 0, 400, 300, 0, 0, 0);
+  XSync(display, False);
+
+  rects = rasterizeShape({circle}, {{350, 250, 50, 50}}, 8);
+  check(setWindowShape(xcb, window, rects), "Window shapes can be set");
+
+  auto bounding = getRegion(xcb, window, XCB_SHAPE_SK_BOUNDING);
+  auto input    = getRegion(xcb, window, XCB_SHAPE_SK_INPUT);
+
+  check(covers(bounding, 200, 150) && covers(bounding, 375, 275) &&
+            !covers(bounding, 10, 10),
+      "The bounding region is set");
+  check(covers(input, 200, 150) && covers(input, 375, 275) && !covers(input, 10, 10),
+      "The input region is set");
+
+  check(resetWindowShape(xcb, window), "Window shapes can be removed");
+  check(covers(getRegion(xcb, window, XCB_SHAPE_SK_BOUNDING), 10, 10) &&
+            covers(getRegion(xcb, window, XCB_SHAPE_SK_INPUT), 10, 10),
+      "The whole window is used again");
+
+  XDestroyWindow(display, window);
+  XSync(display, False);
+
+  check(!setWindowShape(xcb, window, rects), "Destroyed windows are reported");
+
+  XCloseDisplay(display);
+
+  return failures == 0 ? 0 : 1;
+}
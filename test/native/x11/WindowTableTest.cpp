@@ -0,0 +1,385 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test drives the WindowTable through some scripted window churn. It has to be run
+// on an otherwise empty X server like Xvfb, as it plays the role of the window manager
+// and maintains _NET_CLIENT_LIST itself.
+
+#include "TestUtils.hpp"
+#include "WindowTable.hpp"
+
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// This is our fake window manager. It creates client windows and keeps _NET_CLIENT_LIST
+// and the window properties up to date. It does not reparent the windows.
+class FakeWM {
+ public:
+  FakeWM() {
+    mDisplay = XOpenDisplay(nullptr);
+    if (mDisplay) {
+      mRoot          = DefaultRootWindow(mDisplay);
+      mNetClientList = XInternAtom(mDisplay, "_NET_CLIENT_LIST", False);
+      mNetWmName     = XInternAtom(mDisplay, "_NET_WM_NAME", False);
+      mNetActive     = XInternAtom(mDisplay, "_NET_ACTIVE_WINDOW", False);
+      mUtf8String    = XInternAtom(mDisplay, "UTF8_STRING", False);
+      publishClientList();
+    }
+  }
+
+  ~FakeWM() {
+    if (mDisplay) {
+      XCloseDisplay(mDisplay);
+    }
+  }
+
+  bool isConnected() const {
+    return mDisplay != nullptr;
+  }
+
+  Window createWindow(std::string const& app, std::string const& title) {
+    Window window = XCreateSimpleWindow(mDisplay, mRoot, 0, 0, 100, 100, 0, 0, 0);
+
+    std::string wmClass = app + '\0' + app + '\0';
+    XChangeProperty(mDisplay, window, XA_WM_CLASS, XA_STRING, 8, PropModeReplace,
+        reinterpret_cast<const unsigned char*>(wmClass.data()), wmClass.size());
+
+    XMapWindow(mDisplay, window);
+    mWindows[window] = {app, ""};
+    setTitle(window, title);
+    publishClientList();
+
+    return window;
+  }
+
+  void setTitle(Window window, std::string const& title) {
+    XChangeProperty(mDisplay, window, mNetWmName, mUtf8String, 8, PropModeReplace,
+        reinterpret_cast<const unsigned char*>(title.data()), title.size());
+    mWindows[window].second = title;
+    XFlush(mDisplay);
+  }
+
+  // Sets only the legacy WM_NAME property. This is used for windows which do not set
+  // _NET_WM_NAME.
+  void setLegacyTitle(Window window, std::string const& title) {
+    XDeleteProperty(mDisplay, window, mNetWmName);
+    XStoreName(mDisplay, window, title.c_str());
+    mWindows[window].second = title;
+    XFlush(mDisplay);
+  }
+
+  void activateWindow(Window window) {
+    XChangeProperty(mDisplay, mRoot, mNetActive, XA_WINDOW, 32, PropModeReplace,
+        reinterpret_cast<const unsigned char*>(&window), 1);
+    XFlush(mDisplay);
+  }
+
+  void setResources(std::string const& resources) {
+    XChangeProperty(mDisplay, mRoot, XA_RESOURCE_MANAGER, XA_STRING, 8, PropModeReplace,
+        reinterpret_cast<const unsigned char*>(resources.data()), resources.size());
+    XFlush(mDisplay);
+  }
+
+  void setWorkArea(int x, int y, int width, int height) {
+    long workArea[4] = {x, y, width, height};
+    XChangeProperty(mDisplay, mRoot, XInternAtom(mDisplay, "_NET_WORKAREA", False),
+        XA_CARDINAL, 32, PropModeReplace,
+        reinterpret_cast<const unsigned char*>(workArea), 4);
+    XFlush(mDisplay);
+  }
+
+  void moveWindow(Window window, int x, int y, int width, int height) {
+    XMoveResizeWindow(mDisplay, window, x, y, width, height);
+    XFlush(mDisplay);
+  }
+
+  void setStackingOrder(std::vector<Window> const& windows) {
+    std::vector<unsigned long> ids(windows.begin(), windows.end());
+    Atom stacking = XInternAtom(mDisplay, "_NET_CLIENT_LIST_STACKING", False);
+    XChangeProperty(mDisplay, mRoot, stacking, XA_WINDOW, 32, PropModeReplace,
+        reinterpret_cast<const unsigned char*>(ids.data()), ids.size());
+    XFlush(mDisplay);
+  }
+
+  void setFrameExtents(Window window, int left, int right, int top, int bottom) {
+    long extents[4] = {left, right, top, bottom};
+    Atom property   = XInternAtom(mDisplay, "_NET_FRAME_EXTENTS", False);
+    XChangeProperty(mDisplay, window, property, XA_CARDINAL, 32, PropModeReplace,
+        reinterpret_cast<const unsigned char*>(extents), 4);
+    XFlush(mDisplay);
+  }
+
+  void setDesktop(Window window, long desktop) {
+    Atom property = XInternAtom(mDisplay, "_NET_WM_DESKTOP", False);
+    XChangeProperty(mDisplay, window, property, XA_CARDINAL, 32, PropModeReplace,
+        reinterpret_cast<const unsigned char*>(&desktop), 1);
+    XFlush(mDisplay);
+  }
+
+  void setCurrentDesktop(long desktop) {
+    Atom property = XInternAtom(mDisplay, "_NET_CURRENT_DESKTOP", False);
+    XChangeProperty(mDisplay, mRoot, property, XA_CARDINAL, 32, PropModeReplace,
+        reinterpret_cast<const unsigned char*>(&desktop), 1);
+    XFlush(mDisplay);
+  }
+
+  // Unmaps the window but keeps it in the client list, like a minimized window.
+  void hideWindow(Window window) {
+    XUnmapWindow(mDisplay, window);
+    XFlush(mDisplay);
+  }
+
+  void showWindow(Window window) {
+    XMapWindow(mDisplay, window);
+    XFlush(mDisplay);
+  }
+
+  void unmapWindow(Window window) {
+    XUnmapWindow(mDisplay, window);
+    mWindows.erase(window);
+    publishClientList();
+  }
+
+  void destroyWindow(Window window) {
+    mWindows.erase(window);
+    publishClientList();
+    XDestroyWindow(mDisplay, window);
+    XFlush(mDisplay);
+  }
+
+  std::vector<Window> getWindows() const {
+    std::vector<Window> windows;
+    for (auto const& [window, info] : mWindows) {
+      windows.push_back(window);
+    }
+    return windows;
+  }
+
+  // Returns true if the given list matches the current state of the fake window manager.
+  bool matches(std::vector<WindowInfo> const& infos) const {
+    if (infos.size() != mWindows.size()) {
+      return false;
+    }
+
+    for (auto const& info : infos) {
+      auto it = mWindows.find(info.id);
+      if (it == mWindows.end() || it->second.first != info.appName ||
+          it->second.second != info.windowName) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+ private:
+  void publishClientList() {
+    std::vector<unsigned long> ids;
+    for (auto const& [window, info] : mWindows) {
+      ids.push_back(window);
+    }
+
+    XChangeProperty(mDisplay, mRoot, mNetClientList, XA_WINDOW, 32, PropModeReplace,
+        reinterpret_cast<const unsigned char*>(ids.data()), ids.size());
+    XFlush(mDisplay);
+  }
+
+  Display* mDisplay       = nullptr;
+  Window   mRoot          = None;
+  Atom     mNetClientList = None;
+  Atom     mNetWmName     = None;
+  Atom     mNetActive     = None;
+  Atom     mUtf8String    = None;
+
+  std::map<Window, std::pair<std::string, std::string>> mWindows;
+};
+
+// Waits until the window table matches the state of the fake window manager.
+bool waitForMatch(WindowTable const& table, FakeWM const& wm) {
+  return waitFor([&]() { return table.isSynced() && wm.matches(table.getWindows()); });
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  XInitThreads();
+
+  FakeWM wm;
+  if (!wm.isConnected()) {
+    std::cerr << "Failed to connect to the X server!" << std::endl;
+    return 1;
+  }
+
+  WindowTable table;
+  table.start();
+
+  check(waitForMatch(table, wm), "Initial client list is empty");
+
+  Window terminal = wm.createWindow("terminal", "~");
+  Window browser  = wm.createWindow("browser", "New Tab");
+  Window editor   = wm.createWindow("editor", "untitled");
+  check(waitForMatch(table, wm), "Newly mapped windows are added");
+
+  wm.setTitle(browser, "Kando - The Cross-Platform Pie Menu");
+  check(waitForMatch(table, wm), "Renamed windows are updated");
+
+  wm.setLegacyTitle(editor, "notes.txt");
+  check(waitForMatch(table, wm), "WM_NAME is used if _NET_WM_NAME is missing");
+
+  // The callback is called from the event thread, so we have to protect the result.
+  std::mutex  activeMutex;
+  std::string activeTitle;
+  table.setActiveWindowCallback([&](WindowInfo const& window) {
+    std::lock_guard<std::mutex> lock(activeMutex);
+    activeTitle = window.windowName;
+  });
+
+  auto activeTitleIs = [&](std::string const& title) {
+    return waitFor([&]() {
+      std::lock_guard<std::mutex> lock(activeMutex);
+      return activeTitle == title;
+    });
+  };
+
+  wm.activateWindow(terminal);
+  check(activeTitleIs("~"), "Activating a window calls the callback");
+
+  wm.setTitle(terminal, "~/kando");
+  check(activeTitleIs("~/kando"), "Renaming the active window calls the callback");
+  check(table.getActiveWindow().windowName == "~/kando", "Active window is cached");
+
+  table.setActiveWindowCallback(nullptr);
+
+  // The windows are ordered by the focus history, most recent first.
+  auto frontIs = [&](Window window) {
+    return waitFor([&]() {
+      auto windows = table.getWindows();
+      return !windows.empty() && windows.front().id == window;
+    });
+  };
+
+  wm.activateWindow(editor);
+  check(frontIs(editor), "The active window comes first");
+
+  wm.activateWindow(terminal);
+  check(frontIs(terminal) && table.getWindows()[1].id == editor,
+      "Previously active windows follow in the order of use");
+
+  check(table.getWindow(browser) && table.getWindow(browser)->id == browser,
+      "Windows can be looked up by their ID");
+
+  wm.setResources("Xft.dpi:\t192\nXft.antialias:\t1\n");
+  check(waitFor([&]() { return table.getScalingFactor() == 2.0; }),
+      "Scaling factor follows RESOURCE_MANAGER");
+
+  wm.setResources("Xft.antialias:\t1\n");
+  check(waitFor([&]() { return table.getScalingFactor() == 1.0; }),
+      "Scaling factor falls back to one without Xft.dpi");
+
+  auto monitors = table.getMonitors();
+  check(monitors.size() == 1, "Virtual X server has one monitor");
+
+  if (!monitors.empty()) {
+    Rect screen   = monitors[0].geometry;
+    Rect expected = {0, 30, screen.width, screen.height - 30};
+    wm.setWorkArea(expected.x, expected.y, expected.width, expected.height);
+
+    auto workAreaMatches = [&]() {
+      auto monitor = table.findMonitor(screen.width / 2, screen.height / 2);
+      return monitor && monitor->workArea == expected;
+    };
+
+    check(waitFor(workAreaMatches), "Work area follows _NET_WORKAREA");
+  }
+
+  // The window under the pointer is found in the cached geometries.
+  auto hitIs = [&](int x, int y, Window window) {
+    return waitFor([&]() {
+      auto hit = table.findWindowAt(x, y);
+      return window == None ? !hit : hit && hit->id == window;
+    });
+  };
+
+  Window lower = wm.createWindow("lower", "lower");
+  Window upper = wm.createWindow("upper", "upper");
+  wm.moveWindow(lower, 200, 200, 200, 200);
+  wm.moveWindow(upper, 300, 300, 200, 200);
+
+  // The fake window manager publishes the clients sorted by ID.
+  check(hitIs(350, 350, std::max(lower, upper)),
+      "Without stacking order, later clients are on top");
+
+  wm.setStackingOrder({upper, lower});
+  check(hitIs(350, 350, lower), "Windows are tested in stacking order");
+  check(hitIs(450, 450, upper), "Covered windows are hit where they are visible");
+  check(hitIs(150, 450, None), "Positions outside of all windows hit nothing");
+
+  wm.setFrameExtents(upper, 0, 0, 20, 0);
+  check(hitIs(450, 290, upper), "The frame extents are part of the window");
+
+  wm.hideWindow(lower);
+  check(hitIs(350, 350, upper), "Unmapped windows are skipped");
+
+  wm.showWindow(lower);
+  check(hitIs(350, 350, lower), "Mapped windows are hit again");
+
+  wm.setCurrentDesktop(0);
+  wm.setDesktop(lower, 1);
+  check(hitIs(350, 350, upper), "Windows on other desktops are skipped");
+
+  wm.setStackingOrder({});
+  wm.destroyWindow(lower);
+  wm.destroyWindow(upper);
+  check(waitForMatch(table, wm), "Hit-tested windows are removed");
+
+  wm.unmapWindow(terminal);
+  check(waitForMatch(table, wm), "Unmapped windows are removed");
+
+  wm.destroyWindow(browser);
+  check(waitForMatch(table, wm), "Destroyed windows are removed");
+
+  // Now we randomly create, rename and destroy windows without waiting in between.
+  std::mt19937 random(42);
+  for (int i = 0; i < 500; ++i) {
+    auto windows = wm.getWindows();
+    int  action  = random() % 3;
+
+    if (windows.empty() || action == 0) {
+      wm.createWindow(
+          "app" + std::to_string(random() % 10), "window " + std::to_string(i));
+    } else if (action == 1) {
+      wm.setTitle(windows[random() % windows.size()], "renamed " + std::to_string(i));
+    } else {
+      wm.destroyWindow(windows[random() % windows.size()]);
+    }
+  }
+
+  check(waitForMatch(table, wm), "Table is consistent after random churn");
+
+  table.stop();
+
+  return failures == 0 ? 0 : 1;
+}
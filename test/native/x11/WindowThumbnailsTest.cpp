@@ -0,0 +1,125 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test creates some solid-colored windows and checks that the WindowThumbnails
+// capture them and notice changes of their content. It needs an X server with the
+// Composite and Damage extensions like Xvfb.
+
+#include "TestUtils.hpp"
+#include "WindowThumbnails.hpp"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Creates and maps a window with the given size and background color.
+Window createWindow(Display* display, int width, int height, unsigned long color) {
+  Window window = XCreateSimpleWindow(
+      display, DefaultRootWindow(display), 0, 0, width, height, 0, 0, color);
+  XMapWindow(display, window);
+  XFlush(display);
+  return window;
+}
+
+void setColor(Display* display, Window window, unsigned long color) {
+  XSetWindowBackground(display, window, color);
+  XClearWindow(display, window);
+  XFlush(display);
+}
+
+// Returns true if the center pixel of the thumbnail has the given RGB color.
+bool hasColor(std::shared_ptr<const Icon> const& thumbnail, unsigned long color) {
+  if (!thumbnail || thumbnail->rgba.empty()) {
+    return false;
+  }
+
+  size_t         center = thumbnail->height / 2 * thumbnail->width + thumbnail->width / 2;
+  uint8_t const* pixel  = thumbnail->rgba.data() + center * 4;
+
+  return pixel[0] == ((color >> 16) & 0xFF) && pixel[1] == ((color >> 8) & 0xFF) &&
+         pixel[2] == (color & 0xFF) && pixel[3] == 255;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  XInitThreads();
+
+  Display* display = XOpenDisplay(nullptr);
+  if (!display) {
+    std::cerr << "Failed to connect to the X server!" << std::endl;
+    return 1;
+  }
+
+  WindowThumbnails thumbnails;
+  if (!thumbnails.start()) {
+    std::cerr << "Composite or Damage are not supported!" << std::endl;
+    return 1;
+  }
+
+  Window red  = createWindow(display, 400, 200, 0xFF0000);
+  Window blue = createWindow(display, 100, 100, 0x0000FF);
+
+  // Right after mapping, the windows may not be viewable yet.
+  std::vector<std::shared_ptr<const Icon>> result;
+
+  bool captured = waitFor([&]() {
+    result = thumbnails.get({red, blue}, 64);
+    return hasColor(result[0], 0xFF0000) && hasColor(result[1], 0x0000FF);
+  });
+  check(captured, "Windows are captured in one batch");
+
+  check(result[0]->width == 64 && result[0]->height == 32, "Large windows are scaled");
+  check(result[1]->width == 64 && result[1]->height == 64, "Aspect ratio is kept");
+
+  auto cached = thumbnails.get({red, blue}, 64);
+  check(cached[0] == result[0] && cached[1] == result[1], "Unchanged windows are cached");
+
+  setColor(display, red, 0x00FF00);
+  check(waitFor([&]() { return hasColor(thumbnails.get({red}, 64)[0], 0x00FF00); }),
+      "Damaged windows are captured again");
+  check(thumbnails.get({blue}, 64)[0] == result[1], "Other windows stay cached");
+
+  auto small = thumbnails.get({blue}, 16);
+  check(small[0] && small[0]->width == 16, "Other sizes are captured again");
+
+  check(thumbnails.getMemoryUsage() == 64 * 32 * 4 + 16 * 16 * 4,
+      "Memory usage is tracked");
+
+  XDestroyWindow(display, red);
+  XFlush(display);
+  check(waitFor([&]() { return thumbnails.getMemoryUsage() == 16 * 16 * 4; }),
+      "Destroyed windows are removed");
+  check(thumbnails.get({red}, 64)[0] == nullptr, "Destroyed windows have no thumbnail");
+
+  // Many large thumbnails do not fit into the cache.
+  std::vector<Window> windows;
+  for (int i = 0; i < 40; ++i) {
+    windows.push_back(createWindow(display, 1024, 1024, 0x808080));
+  }
+
+  thumbnails.get(windows, 1024);
+  check(thumbnails.getMemoryUsage() <= 32 * 1024 * 1024, "Memory usage is capped");
+
+  thumbnails.stop();
+  check(thumbnails.getMemoryUsage() == 0, "Stopping clears the cache");
+
+  XCloseDisplay(display);
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,222 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//   _  _ ____ _  _ ___  ____                                                           //
+//   |_/  |__| |\ | |  \ |  |    This file belongs to Kando, the cross-platform         //
+//   | \_ |  | | \| |__/ |__|    pie menu. Read more on github.com/kando-menu/kando     //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: Simon Schneegans <code@simonschneegans.de>
+// SPDX-License-Identifier: MIT
+
+// This test checks the XSETTINGS parser and how the WindowTable follows the icon theme of
+// an XSETTINGS manager. It plays the role of the manager itself, so it has to be run on
+// an X server without one, like Xvfb.
+
+#include "TestUtils.hpp"
+#include "WindowTable.hpp"
+#include "XSettings.hpp"
+
+#include <X11/Xlib.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Assembles the content of an _XSETTINGS_SETTINGS property in the given byte order.
+class SettingsWriter {
+ public:
+  SettingsWriter(bool bigEndian, uint32_t serial)
+      : mBigEndian(bigEndian) {
+    mData = {uint8_t(bigEndian ? 1 : 0), 0, 0, 0};
+    put(serial, 4);
+    put(0, 4);
+  }
+
+  void addInteger(std::string const& name, int32_t value) {
+    addHeader(0, name);
+    put(uint32_t(value), 4);
+  }
+
+  void addString(std::string const& name, std::string const& value) {
+    addHeader(1, name);
+    put(value.size(), 4);
+    putString(value);
+  }
+
+  void addColor(std::string const& name, uint16_t r, uint16_t g, uint16_t b, uint16_t a) {
+    addHeader(2, name);
+    put(r, 2);
+    put(b, 2);
+    put(g, 2);
+    put(a, 2);
+  }
+
+  std::vector<uint8_t> const& data() const {
+    return mData;
+  }
+
+ private:
+  void addHeader(uint8_t type, std::string const& name) {
+    mData.push_back(type);
+    mData.push_back(0);
+    put(name.size(), 2);
+    putString(name);
+    put(0, 4);
+
+    // The number of settings is stored right after the serial.
+    ++mCount;
+    for (size_t i = 0; i < 4; ++i) {
+      mData[8 + i] = byte(mCount, i, 4);
+    }
+  }
+
+  void put(uint32_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+      mData.push_back(byte(value, i, bytes));
+    }
+  }
+
+  // Returns the i-th byte of the given value when stored with the given size.
+  uint8_t byte(uint32_t value, size_t i, size_t bytes) const {
+    size_t shift = mBigEndian ? (bytes - 1 - i) * 8 : i * 8;
+    return uint8_t(value >> shift);
+  }
+
+  void putString(std::string const& value) {
+    mData.insert(mData.end(), value.begin(), value.end());
+    mData.resize(mData.size() + (4 - value.size() % 4) % 4, 0);
+  }
+
+  std::vector<uint8_t> mData;
+  bool                 mBigEndian = false;
+  uint32_t             mCount     = 0;
+};
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+
+  // First, we check the parser in both byte orders.
+  for (bool bigEndian : {false, true}) {
+    SettingsWriter writer(bigEndian, 7);
+    writer.addString("Net/IconThemeName", "Papirus");
+    writer.addInteger("Xft/DPI", 98304);
+    writer.addColor("Gtk/Color", 1, 2, 3, 4);
+
+    std::string order    = bigEndian ? " (MSB first)" : " (LSB first)";
+    auto        settings = parseXSettings(writer.data().data(), writer.data().size());
+
+    check(settings && settings->serial == 7 && settings->values.size() == 3,
+        "All settings are parsed" + order);
+    check(settings && settings->getString("Net/IconThemeName") == "Papirus",
+        "Strings are parsed" + order);
+
+    auto get = [&](std::string const& name) -> XSettingsValue const* {
+      if (!settings || settings->values.count(name) == 0) {
+        return nullptr;
+      }
+      return &settings->values.at(name);
+    };
+
+    auto* dpi = get("Xft/DPI") ? std::get_if<int32_t>(get("Xft/DPI")) : nullptr;
+    check(dpi && *dpi == 98304, "Integers are parsed" + order);
+
+    auto* color =
+        get("Gtk/Color") ? std::get_if<XSettingsColor>(get("Gtk/Color")) : nullptr;
+    check(color && color->red == 1 && color->green == 2 && color->blue == 3 &&
+              color->alpha == 4,
+        "Colors are parsed" + order);
+    check(settings && !settings->getString("Xft/DPI"), "Integers are no strings" + order);
+
+    // Truncated data is rejected.
+    bool truncated = true;
+    for (size_t length = 0; length < writer.data().size(); ++length) {
+      truncated &= !parseXSettings(writer.data().data(), length);
+    }
+    check(truncated, "Truncated data is rejected" + order);
+  }
+
+  // Now we play the XSETTINGS manager.
+  XInitThreads();
+
+  Display* display = XOpenDisplay(nullptr);
+  if (!display) {
+    std::cerr << "Failed to connect to the X server!" << std::endl;
+    return 1;
+  }
+
+  Window root      = DefaultRootWindow(display);
+  Atom   selection = XInternAtom(
+      display, ("_XSETTINGS_S" + std::to_string(DefaultScreen(display))).c_str(), False);
+  Atom property = XInternAtom(display, "_XSETTINGS_SETTINGS", False);
+  Atom manager  = XInternAtom(display, "MANAGER", False);
+
+  auto publish = [&](Window window, uint32_t serial, std::string const& iconTheme) {
+    SettingsWriter writer(false, serial);
+    writer.addString("Net/IconThemeName", iconTheme);
+    XChangeProperty(display, window, property, property, 8, PropModeReplace,
+        writer.data().data(), writer.data().size());
+    XFlush(display);
+  };
+
+  WindowTable table;
+  table.start();
+
+  check(waitFor([&]() { return table.isSynced(); }) && !table.getIconTheme(),
+      "There is no icon theme without an XSETTINGS manager");
+
+  // A new manager sets its settings, acquires the selection, and announces itself.
+  auto startManager = [&](std::string const& iconTheme) {
+    Window window = XCreateSimpleWindow(display, root, 0, 0, 1, 1, 0, 0, 0);
+    publish(window, 0, iconTheme);
+    XSetSelectionOwner(display, selection, window, CurrentTime);
+
+    XEvent event               = {};
+    event.xclient.type         = ClientMessage;
+    event.xclient.window       = root;
+    event.xclient.message_type = manager;
+    event.xclient.format       = 32;
+    event.xclient.data.l[0]    = CurrentTime;
+    event.xclient.data.l[1]    = long(selection);
+    event.xclient.data.l[2]    = long(window);
+    XSendEvent(display, root, False, StructureNotifyMask, &event);
+    XFlush(display);
+
+    return window;
+  };
+
+  auto iconThemeIs = [&](std::string const& iconTheme) {
+    return waitFor([&]() { return table.getIconTheme() == iconTheme; });
+  };
+
+  Window window = startManager("Adwaita");
+  check(iconThemeIs("Adwaita"), "The icon theme of a new manager is read");
+
+  publish(window, 1, "Papirus");
+  check(iconThemeIs("Papirus"), "Changes of the settings are followed");
+
+  XDestroyWindow(display, window);
+  XFlush(display);
+  check(waitFor([&]() { return !table.getIconTheme(); }),
+      "The icon theme is forgotten once the manager exits");
+
+  window = startManager("Breeze");
+  check(iconThemeIs("Breeze"), "A replacement manager is picked up");
+
+  table.stop();
+  XDestroyWindow(display, window);
+  XCloseDisplay(display);
+
+  return failures == 0 ? 0 : 1;
+}